@@ -183,6 +183,14 @@ void BTManager::send_feedback_cb(void* context)
     }
 }
 
+//Runs on the i2c thread
+void BTManager::feedback_read_cb(void* context, const I2CDriver::PacketOut& packet_out)
+{
+    FBContext* fb_context = reinterpret_cast<FBContext*>(context);
+    fb_context->packet_out->store(packet_out);
+    btstack_run_loop_execute_on_main_thread(&fb_context->cb_reg);
+}
+
 //This will have to be changed once full support for multiple devices is added
 void BTManager::feedback_timer_cb(btstack_timer_source *ts)
 {
@@ -203,12 +211,7 @@ void BTManager::feedback_timer_cb(btstack_timer_source *ts)
         fb_context.cb_reg.context = reinterpret_cast<void*>(&fb_context);
 
         //Register a read on i2c thread, with callback to send feedback on btstack thread
-        bt_manager.i2c_driver_.read_packet(I2CDriver::MULTI_SLAVE ? i + 1 : 0x01,
-            [&fb_context](const I2CDriver::PacketOut& packet_out)
-            {
-                fb_context.packet_out->store(packet_out);
-                btstack_run_loop_execute_on_main_thread(&fb_context.cb_reg);
-            });
+        bt_manager.i2c_driver_.read_packet(I2CDriver::MULTI_SLAVE ? i + 1 : 0x01, i, feedback_read_cb, &fb_context);
     }
 
     btstack_run_loop_set_timer(ts, FEEDBACK_TIME_MS);
@@ -243,7 +246,7 @@ void BTManager::manage_connection(uint8_t index, bool connected)
         I2CDriver::PacketIn packet_in = I2CDriver::PacketIn();
         packet_in.packet_id = I2CDriver::PacketID::SET_PAD;
         packet_in.index = index;
-        i2c_driver_.write_packet(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
+        i2c_driver_.write_pad(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
     }
 }
 
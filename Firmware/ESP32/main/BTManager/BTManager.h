@@ -61,6 +61,7 @@ private:
     static uni_hid_device_t* get_connected_bp32_device(uint8_t index);
     static void check_led_cb(btstack_timer_source *ts);
     static void send_feedback_cb(void* context);
+    static void feedback_read_cb(void* context, const I2CDriver::PacketOut& packet_out);
     static void feedback_timer_cb(btstack_timer_source *ts);
     static void driver_update_timer_cb(btstack_timer_source *ts);
 
@@ -1,3 +1,5 @@
+#include <esp_timer.h>
+
 #include "btstack_port_esp32.h"
 #include "btstack_run_loop.h"
 #include "btstack_stdio_esp32.h"
@@ -56,6 +58,8 @@ uni_error_t BTManager::device_ready_cb(uni_hid_device_t* device)
 
 void BTManager::controller_data_cb(uni_hid_device_t* bp_device, uni_controller_t* controller) 
 {
+    //For the I2C latency stats
+    const int64_t received_us = esp_timer_get_time();
     static uni_gamepad_t prev_uni_gps[MAX_GAMEPADS] = {};
 
     if (controller->klass != UNI_CONTROLLER_CLASS_GAMEPAD)
@@ -135,7 +139,7 @@ void BTManager::controller_data_cb(uni_hid_device_t* bp_device, uni_controller_t
     std::tie(packet_in.joystick_lx, packet_in.joystick_ly) = mapper.scale_joystick_l<10>(uni_gp->axis_x, uni_gp->axis_y);
     std::tie(packet_in.joystick_rx, packet_in.joystick_ry) = mapper.scale_joystick_r<10>(uni_gp->axis_rx, uni_gp->axis_ry);
 
-    i2c_driver_.write_packet(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in);
+    i2c_driver_.write_pad(I2CDriver::MULTI_SLAVE ? packet_in.index + 1 : 0x01, packet_in, received_us);
 
     std::memcpy(&prev_uni_gps[idx], uni_gp, sizeof(uni_gamepad_t));
 }
@@ -0,0 +1,156 @@
+#ifndef _OGXM_PAD_DELTA_H_
+#define _OGXM_PAD_DELTA_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <array>
+
+/*  Delta coding for pad state sent between chips (4-channel master to slaves, ESP32 to RP2040).
+
+    The state is a fixed run of bytes split into fields by a Layout. A frame is a sequence byte, a
+    field bitmap and the bytes of every field set in the bitmap, in field order:
+
+        [seq: stream << 6 | count & 0x3F][map][fields...]
+
+    Only fields that changed since the last frame are set, an unchanged pad is the 2 byte header.
+    A frame with every field set is a keyframe: it's sent first, every KEYFRAME_INTERVAL frames and
+    whenever the sender is told to (a write failed, the receiver asked). The receiver applies every
+    frame it gets, but once it sees a count out of order or a malformed frame it asks for a keyframe
+    until one arrives. Stream tells apart pads multiplexed on one link.
+
+    Both ends need the same code: Firmware/RP2040/src/Board/pad_delta.h and
+    Firmware/ESP32/main/Board/pad_delta.h are copies of one file, the host bench checks they match. */
+
+namespace pad_delta {
+    static constexpr size_t  HEADER_SIZE = 2;
+    static constexpr uint8_t COUNT_MASK = 0x3F;
+    static constexpr uint8_t STREAM_SHIFT = 6;
+    static constexpr uint8_t NUM_STREAMS = 4;
+    static constexpr uint8_t KEYFRAME_INTERVAL = 64;
+
+    //Sizes of each field in bytes, in the order they sit in the state
+    template <uint8_t... SIZES>
+    struct Layout {
+        static constexpr size_t NUM_FIELDS = sizeof...(SIZES);
+        static constexpr std::array<uint8_t, NUM_FIELDS> FIELD_SIZES{SIZES...};
+        static constexpr size_t STATE_SIZE = (static_cast<size_t>(SIZES) + ...);
+        static constexpr uint8_t ALL_FIELDS = static_cast<uint8_t>((1u << NUM_FIELDS) - 1);
+        static constexpr size_t FRAME_SIZE_MAX = HEADER_SIZE + STATE_SIZE;
+
+        static_assert(NUM_FIELDS > 0 && NUM_FIELDS <= 8, "pad_delta::Layout takes 1 to 8 fields");
+    };
+
+    static inline uint8_t stream(const uint8_t* frame) {
+        return frame[0] >> STREAM_SHIFT;
+    }
+
+    template <typename L>
+    class Encoder {
+    public:
+        //Next frame carries every field
+        void force_keyframe() { keyframe_due_ = true; }
+
+        //Writes the frame for state to out (L::FRAME_SIZE_MAX bytes), returns its size
+        size_t encode(const uint8_t* state, uint8_t stream, uint8_t* out) {
+            if (++since_keyframe_ >= KEYFRAME_INTERVAL) {
+                keyframe_due_ = true;
+            }
+            const bool keyframe = keyframe_due_;
+            if (keyframe) {
+                keyframe_due_ = false;
+                since_keyframe_ = 0;
+            }
+
+            uint8_t map = 0;
+            size_t len = HEADER_SIZE;
+            size_t offset = 0;
+            for (size_t i = 0; i < L::NUM_FIELDS; ++i) {
+                const size_t size = L::FIELD_SIZES[i];
+                if (keyframe || std::memcmp(&state[offset], &last_[offset], size) != 0) {
+                    map |= static_cast<uint8_t>(1u << i);
+                    std::memcpy(&out[len], &state[offset], size);
+                    std::memcpy(&last_[offset], &state[offset], size);
+                    len += size;
+                }
+                offset += size;
+            }
+            out[0] = static_cast<uint8_t>((stream << STREAM_SHIFT) | (count_ & COUNT_MASK));
+            out[1] = map;
+            count_ = (count_ + 1) & COUNT_MASK;
+            return len;
+        }
+
+    private:
+        uint8_t last_[L::STATE_SIZE]{0};
+        uint8_t count_{0};
+        uint8_t since_keyframe_{0};
+        bool keyframe_due_{true};
+    };
+
+    enum class Result : uint8_t {
+        INVALID = 0,
+        UNCHANGED,
+        CHANGED
+    };
+
+    template <typename L>
+    class Decoder {
+    public:
+        //Applies a frame of len bytes to the state, an invalid one leaves it as it was
+        Result decode(const uint8_t* frame, size_t len) {
+            if (len < HEADER_SIZE || (frame[1] & ~L::ALL_FIELDS) != 0) {
+                synced_ = false;
+                return Result::INVALID;
+            }
+            const uint8_t map = frame[1];
+            size_t expected_len = HEADER_SIZE;
+            for (size_t i = 0; i < L::NUM_FIELDS; ++i) {
+                if (map & (1u << i)) {
+                    expected_len += L::FIELD_SIZES[i];
+                }
+            }
+            if (len != expected_len) {
+                synced_ = false;
+                return Result::INVALID;
+            }
+
+            const uint8_t count = frame[0] & COUNT_MASK;
+            if (map == L::ALL_FIELDS) {
+                synced_ = true;
+            } else if (count != next_count_) {
+                synced_ = false;
+            }
+            next_count_ = (count + 1) & COUNT_MASK;
+
+            bool changed = false;
+            size_t in = HEADER_SIZE;
+            size_t offset = 0;
+            for (size_t i = 0; i < L::NUM_FIELDS; ++i) {
+                const size_t size = L::FIELD_SIZES[i];
+                if (map & (1u << i)) {
+                    if (std::memcmp(&state_[offset], &frame[in], size) != 0) {
+                        std::memcpy(&state_[offset], &frame[in], size);
+                        changed = true;
+                    }
+                    in += size;
+                }
+                offset += size;
+            }
+            return changed ? Result::CHANGED : Result::UNCHANGED;
+        }
+
+        const uint8_t* state() const { return state_; }
+
+        //A frame went missing or arrived broken since the last keyframe
+        bool resync_needed() const { return !synced_; }
+
+    private:
+        uint8_t state_[L::STATE_SIZE]{0};
+        uint8_t next_count_{0};
+        bool synced_{false};
+    };
+
+} // namespace pad_delta
+
+#endif // _OGXM_PAD_DELTA_H_
@@ -307,8 +307,8 @@ private:
 
         if (anti_r_scale > FIX_0 && anti_dz_c > FIX_0)
         {
-            Fix16 anti_ellip_scale = anti_ellip_scale / anti_dz_c;
-            Fix16 ellipse_angle = fix16::atan((FIX_1 / anti_ellip_scale) * fix16::tan(fix16::rad2deg(rAngle)));
+            Fix16 anti_ellip_scale = anti_r_scale / anti_dz_c;
+            Fix16 ellipse_angle = fix16::atan((FIX_1 / anti_ellip_scale) * fix16::tan(fix16::deg2rad(rAngle)));
             ellipse_angle = (ellipse_angle < FIX_0) ? FIX_ELLIPSE_DEF : ellipse_angle;
 
             Fix16 ellipse_x = fix16::cos(ellipse_angle);
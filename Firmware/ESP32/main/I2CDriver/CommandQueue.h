@@ -0,0 +1,126 @@
+#ifndef _I2C_COMMAND_QUEUE_H_
+#define _I2C_COMMAND_QUEUE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+
+/*  Commands for the i2c task, filled from the Bluetooth thread.
+
+    Every slot (pad index) holds the newest control packet, pad and read request, each in its own
+    LatestValue. A newer one replaces one the i2c task hasn't taken yet, that's counted as
+    coalesced. Nothing is ever pushed out to make room, so a control packet can only be replaced
+    by a newer control packet for the same slot. No allocations, no locks. */
+
+//Single producer, single consumer triple buffer
+template <typename Type>
+class LatestValue
+{
+public:
+    //True if it replaced a value that wasn't taken
+    bool store(const Type& value)
+    {
+        buffers_[back_] = value;
+        const uint8_t previous = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel);
+        back_ = previous & INDEX_MASK;
+        return (previous & FRESH) != 0;
+    }
+
+    bool take(Type& value)
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH))
+        {
+            return false;
+        }
+        const uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = previous & INDEX_MASK;
+        value = buffers_[front_];
+        return true;
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH = 0x04;
+
+    std::array<Type, 3> buffers_{};
+    std::atomic<uint8_t> middle_{1};
+    uint8_t back_{0};   //Producer only
+    uint8_t front_{2};  //Consumer only
+};
+
+template <typename Control, typename Pad, typename Read, size_t NUM_SLOTS>
+class CommandQueue
+{
+public:
+    enum Kind : uint8_t { CONTROL = 0, PAD, READ, NUM_KINDS };
+
+    struct Stats
+    {
+        uint32_t pushed[NUM_KINDS]{0};
+        uint32_t coalesced[NUM_KINDS]{0};
+        uint32_t failed[NUM_KINDS]{0};  //Taken but the transfer failed, counted by the consumer
+        uint32_t dropped{0};    //Slot out of range
+    };
+
+    //Producer
+
+    bool push_control(size_t slot, const Control& control) { return push(slot, CONTROL, &Slot::control, control); }
+    bool push_pad(size_t slot, const Pad& pad) { return push(slot, PAD, &Slot::pad, pad); }
+    bool push_read(size_t slot, const Read& read) { return push(slot, READ, &Slot::read, read); }
+
+    //Consumer
+
+    bool take_control(size_t slot, Control& control) { return slots_[slot].control.take(control); }
+    bool take_pad(size_t slot, Pad& pad) { return slots_[slot].pad.take(pad); }
+    bool take_read(size_t slot, Read& read) { return slots_[slot].read.take(read); }
+    void count_failed(Kind kind) { failed_[kind].fetch_add(1, std::memory_order_relaxed); }
+
+    //Any thread, counts since boot
+    Stats stats() const
+    {
+        Stats stats;
+        for (size_t i = 0; i < NUM_KINDS; ++i)
+        {
+            stats.pushed[i] = pushed_[i].load(std::memory_order_relaxed);
+            stats.coalesced[i] = coalesced_[i].load(std::memory_order_relaxed);
+            stats.failed[i] = failed_[i].load(std::memory_order_relaxed);
+        }
+        stats.dropped = dropped_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    static constexpr size_t num_slots() { return NUM_SLOTS; }
+
+private:
+    struct Slot
+    {
+        LatestValue<Control> control;
+        LatestValue<Pad> pad;
+        LatestValue<Read> read;
+    };
+
+    std::array<Slot, NUM_SLOTS> slots_;
+    std::atomic<uint32_t> pushed_[NUM_KINDS]{};
+    std::atomic<uint32_t> coalesced_[NUM_KINDS]{};
+    std::atomic<uint32_t> failed_[NUM_KINDS]{};
+    std::atomic<uint32_t> dropped_{0};
+
+    template <typename Type>
+    bool push(size_t slot, Kind kind, LatestValue<Type> Slot::* member, const Type& value)
+    {
+        if (slot >= NUM_SLOTS)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        pushed_[kind].fetch_add(1, std::memory_order_relaxed);
+        if ((slots_[slot].*member).store(value))
+        {
+            coalesced_[kind].fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+};
+
+#endif // _I2C_COMMAND_QUEUE_H_
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/timers.h>
 #include <driver/gpio.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 
+#include "Board/ogxm_log.h"
 #include "I2CDriver/I2CDriver.h"
 
 I2CDriver::~I2CDriver()
@@ -38,35 +41,238 @@ void I2CDriver::initialize_i2c(i2c_port_t i2c_port, gpio_num_t sda, gpio_num_t s
 
 void I2CDriver::run_tasks()
 {
-    std::function<void()> task;
+    WriteCommand write;
+    ReadCommand read;
+    TickType_t stats_logged = xTaskGetTickCount();
+
+    //Commands queued before this are drained by the first pass
+    task_.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
 
     while (true)
     {   
-        while (task_queue_.pop(task))
+        bool control_pending = false;
+        for (size_t slot = 0; slot < queue_.num_slots(); ++slot)
         {
-            task();
+            control_pending = send_control(slot) || control_pending;
+            //The read goes after the pad so the pico has this index's PadOut staged
+            const bool have_read = queue_.take_read(slot, read);
+            if (queue_.take_pad(slot, write))
+            {
+                write_pad_now(write, have_read ? &read : nullptr);
+            }
+            else if (have_read)
+            {
+                read_now(read);
+            }
         }
 
-        vTaskDelay(1);
+        const TickType_t since_log = xTaskGetTickCount() - stats_logged;
+        if (since_log >= pdMS_TO_TICKS(STATS_LOG_MS))
+        {
+            stats_logged = xTaskGetTickCount();
+            log_stats();
+            continue;
+        }
+
+        //Anything pushed since the pass above left a notification pending, this returns at once
+        const TickType_t until_log = pdMS_TO_TICKS(STATS_LOG_MS) - since_log;
+        ulTaskNotifyTake(pdTRUE, control_pending ? std::min(until_log, pdMS_TO_TICKS(CONTROL_RETRY_MS)) : until_log);
+    }
+}
+
+bool I2CDriver::send_control(size_t slot)
+{
+    if (queue_.take_control(slot, controls_[slot]))
+    {
+        control_pending_[slot] = true;
+    }
+    if (!control_pending_[slot])
+    {
+        return false;
+    }
+
+    const WriteCommand& control = controls_[slot];
+    if (transfer(control.address, reinterpret_cast<const uint8_t*>(&control.packet_in), sizeof(PacketIn), nullptr, 0) != ESP_OK)
+    {
+        queue_.count_failed(Queue::CONTROL);
+        return true;
+    }
+    control_pending_[slot] = false;
+    return false;
+}
+
+void I2CDriver::notify_task()
+{
+    TaskHandle_t task = task_.load(std::memory_order_acquire);
+    if (task)
+    {
+        xTaskNotifyGive(task);
     }
 }
 
 void I2CDriver::write_packet(uint8_t address, const PacketIn& data_in) 
 {
-    task_queue_.push([this, address, data_in]() 
+    WriteCommand command;
+    command.address = address;
+    command.packet_in = data_in;
+    queue_.push_control(data_in.index, command);
+    notify_task();
+}
+
+void I2CDriver::write_pad(uint8_t address, const PacketIn& data_in, int64_t received_us) 
+{
+    WriteCommand command;
+    command.address = address;
+    command.received_us = received_us;
+    command.packet_in = data_in;
+    queue_.push_pad(data_in.index, command);
+    notify_task();
+}
+
+void I2CDriver::read_packet(uint8_t address, uint8_t index, ReadCallback callback, void* context) 
+{
+    ReadCommand command;
+    command.address = address;
+    command.callback = callback;
+    command.context = context;
+    queue_.push_read(index, command);
+    notify_task();
+}
+
+//Write, then read after a repeated start, either can be left out.
+//The link lives in link_buffer_ so nothing is allocated per transaction
+esp_err_t I2CDriver::transfer(uint8_t address, const uint8_t* write, size_t write_len, uint8_t* read, size_t read_len)
+{
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create_static(link_buffer_.data(), link_buffer_.size());
+    if (write_len > 0)
     {
-        i2c_write_blocking(address, reinterpret_cast<const uint8_t*>(&data_in), sizeof(PacketIn));
-    });
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
+        i2c_master_write(cmd, write, write_len, true);
+    }
+    if (read_len > 0)
+    {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_READ, true);
+        i2c_master_read(cmd, read, read_len, I2C_MASTER_LAST_NACK);
+    }
+    i2c_master_stop(cmd);
+
+    esp_err_t ret = i2c_master_cmd_begin(i2c_port_, cmd, pdMS_TO_TICKS(TIMEOUT_MS));
+    i2c_cmd_link_delete_static(cmd);
+    return ret;
 }
 
-void I2CDriver::read_packet(uint8_t address, std::function<void(const PacketOut&)> callback) 
+esp_err_t I2CDriver::send_pad(uint8_t address, uint8_t index, const PacketIn& data_in, PacketOut* reply)
 {
-    task_queue_.push([this, address, callback]() 
+    constexpr size_t HEADER_SIZE = 2;
+    uint8_t buffer[HEADER_SIZE + PadLayout::FRAME_SIZE_MAX];
+
+    const size_t frame_len = encoders_[index].encode(
+        reinterpret_cast<const uint8_t*>(&data_in) + offsetof(PacketIn, dpad), index, &buffer[HEADER_SIZE]);
+    buffer[0] = static_cast<uint8_t>(HEADER_SIZE + frame_len);
+    buffer[1] = static_cast<uint8_t>(PacketID::SET_PAD_DELTA);
+
+    esp_err_t ret = transfer(address, buffer, buffer[0], 
+                             reinterpret_cast<uint8_t*>(reply), reply ? sizeof(PacketOut) : 0);
+    if (ret != ESP_OK)
     {
-        PacketOut data_out;
-        if (i2c_read_blocking(address, reinterpret_cast<uint8_t*>(&data_out), sizeof(PacketOut)) == ESP_OK)
+        //The pico may or may not have it, the next frame can't build on it
+        encoders_[index].force_keyframe();
+    }
+    return ret;
+}
+
+void I2CDriver::write_pad_now(const WriteCommand& command, const ReadCommand* read)
+{
+    const PacketIn& data_in = command.packet_in;
+    last_pads_[data_in.index] = data_in;
+    pad_sent_[data_in.index] = true;
+
+    PacketOut data_out;
+    PacketOut* reply = (read && read->address == command.address) ? &data_out : nullptr;
+    const int64_t started_us = esp_timer_get_time();
+
+    //Pads are only sent on change, a lost one would otherwise stick until the next
+    esp_err_t ret = send_pad(command.address, data_in.index, data_in, reply);
+    if (ret != ESP_OK)
+    {
+        ret = send_pad(command.address, data_in.index, data_in, reply);
+    }
+
+    if (ret == ESP_OK && command.received_us > 0)
+    {
+        const int64_t to_wire_us = started_us - command.received_us;
+        const int64_t to_done_us = esp_timer_get_time() - command.received_us;
+        ++latency_.pads;
+        latency_.to_wire_sum_us += to_wire_us;
+        latency_.to_done_sum_us += to_done_us;
+        latency_.to_wire_max_us = std::max(latency_.to_wire_max_us, to_wire_us);
+        latency_.to_done_max_us = std::max(latency_.to_done_max_us, to_done_us);
+    }
+
+    if (ret != ESP_OK)
+    {
+        queue_.count_failed(Queue::PAD);
+    }
+
+    if (reply)
+    {
+        if (ret == ESP_OK)
         {
-            callback(data_out);
+            handle_reply(*read, data_out);
         }
-    });
-}
\ No newline at end of file
+        else
+        {
+            queue_.count_failed(Queue::READ);
+        }
+    }
+    else if (read)
+    {
+        read_now(*read);
+    }
+}
+
+void I2CDriver::read_now(const ReadCommand& command)
+{
+    PacketOut data_out;
+    if (transfer(command.address, nullptr, 0, reinterpret_cast<uint8_t*>(&data_out), sizeof(PacketOut)) != ESP_OK)
+    {
+        queue_.count_failed(Queue::READ);
+        return;
+    }
+    handle_reply(command, data_out);
+}
+
+void I2CDriver::handle_reply(const ReadCommand& command, const PacketOut& data_out)
+{
+    //Nothing to resend before this slot's first pad, that one goes out as a keyframe anyway
+    if (data_out.resync && data_out.index < encoders_.size() && pad_sent_[data_out.index])
+    {
+        encoders_[data_out.index].force_keyframe();
+        send_pad(command.address, data_out.index, last_pads_[data_out.index], nullptr);
+    }
+    if (command.callback)
+    {
+        command.callback(command.context, data_out);
+    }
+}
+
+void I2CDriver::log_stats()
+{
+    [[maybe_unused]] const Queue::Stats stats = queue_.stats();
+    OGXM_LOG("I2C queue: control %u/%u/%u, pad %u/%u/%u, read %u/%u/%u (pushed/coalesced/failed), %u dropped\n",
+             stats.pushed[Queue::CONTROL], stats.coalesced[Queue::CONTROL], stats.failed[Queue::CONTROL],
+             stats.pushed[Queue::PAD], stats.coalesced[Queue::PAD], stats.failed[Queue::PAD],
+             stats.pushed[Queue::READ], stats.coalesced[Queue::READ], stats.failed[Queue::READ],
+             stats.dropped);
+
+    if (latency_.pads > 0)
+    {
+        OGXM_LOG("I2C latency: %u pads, report to wire avg %u us max %u us, to sent avg %u us max %u us\n",
+                 latency_.pads,
+                 static_cast<uint32_t>(latency_.to_wire_sum_us / latency_.pads), static_cast<uint32_t>(latency_.to_wire_max_us),
+                 static_cast<uint32_t>(latency_.to_done_sum_us / latency_.pads), static_cast<uint32_t>(latency_.to_done_max_us));
+    }
+    latency_ = LatencyStats();
+}
@@ -3,11 +3,16 @@
 
 #include <cstdint>
 #include <cstring>
-#include <functional>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include <driver/i2c.h>
 
 #include "sdkconfig.h"
-#include "RingBuffer.h"
+#include "Board/pad_delta.h"
+#include "I2CDriver/CommandQueue.h"
 #include "UserSettings/DeviceDriverTypes.h"
 
 class I2CDriver 
@@ -20,7 +25,8 @@ public:
         true;
 #endif
 
-    enum class PacketID : uint8_t { UNKNOWN = 0, SET_PAD, GET_PAD, SET_DRIVER };
+    //SET_PAD_DELTA is [packet_len][packet_id][pad_delta frame] with the pad index as the stream
+    enum class PacketID : uint8_t { UNKNOWN = 0, SET_PAD, GET_PAD, SET_DRIVER, SET_PAD_DELTA };
     enum class PacketResp : uint8_t { OK = 1, ERROR };
 
     #pragma pack(push, 1)
@@ -42,6 +48,10 @@ public:
     };
     static_assert(sizeof(PacketIn) == 32, "PacketIn is misaligned");
 
+    //dpad through joystick_ry
+    using PadLayout = pad_delta::Layout<1, 2, 2, 4, 4>;
+    static_assert(offsetof(PacketIn, reserved1) - offsetof(PacketIn, dpad) == PadLayout::STATE_SIZE, "PadLayout doesn't match PacketIn");
+
     struct PacketOut
     {
         uint8_t packet_len{0};
@@ -49,60 +59,89 @@ public:
         uint8_t index{0};
         uint8_t rumble_l{0};
         uint8_t rumble_r{0};
-        std::array<uint8_t, 3> reserved{0};
+        bool resync{false}; //Pico lost a delta for this index
+        std::array<uint8_t, 2> reserved{0};
     };
     static_assert(sizeof(PacketOut) == 8, "PacketOut is misaligned");
     #pragma pack(pop)
 
+    //Called on the i2c task
+    using ReadCallback = void (*)(void* context, const PacketOut& packet_out);
+
     I2CDriver() = default;
     ~I2CDriver();
 
     void initialize_i2c(i2c_port_t i2c_port, gpio_num_t sda, gpio_num_t scl, uint32_t clk_speed);
 
-    //Does not return
+    //Does not return, sleeps until a command is queued
     void run_tasks();
 
+    //Queued per data_in.index from one thread (btstack's), the newest of each kind is sent.
+    //Control packets (SET_DRIVER) go out before the pad, reads after it
     void write_packet(uint8_t address, const PacketIn& data_in);
-    void read_packet(uint8_t address, std::function<void(const PacketOut&)> callback);
+    //Sends only what changed since the last pad for data_in.index. received_us is when the
+    //controller report came in (esp_timer_get_time()), 0 leaves it out of the latency stats
+    void write_pad(uint8_t address, const PacketIn& data_in, int64_t received_us = 0);
+    void read_packet(uint8_t address, uint8_t index, ReadCallback callback, void* context);
 
 private:
-    using TaskQueue = RingBuffer<std::function<void()>, CONFIG_I2C_RING_BUFFER_SIZE>;
-    
-    TaskQueue task_queue_;
-    i2c_port_t i2c_port_ = I2C_NUM_0;
-    bool initialized_ = false;
+    static constexpr uint32_t STATS_LOG_MS = 10000;
+    static constexpr uint32_t TIMEOUT_MS = 2;
+    static constexpr uint32_t CONTROL_RETRY_MS = 10;
 
-    static inline esp_err_t i2c_write_blocking(uint8_t address, const uint8_t* buffer, size_t len) 
+    struct WriteCommand
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_WRITE, true);
-        i2c_master_write(cmd, buffer, len, true);
-        i2c_master_stop(cmd);
-
-        esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, pdMS_TO_TICKS(2));
-        i2c_cmd_link_delete(cmd);
-        return ret;
-    }
-
-    static inline esp_err_t i2c_read_blocking(uint8_t address, uint8_t* buffer, size_t len) 
+        uint8_t address{0};
+        int64_t received_us{0};
+        PacketIn packet_in;
+    };
+
+    struct ReadCommand
     {
-        i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-        i2c_master_start(cmd);
-        i2c_master_write_byte(cmd, (address << 1) | I2C_MASTER_READ, true);
-        
-        if (len > 1) 
-        {
-            i2c_master_read(cmd, buffer, len - 1, I2C_MASTER_ACK);
-        }
-
-        i2c_master_read_byte(cmd, buffer + len - 1, I2C_MASTER_NACK);
-        i2c_master_stop(cmd);
-        
-        esp_err_t ret = i2c_master_cmd_begin(I2C_NUM_0, cmd, pdMS_TO_TICKS(2));
-        i2c_cmd_link_delete(cmd);
-        return ret;
-    }
+        uint8_t address{0};
+        ReadCallback callback{nullptr};
+        void* context{nullptr};
+    };
+
+    using Queue = CommandQueue<WriteCommand, WriteCommand, ReadCommand, pad_delta::NUM_STREAMS>;
+
+    //Controller report to the pad going out, over one STATS_LOG_MS window
+    struct LatencyStats
+    {
+        uint32_t pads{0};
+        int64_t to_wire_sum_us{0};
+        int64_t to_wire_max_us{0};
+        int64_t to_done_sum_us{0};
+        int64_t to_done_max_us{0};
+    };
+
+    Queue queue_;
+    std::atomic<TaskHandle_t> task_{nullptr};
+    i2c_port_t i2c_port_ = I2C_NUM_0;
+    bool initialized_ = false;
+
+    //Only used from the i2c task
+    std::array<pad_delta::Encoder<PadLayout>, pad_delta::NUM_STREAMS> encoders_;
+    std::array<PacketIn, pad_delta::NUM_STREAMS> last_pads_;
+    std::array<bool, pad_delta::NUM_STREAMS> pad_sent_{};
+    //A control packet stays here until it's sent or a newer one for the slot replaces it
+    std::array<WriteCommand, pad_delta::NUM_STREAMS> controls_;
+    std::array<bool, pad_delta::NUM_STREAMS> control_pending_{};
+    LatencyStats latency_;
+    //Command link storage, a transaction is at most a write and a read
+    std::array<uint8_t, I2C_LINK_RECOMMENDED_SIZE(2)> link_buffer_;
+
+    void notify_task();
+    //True if the slot still has a control packet to send
+    bool send_control(size_t slot);
+    esp_err_t transfer(uint8_t address, const uint8_t* write, size_t write_len, uint8_t* read, size_t read_len);
+    //index picks the encoder and the stream, not data_in.index
+    esp_err_t send_pad(uint8_t address, uint8_t index, const PacketIn& data_in, PacketOut* reply);
+    //read is answered in the same transaction if it's for the same slave
+    void write_pad_now(const WriteCommand& command, const ReadCommand* read);
+    void read_now(const ReadCommand& command);
+    void handle_reply(const ReadCommand& command, const PacketOut& data_out);
+    void log_stats();
 }; // class I2CDriver
 
 #endif // _I2C_DRIVER_H_
\ No newline at end of file
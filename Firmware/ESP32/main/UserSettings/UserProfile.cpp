@@ -37,4 +37,8 @@ UserProfile::UserProfile()
     analog_off_y = Gamepad::ANALOG_OFF_Y;
     analog_off_lb = Gamepad::ANALOG_OFF_LB;
     analog_off_rb = Gamepad::ANALOG_OFF_RB;
+
+    poll_interval_ms = 0;
+
+    std::memset(turbo, 0, sizeof(turbo));
 }
\ No newline at end of file
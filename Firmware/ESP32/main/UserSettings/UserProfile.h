@@ -5,6 +5,7 @@
 
 #include "UserSettings/JoystickSettings.h"
 #include "UserSettings/TriggerSettings.h"   
+#include "UserSettings/OutputCurveSettings.h"
 
 #pragma pack(push, 1)
 struct UserProfile
@@ -47,9 +48,18 @@ struct UserProfile
     uint8_t analog_off_lb;
     uint8_t analog_off_rb;
 
+    uint8_t poll_interval_ms; //1, 2, 4 or 8, 0 keeps the interval of the device driver
+
+    OutputCurveRaw output_curve_l;
+    OutputCurveRaw output_curve_r;
+
+    //Per button in Gamepad::BUTTON_* bit order, high nibble a TurboEngine::RATES_HZ index (0 off),
+    //low nibble on time in 16ths of the period (0 for half)
+    uint8_t turbo[12];
+
     UserProfile();
 };
-static_assert(sizeof(UserProfile) == 190, "UserProfile struct size mismatch");
+static_assert(sizeof(UserProfile) == 239, "UserProfile struct size mismatch");
 #pragma pack(pop)
 
 #endif // _USER_PROFILE_H_
\ No newline at end of file
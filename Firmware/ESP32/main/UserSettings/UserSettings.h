@@ -42,7 +42,8 @@ private:
     UserSettings& operator=(const UserSettings&) = delete;
 
     static constexpr uint8_t GP_CHECK_COUNT = 3000 / GP_CHECK_DELAY_MS;
-    static constexpr uint8_t INIT_FLAG = 0x12;
+    //One bump for the poll interval, output curve and turbo fields together, profiles are wiped once
+    static constexpr uint8_t INIT_FLAG = 0x13;
 
     NVSHelper& nvs_helper_{NVSHelper::get_instance()};
     DeviceDriverType current_driver_{DeviceDriverType::NONE};
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "Bench.h"
+
+namespace Bench {
+
+static bool _csv = false;
+static std::string _filter;
+static bool _failed = false;
+
+InstrCounter::InstrCounter()
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+InstrCounter::~InstrCounter()
+{
+    if (fd_ >= 0)
+    {
+        close(fd_);
+    }
+}
+
+void InstrCounter::start()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+}
+
+uint64_t InstrCounter::stop()
+{
+    if (fd_ < 0)
+    {
+        return 0;
+    }
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+
+    uint64_t count = 0;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count))
+    {
+        return 0;
+    }
+    return count;
+}
+
+InstrCounter& instr_counter()
+{
+    static InstrCounter counter;
+    return counter;
+}
+
+void set_csv(bool csv)
+{
+    _csv = csv;
+}
+
+bool csv()
+{
+    return _csv;
+}
+
+void set_filter(const std::string& filter)
+{
+    _filter = filter;
+}
+
+bool enabled(const std::string& suite, const std::string& name)
+{
+    return _filter.empty() || 
+           (suite.find(_filter) != std::string::npos) || 
+           (name.find(_filter) != std::string::npos);
+}
+
+void fail(const std::string& suite, const std::string& what)
+{
+    _failed = true;
+    std::fprintf(stderr, "FAIL [%s] %s\n", suite.c_str(), what.c_str());
+}
+
+bool failed()
+{
+    return _failed;
+}
+
+void print_header(const std::string& suite)
+{
+    if (_csv)
+    {
+        static bool printed = false;
+        if (!printed)
+        {
+            std::printf("suite,profile,function,ns_per_sample,instr_per_sample\n");
+            printed = true;
+        }
+        return;
+    }
+    std::printf("\n[%s]\n", suite.c_str());
+    std::printf("%-22s %-44s %12s %14s\n", "profile", "function", "ns/sample", "instr/sample");
+}
+
+void print_row(const std::string& suite, const std::string& profile, const std::string& name, const Result& result)
+{
+    char instr[32];
+    if (result.instr_per_sample < 0.0)
+    {
+        std::snprintf(instr, sizeof(instr), "n/a");
+    }
+    else
+    {
+        std::snprintf(instr, sizeof(instr), "%.1f", result.instr_per_sample);
+    }
+
+    if (_csv)
+    {
+        std::printf("%s,%s,%s,%.2f,%s\n", suite.c_str(), profile.c_str(), name.c_str(), result.ns_per_sample, instr);
+    }
+    else
+    {
+        std::printf("%-22s %-44s %12.2f %14s\n", profile.c_str(), name.c_str(), result.ns_per_sample, instr);
+    }
+    std::fflush(stdout);
+}
+
+} // namespace Bench
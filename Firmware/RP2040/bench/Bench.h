@@ -0,0 +1,95 @@
+#ifndef _OGXM_BENCH_H_
+#define _OGXM_BENCH_H_
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+namespace Bench {
+
+    struct Result
+    {
+        double ns_per_sample{0.0};
+        double instr_per_sample{-1.0}; //Negative if the instruction counter is unavailable
+    };
+
+    //Counts retired user-space instructions with perf_event_open, 
+    //falls back to timing only if the kernel doesn't allow it
+    class InstrCounter
+    {
+    public:
+        InstrCounter();
+        ~InstrCounter();
+
+        bool available() const { return fd_ >= 0; }
+        void start();
+        uint64_t stop();
+
+    private:
+        int fd_{-1};
+    };
+
+    InstrCounter& instr_counter();
+
+    //Keeps the compiler from discarding results
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    void set_csv(bool csv);
+    bool csv();
+    void set_filter(const std::string& filter);
+    bool enabled(const std::string& suite, const std::string& name);
+
+    //Suites that verify something call fail(), main() exits non-zero if any did
+    void fail(const std::string& suite, const std::string& what);
+    bool failed();
+
+    void print_header(const std::string& suite);
+    void print_row(const std::string& suite, const std::string& profile, const std::string& name, const Result& result);
+
+    //Runs func(i) for every sample index, repeating until min_ns has elapsed
+    template <typename Func>
+    Result run(size_t num_samples, Func&& func, uint64_t min_ns = 50'000'000)
+    {
+        InstrCounter& counter = instr_counter();
+
+        //Warm up
+        for (size_t i = 0; i < num_samples; ++i)
+        {
+            func(i);
+        }
+
+        uint64_t iterations = 0;
+        uint64_t instructions = 0;
+        auto start = std::chrono::steady_clock::now();
+        uint64_t elapsed_ns = 0;
+
+        do
+        {
+            counter.start();
+            for (size_t i = 0; i < num_samples; ++i)
+            {
+                func(i);
+            }
+            instructions += counter.stop();
+            ++iterations;
+
+            elapsed_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        } 
+        while (elapsed_ns < min_ns);
+
+        const double total = static_cast<double>(iterations) * static_cast<double>(num_samples);
+
+        Result result;
+        result.ns_per_sample = static_cast<double>(elapsed_ns) / total;
+        result.instr_per_sample = counter.available() ? (static_cast<double>(instructions) / total) : -1.0;
+        return result;
+    }
+
+} // namespace Bench
+
+#endif // _OGXM_BENCH_H_
@@ -0,0 +1,143 @@
+#include "BenchHIDDescriptors.h"
+
+namespace BenchHIDDescriptors {
+
+//8 bit axes, hat, 12 buttons and a vendor byte, no report IDs. Cheap DInput pads look like this
+const Descriptor& generic_pad()
+{
+    static const Descriptor descriptor =
+    {
+        "generic 8 bit pad",
+        {
+            0x05, 0x01, 0x09, 0x04, 0xA1, 0x01,
+            0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04,
+            0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02,
+            0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x09, 0x39, 0x81, 0x42,
+            0x25, 0x01, 0x75, 0x01, 0x95, 0x0C, 0x05, 0x09, 0x19, 0x01, 0x29, 0x0C, 0x81, 0x02,
+            0x06, 0x00, 0xFF, 0x75, 0x08, 0x95, 0x01, 0x09, 0x01, 0x81, 0x02,
+            0xC0
+        },
+        {},
+        7,
+        true
+    };
+    return descriptor;
+}
+
+//Two collections with report IDs, hat and buttons off byte boundaries
+const Descriptor& report_id_pad()
+{
+    static const Descriptor descriptor =
+    {
+        "report id pad",
+        {
+            0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x0D, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0D, 0x81, 0x02,
+            0x05, 0x01, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x09, 0x39, 0x81, 0x42,
+            0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x09, 0x30, 0x09, 0x31, 0x09, 0x33, 0x09, 0x34, 0x81, 0x02,
+            0x75, 0x07, 0x95, 0x01, 0x81, 0x03,
+            0xC0,
+            0x05, 0x01, 0x09, 0x04, 0xA1, 0x01, 0x85, 0x02,
+            0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x02, 0x09, 0x30, 0x09, 0x31, 0x81, 0x02,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x08, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+            0xC0
+        },
+        { 1, 2 },
+        8,
+        true
+    };
+    return descriptor;
+}
+
+//Signed 16 bit axes like the better wired pads send
+const Descriptor& signed_16_pad()
+{
+    static const Descriptor descriptor =
+    {
+        "signed 16 bit pad",
+        {
+            0x05, 0x01, 0x09, 0x05, 0xA1, 0x01,
+            0x16, 0x00, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x04,
+            0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x81, 0x02,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x10, 0x81, 0x02,
+            0xC0
+        },
+        {},
+        10,
+        false
+    };
+    return descriptor;
+}
+
+const std::vector<Descriptor>& hot_plug()
+{
+    static const std::vector<Descriptor> descriptors = []
+    {
+        std::vector<Descriptor> out;
+
+        out.push_back({ "boot keyboard",
+            {
+                0x05, 0x01, 0x09, 0x06, 0xA1, 0x01,
+                0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+                0x95, 0x01, 0x75, 0x08, 0x81, 0x01,
+                0x95, 0x05, 0x75, 0x01, 0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02,
+                0x95, 0x01, 0x75, 0x03, 0x91, 0x01,
+                0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00,
+                0xC0
+            },
+            {}, 0, false });
+
+        out.push_back({ "mouse",
+            {
+                0x05, 0x01, 0x09, 0x02, 0xA1, 0x01, 0x09, 0x01, 0xA1, 0x00,
+                0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01, 0x81, 0x02,
+                0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+                0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38, 0x15, 0x81, 0x25, 0x7F, 0x75, 0x08, 0x95, 0x03, 0x81, 0x06,
+                0xC0, 0xC0
+            },
+            {}, 0, false });
+
+        out.push_back({ "vendor 64 byte in/out/feature",
+            {
+                0x06, 0x00, 0xFF, 0x09, 0x01, 0xA1, 0x01,
+                0x85, 0x01, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x3F, 0x09, 0x01, 0x81, 0x02,
+                0x09, 0x01, 0x91, 0x02,
+                0x85, 0x02, 0x09, 0x02, 0x95, 0x3F, 0xB1, 0x02,
+                0x85, 0x03, 0x09, 0x03, 0x95, 0x3F, 0xB1, 0x02,
+                0xC0
+            },
+            {}, 0, false });
+
+        //Gamepad input report 1 then a feature report per ID, like a DualShock 4
+        Descriptor ds4 = { "ds4 style gamepad", {}, { 1 }, 64, true };
+        ds4.data =
+        {
+            0x05, 0x01, 0x09, 0x05, 0xA1, 0x01, 0x85, 0x01,
+            0x09, 0x30, 0x09, 0x31, 0x09, 0x32, 0x09, 0x35, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x04, 0x81, 0x02,
+            0x09, 0x39, 0x15, 0x00, 0x25, 0x07, 0x75, 0x04, 0x95, 0x01, 0x81, 0x42,
+            0x05, 0x09, 0x19, 0x01, 0x29, 0x0E, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x0E, 0x81, 0x02,
+            0x06, 0x00, 0xFF, 0x09, 0x20, 0x75, 0x06, 0x95, 0x01, 0x15, 0x00, 0x25, 0x7F, 0x81, 0x02,
+            0x05, 0x01, 0x09, 0x33, 0x09, 0x34, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x95, 0x02, 0x81, 0x02,
+            0x06, 0x00, 0xFF, 0x09, 0x21, 0x95, 0x36, 0x81, 0x02,
+            0x85, 0x05, 0x09, 0x22, 0x95, 0x1F, 0x91, 0x02,
+        };
+        const uint8_t feature_ids[] =
+        {
+            0x04, 0x02, 0x08, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86,
+            0x87, 0x88, 0x89, 0x90, 0x91, 0x92, 0x93, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7, 0xA8,
+            0xA9, 0xAA, 0xAB, 0xAC, 0xAD, 0xB0, 0xF0, 0xF1, 0xF2
+        };
+        for (uint8_t id : feature_ids)
+        {
+            const uint8_t count = static_cast<uint8_t>(0x24 + (id % 0x1C));
+            ds4.data.insert(ds4.data.end(), { 0x85, id, 0x09, static_cast<uint8_t>(id & 0x7F), 0x95, count, 0xB1, 0x02 });
+        }
+        ds4.data.push_back(0xC0);
+        out.push_back(ds4);
+
+        return out;
+    }();
+    return descriptors;
+}
+
+} // namespace BenchHIDDescriptors
@@ -0,0 +1,29 @@
+#ifndef _OGXM_BENCH_HID_DESCRIPTORS_H_
+#define _OGXM_BENCH_HID_DESCRIPTORS_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace BenchHIDDescriptors {
+
+    struct Descriptor
+    {
+        const char* name;
+        std::vector<uint8_t> data;
+        std::vector<uint8_t> report_ids; //Joystick/gamepad input report IDs, empty if the device doesn't use them
+        uint16_t report_len;             //Longest joystick/gamepad input report, 0 if there isn't one
+        bool compare_parse_data;         //parseData overflows int32 mapping 16 bit axes, check those against the exact mapping instead
+    };
+
+    //Gamepads the report plan is checked and timed on
+    const Descriptor& generic_pad();
+    const Descriptor& report_id_pad();
+    const Descriptor& signed_16_pad();
+
+    //What a multi interface device hands the host one after another: keyboard, mouse,
+    //vendor, and a DualShock 4 style gamepad with dozens of vendor feature reports
+    const std::vector<Descriptor>& hot_plug();
+
+} // namespace BenchHIDDescriptors
+
+#endif // _OGXM_BENCH_HID_DESCRIPTORS_H_
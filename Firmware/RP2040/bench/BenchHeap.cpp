@@ -0,0 +1,71 @@
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include <malloc.h>
+
+#include "BenchHeap.h"
+
+namespace {
+
+    std::atomic<int64_t> heap_live{0};
+    std::atomic<int64_t> heap_peak{0};
+    std::atomic<uint64_t> heap_allocs{0};
+
+} // namespace
+
+namespace BenchHeap {
+
+int64_t live()
+{
+    return heap_live.load(std::memory_order_relaxed);
+}
+
+int64_t peak()
+{
+    return heap_peak.load(std::memory_order_relaxed);
+}
+
+uint64_t allocs()
+{
+    return heap_allocs.load(std::memory_order_relaxed);
+}
+
+void reset_peak()
+{
+    heap_peak.store(heap_live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+} // namespace BenchHeap
+
+void* operator new(size_t size)
+{
+    void* memory = std::malloc(size ? size : 1);
+    if (!memory)
+    {
+        throw std::bad_alloc();
+    }
+    const int64_t live = heap_live.fetch_add(static_cast<int64_t>(malloc_usable_size(memory)), std::memory_order_relaxed) +
+                         static_cast<int64_t>(malloc_usable_size(memory));
+    int64_t peak = heap_peak.load(std::memory_order_relaxed);
+    while (live > peak && !heap_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    heap_allocs.fetch_add(1, std::memory_order_relaxed);
+    return memory;
+}
+
+//GCC pairs the free() below with the new expressions that call this, not the malloc() above
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void operator delete(void* memory) noexcept
+{
+    if (memory)
+    {
+        heap_live.fetch_sub(static_cast<int64_t>(malloc_usable_size(memory)), std::memory_order_relaxed);
+        std::free(memory);
+    }
+}
+#pragma GCC diagnostic pop
+
+void operator delete(void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
@@ -0,0 +1,17 @@
+#ifndef _OGXM_BENCH_HEAP_H_
+#define _OGXM_BENCH_HEAP_H_
+
+#include <cstdint>
+
+//operator new/delete for the whole bench are replaced in BenchHeap.cpp to count heap use,
+//suites read the counters around whatever they measure
+namespace BenchHeap {
+
+    int64_t live();     //Bytes currently allocated through operator new
+    int64_t peak();     //High water mark of live() since the last reset_peak()
+    uint64_t allocs();  //operator new calls since start
+    void reset_peak();
+
+} // namespace BenchHeap
+
+#endif // _OGXM_BENCH_HEAP_H_
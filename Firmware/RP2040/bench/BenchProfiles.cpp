@@ -0,0 +1,172 @@
+#include <cmath>
+
+#include "BenchProfiles.h"
+
+namespace BenchProfiles {
+
+static constexpr size_t NUM_SAMPLES = 4096;
+
+//Deterministic so runs are comparable
+static uint32_t lcg_next(uint32_t& state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state;
+}
+
+const std::vector<JoyProfile>& joystick_profiles()
+{
+    static const std::vector<JoyProfile> profiles = [] 
+    {
+        std::vector<JoyProfile> out;
+
+        JoystickSettingsRaw raw;
+        out.push_back({ "default", raw });
+
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.08);
+        out.push_back({ "deadzone", raw });
+
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.08);
+        raw.curve = F16(1.5);
+        out.push_back({ "deadzone+curve", raw });
+
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.05);
+        raw.anti_dz_circle = F16(0.2);
+        raw.anti_dz_square = F16(0.1);
+        out.push_back({ "anti-deadzone", raw });
+
+        //axis_restrict and angle_restrict are scaled by 100 in Gamepad::set_profile_settings
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.05);
+        raw.axis_restrict = F16(0.001);
+        raw.angle_restrict = F16(0.1);
+        out.push_back({ "axis+angle restrict", raw });
+
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.05);
+        raw.diag_scale_min = F16(1.0);
+        raw.diag_scale_max = F16(1.25);
+        out.push_back({ "diagonal scaling", raw });
+
+        raw = JoystickSettingsRaw();
+        raw.dz_inner = F16(0.08);
+        raw.dz_outer = F16(0.95);
+        raw.anti_dz_circle = F16(0.15);
+        raw.anti_dz_square = F16(0.1);
+        raw.anti_dz_square_y_scale = F16(0.12);
+        raw.anti_dz_outer = F16(0.98);
+        raw.axis_restrict = F16(0.001);
+        raw.angle_restrict = F16(0.1);
+        raw.diag_scale_min = F16(1.0);
+        raw.diag_scale_max = F16(1.25);
+        raw.curve = F16(1.5);
+        raw.uncap_radius = 0;
+        out.push_back({ "full", raw });
+
+        return out;
+    }();
+    return profiles;
+}
+
+const std::vector<TrigProfile>& trigger_profiles()
+{
+    static const std::vector<TrigProfile> profiles = [] 
+    {
+        std::vector<TrigProfile> out;
+
+        TriggerSettingsRaw raw;
+        out.push_back({ "default", raw });
+
+        raw = TriggerSettingsRaw();
+        raw.dz_inner = F16(0.1);
+        out.push_back({ "deadzone", raw });
+
+        raw = TriggerSettingsRaw();
+        raw.dz_inner = F16(0.1);
+        raw.curve = F16(1.5);
+        out.push_back({ "deadzone+curve", raw });
+
+        raw = TriggerSettingsRaw();
+        raw.dz_inner = F16(0.05);
+        raw.dz_outer = F16(0.95);
+        raw.anti_dz_inner = F16(0.1);
+        raw.anti_dz_outer = F16(0.9);
+        raw.curve = F16(1.5);
+        out.push_back({ "full", raw });
+
+        return out;
+    }();
+    return profiles;
+}
+
+const std::vector<std::pair<int16_t, int16_t>>& joystick_samples()
+{
+    static const std::vector<std::pair<int16_t, int16_t>> samples = [] 
+    {
+        std::vector<std::pair<int16_t, int16_t>> out;
+        out.reserve(NUM_SAMPLES);
+        uint32_t state = 0x0617;
+
+        auto polar = [](double angle, double radius) 
+        {
+            double x = std::cos(angle) * radius * 32767.0;
+            double y = std::sin(angle) * radius * 32767.0;
+            return std::make_pair(static_cast<int16_t>(x), static_cast<int16_t>(y));
+        };
+
+        //Resting stick with sensor noise
+        for (size_t i = 0; i < NUM_SAMPLES / 4; ++i)
+        {
+            int16_t x = static_cast<int16_t>(static_cast<int32_t>(lcg_next(state) % 1601) - 800);
+            int16_t y = static_cast<int16_t>(static_cast<int32_t>(lcg_next(state) % 1601) - 800);
+            out.emplace_back(x, y);
+        }
+        //Radial sweeps from center to edge at 16 angles
+        for (size_t i = 0; i < NUM_SAMPLES / 4; ++i)
+        {
+            double angle = (static_cast<double>(i % 16) / 16.0) * 2.0 * M_PI;
+            double radius = static_cast<double>(i / 16) / static_cast<double>(NUM_SAMPLES / 64);
+            out.push_back(polar(angle, radius));
+        }
+        //Full deflection circles
+        for (size_t i = 0; i < NUM_SAMPLES / 4; ++i)
+        {
+            double angle = (static_cast<double>(i) / static_cast<double>(NUM_SAMPLES / 4)) * 2.0 * M_PI;
+            out.push_back(polar(angle, 1.0));
+        }
+        //Anywhere
+        while (out.size() < NUM_SAMPLES)
+        {
+            int16_t x = static_cast<int16_t>(lcg_next(state) >> 16);
+            int16_t y = static_cast<int16_t>(lcg_next(state) >> 16);
+            out.emplace_back(x, y);
+        }
+        return out;
+    }();
+    return samples;
+}
+
+const std::vector<uint8_t>& trigger_samples()
+{
+    static const std::vector<uint8_t> samples = [] 
+    {
+        std::vector<uint8_t> out;
+        out.reserve(NUM_SAMPLES);
+        uint32_t state = 0x7A11;
+
+        for (size_t i = 0; i < NUM_SAMPLES / 2; ++i)
+        {
+            out.push_back(static_cast<uint8_t>(i & 0xFF));
+        }
+        while (out.size() < NUM_SAMPLES)
+        {
+            out.push_back(static_cast<uint8_t>(lcg_next(state) >> 24));
+        }
+        return out;
+    }();
+    return samples;
+}
+
+} // namespace BenchProfiles
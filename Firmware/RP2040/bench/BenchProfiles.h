@@ -0,0 +1,36 @@
+#ifndef _OGXM_BENCH_PROFILES_H_
+#define _OGXM_BENCH_PROFILES_H_
+
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+#include "UserSettings/JoystickSettings.h"
+#include "UserSettings/TriggerSettings.h"
+
+namespace BenchProfiles {
+
+    struct JoyProfile
+    {
+        const char* name;
+        JoystickSettingsRaw settings;
+    };
+
+    struct TrigProfile
+    {
+        const char* name;
+        TriggerSettingsRaw settings;
+    };
+
+    //Sweep of settings as the webapp would store them, from the default (shaping disabled)
+    //up to the full deadzone, anti-deadzone, restrict and diagonal-scaling feature set
+    const std::vector<JoyProfile>& joystick_profiles();
+    const std::vector<TrigProfile>& trigger_profiles();
+
+    //Realistic stick samples: resting noise, radial sweeps, full deflection circles and random positions
+    const std::vector<std::pair<int16_t, int16_t>>& joystick_samples();
+    const std::vector<uint8_t>& trigger_samples();
+
+} // namespace BenchProfiles
+
+#endif // _OGXM_BENCH_PROFILES_H_
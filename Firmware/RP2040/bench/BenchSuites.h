@@ -0,0 +1,22 @@
+#ifndef _OGXM_BENCH_SUITES_H_
+#define _OGXM_BENCH_SUITES_H_
+
+void bench_gamepad();
+void bench_stick_lut();
+void bench_snapshot();
+void bench_taskqueue();
+void bench_hid_plan();
+void bench_hid_arena();
+void bench_hid_plan_cache();
+void bench_heap_soak();
+void bench_feedback();
+void bench_in_pipe();
+void bench_device_poll();
+void bench_sof_sync();
+void bench_mapping();
+void bench_output_curve();
+void bench_turbo();
+void bench_pad_delta();
+void bench_i2c_queue();
+
+#endif // _OGXM_BENCH_SUITES_H_
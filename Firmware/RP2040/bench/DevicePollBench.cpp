@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+
+#include "USBDevice/ConfigDescriptor.h"
+#include "USBDevice/PollMeter.h"
+#include "Descriptors/PS3.h"
+#include "Descriptors/PS4Device.h"
+#include "Descriptors/PSClassic.h"
+#include "Descriptors/XInput.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Configuration descriptors built from the drivers' templates with each poll interval a profile
+//can ask for: only bInterval of the gamepad interface's interrupt endpoints may change. Then
+//the poll meter against a console polling at a known rate, with the pad only sometimes having
+//a report queued and the completion callback running late by up to a quarter frame
+
+namespace {
+
+    struct Template
+    {
+        const char* name;
+        std::vector<uint8_t> desc;
+        uint8_t in_endpoint;
+        uint8_t patched; //Endpoints that should get the interval
+    };
+
+    //What DInput/Switch look like with 2 gamepads, plus a CDC interface that must be left alone
+    std::vector<uint8_t> multi_interface()
+    {
+        std::vector<uint8_t> desc = { 0x09, 0x02, 0x00, 0x00, 0x03, 0x01, 0x00, 0x80, 0xFA };
+        for (uint8_t itf = 0; itf < 2; ++itf)
+        {
+            const uint8_t hid[] =
+            {
+                0x09, 0x04, itf, 0x00, 0x02, 0x03, 0x00, 0x00, 0x00,
+                0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, 0x50, 0x00,
+                0x07, 0x05, static_cast<uint8_t>(0x81 + itf), 0x03, 0x40, 0x00, 0x01,
+                0x07, 0x05, static_cast<uint8_t>(0x01 + itf), 0x03, 0x40, 0x00, 0x01,
+            };
+            desc.insert(desc.end(), std::begin(hid), std::end(hid));
+        }
+        const uint8_t cdc[] =
+        {
+            0x09, 0x04, 0x02, 0x00, 0x01, 0x02, 0x02, 0x00, 0x00,
+            0x07, 0x05, 0x83, 0x03, 0x08, 0x00, 0x10,
+        };
+        desc.insert(desc.end(), std::begin(cdc), std::end(cdc));
+        desc[2] = static_cast<uint8_t>(desc.size());
+        desc[3] = static_cast<uint8_t>(desc.size() >> 8);
+        return desc;
+    }
+
+    std::vector<uint8_t> to_vector(const uint8_t* desc)
+    {
+        return std::vector<uint8_t>(desc, desc + (desc[2] | (desc[3] << 8)));
+    }
+
+    //Offsets of the bInterval bytes allowed to change
+    std::vector<size_t> interval_offsets(const std::vector<uint8_t>& desc)
+    {
+        std::vector<size_t> offsets;
+        uint32_t first_itf = 0xFFFFFFFF;
+        bool gamepad = false;
+        for (size_t offset = desc[0]; offset < desc.size(); offset += desc[offset])
+        {
+            if (desc[offset + 1] == 0x04)
+            {
+                const uint32_t itf = (desc[offset + 5] << 16) | (desc[offset + 6] << 8) | desc[offset + 7];
+                first_itf = (first_itf == 0xFFFFFFFF) ? itf : first_itf;
+                gamepad = (itf == first_itf);
+            }
+            else if (desc[offset + 1] == 0x05 && gamepad && (desc[offset + 3] & 0x03) == 0x03)
+            {
+                offsets.push_back(offset + 6);
+            }
+        }
+        return offsets;
+    }
+
+    uint32_t check_descriptor(const char* suite, const Template& tmpl)
+    {
+        uint32_t errors = 0;
+        const std::vector<size_t> offsets = interval_offsets(tmpl.desc);
+        if (offsets.size() != tmpl.patched)
+        {
+            Bench::fail(suite, std::string(tmpl.name) + " gamepad endpoints found");
+            ++errors;
+        }
+
+        for (uint8_t interval : { 0, 1, 2, 4, 8, 3, 16 })
+        {
+            ConfigDescriptor config;
+            if (!config.build(tmpl.desc.data(), interval))
+            {
+                Bench::fail(suite, std::string(tmpl.name) + " didn't build");
+                ++errors;
+                continue;
+            }
+
+            const uint8_t* built = config.get(tmpl.desc.data());
+            const bool applies = ConfigDescriptor::valid_interval(interval);
+            for (size_t i = 0; i < tmpl.desc.size(); ++i)
+            {
+                bool is_interval = false;
+                for (size_t offset : offsets)
+                {
+                    is_interval |= (offset == i);
+                }
+                const uint8_t expected = (is_interval && applies) ? interval : tmpl.desc[i];
+                if (built[i] != expected)
+                {
+                    Bench::fail(suite, std::string(tmpl.name) + " byte " + std::to_string(i) + " with interval " + std::to_string(interval));
+                    ++errors;
+                    break;
+                }
+            }
+            if (config.in_endpoint() != tmpl.in_endpoint)
+            {
+                Bench::fail(suite, std::string(tmpl.name) + " IN endpoint");
+                ++errors;
+            }
+        }
+        return errors;
+    }
+
+    struct PollResult
+    {
+        uint8_t console_ms;
+        uint32_t queued_pct;
+        uint32_t completions;
+        uint8_t measured_ms;
+    };
+
+    PollResult measure(uint8_t console_ms, uint32_t queued_pct, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        PollMeter meter;
+        const uint32_t window_us = 5000 * 1000;
+
+        for (uint32_t poll_us = 0; poll_us < window_us; poll_us += console_ms * PollMeter::FRAME_US)
+        {
+            if (rng() % 100 < queued_pct)
+            {
+                meter.completed(poll_us + rng() % (PollMeter::FRAME_US / 4));
+            }
+        }
+        return { console_ms, queued_pct, meter.completions(), meter.interval_ms() };
+    }
+
+} // namespace
+
+void bench_device_poll()
+{
+    const char* suite = "device.poll";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const std::vector<Template> templates =
+    {
+        { "ps3",        to_vector(PS3::CONFIGURATION_DESCRIPTORS),       0x81, 2 },
+        { "ps4",        to_vector(PS4Dev::CONFIGURATION_DESCRIPTORS),    0x81, 2 },
+        { "psclassic",  to_vector(PSClassic::CONFIGURATION_DESCRIPTORS), 0x81, 1 },
+        { "xinput",     to_vector(XInput::DESC_CONFIGURATION),           0x81, 2 },
+        { "multi_itf",  multi_interface(),                               0x81, 4 },
+    };
+
+    uint32_t descriptor_errors = 0;
+    for (const Template& tmpl : templates)
+    {
+        descriptor_errors += check_descriptor(suite, tmpl);
+    }
+
+    //Truncated, has to fall back to the template
+    {
+        std::vector<uint8_t> broken = to_vector(PS3::CONFIGURATION_DESCRIPTORS);
+        broken[9 + 9] = 0x40;
+        ConfigDescriptor config;
+        if (config.build(broken.data(), 1) || config.get(broken.data()) != broken.data() || config.in_endpoint() != 0)
+        {
+            Bench::fail(suite, "malformed descriptor wasn't served as is");
+            ++descriptor_errors;
+        }
+    }
+
+    std::vector<PollResult> results;
+    for (uint8_t console_ms : { 1, 2, 4, 8 })
+    {
+        for (uint32_t queued_pct : { 100, 50, 20 })
+        {
+            results.push_back(measure(console_ms, queued_pct, 0xB00 + console_ms * 100 + queued_pct));
+        }
+    }
+
+    if (Bench::csv())
+    {
+        std::printf("suite,descriptor_errors\n%s,%u\n", suite, descriptor_errors);
+        std::printf("suite,console_ms,queued_pct,completions,measured_ms\n");
+        for (const PollResult& result : results)
+        {
+            std::printf("%s,%u,%u,%u,%u\n", suite, result.console_ms, result.queued_pct, result.completions, result.measured_ms);
+        }
+    }
+    else
+    {
+        std::printf("\n[%s] %zu config descriptor templates, %u errors\n", suite, templates.size(), descriptor_errors);
+        std::printf("%12s %12s %12s %12s\n", "console ms", "queued %", "reports", "measured ms");
+        for (const PollResult& result : results)
+        {
+            std::printf("%12u %12u %12u %12u\n", result.console_ms, result.queued_pct, result.completions, result.measured_ms);
+        }
+    }
+
+    for (const PollResult& result : results)
+    {
+        if (result.measured_ms != result.console_ms)
+        {
+            Bench::fail(suite, "console polling every " + std::to_string(result.console_ms) + " ms measured as " +
+                std::to_string(result.measured_ms) + " ms with " + std::to_string(result.queued_pct) + "% queued");
+        }
+    }
+
+    //Nothing sent, nothing measured
+    PollMeter idle;
+    idle.completed(0);
+    if (idle.interval_ms() != 0 || idle.rate_hz() != 0)
+    {
+        Bench::fail(suite, "interval from a single report");
+    }
+}
@@ -0,0 +1,332 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "Board/Config.h"
+#include "Gamepad/Gamepad.h"
+#include "Gamepad/FeedbackLimiter.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Console to controller rumble latency on simulated time. The console side calls
+//Gamepad::set_pad_out, a core1 loop pass runs HostManager::send_feedback's logic against
+//a mocked transport that takes transfer_us per report and refuses sends while it's busy.
+//The old fixed FEEDBACK_REFRESH_MS timer is run on the same writes for comparison
+
+namespace {
+
+    using Feedback = FeedbackLimiter<FEEDBACK_MIN_INTERVAL_US, FEEDBACK_REFRESH_MS * 1000>;
+
+    constexpr uint64_t LOOP_US = 125; //One core1 pass, process_tasks + tuh_task
+    constexpr uint64_t USB_FRAME_US = 1000;
+    constexpr uint64_t MIN_INTERVAL_US = FEEDBACK_MIN_INTERVAL_US;
+    constexpr uint64_t REFRESH_US = FEEDBACK_REFRESH_MS * 1000;
+
+    struct Write
+    {
+        uint64_t time_us;
+        Gamepad::PadOut pad_out;
+    };
+
+    struct Send
+    {
+        uint64_t time_us;
+        Gamepad::PadOut pad_out;
+    };
+
+    //Reads the pad out before checking the endpoint and zeroes short rumble after a send, like PS4Host
+    class MockDriver
+    {
+    public:
+        MockDriver(uint64_t transfer_us)
+            : transfer_us_(transfer_us) {}
+
+        bool send_feedback(Gamepad& gamepad, uint64_t now_us)
+        {
+            ++attempts;
+            Gamepad::PadOut gp_out = gamepad.get_pad_out();
+            if (now_us < busy_until_us_)
+            {
+                return false;
+            }
+            busy_until_us_ = now_us + transfer_us_;
+            sends.push_back({ now_us, gp_out });
+
+            bool reset = false;
+            if (gp_out.rumble_l != Range::MAX<uint8_t>)
+            {
+                gp_out.rumble_l = 0;
+                reset = true;
+            }
+            if (gp_out.rumble_r != Range::MAX<uint8_t>)
+            {
+                gp_out.rumble_r = 0;
+                reset = true;
+            }
+            if (reset)
+            {
+                gamepad.decay_pad_out(gp_out);
+            }
+            return true;
+        }
+
+        std::vector<Send> sends;
+        uint64_t attempts{0};
+
+    private:
+        const uint64_t transfer_us_;
+        uint64_t busy_until_us_{0};
+    };
+
+    enum class Mode { EVENT, TIMER };
+
+    struct Result
+    {
+        uint64_t writes{0};
+        uint64_t sends{0};
+        uint64_t attempts{0};
+        uint64_t p50_us{0};
+        uint64_t p99_us{0};
+        uint64_t max_us{0};
+        uint64_t max_idle_us{0};
+        uint64_t max_decay_us{0};
+        uint64_t min_gap_us{UINT64_MAX};
+        bool final_delivered{false};
+    };
+
+    Gamepad::PadOut make_pad_out(std::mt19937& rng)
+    {
+        Gamepad::PadOut pad_out;
+        //Max rumble holds, anything else is zeroed by the driver after a refresh
+        pad_out.rumble_l = (rng() % 4 == 0) ? Range::MAX<uint8_t> : static_cast<uint8_t>(1 + rng() % 254);
+        pad_out.rumble_r = (rng() % 4 == 0) ? Range::MAX<uint8_t> : static_cast<uint8_t>(rng() % 255);
+        return pad_out;
+    }
+
+    std::vector<Write> make_writes(uint32_t seed, uint32_t count, uint64_t min_gap_us, uint64_t max_gap_us)
+    {
+        std::mt19937 rng(seed);
+        std::vector<Write> writes;
+        uint64_t time_us = 1000;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            time_us += min_gap_us + rng() % (max_gap_us - min_gap_us + 1);
+            writes.push_back({ time_us, make_pad_out(rng) });
+        }
+        return writes;
+    }
+
+    Result simulate(Mode mode, const std::vector<Write>& writes, uint64_t transfer_us)
+    {
+        Gamepad gamepad;
+        Feedback feedback;
+        MockDriver driver(transfer_us);
+        feedback.reset(gamepad.pad_out_event());
+        gamepad.get_pad_out();
+
+        const uint64_t end_us = writes.back().time_us + 2 * REFRESH_US + transfer_us;
+        uint64_t next_timer_us = REFRESH_US;
+        size_t next_write = 0;
+
+        for (uint64_t now_us = 0; now_us <= end_us; now_us += LOOP_US)
+        {
+            while (next_write < writes.size() && writes[next_write].time_us <= now_us)
+            {
+                gamepad.set_pad_out(writes[next_write++].pad_out);
+            }
+
+            if (mode == Mode::EVENT)
+            {
+                const uint32_t event = gamepad.pad_out_event();
+                if (feedback.due(event, gamepad.new_pad_out(), now_us) == Feedback::Due::NONE)
+                {
+                    continue;
+                }
+                if (driver.send_feedback(gamepad, now_us))
+                {
+                    feedback.sent(event, now_us);
+                }
+                else
+                {
+                    feedback.failed(now_us);
+                }
+            }
+            else if (now_us >= next_timer_us)
+            {
+                next_timer_us += REFRESH_US;
+                if (gamepad.new_pad_out())
+                {
+                    driver.send_feedback(gamepad, now_us);
+                }
+            }
+        }
+
+        Result result;
+        result.writes = writes.size();
+        result.sends = driver.sends.size();
+        result.attempts = driver.attempts;
+
+        //A write is delivered by the first send after it, that send carries it or something newer
+        //Idle is a write landing when the controller hasn't been sent anything for a while,
+        //that has to go out in the next frame whatever came before it
+        std::vector<uint64_t> latencies;
+        size_t send_idx = 0;
+        const uint64_t idle_us = std::max(MIN_INTERVAL_US, transfer_us);
+        for (const Write& write : writes)
+        {
+            while (send_idx < driver.sends.size() && driver.sends[send_idx].time_us < write.time_us)
+            {
+                ++send_idx;
+            }
+            if (send_idx < driver.sends.size())
+            {
+                const uint64_t latency_us = driver.sends[send_idx].time_us - write.time_us;
+                latencies.push_back(latency_us);
+                if (send_idx == 0 || (write.time_us - driver.sends[send_idx - 1].time_us) >= idle_us)
+                {
+                    result.max_idle_us = std::max(result.max_idle_us, latency_us);
+                }
+            }
+        }
+        if (!latencies.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            result.p50_us = latencies[latencies.size() / 2];
+            result.p99_us = latencies[(latencies.size() * 99) / 100];
+            result.max_us = latencies.back();
+        }
+        for (size_t i = 1; i < driver.sends.size(); ++i)
+        {
+            result.min_gap_us = std::min(result.min_gap_us, driver.sends[i].time_us - driver.sends[i - 1].time_us);
+        }
+
+        //The first send after the last write has to carry it, not something older
+        const Gamepad::PadOut& last = writes.back().pad_out;
+        result.final_delivered = (latencies.size() == writes.size()) &&
+            std::memcmp(&driver.sends[send_idx].pad_out, &last, sizeof(last)) == 0;
+
+        //Short rumble that nothing replaced has to stop one refresh after it started
+        for (size_t i = 0; i + 1 < driver.sends.size(); ++i)
+        {
+            const Gamepad::PadOut& sent = driver.sends[i].pad_out;
+            const Gamepad::PadOut& next = driver.sends[i + 1].pad_out;
+            const bool short_rumble = (sent.rumble_l != Range::MAX<uint8_t> && sent.rumble_l != 0) ||
+                                      (sent.rumble_r != Range::MAX<uint8_t> && sent.rumble_r != 0);
+            const bool stopped = (next.rumble_l == 0 || next.rumble_l == Range::MAX<uint8_t>) &&
+                                 (next.rumble_r == 0 || next.rumble_r == Range::MAX<uint8_t>);
+            const auto after = std::upper_bound(writes.begin(), writes.end(), driver.sends[i].time_us,
+                [](uint64_t time_us, const Write& write) { return time_us < write.time_us; });
+            const bool replaced = (after != writes.end() && after->time_us <= driver.sends[i + 1].time_us);
+            if (short_rumble && stopped && !replaced)
+            {
+                result.max_decay_us = std::max(result.max_decay_us, driver.sends[i + 1].time_us - driver.sends[i].time_us);
+            }
+        }
+        return result;
+    }
+
+    void print_header(const char* suite)
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,scenario,mode,writes,sends,attempts,p50_us,p99_us,max_us,max_idle_us,max_decay_us\n");
+            return;
+        }
+        std::printf("\n[%s] min interval %llu us, refresh %llu us, loop pass %llu us\n", suite,
+            static_cast<unsigned long long>(MIN_INTERVAL_US), static_cast<unsigned long long>(REFRESH_US),
+            static_cast<unsigned long long>(LOOP_US));
+        std::printf("%-18s %-6s %7s %7s %9s %9s %9s %9s %9s %10s\n",
+            "scenario", "mode", "writes", "sends", "attempts", "p50 us", "p99 us", "max us", "idle us", "decay us");
+    }
+
+    void print_row(const char* suite, const char* scenario, Mode mode, const Result& result)
+    {
+        const char* mode_name = (mode == Mode::EVENT) ? "event" : "timer";
+        if (Bench::csv())
+        {
+            std::printf("%s,%s,%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", suite, scenario, mode_name,
+                static_cast<unsigned long long>(result.writes), static_cast<unsigned long long>(result.sends),
+                static_cast<unsigned long long>(result.attempts), static_cast<unsigned long long>(result.p50_us),
+                static_cast<unsigned long long>(result.p99_us), static_cast<unsigned long long>(result.max_us),
+                static_cast<unsigned long long>(result.max_idle_us), static_cast<unsigned long long>(result.max_decay_us));
+            return;
+        }
+        std::printf("%-18s %-6s %7llu %7llu %9llu %9llu %9llu %9llu %9llu %10llu\n", scenario, mode_name,
+            static_cast<unsigned long long>(result.writes), static_cast<unsigned long long>(result.sends),
+            static_cast<unsigned long long>(result.attempts), static_cast<unsigned long long>(result.p50_us),
+            static_cast<unsigned long long>(result.p99_us), static_cast<unsigned long long>(result.max_us),
+            static_cast<unsigned long long>(result.max_idle_us), static_cast<unsigned long long>(result.max_decay_us));
+    }
+
+    struct Scenario
+    {
+        const char* name;
+        std::vector<Write> writes;
+        uint64_t transfer_us;
+        uint64_t max_latency_us; //Event mode bound for any write
+    };
+
+} // namespace
+
+void bench_feedback()
+{
+    const char* suite = "feedback.latency";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const Scenario scenarios[] =
+    {
+        //Writes further apart than the rate limit, only a refresh send just before one can hold it back
+        { "sparse", make_writes(0xFEED, 2000, MIN_INTERVAL_US + LOOP_US, 400'000), 500, MIN_INTERVAL_US + LOOP_US },
+        //A console writing every frame, coalesced down to one send per min interval
+        { "every_frame", make_writes(0xF00D, 20000, USB_FRAME_US, USB_FRAME_US), 500, MIN_INTERVAL_US + LOOP_US },
+        //Random bursts faster than the limit
+        { "bursty", make_writes(0xB075, 20000, 50, 30'000), 500, MIN_INTERVAL_US + LOOP_US },
+        //Controller that takes 20ms per report, must not be flooded while busy
+        { "slow_controller", make_writes(0x510E, 5000, USB_FRAME_US, 60'000), 20'000, 20'000 + Feedback::RETRY_US + LOOP_US },
+    };
+
+    print_header(suite);
+    for (const Scenario& scenario : scenarios)
+    {
+        const Result timer = simulate(Mode::TIMER, scenario.writes, scenario.transfer_us);
+        const Result event = simulate(Mode::EVENT, scenario.writes, scenario.transfer_us);
+        print_row(suite, scenario.name, Mode::TIMER, timer);
+        print_row(suite, scenario.name, Mode::EVENT, event);
+
+        const uint64_t duration_us = scenario.writes.back().time_us - scenario.writes.front().time_us + 2 * REFRESH_US;
+        //At most one failed attempt per frame on top of the sends
+        const uint64_t max_attempts = duration_us / Feedback::RETRY_US + event.sends;
+
+        if (event.max_idle_us > USB_FRAME_US)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " idle controller not sent within a frame");
+        }
+        if (event.max_us > scenario.max_latency_us)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " latency over bound");
+        }
+        if (event.attempts > max_attempts)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " driver retried faster than once a frame");
+        }
+        if (event.max_decay_us > REFRESH_US + MIN_INTERVAL_US + LOOP_US)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " short rumble not stopped on refresh");
+        }
+        if (!event.final_delivered)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " last console write never reached the controller");
+        }
+        if (event.min_gap_us < MIN_INTERVAL_US)
+        {
+            Bench::fail(suite, std::string(scenario.name) + " sends closer than the min interval");
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#include <string>
+#include <memory>
+
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserProfile.h"
+#include "BenchProfiles.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Rows named apply_*_settings are the Fix16 reference shaping alone,
+//scale_* rows go through whichever stick engine the build selected
+
+static void bench_joysticks(const char* suite)
+{
+    const auto& samples = BenchProfiles::joystick_samples();
+
+    //10 bit signed, as Bluepad32 reports sticks
+    std::vector<std::pair<int32_t, int32_t>> samples_10b;
+    //8 bit unsigned, as PS3/PS4/PS5/DInput/Switch report sticks
+    std::vector<std::pair<uint8_t, uint8_t>> samples_u8;
+
+    for (const auto& sample : samples)
+    {
+        samples_10b.emplace_back(sample.first >> 6, sample.second >> 6);
+        samples_u8.emplace_back(Scale::int16_to_uint8(sample.first), Scale::int16_to_uint8(sample.second));
+    }
+
+    for (const auto& joy_profile : BenchProfiles::joystick_profiles())
+    {
+        UserProfile profile;
+        profile.joystick_settings_l = joy_profile.settings;
+        profile.joystick_settings_r = joy_profile.settings;
+
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_profile(profile);
+
+        JoystickSettings settings;
+        Gamepad::load_joystick_settings(settings, joy_profile.settings);
+
+        auto row = [&](const char* name, auto&& func) 
+        {
+            if (Bench::enabled(suite, name))
+            {
+                Bench::print_row(suite, joy_profile.name, name, Bench::run(samples.size(), func));
+            }
+        };
+
+        row("apply_joystick_settings", [&](size_t i) {
+            Bench::do_not_optimize(Gamepad::apply_joystick_settings(samples[i].first, samples[i].second, settings, false));
+        });
+        row("scale_joystick_l<int16_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_l(samples[i].first, samples[i].second));
+        });
+        row("scale_joystick_l<int16_t>(invert_y)", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_l(samples[i].first, samples[i].second, true));
+        });
+        row("scale_joystick_r<int16_t>(invert_y)", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_r(samples[i].first, samples[i].second, true));
+        });
+        row("scale_joystick_l<uint8_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_l(samples_u8[i].first, samples_u8[i].second));
+        });
+        row("scale_joystick_r<uint8_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_r(samples_u8[i].first, samples_u8[i].second));
+        });
+        row("scale_joystick_l<10, int32_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_l<10>(samples_10b[i].first, samples_10b[i].second));
+        });
+        row("scale_joystick_r<10, int32_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_joystick_r<10>(samples_10b[i].first, samples_10b[i].second));
+        });
+    }
+}
+
+static void bench_triggers(const char* suite)
+{
+    const auto& samples = BenchProfiles::trigger_samples();
+
+    //10 bit unsigned, as Bluepad32 reports brake/throttle
+    std::vector<uint16_t> samples_10b;
+    for (const auto& sample : samples)
+    {
+        samples_10b.push_back(static_cast<uint16_t>(sample) << 2);
+    }
+
+    for (const auto& trig_profile : BenchProfiles::trigger_profiles())
+    {
+        UserProfile profile;
+        profile.trigger_settings_l = trig_profile.settings;
+        profile.trigger_settings_r = trig_profile.settings;
+
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_profile(profile);
+
+        TriggerSettings settings;
+        settings.set_from_raw(trig_profile.settings);
+
+        auto row = [&](const char* name, auto&& func) 
+        {
+            if (Bench::enabled(suite, name))
+            {
+                Bench::print_row(suite, trig_profile.name, name, Bench::run(samples.size(), func));
+            }
+        };
+
+        row("apply_trigger_settings", [&](size_t i) {
+            Bench::do_not_optimize(Gamepad::apply_trigger_settings(samples[i], settings));
+        });
+        row("scale_trigger_l<uint8_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_trigger_l(samples[i]));
+        });
+        row("scale_trigger_r<uint8_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_trigger_r(samples[i]));
+        });
+        row("scale_trigger_l<10, uint16_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_trigger_l<10>(samples_10b[i]));
+        });
+        row("scale_trigger_r<10, uint16_t>", [&](size_t i) {
+            Bench::do_not_optimize(gamepad->scale_trigger_r<10>(samples_10b[i]));
+        });
+    }
+}
+
+//Both sticks and both triggers, what a host driver does for every report
+static void bench_report(const char* suite)
+{
+    const auto& joy_samples = BenchProfiles::joystick_samples();
+    const auto& trig_samples = BenchProfiles::trigger_samples();
+    const auto& joy_profiles = BenchProfiles::joystick_profiles();
+    const auto& trig_profiles = BenchProfiles::trigger_profiles();
+
+    const char* name = "report (2 sticks + 2 triggers)";
+    if (!Bench::enabled(suite, name))
+    {
+        return;
+    }
+
+    for (size_t p = 0; p < joy_profiles.size(); ++p)
+    {
+        UserProfile profile;
+        profile.joystick_settings_l = joy_profiles[p].settings;
+        profile.joystick_settings_r = joy_profiles[p].settings;
+        profile.trigger_settings_l = trig_profiles[std::min(p, trig_profiles.size() - 1)].settings;
+        profile.trigger_settings_r = trig_profiles[std::min(p, trig_profiles.size() - 1)].settings;
+
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_profile(profile);
+
+        Bench::print_row(suite, joy_profiles[p].name, name, Bench::run(joy_samples.size(), [&](size_t i) 
+        {
+            const size_t j = (i + joy_samples.size() / 2) % joy_samples.size();
+            Gamepad::PadIn gp_in;
+            std::tie(gp_in.joystick_lx, gp_in.joystick_ly) = gamepad->scale_joystick_l(joy_samples[i].first, joy_samples[i].second, true);
+            std::tie(gp_in.joystick_rx, gp_in.joystick_ry) = gamepad->scale_joystick_r(joy_samples[j].first, joy_samples[j].second, true);
+            gp_in.trigger_l = gamepad->scale_trigger_l(trig_samples[i]);
+            gp_in.trigger_r = gamepad->scale_trigger_r(trig_samples[j]);
+            Bench::do_not_optimize(gp_in);
+        }));
+    }
+}
+
+void bench_gamepad()
+{
+    Bench::print_header("gamepad.joystick");
+    bench_joysticks("gamepad.joystick");
+
+    Bench::print_header("gamepad.trigger");
+    bench_triggers("gamepad.trigger");
+
+    Bench::print_header("gamepad.report");
+    bench_report("gamepad.report");
+}
@@ -0,0 +1,323 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+
+#include "USBHost/HIDParser/HIDReportDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystick.h"
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "BenchHIDDescriptors.h"
+#include "BenchHeap.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//HIDArenaDescriptor against the vector based HIDReportDescriptor it replaced in HIDHost:
+//same reports out, what each costs in heap/arena and time, and clean failure when the arena is short
+
+namespace {
+
+    using BenchHIDDescriptors::Descriptor;
+    using IO = HIDArenaDescriptor::IO;
+
+    constexpr size_t ARENA_SIZE = 0x10000;
+    constexpr uint8_t CANARY = 0xA5;
+    constexpr size_t CANARY_SIZE = 64;
+
+    struct CheckResult
+    {
+        uint64_t descriptors{0};
+        uint64_t checks{0};
+        uint64_t errors{0};
+    };
+
+    const std::vector<HIDIOBlock>& old_blocks(const HIDIOReport& report, IO io)
+    {
+        switch (io)
+        {
+            case IO::INPUT:
+                return report.inputs;
+            case IO::OUTPUT:
+                return report.outputs;
+            default:
+                return report.features;
+        }
+    }
+
+    //Every report, block and value, expanding runs back into what HIDReportDescriptor makes
+    void compare(const std::vector<HIDIOReport>& expected, const HIDArenaDescriptor& actual, CheckResult& result)
+    {
+        auto report = actual.reports();
+        for (const auto& expected_report : expected)
+        {
+            ++result.checks;
+            if (!report || report->report_type != expected_report.report_type)
+            {
+                ++result.errors;
+                return;
+            }
+
+            for (uint8_t io_idx = 0; io_idx < static_cast<uint8_t>(IO::COUNT); ++io_idx)
+            {
+                const IO io = static_cast<IO>(io_idx);
+                auto block = report->blocks(io);
+                for (const auto& expected_block : old_blocks(expected_report, io))
+                {
+                    ++result.checks;
+                    if (!block)
+                    {
+                        ++result.errors;
+                        return;
+                    }
+
+                    auto run = block->first_run;
+                    uint32_t value_idx = 0;
+                    for (const auto& value : expected_block.data)
+                    {
+                        while (run && value_idx >= run->count)
+                        {
+                            run = run->next;
+                            value_idx = 0;
+                        }
+                        ++result.checks;
+                        if (!run || run->type != value.type || run->size != value.size || run->id + value_idx != value.id ||
+                            run->logical_min != value.logical_min || run->logical_max != value.logical_max)
+                        {
+                            ++result.errors;
+                            return;
+                        }
+                        ++value_idx;
+                    }
+
+                    ++result.checks;
+                    if (run && (value_idx < run->count || run->next))
+                    {
+                        ++result.errors;
+                    }
+                    block = block->next;
+                }
+                ++result.checks;
+                result.errors += block ? 1 : 0;
+            }
+            report = report->next;
+        }
+        ++result.checks;
+        result.errors += report ? 1 : 0;
+    }
+
+    //Changes the data of items the old parser can't crash on, leaves collections alone
+    std::vector<uint8_t> mutate(const std::vector<uint8_t>& data, std::mt19937& rng)
+    {
+        std::vector<uint8_t> out = data;
+        size_t offset = 0;
+        while (offset < out.size())
+        {
+            const uint8_t prefix = out[offset];
+            const uint8_t item_size = ((prefix & 0x03) == 3) ? 4 : (prefix & 0x03);
+            const uint8_t type = prefix & 0xFC;
+            if (type != 0xA0 && type != 0xC0 && item_size > 0 && rng() % 4 == 0)
+            {
+                out[offset + 1 + rng() % item_size] = static_cast<uint8_t>(rng());
+            }
+            offset += 1 + item_size;
+        }
+        return out;
+    }
+
+    CheckResult check_against_old(const std::vector<Descriptor>& descriptors)
+    {
+        CheckResult result;
+        std::vector<uint8_t> buffer(ARENA_SIZE);
+        std::mt19937 rng(8);
+
+        for (const auto& descriptor : descriptors)
+        {
+            for (uint32_t variant = 0; variant < 2000; ++variant)
+            {
+                const auto data = (variant == 0) ? descriptor.data : mutate(descriptor.data, rng);
+                HIDReportDescriptor old_descriptor(data.data(), static_cast<uint16_t>(data.size()));
+
+                HIDArena arena(buffer.data(), buffer.size());
+                HIDArenaDescriptor arena_descriptor;
+                ++result.descriptors;
+                ++result.checks;
+                if (arena_descriptor.parse(data.data(), static_cast<uint16_t>(data.size()), arena) != HIDArenaDescriptor::Status::OK)
+                {
+                    ++result.errors;
+                    continue;
+                }
+                compare(old_descriptor.GetReports(), arena_descriptor, result);
+            }
+        }
+        return result;
+    }
+
+    //Every arena size short of what a descriptor needs must fail as ARENA_FULL without writing past the end
+    CheckResult check_arena_full(const std::vector<Descriptor>& descriptors)
+    {
+        CheckResult result;
+        for (const auto& descriptor : descriptors)
+        {
+            const uint16_t len = static_cast<uint16_t>(descriptor.data.size());
+            std::vector<uint8_t> buffer(ARENA_SIZE);
+            HIDArena sizing_arena(buffer.data(), buffer.size());
+            HIDArenaDescriptor sizing;
+            sizing.parse(descriptor.data.data(), len, sizing_arena);
+            const size_t needed = sizing.stats().arena_used;
+
+            for (size_t size = 0; size <= needed; ++size)
+            {
+                std::vector<uint8_t> short_buffer(size + CANARY_SIZE, CANARY);
+                HIDArena arena(short_buffer.data(), size);
+                HIDArenaDescriptor arena_descriptor;
+                const auto status = arena_descriptor.parse(descriptor.data.data(), len, arena);
+
+                ++result.descriptors;
+                result.checks += 3;
+                const bool fits = (size == needed);
+                result.errors += (status == (fits ? HIDArenaDescriptor::Status::OK : HIDArenaDescriptor::Status::ARENA_FULL)) ? 0 : 1;
+                result.errors += ((arena_descriptor.reports() != nullptr) == fits) ? 0 : 1;
+                bool canary_ok = true;
+                for (size_t i = size; i < short_buffer.size(); ++i)
+                {
+                    canary_ok &= (short_buffer[i] == CANARY);
+                }
+                result.errors += canary_ok ? 0 : 1;
+            }
+        }
+        return result;
+    }
+
+    void print_check_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,check,descriptors,checks,errors\n");
+            return;
+        }
+        std::printf("\n[hid.arena.check]\n");
+        std::printf("%-44s %12s %12s %8s\n", "check", "descriptors", "checks", "errors");
+    }
+
+    void print_check_row(const char* name, const CheckResult& result)
+    {
+        if (Bench::csv())
+        {
+            std::printf("hid.arena.check,%s,%llu,%llu,%llu\n", name,
+                static_cast<unsigned long long>(result.descriptors), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+        else
+        {
+            std::printf("%-44s %12llu %12llu %8llu\n", name,
+                static_cast<unsigned long long>(result.descriptors), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+
+        if (result.errors > 0 || result.descriptors == 0)
+        {
+            Bench::fail("hid.arena.check", name);
+        }
+    }
+
+    struct MemoryRow
+    {
+        double old_ns{0};
+        int64_t old_peak{0};     //Heap during parse
+        int64_t old_kept{0};     //Heap HIDHost held on to afterwards
+        uint64_t old_allocs{0};
+        double arena_ns{0};
+        uint32_t arena_used{0};
+    };
+
+    MemoryRow measure(const Descriptor& descriptor)
+    {
+        MemoryRow row;
+        const uint16_t len = static_cast<uint16_t>(descriptor.data.size());
+
+        {
+            //What HIDHost::initialize did before
+            const int64_t live_before = BenchHeap::live();
+            BenchHeap::reset_peak();
+            const uint64_t allocs_before = BenchHeap::allocs();
+
+            auto joystick = std::make_unique<HIDJoystick>(std::make_shared<HIDReportDescriptor>(descriptor.data.data(), len));
+
+            row.old_peak = BenchHeap::peak() - live_before;
+            row.old_kept = BenchHeap::live() - live_before;
+            row.old_allocs = BenchHeap::allocs() - allocs_before;
+        }
+        row.old_ns = Bench::run(1, [&](size_t)
+        {
+            HIDReportDescriptor old_descriptor(descriptor.data.data(), len);
+            Bench::do_not_optimize(old_descriptor);
+        }, 20'000'000).ns_per_sample;
+
+        std::vector<uint8_t> buffer(ARENA_SIZE);
+        row.arena_ns = Bench::run(1, [&](size_t)
+        {
+            HIDArena arena(buffer.data(), buffer.size());
+            HIDArenaDescriptor arena_descriptor;
+            Bench::do_not_optimize(arena_descriptor.parse(descriptor.data.data(), len, arena));
+            row.arena_used = arena_descriptor.stats().arena_used;
+        }, 20'000'000).ns_per_sample;
+        return row;
+    }
+
+    void print_memory_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,descriptor,bytes,old_ns,old_peak_heap,old_kept_heap,old_allocs,arena_ns,arena_bytes\n");
+            return;
+        }
+        std::printf("\n[hid.arena]\n");
+        std::printf("%-32s %6s %10s %12s %12s %10s %10s %12s\n",
+            "descriptor", "bytes", "old ns", "old peak B", "old kept B", "old allocs", "arena ns", "arena B");
+    }
+
+    void print_memory_row(const char* name, size_t bytes, const MemoryRow& row)
+    {
+        if (Bench::csv())
+        {
+            std::printf("hid.arena,%s,%zu,%.1f,%lld,%lld,%llu,%.1f,%u\n", name, bytes, row.old_ns,
+                static_cast<long long>(row.old_peak), static_cast<long long>(row.old_kept),
+                static_cast<unsigned long long>(row.old_allocs), row.arena_ns, row.arena_used);
+            return;
+        }
+        std::printf("%-32s %6zu %10.1f %12lld %12lld %10llu %10.1f %12u\n", name, bytes, row.old_ns,
+            static_cast<long long>(row.old_peak), static_cast<long long>(row.old_kept),
+            static_cast<unsigned long long>(row.old_allocs), row.arena_ns, row.arena_used);
+    }
+
+} // namespace
+
+void bench_hid_arena()
+{
+    const char* suite = "hid.arena";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    std::vector<Descriptor> descriptors =
+    {
+        BenchHIDDescriptors::generic_pad(),
+        BenchHIDDescriptors::report_id_pad(),
+        BenchHIDDescriptors::signed_16_pad()
+    };
+    descriptors.insert(descriptors.end(), BenchHIDDescriptors::hot_plug().begin(), BenchHIDDescriptors::hot_plug().end());
+
+    //Arena bytes are for 64 bit pointers here, about 60% of that on the RP2040
+    print_memory_header();
+    for (const auto& descriptor : descriptors)
+    {
+        print_memory_row(descriptor.name, descriptor.data.size(), measure(descriptor));
+    }
+
+    print_check_header();
+    print_check_row("same reports as HIDReportDescriptor, mutated", check_against_old(descriptors));
+    print_check_row("arena full fails clean, every short size", check_arena_full(descriptors));
+}
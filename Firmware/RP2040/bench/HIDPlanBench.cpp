@@ -0,0 +1,250 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <memory>
+
+#include "USBHost/HIDParser/HIDReportDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystick.h"
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "BenchHIDDescriptors.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//HIDHost's compiled report plan against HIDJoystick::parseData, the per report parse it replaced
+
+namespace {
+
+    using BenchHIDDescriptors::Descriptor;
+
+    //Compiled the way HIDHost does it, through an arena parse
+    bool compile_plan(const Descriptor& descriptor, HIDJoystickPlan& plan)
+    {
+        std::vector<uint8_t> buffer(0x10000);
+        HIDArena arena(buffer.data(), buffer.size());
+        HIDArenaDescriptor parsed;
+        return parsed.parse(descriptor.data.data(), static_cast<uint16_t>(descriptor.data.size()), arena) == HIDArenaDescriptor::Status::OK &&
+               plan.compile(parsed);
+    }
+
+    struct CheckResult
+    {
+        uint64_t reports{0};
+        uint64_t checks{0};
+        uint64_t errors{0};
+    };
+
+    std::vector<std::vector<uint8_t>> make_reports(const Descriptor& descriptor, size_t count, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<std::vector<uint8_t>> reports(count, std::vector<uint8_t>(descriptor.report_len));
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (auto& byte : reports[i])
+            {
+                byte = static_cast<uint8_t>(rng());
+            }
+            if (!descriptor.report_ids.empty())
+            {
+                //Mostly known IDs, some the plan has to reject
+                const uint32_t pick = rng() % (descriptor.report_ids.size() + 1);
+                reports[i][0] = (pick < descriptor.report_ids.size()) ? descriptor.report_ids[pick] : static_cast<uint8_t>(0x40 + pick);
+            }
+        }
+        return reports;
+    }
+
+    bool near(int32_t a, int32_t b)
+    {
+        return std::abs(a - b) <= 1;
+    }
+
+    void compare(const HIDJoystickData& expected, const HIDJoystickData& actual, CheckResult& result)
+    {
+        const int16_t HIDJoystickData::* axes[] =
+        {
+            &HIDJoystickData::X, &HIDJoystickData::Y, &HIDJoystickData::Z, &HIDJoystickData::Rx,
+            &HIDJoystickData::Ry, &HIDJoystickData::Rz, &HIDJoystickData::Slider, &HIDJoystickData::Dial
+        };
+        for (auto axis : axes)
+        {
+            ++result.checks;
+            result.errors += near(expected.*axis, actual.*axis) ? 0 : 1;
+        }
+        for (uint8_t i = 0; i < MAX_BUTTONS; ++i)
+        {
+            ++result.checks;
+            result.errors += (expected.buttons[i] == actual.buttons[i]) ? 0 : 1;
+        }
+        result.checks += 4;
+        result.errors += (expected.index == actual.index) ? 0 : 1;
+        result.errors += (expected.support == actual.support) ? 0 : 1;
+        result.errors += (expected.button_count == actual.button_count) ? 0 : 1;
+        result.errors += (expected.hat_switch == actual.hat_switch) ? 0 : 1;
+    }
+
+    //Same reports through both, including truncated ones
+    CheckResult check_against_parse_data(const Descriptor& descriptor)
+    {
+        CheckResult result;
+        auto hid_descriptor = std::make_shared<HIDReportDescriptor>(descriptor.data.data(), static_cast<uint16_t>(descriptor.data.size()));
+        HIDJoystick joystick(hid_descriptor);
+        HIDJoystickPlan plan;
+        ++result.checks;
+        if (!compile_plan(descriptor, plan) || plan.joystick_count() != joystick.getCount())
+        {
+            ++result.errors;
+            return result;
+        }
+
+        HIDJoystickData expected;
+        HIDJoystickData actual;
+        std::mt19937 rng(5);
+        for (auto& report : make_reports(descriptor, 200'000, 6))
+        {
+            const uint16_t len = (rng() % 8 == 0) ? static_cast<uint16_t>(rng() % descriptor.report_len) : descriptor.report_len;
+            const bool expected_ok = joystick.parseData(report.data(), len, &expected);
+            const bool actual_ok = plan.parse(report.data(), len, actual);
+
+            ++result.reports;
+            ++result.checks;
+            if (expected_ok != actual_ok)
+            {
+                ++result.errors;
+                continue;
+            }
+            if (!expected_ok)
+            {
+                //parseData may have written part of a short report, start both from the same state
+                actual = expected;
+                continue;
+            }
+            compare(expected, actual, result);
+        }
+        return result;
+    }
+
+    //Axes against the exact mapping, and every 16 bit value hits its ends and is monotonic
+    CheckResult check_signed_axes(const Descriptor& descriptor)
+    {
+        CheckResult result;
+        HIDJoystickPlan plan;
+        ++result.checks;
+        if (!compile_plan(descriptor, plan))
+        {
+            ++result.errors;
+            return result;
+        }
+
+        std::vector<uint8_t> report(descriptor.report_len, 0);
+        HIDJoystickData data;
+        int32_t prev = INT32_MIN;
+        for (int32_t value = -32768; value <= 32767; ++value)
+        {
+            report[0] = static_cast<uint8_t>(value);
+            report[1] = static_cast<uint8_t>(value >> 8);
+            ++result.reports;
+            ++result.checks;
+            if (!plan.parse(report.data(), static_cast<uint16_t>(report.size()), data))
+            {
+                ++result.errors;
+                continue;
+            }
+
+            //Logical range matches int16 so the exact mapping is the value itself
+            result.checks += 2;
+            result.errors += near(data.X, value) ? 0 : 1;
+            result.errors += (data.X >= prev) ? 0 : 1;
+            prev = data.X;
+        }
+        result.checks += 2;
+        result.errors += (prev == 32767) ? 0 : 1;
+        result.errors += (data.support == (JOYSTICK_SUPPORT_X | JOYSTICK_SUPPORT_Y | JOYSTICK_SUPPORT_Z | JOYSTICK_SUPPORT_Rz)) ? 0 : 1;
+        return result;
+    }
+
+    void print_check_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,descriptor,reports,checks,errors\n");
+            return;
+        }
+        std::printf("\n[hid.plan]\n");
+        std::printf("%-44s %12s %12s %8s\n", "descriptor", "reports", "checks", "errors");
+    }
+
+    void print_check_row(const char* name, const CheckResult& result)
+    {
+        if (Bench::csv())
+        {
+            std::printf("hid.plan,%s,%llu,%llu,%llu\n", name,
+                static_cast<unsigned long long>(result.reports), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+        else
+        {
+            std::printf("%-44s %12llu %12llu %8llu\n", name,
+                static_cast<unsigned long long>(result.reports), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+
+        if (result.errors > 0 || result.reports == 0)
+        {
+            Bench::fail("hid.plan", name);
+        }
+    }
+
+    void bench_descriptor(const char* suite, const Descriptor& descriptor)
+    {
+        const auto reports = make_reports(descriptor, 1024, 7);
+
+        if (descriptor.compare_parse_data)
+        {
+            HIDJoystick joystick(std::make_shared<HIDReportDescriptor>(descriptor.data.data(), static_cast<uint16_t>(descriptor.data.size())));
+            HIDJoystickData data;
+            Bench::print_row(suite, descriptor.name, "HIDJoystick::parseData", Bench::run(reports.size(), [&](size_t i)
+            {
+                Bench::do_not_optimize(joystick.parseData(const_cast<uint8_t*>(reports[i].data()), descriptor.report_len, &data));
+            }));
+            Bench::do_not_optimize(data);
+        }
+
+        auto plan = std::make_unique<HIDJoystickPlan>();
+        compile_plan(descriptor, *plan);
+        HIDJoystickData data;
+        Bench::print_row(suite, descriptor.name, "HIDJoystickPlan::parse", Bench::run(reports.size(), [&](size_t i)
+        {
+            Bench::do_not_optimize(plan->parse(reports[i].data(), descriptor.report_len, data));
+        }));
+        Bench::do_not_optimize(data);
+    }
+
+} // namespace
+
+void bench_hid_plan()
+{
+    const char* suite = "hid";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const Descriptor& ds4 = BenchHIDDescriptors::hot_plug().back();
+
+    Bench::print_header(suite);
+    bench_descriptor(suite, BenchHIDDescriptors::generic_pad());
+    bench_descriptor(suite, BenchHIDDescriptors::report_id_pad());
+    bench_descriptor(suite, BenchHIDDescriptors::signed_16_pad());
+    bench_descriptor(suite, ds4);
+
+    print_check_header();
+    print_check_row("generic 8 bit pad vs parseData", check_against_parse_data(BenchHIDDescriptors::generic_pad()));
+    print_check_row("report id pad vs parseData", check_against_parse_data(BenchHIDDescriptors::report_id_pad()));
+    print_check_row("ds4 style gamepad vs parseData", check_against_parse_data(ds4));
+    print_check_row("signed 16 bit pad, full X sweep", check_signed_axes(BenchHIDDescriptors::signed_16_pad()));
+}
@@ -0,0 +1,359 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <random>
+#include <memory>
+
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
+#include "USBHost/HIDParser/HIDPlanCache.h"
+#include "BenchHIDDescriptors.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//HIDPlanCache over a RAM stand-in for its flash sectors: plans survive a flush and a new
+//instance (a reboot) unchanged, a new build tag or a damaged slot misses, the oldest slot is
+//replaced first, and what a hit costs next to parsing and compiling the descriptor
+
+namespace {
+
+    using BenchHIDDescriptors::Descriptor;
+
+    constexpr uint8_t NUM_SLOTS = 4;
+    const char* BUILD_TAG = "2026-01-01 00:00:00";
+
+    std::vector<uint8_t> flash(NUM_SLOTS * HIDPlanCache::SLOT_SIZE, 0xFF);
+    uint32_t slot_writes = 0;
+
+    void write_slot(uint8_t slot, const uint8_t* data, size_t len)
+    {
+        uint8_t* sector = flash.data() + slot * HIDPlanCache::SLOT_SIZE;
+        std::memset(sector, 0xFF, HIDPlanCache::SLOT_SIZE);
+        std::memcpy(sector, data, len);
+        ++slot_writes;
+    }
+
+    std::unique_ptr<HIDPlanCache> boot(const char* build_tag = BUILD_TAG)
+    {
+        return std::make_unique<HIDPlanCache>(flash.data(), NUM_SLOTS, HIDPlanCache::make_version(build_tag), &write_slot);
+    }
+
+    //HID_DESCRIPTOR_ARENA_SIZE is sized for 32 bit pointers, the ds4 style descriptor needs a little more here
+    constexpr size_t ARENA_SIZE = 0x10000;
+
+    void erase_flash()
+    {
+        std::fill(flash.begin(), flash.end(), 0xFF);
+    }
+
+    bool compile_plan(const Descriptor& descriptor, HIDJoystickPlan& plan)
+    {
+        std::vector<uint8_t> buffer(ARENA_SIZE);
+        HIDArena arena(buffer.data(), buffer.size());
+        HIDArenaDescriptor parsed;
+        return parsed.parse(descriptor.data.data(), static_cast<uint16_t>(descriptor.data.size()), arena) == HIDArenaDescriptor::Status::OK &&
+               plan.compile(parsed);
+    }
+
+    HIDPlanCache::Key key_for(const Descriptor& descriptor, uint16_t vid)
+    {
+        return HIDPlanCache::make_key(vid, 0x0001, descriptor.data.data(), static_cast<uint16_t>(descriptor.data.size()));
+    }
+
+    struct CheckResult
+    {
+        uint64_t checks{0};
+        uint64_t errors{0};
+    };
+
+    void expect(bool ok, CheckResult& result)
+    {
+        ++result.checks;
+        result.errors += ok ? 0 : 1;
+    }
+
+    bool same_data(const HIDJoystickData& a, const HIDJoystickData& b)
+    {
+        return a.index == b.index && a.support == b.support && a.X == b.X && a.Y == b.Y && a.Z == b.Z &&
+               a.Rx == b.Rx && a.Ry == b.Ry && a.Rz == b.Rz && a.Slider == b.Slider && a.Dial == b.Dial &&
+               a.hat_switch == b.hat_switch && a.button_count == b.button_count &&
+               std::memcmp(a.buttons, b.buttons, sizeof(a.buttons)) == 0;
+    }
+
+    //Restored plans have to read every report exactly like the one that was compiled
+    void expect_same_plan(const Descriptor& descriptor, const HIDJoystickPlan& expected, const HIDJoystickPlan& actual, CheckResult& result)
+    {
+        std::mt19937 rng(11);
+        std::vector<uint8_t> report(descriptor.report_len);
+        HIDJoystickData expected_data;
+        HIDJoystickData actual_data;
+        expect(expected.field_count() == actual.field_count() && expected.joystick_count() == actual.joystick_count(), result);
+
+        for (uint32_t i = 0; i < 20'000; ++i)
+        {
+            for (auto& byte : report)
+            {
+                byte = static_cast<uint8_t>(rng());
+            }
+            if (!descriptor.report_ids.empty() && (rng() % 4) != 0)
+            {
+                report[0] = descriptor.report_ids[rng() % descriptor.report_ids.size()];
+            }
+            const uint16_t len = (rng() % 8 == 0) ? static_cast<uint16_t>(rng() % descriptor.report_len) : descriptor.report_len;
+            const bool expected_ok = expected.parse(report.data(), len, expected_data);
+            expect(expected_ok == actual.parse(report.data(), len, actual_data), result);
+            if (expected_ok)
+            {
+                expect(same_data(expected_data, actual_data), result);
+            }
+        }
+    }
+
+    CheckResult check_round_trip(const std::vector<Descriptor>& pads)
+    {
+        CheckResult result;
+        erase_flash();
+
+        std::vector<std::unique_ptr<HIDJoystickPlan>> compiled;
+        for (size_t i = 0; i < pads.size(); ++i)
+        {
+            compiled.push_back(std::make_unique<HIDJoystickPlan>());
+            expect(compile_plan(pads[i], *compiled.back()), result);
+        }
+
+        //Two at a time, the most a session queues
+        for (size_t i = 0; i < pads.size(); i += HIDPlanCache::MAX_PENDING)
+        {
+            auto cache = boot();
+            for (size_t j = i; j < pads.size() && j < i + HIDPlanCache::MAX_PENDING; ++j)
+            {
+                const auto key = key_for(pads[j], static_cast<uint16_t>(j));
+                expect(cache->store(key, *compiled[j]), result);
+                expect(!cache->store(key, *compiled[j]), result);
+
+                //Hits from RAM before the flush
+                auto plan = std::make_unique<HIDJoystickPlan>();
+                expect(cache->load(key, *plan), result);
+                expect_same_plan(pads[j], *compiled[j], *plan, result);
+            }
+            cache->flush();
+            expect(cache->pending() == 0, result);
+        }
+
+        //And from flash after the reboot
+        auto cache = boot();
+        for (size_t i = 0; i < pads.size(); ++i)
+        {
+            auto plan = std::make_unique<HIDJoystickPlan>();
+            expect(cache->load(key_for(pads[i], static_cast<uint16_t>(i)), *plan), result);
+            expect_same_plan(pads[i], *compiled[i], *plan, result);
+
+            //Same descriptor from another VID/PID, and another descriptor under this one's
+            expect(!cache->load(key_for(pads[i], 0x1000), *plan) && !plan->valid(), result);
+            expect(!cache->load(key_for(pads[(i + 1) % pads.size()], static_cast<uint16_t>(i)), *plan), result);
+        }
+        return result;
+    }
+
+    CheckResult check_invalidation(const std::vector<Descriptor>& pads)
+    {
+        CheckResult result;
+        erase_flash();
+
+        auto plan = std::make_unique<HIDJoystickPlan>();
+        expect(compile_plan(pads[0], *plan), result);
+        const auto key = key_for(pads[0], 0);
+        {
+            auto cache = boot();
+            expect(cache->store(key, *plan), result);
+            cache->flush();
+        }
+
+        //Firmware update
+        expect(!boot("2026-01-01 00:00:01")->load(key, *plan), result);
+        expect(boot()->load(key, *plan), result);
+
+        //Any flipped bit in the slot's header or image
+        const size_t used = sizeof(uint32_t) * 8 + plan->field_count() * 24;
+        std::mt19937 rng(3);
+        for (uint32_t i = 0; i < 2000; ++i)
+        {
+            const size_t offset = rng() % used;
+            const uint8_t bit = static_cast<uint8_t>(1u << (rng() % 8));
+            flash[offset] ^= bit;
+            expect(!boot()->load(key, *plan) && !plan->valid(), result);
+            flash[offset] ^= bit;
+        }
+        expect(boot()->load(key, *plan), result);
+        return result;
+    }
+
+    CheckResult check_eviction(const std::vector<Descriptor>& pads)
+    {
+        CheckResult result;
+        erase_flash();
+
+        auto plan = std::make_unique<HIDJoystickPlan>();
+        expect(compile_plan(pads[0], *plan), result);
+
+        //One new pad per session, more than there are slots
+        const uint16_t NUM_PADS = NUM_SLOTS + 3;
+        for (uint16_t vid = 0; vid < NUM_PADS; ++vid)
+        {
+            auto cache = boot();
+            expect(cache->store(key_for(pads[0], vid), *plan), result);
+            expect(cache->flush() == 1, result);
+        }
+
+        auto cache = boot();
+        for (uint16_t vid = 0; vid < NUM_PADS; ++vid)
+        {
+            expect(cache->load(key_for(pads[0], vid), *plan) == (vid >= NUM_PADS - NUM_SLOTS), result);
+        }
+
+        //Past MAX_PENDING new pads wait for the next session
+        for (uint16_t vid = 100; vid < 100 + HIDPlanCache::MAX_PENDING + 1; ++vid)
+        {
+            expect(cache->store(key_for(pads[0], vid), *plan) == (vid < 100 + HIDPlanCache::MAX_PENDING), result);
+        }
+        return result;
+    }
+
+    //Random images never load into a plan that reads outside its report
+    CheckResult check_mutated_images(const std::vector<Descriptor>& pads)
+    {
+        CheckResult result;
+        std::mt19937 rng(9);
+        for (const auto& pad : pads)
+        {
+            auto plan = std::make_unique<HIDJoystickPlan>();
+            expect(compile_plan(pad, *plan), result);
+            std::vector<uint8_t> image(HIDJoystickPlan::max_image_size());
+            image.resize(plan->save(image.data(), image.size()));
+            expect(!image.empty(), result);
+
+            for (uint32_t i = 0; i < 20'000; ++i)
+            {
+                std::vector<uint8_t> mutated = image;
+                for (uint32_t n = 1 + rng() % 3; n > 0; --n)
+                {
+                    mutated[rng() % mutated.size()] = static_cast<uint8_t>(rng());
+                }
+
+                auto loaded = std::make_unique<HIDJoystickPlan>();
+                if (!loaded->load(mutated.data(), mutated.size()))
+                {
+                    expect(!loaded->valid(), result);
+                    continue;
+                }
+
+                //Reports exactly as long as the plan says it needs, read back from a buffer with a canary after it
+                for (uint32_t len = 0; len <= pad.report_len + 8u; ++len)
+                {
+                    std::vector<uint8_t> report(len + 64, 0x5A);
+                    if (len > 0 && !pad.report_ids.empty())
+                    {
+                        report[0] = pad.report_ids[rng() % pad.report_ids.size()];
+                    }
+                    HIDJoystickData data;
+                    if (loaded->parse(report.data(), static_cast<uint16_t>(len), data))
+                    {
+                        //Whatever it read, another parse of the same bytes with garbage past len must match
+                        HIDJoystickData again;
+                        std::fill(report.begin() + len, report.end(), 0xA5);
+                        loaded->parse(report.data(), static_cast<uint16_t>(len), again);
+                        expect(same_data(data, again), result);
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    void print_check_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,check,checks,errors\n");
+            return;
+        }
+        std::printf("\n[hid.cache.check]\n");
+        std::printf("%-44s %12s %8s\n", "check", "checks", "errors");
+    }
+
+    void print_check_row(const char* name, const CheckResult& result)
+    {
+        if (Bench::csv())
+        {
+            std::printf("hid.cache.check,%s,%llu,%llu\n", name,
+                static_cast<unsigned long long>(result.checks), static_cast<unsigned long long>(result.errors));
+        }
+        else
+        {
+            std::printf("%-44s %12llu %8llu\n", name,
+                static_cast<unsigned long long>(result.checks), static_cast<unsigned long long>(result.errors));
+        }
+
+        if (result.errors > 0 || result.checks == 0)
+        {
+            Bench::fail("hid.cache.check", name);
+        }
+    }
+
+    void bench_descriptor(const char* suite, const Descriptor& descriptor)
+    {
+        const uint16_t len = static_cast<uint16_t>(descriptor.data.size());
+        auto plan = std::make_unique<HIDJoystickPlan>();
+        std::vector<uint8_t> buffer(ARENA_SIZE);
+
+        Bench::print_row(suite, descriptor.name, "parse + compile", Bench::run(1, [&](size_t)
+        {
+            HIDArena arena(buffer.data(), buffer.size());
+            HIDArenaDescriptor parsed;
+            parsed.parse(descriptor.data.data(), len, arena);
+            Bench::do_not_optimize(plan->compile(parsed));
+        }, 20'000'000));
+
+        erase_flash();
+        auto cache = boot();
+        cache->store(key_for(descriptor, 0), *plan);
+        cache->flush();
+        cache = boot();
+
+        //What HIDHost::initialize does on a hit: hash the descriptor, find the slot, restore
+        Bench::print_row(suite, descriptor.name, "cache hit", Bench::run(1, [&](size_t)
+        {
+            Bench::do_not_optimize(cache->load(key_for(descriptor, 0), *plan));
+        }, 20'000'000));
+    }
+
+} // namespace
+
+void bench_hid_plan_cache()
+{
+    const char* suite = "hid.cache";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const std::vector<Descriptor> pads =
+    {
+        BenchHIDDescriptors::generic_pad(),
+        BenchHIDDescriptors::report_id_pad(),
+        BenchHIDDescriptors::signed_16_pad(),
+        BenchHIDDescriptors::hot_plug().back()
+    };
+
+    //Flash reads here are RAM reads, through XIP a hit costs more but still skips the parse
+    Bench::print_header(suite);
+    bench_descriptor(suite, pads[0]);
+    bench_descriptor(suite, pads.back());
+
+    print_check_header();
+    print_check_row("same plan after flush and reboot", check_round_trip(pads));
+    print_check_row("new build tag or damaged slot misses", check_invalidation(pads));
+    print_check_row("oldest slot replaced first", check_eviction(pads));
+    print_check_row("mutated images load safely or not at all", check_mutated_images(pads));
+}
@@ -0,0 +1,222 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <random>
+
+#include "USBHost/HostDriver/HostDriverPool.h"
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
+#include "USBHost/HIDParser/HIDPlanCache.h"
+#include "BenchHIDDescriptors.h"
+#include "BenchHeap.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Hot plug soak: thousands of mount/unmount cycles through the same driver pool and HID mount
+//path HostManager uses (pool create/destroy, descriptor parse into the arena, plan compile,
+//plan cache load/store/flush). After the first few cycles the heap must not move at all
+
+namespace {
+
+    using BenchHIDDescriptors::Descriptor;
+
+    constexpr uint32_t CYCLES = 20000;
+    constexpr uint32_t WARM_UP_CYCLES = 100;
+    constexpr uint8_t MAX_DEVICES = 4;
+    constexpr uint8_t NUM_CACHE_SLOTS = 4;
+    //HID_DESCRIPTOR_ARENA_SIZE is sized for 32 bit pointers, the ds4 style descriptor needs a little more here
+    constexpr size_t ARENA_SIZE = 0x10000;
+
+    int32_t live_drivers = 0;
+
+    //Stand-ins for the host drivers, different sizes so slots get reused by other types
+    class FakeDriver
+    {
+    public:
+        FakeDriver() { ++live_drivers; }
+        virtual ~FakeDriver() { --live_drivers; }
+        virtual uint8_t type() const = 0;
+    };
+
+    class SmallDriver : public FakeDriver
+    {
+    public:
+        uint8_t type() const override { return 0; }
+        uint8_t report[16]{};
+    };
+
+    class LargeDriver : public FakeDriver
+    {
+    public:
+        uint8_t type() const override { return 1; }
+        uint8_t report[512]{};
+    };
+
+    //Holds its compiled plan like HIDHost does
+    class HIDDriver : public FakeDriver
+    {
+    public:
+        uint8_t type() const override { return 2; }
+        HIDJoystickPlan plan;
+    };
+
+    using Pool = HostDriverPool<FakeDriver, MAX_DEVICES, SmallDriver, LargeDriver, HIDDriver>;
+
+    std::vector<uint8_t> flash(NUM_CACHE_SLOTS * HIDPlanCache::SLOT_SIZE, 0xFF);
+    std::vector<uint8_t> arena_buffer(ARENA_SIZE);
+
+    void write_slot(uint8_t slot, const uint8_t* data, size_t len)
+    {
+        uint8_t* sector = flash.data() + slot * HIDPlanCache::SLOT_SIZE;
+        std::memset(sector, 0xFF, HIDPlanCache::SLOT_SIZE);
+        std::memcpy(sector, data, len);
+    }
+
+    struct SoakResult
+    {
+        uint32_t cycles{0};
+        uint64_t mounts{0};
+        uint64_t steady_allocs{0};
+        int64_t steady_live_delta{0};
+        uint64_t errors{0};
+    };
+
+    //What HIDHost::initialize does with a descriptor
+    bool mount_hid(HIDDriver& driver, HIDPlanCache& cache, const Descriptor& descriptor, uint16_t vid)
+    {
+        const uint16_t len = static_cast<uint16_t>(descriptor.data.size());
+        const HIDPlanCache::Key key = HIDPlanCache::make_key(vid, 0x0001, descriptor.data.data(), len);
+        if (cache.load(key, driver.plan))
+        {
+            return true;
+        }
+
+        HIDArena arena(arena_buffer.data(), arena_buffer.size());
+        HIDArenaDescriptor parsed;
+        if (parsed.parse(descriptor.data.data(), len, arena) != HIDArenaDescriptor::Status::OK ||
+            !driver.plan.compile(parsed))
+        {
+            return false;
+        }
+        cache.store(key, driver.plan);
+        return true;
+    }
+
+    SoakResult soak(const std::vector<Descriptor>& pads)
+    {
+        SoakResult result;
+        std::mt19937 rng(0x50A6);
+        Pool pool;
+        HIDPlanCache cache(flash.data(), NUM_CACHE_SLOTS, HIDPlanCache::make_version("soak"), &write_slot);
+        std::array<FakeDriver*, MAX_DEVICES> devices{};
+        int32_t mounted = 0;
+
+        uint64_t allocs_at_warm_up = 0;
+        int64_t live_at_warm_up = 0;
+
+        for (uint32_t cycle = 0; cycle < CYCLES; ++cycle)
+        {
+            if (cycle == WARM_UP_CYCLES)
+            {
+                allocs_at_warm_up = BenchHeap::allocs();
+                live_at_warm_up = BenchHeap::live();
+            }
+
+            const uint8_t idx = static_cast<uint8_t>(rng() % MAX_DEVICES);
+            if (devices[idx])
+            {
+                //Unmount, same as HostManager::reset_device
+                pool.destroy(devices[idx]);
+                devices[idx] = nullptr;
+                --mounted;
+            }
+            else
+            {
+                //Mount, same as HostManager::create_driver
+                const uint32_t pick = rng() % 3;
+                if (pick == 0)
+                {
+                    devices[idx] = pool.create<SmallDriver>();
+                }
+                else if (pick == 1)
+                {
+                    devices[idx] = pool.create<LargeDriver>();
+                }
+                else
+                {
+                    HIDDriver* driver = static_cast<HIDDriver*>(pool.create<HIDDriver>());
+                    devices[idx] = driver;
+                    if (driver)
+                    {
+                        //More distinct VIDs than cache slots so eviction runs too
+                        const Descriptor& pad = pads[rng() % pads.size()];
+                        result.errors += mount_hid(*driver, cache, pad, static_cast<uint16_t>(rng() % 6)) ? 0 : 1;
+                    }
+                }
+                result.errors += devices[idx] ? 0 : 1;
+                mounted += devices[idx] ? 1 : 0;
+                ++result.mounts;
+            }
+
+            //Pending plans are written on the next reboot, board_api::usb::disconnect_all
+            if ((cycle % 64) == 63)
+            {
+                cache.flush();
+            }
+
+            result.errors += (static_cast<int32_t>(pool.in_use()) == mounted && live_drivers == mounted) ? 0 : 1;
+            ++result.cycles;
+        }
+
+        result.steady_allocs = BenchHeap::allocs() - allocs_at_warm_up;
+        result.steady_live_delta = BenchHeap::live() - live_at_warm_up;
+        return result;
+    }
+
+} // namespace
+
+void bench_heap_soak()
+{
+    const char* suite = "heap.soak";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const std::vector<Descriptor> pads =
+    {
+        BenchHIDDescriptors::generic_pad(),
+        BenchHIDDescriptors::report_id_pad(),
+        BenchHIDDescriptors::signed_16_pad(),
+        BenchHIDDescriptors::hot_plug().back()
+    };
+
+    const SoakResult result = soak(pads);
+
+    if (Bench::csv())
+    {
+        std::printf("suite,cycles,mounts,steady_allocs,steady_live_delta,errors\n");
+        std::printf("%s,%u,%llu,%llu,%lld,%llu\n", suite, result.cycles,
+            static_cast<unsigned long long>(result.mounts), static_cast<unsigned long long>(result.steady_allocs),
+            static_cast<long long>(result.steady_live_delta), static_cast<unsigned long long>(result.errors));
+    }
+    else
+    {
+        std::printf("\n[%s]\n", suite);
+        std::printf("%10s %10s %14s %14s %8s\n", "cycles", "mounts", "steady allocs", "steady live B", "errors");
+        std::printf("%10u %10llu %14llu %14lld %8llu\n", result.cycles,
+            static_cast<unsigned long long>(result.mounts), static_cast<unsigned long long>(result.steady_allocs),
+            static_cast<long long>(result.steady_live_delta), static_cast<unsigned long long>(result.errors));
+    }
+
+    if (result.errors > 0)
+    {
+        Bench::fail(suite, "mount/unmount bookkeeping");
+    }
+    if (result.steady_allocs > 0 || result.steady_live_delta != 0)
+    {
+        Bench::fail(suite, "heap moved after warm up");
+    }
+}
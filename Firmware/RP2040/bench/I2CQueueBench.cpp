@@ -0,0 +1,270 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <random>
+
+#include ESP32_COMMAND_QUEUE_PATH
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//The ESP32 I2CDriver's command queue with a producer thread standing in for btstack and a consumer
+//for the i2c task, both flat out. Every command carries a per slot, per kind sequence number and
+//pads fill all their words from it, so a torn copy, a value going backwards or the newest one never
+//arriving shows up. Taken plus coalesced has to add up to pushed for every kind, nothing else may
+//go missing, and only pushes to a slot past the end are dropped
+
+namespace {
+
+    constexpr size_t NUM_SLOTS = 4;
+    constexpr uint32_t PUSHES = 2000000;
+    constexpr uint32_t CONTROL_EVERY = 61;
+    constexpr uint32_t READ_EVERY = 17;
+    constexpr uint32_t OUT_OF_RANGE_EVERY = 10007;
+    //So the threads interleave on a single core too
+    constexpr uint32_t YIELD_EVERY = 7;
+
+    struct Control
+    {
+        uint32_t seq{0};
+        uint32_t check{0};
+    };
+
+    //Around the size of the real WriteCommand
+    struct Pad
+    {
+        uint32_t seq{0};
+        std::array<uint32_t, 8> words{};
+    };
+
+    struct Read
+    {
+        uint32_t seq{0};
+    };
+
+    using Queue = CommandQueue<Control, Pad, Read, NUM_SLOTS>;
+
+    uint32_t mix(uint32_t seq)
+    {
+        return seq * 2654435761u ^ 0x5bd1e995u;
+    }
+
+    struct StressResult
+    {
+        uint64_t taken[Queue::NUM_KINDS]{};
+        uint64_t torn{0};
+        uint64_t backwards{0};
+        uint64_t newest_missing{0};
+        uint32_t out_of_range{0};
+        uint32_t failed{0};
+    };
+
+    StressResult stress(Queue& queue)
+    {
+        StressResult result;
+        std::atomic<bool> done{false};
+        uint32_t pushed_seq[NUM_SLOTS][Queue::NUM_KINDS]{};
+        uint32_t seen_seq[NUM_SLOTS][Queue::NUM_KINDS]{};
+
+        std::thread producer([&]
+        {
+            std::mt19937 rng(24);
+            for (uint32_t i = 1; i <= PUSHES; ++i)
+            {
+                if (i % OUT_OF_RANGE_EVERY == 0)
+                {
+                    queue.push_pad(NUM_SLOTS, Pad());
+                    ++result.out_of_range;
+                }
+                const size_t slot = rng() % NUM_SLOTS;
+                if (i % CONTROL_EVERY == 0)
+                {
+                    Control control;
+                    control.seq = ++pushed_seq[slot][Queue::CONTROL];
+                    control.check = mix(control.seq);
+                    queue.push_control(slot, control);
+                }
+                if (i % READ_EVERY == 0)
+                {
+                    Read read;
+                    read.seq = ++pushed_seq[slot][Queue::READ];
+                    queue.push_read(slot, read);
+                }
+                Pad pad;
+                pad.seq = ++pushed_seq[slot][Queue::PAD];
+                pad.words.fill(mix(pad.seq));
+                queue.push_pad(slot, pad);
+                if (i % YIELD_EVERY == 0)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            done.store(true, std::memory_order_release);
+        });
+
+        std::thread consumer([&]
+        {
+            Control control;
+            Pad pad;
+            Read read;
+            auto seen = [&](size_t slot, Queue::Kind kind, uint32_t seq)
+            {
+                if (seq <= seen_seq[slot][kind])
+                {
+                    ++result.backwards;
+                }
+                seen_seq[slot][kind] = seq;
+                ++result.taken[kind];
+            };
+
+            //One more pass after done so nothing pushed last is left behind
+            bool last_pass = false;
+            while (true)
+            {
+                for (size_t slot = 0; slot < NUM_SLOTS; ++slot)
+                {
+                    if (queue.take_control(slot, control))
+                    {
+                        result.torn += (control.check != mix(control.seq));
+                        seen(slot, Queue::CONTROL, control.seq);
+                        //As if the bus NACKed it, the i2c task keeps it and counts the failure
+                        if (control.seq % 8 == 0)
+                        {
+                            queue.count_failed(Queue::CONTROL);
+                            ++result.failed;
+                        }
+                    }
+                    if (queue.take_pad(slot, pad))
+                    {
+                        for (uint32_t word : pad.words)
+                        {
+                            if (word != mix(pad.seq))
+                            {
+                                ++result.torn;
+                                break;
+                            }
+                        }
+                        seen(slot, Queue::PAD, pad.seq);
+                    }
+                    if (queue.take_read(slot, read))
+                    {
+                        seen(slot, Queue::READ, read.seq);
+                    }
+                }
+                std::this_thread::yield();
+                if (last_pass)
+                {
+                    break;
+                }
+                last_pass = done.load(std::memory_order_acquire);
+            }
+        });
+
+        producer.join();
+        consumer.join();
+
+        for (size_t slot = 0; slot < NUM_SLOTS; ++slot)
+        {
+            for (size_t kind = 0; kind < Queue::NUM_KINDS; ++kind)
+            {
+                result.newest_missing += (seen_seq[slot][kind] != pushed_seq[slot][kind]);
+            }
+        }
+        return result;
+    }
+
+    const char* kind_name(size_t kind)
+    {
+        switch (kind)
+        {
+            case Queue::CONTROL: return "control";
+            case Queue::PAD: return "pad";
+            default: return "read";
+        }
+    }
+
+} // namespace
+
+void bench_i2c_queue()
+{
+    const char* suite = "esp32.i2c_queue";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    Queue queue;
+    const StressResult result = stress(queue);
+    const Queue::Stats stats = queue.stats();
+
+    if (result.torn)
+    {
+        Bench::fail(suite, "torn command");
+    }
+    if (result.backwards)
+    {
+        Bench::fail(suite, "older command after a newer one");
+    }
+    if (result.newest_missing)
+    {
+        Bench::fail(suite, "newest command never arrived");
+    }
+    if (stats.failed[Queue::CONTROL] != result.failed || stats.failed[Queue::PAD] || stats.failed[Queue::READ])
+    {
+        Bench::fail(suite, "failed count doesn't match the failures reported");
+    }
+    if (stats.dropped != result.out_of_range)
+    {
+        Bench::fail(suite, "dropped count doesn't match out of range pushes");
+    }
+
+    if (Bench::csv())
+    {
+        std::printf("suite,kind,pushed,coalesced,taken\n");
+    }
+    else
+    {
+        std::printf("\n[%s] %u pushes from one thread, drained by another, %u dropped\n", suite, PUSHES, stats.dropped);
+        std::printf("%-10s %12s %12s %12s\n", "kind", "pushed", "coalesced", "taken");
+    }
+    for (size_t kind = 0; kind < Queue::NUM_KINDS; ++kind)
+    {
+        if (result.taken[kind] + stats.coalesced[kind] != stats.pushed[kind])
+        {
+            Bench::fail(suite, std::string(kind_name(kind)) + ": taken plus coalesced isn't pushed");
+        }
+        if (Bench::csv())
+        {
+            std::printf("%s,%s,%u,%u,%llu\n", suite, kind_name(kind), stats.pushed[kind], stats.coalesced[kind],
+                static_cast<unsigned long long>(result.taken[kind]));
+            continue;
+        }
+        std::printf("%-10s %12u %12u %12llu\n", kind_name(kind), stats.pushed[kind], stats.coalesced[kind],
+            static_cast<unsigned long long>(result.taken[kind]));
+    }
+
+    //Uncontended cost of a pad push and of taking it
+    Queue bench_queue;
+    Pad pad;
+    Bench::print_header(suite);
+    if (Bench::enabled(suite, "push_pad"))
+    {
+        Bench::print_row(suite, "1 thread", "push_pad", Bench::run(4096, [&](size_t i)
+        {
+            pad.seq = static_cast<uint32_t>(i);
+            Bench::do_not_optimize(bench_queue.push_pad(i % NUM_SLOTS, pad));
+        }));
+    }
+    if (Bench::enabled(suite, "push_take_pad"))
+    {
+        Pad out;
+        Bench::print_row(suite, "1 thread", "push_take_pad", Bench::run(4096, [&](size_t i)
+        {
+            pad.seq = static_cast<uint32_t>(i);
+            bench_queue.push_pad(i % NUM_SLOTS, pad);
+            Bench::do_not_optimize(bench_queue.take_pad(i % NUM_SLOTS, out));
+        }));
+    }
+}
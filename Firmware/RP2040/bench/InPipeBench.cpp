@@ -0,0 +1,197 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <random>
+#include <algorithm>
+
+#include "USBHost/HostInPipe.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Host IN pipe on simulated time: a controller with a new report every frame (bInterval 1), a core1
+//loop that gets to the report callback some time after the transfer completes, and a driver that
+//takes a while to map each report. Re-arming after the driver (what every host driver used to do)
+//is run against HostManager's re-arm before the driver on the same timings. TinyUSB HID's single IN
+//buffer is modelled too, the report the driver parses must not be overwritten by the next transfer
+
+namespace {
+
+    using InPipe = HostInPipe<64>;
+
+    constexpr uint32_t FRAME_US = InPipe::FRAME_US;
+    constexpr uint32_t REPORTS = 200000;
+    constexpr uint32_t HOLD_US = 2; //Copying the report out of TinyUSB's buffer
+
+    enum class Mode { ARM_AFTER, ARM_BEFORE };
+
+    struct Timing
+    {
+        const char* name;
+        uint32_t dispatch_max_us; //Transfer completion to report callback
+        uint32_t parse_min_us;
+        uint32_t parse_max_us;
+        uint32_t spike_per_mille; //Reports that take spike_us to map (profile switch, first parse)
+        uint32_t spike_us;
+    };
+
+    struct Result
+    {
+        uint64_t frames{0};
+        uint64_t reports{0};
+        uint64_t dropped{0};        //Frames the controller had a report but the endpoint wasn't armed
+        uint64_t overwritten{0};    //Next transfer landed in the single buffer while the driver parsed
+        uint64_t torn{0};           //Driver saw a report other than the one delivered
+        InPipe::Stats stats;
+    };
+
+    Result simulate(Mode mode, const Timing& timing, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        InPipe pipe;
+        Result result;
+
+        uint32_t tusb_buffer = 0; //Report id, the frame it was sent in
+        uint32_t armed_us = 0;
+        uint32_t busy_until_us = 0;
+        uint32_t last_frame = 0;
+
+        pipe.reset(0);
+        pipe.armed(0, true);
+
+        for (uint32_t i = 0; i < REPORTS; ++i)
+        {
+            //Transfer completes in the first frame after it was armed
+            const uint32_t frame = armed_us / FRAME_US + 1;
+            const uint32_t complete_us = frame * FRAME_US;
+            tusb_buffer = frame;
+
+            if (i > 0)
+            {
+                result.dropped += frame - last_frame - 1;
+            }
+            last_frame = frame;
+
+            const uint32_t callback_us = std::max(complete_us, busy_until_us) + rng() % (timing.dispatch_max_us + 1);
+            const uint32_t parse_us = (rng() % 1000 < timing.spike_per_mille)
+                ? timing.spike_us : timing.parse_min_us + rng() % (timing.parse_max_us - timing.parse_min_us + 1);
+
+            pipe.completed(callback_us, 8);
+            const uint32_t delivered = tusb_buffer;
+            uint32_t parse_start_us = callback_us;
+            uint32_t parsed = 0;
+
+            if (mode == Mode::ARM_BEFORE)
+            {
+                uint16_t len = sizeof(tusb_buffer);
+                const uint8_t* held = pipe.hold(reinterpret_cast<const uint8_t*>(&tusb_buffer), len);
+                parse_start_us += HOLD_US;
+                armed_us = parse_start_us;
+                pipe.armed(armed_us, true);
+
+                //The next transfer can complete mid parse and lands in TinyUSB's buffer, not the held copy
+                if ((armed_us / FRAME_US + 1) * FRAME_US < parse_start_us + parse_us)
+                {
+                    tusb_buffer = armed_us / FRAME_US + 1;
+                    ++result.overwritten;
+                }
+                std::memcpy(&parsed, held, sizeof(parsed));
+            }
+            else
+            {
+                std::memcpy(&parsed, &tusb_buffer, sizeof(parsed));
+                armed_us = parse_start_us + parse_us;
+                pipe.armed(armed_us, true);
+            }
+
+            busy_until_us = parse_start_us + parse_us;
+            result.torn += (parsed != delivered) ? 1 : 0;
+            ++result.reports;
+        }
+
+        result.frames = last_frame;
+        result.stats = pipe.stats();
+        return result;
+    }
+
+    void print_header(const char* suite)
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,timing,mode,frames,reports,dropped,unarmed_frames,max_unarmed_us,overwritten,torn\n");
+            return;
+        }
+        std::printf("\n[%s] %u reports from a 1 kHz controller\n", suite, REPORTS);
+        std::printf("%-16s %-11s %9s %9s %9s %15s %15s %12s %6s\n",
+            "timing", "mode", "frames", "reports", "dropped", "unarmed frames", "max unarmed us", "overwritten", "torn");
+    }
+
+    void print_row(const char* suite, const Timing& timing, Mode mode, const Result& result)
+    {
+        const char* mode_name = (mode == Mode::ARM_BEFORE) ? "arm_before" : "arm_after";
+        if (Bench::csv())
+        {
+            std::printf("%s,%s,%s,%llu,%llu,%llu,%u,%u,%llu,%llu\n", suite, timing.name, mode_name,
+                static_cast<unsigned long long>(result.frames), static_cast<unsigned long long>(result.reports),
+                static_cast<unsigned long long>(result.dropped), result.stats.unarmed_frames, result.stats.max_unarmed_us,
+                static_cast<unsigned long long>(result.overwritten), static_cast<unsigned long long>(result.torn));
+            return;
+        }
+        std::printf("%-16s %-11s %9llu %9llu %9llu %15u %15u %12llu %6llu\n", timing.name, mode_name,
+            static_cast<unsigned long long>(result.frames), static_cast<unsigned long long>(result.reports),
+            static_cast<unsigned long long>(result.dropped), result.stats.unarmed_frames, result.stats.max_unarmed_us,
+            static_cast<unsigned long long>(result.overwritten), static_cast<unsigned long long>(result.torn));
+    }
+
+} // namespace
+
+void bench_in_pipe()
+{
+    const char* suite = "host.in_pipe";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const Timing timings[] =
+    {
+        //Plain mapping, the callback always runs inside the frame
+        { "typical", 150, 60, 300, 0, 0 },
+        //A busier loop and Fix16 shaping with every option on
+        { "heavy", 400, 300, 900, 0, 0 },
+        //Occasional slow reports, generic HID first parse or a profile change
+        { "spikes", 200, 60, 400, 20, 2500 },
+    };
+
+    print_header(suite);
+    for (const Timing& timing : timings)
+    {
+        const Result after = simulate(Mode::ARM_AFTER, timing, 0x1A2B);
+        const Result before = simulate(Mode::ARM_BEFORE, timing, 0x1A2B);
+        print_row(suite, timing, Mode::ARM_AFTER, after);
+        print_row(suite, timing, Mode::ARM_BEFORE, before);
+
+        if (before.torn > 0 || after.torn > 0)
+        {
+            Bench::fail(suite, std::string(timing.name) + " driver parsed a report the next transfer overwrote");
+        }
+        if (before.dropped > after.dropped || (after.dropped > 0 && before.dropped == after.dropped))
+        {
+            Bench::fail(suite, std::string(timing.name) + " re-arming first dropped more polls");
+        }
+        //Every report handled inside a frame, re-arming first has to catch every poll
+        if (timing.spike_per_mille == 0 && timing.dispatch_max_us + HOLD_US + timing.parse_max_us < FRAME_US && before.dropped > 0)
+        {
+            Bench::fail(suite, std::string(timing.name) + " polls dropped with the endpoint re-armed first");
+        }
+        //Counted from the callback, the wait for the loop to get there isn't seen
+        if (before.stats.unarmed_frames > before.dropped || after.stats.unarmed_frames > after.dropped)
+        {
+            Bench::fail(suite, std::string(timing.name) + " unarmed frame counter over the real drops");
+        }
+        if (before.stats.reports != REPORTS || after.stats.reports != REPORTS)
+        {
+            Bench::fail(suite, std::string(timing.name) + " report counter");
+        }
+    }
+}
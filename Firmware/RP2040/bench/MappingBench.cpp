@@ -0,0 +1,392 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <memory>
+
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserProfile.h"
+#include "Descriptors/PS3.h"
+#include "Descriptors/PS4.h"
+#include "Descriptors/PSClassic.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//The SourceMap/MappingPlan and DeviceMap/KeyMap tables against the if-chains they replaced, on random
+//reports and random profiles (buttons remapped to several buttons or to none). Any difference in the
+//mapped bits fails the suite, then both are timed per report
+
+namespace {
+
+    constexpr size_t NUM_SAMPLES = 4096;
+    constexpr size_t NUM_PROFILES = 64;
+
+    //What Gamepad::set_profile_mappings used to fill in for the drivers
+    struct LegacyMap
+    {
+        uint8_t up, down, left, right;
+        uint8_t up_left, up_right, down_left, down_right;
+        uint16_t a, b, x, y, l3, r3, back, start, lb, rb, sys, misc;
+
+        explicit LegacyMap(const UserProfile& profile)
+            :   up(profile.dpad_up), down(profile.dpad_down), left(profile.dpad_left), right(profile.dpad_right),
+                up_left(profile.dpad_up | profile.dpad_left), up_right(profile.dpad_up | profile.dpad_right),
+                down_left(profile.dpad_down | profile.dpad_left), down_right(profile.dpad_down | profile.dpad_right),
+                a(profile.button_a), b(profile.button_b), x(profile.button_x), y(profile.button_y),
+                l3(profile.button_l3), r3(profile.button_r3), back(profile.button_back), start(profile.button_start),
+                lb(profile.button_lb), rb(profile.button_rb), sys(profile.button_sys), misc(profile.button_misc) {}
+    };
+
+    //Same rules as the PS4 and PSClassic host drivers and the PS3 device driver
+    constexpr SourceMap<3> PS4_MAP = SourceMap<3>()
+        .hat(0, PS4::DPAD_MASK, { PS4::Buttons0::DPAD_UP, PS4::Buttons0::DPAD_UP_RIGHT, PS4::Buttons0::DPAD_RIGHT, PS4::Buttons0::DPAD_RIGHT_DOWN,
+                                  PS4::Buttons0::DPAD_DOWN, PS4::Buttons0::DPAD_DOWN_LEFT, PS4::Buttons0::DPAD_LEFT, PS4::Buttons0::DPAD_LEFT_UP })
+        .button(0, PS4::Buttons0::SQUARE,   Gamepad::BUTTON_X)
+        .button(0, PS4::Buttons0::CROSS,    Gamepad::BUTTON_A)
+        .button(0, PS4::Buttons0::CIRCLE,   Gamepad::BUTTON_B)
+        .button(0, PS4::Buttons0::TRIANGLE, Gamepad::BUTTON_Y)
+        .button(1, PS4::Buttons1::L1,       Gamepad::BUTTON_LB)
+        .button(1, PS4::Buttons1::R1,       Gamepad::BUTTON_RB)
+        .button(1, PS4::Buttons1::L3,       Gamepad::BUTTON_L3)
+        .button(1, PS4::Buttons1::R3,       Gamepad::BUTTON_R3)
+        .button(1, PS4::Buttons1::SHARE,    Gamepad::BUTTON_BACK)
+        .button(1, PS4::Buttons1::OPTIONS,  Gamepad::BUTTON_START)
+        .button(2, PS4::Buttons2::PS,       Gamepad::BUTTON_SYS)
+        .button(2, PS4::Buttons2::TP,       Gamepad::BUTTON_MISC);
+
+    constexpr SourceMap<2> PSCLASSIC_MAP = SourceMap<2>()
+        .hat(0, PSClassic::DPAD_MASK, { PSClassic::Buttons::UP, PSClassic::Buttons::UP_RIGHT, PSClassic::Buttons::RIGHT, PSClassic::Buttons::DOWN_RIGHT,
+                                        PSClassic::Buttons::DOWN, PSClassic::Buttons::DOWN_LEFT, PSClassic::Buttons::LEFT, PSClassic::Buttons::UP_LEFT })
+        .button(0, PSClassic::Buttons::SQUARE,   Gamepad::BUTTON_X)
+        .button(0, PSClassic::Buttons::CROSS,    Gamepad::BUTTON_A)
+        .button(0, PSClassic::Buttons::CIRCLE,   Gamepad::BUTTON_B)
+        .button(0, PSClassic::Buttons::TRIANGLE, Gamepad::BUTTON_Y)
+        .button(0, PSClassic::Buttons::L1,       Gamepad::BUTTON_LB)
+        .button(0, PSClassic::Buttons::R1,       Gamepad::BUTTON_RB)
+        .button(0, PSClassic::Buttons::SELECT,   Gamepad::BUTTON_BACK)
+        .button(0, PSClassic::Buttons::START,    Gamepad::BUTTON_START);
+
+    constexpr DeviceMap<3> PS3_MAP = DeviceMap<3>()
+        .hat(0, PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT | PS3::Buttons0::DPAD_RIGHT,
+            {   PS3::Buttons0::DPAD_UP,
+                PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_RIGHT,
+                PS3::Buttons0::DPAD_RIGHT,
+                PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_RIGHT,
+                PS3::Buttons0::DPAD_DOWN,
+                PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT,
+                PS3::Buttons0::DPAD_LEFT,
+                PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_LEFT }, 0)
+        .button(Gamepad::BUTTON_X,     1, PS3::Buttons1::SQUARE)
+        .button(Gamepad::BUTTON_A,     1, PS3::Buttons1::CROSS)
+        .button(Gamepad::BUTTON_Y,     1, PS3::Buttons1::TRIANGLE)
+        .button(Gamepad::BUTTON_B,     1, PS3::Buttons1::CIRCLE)
+        .button(Gamepad::BUTTON_LB,    1, PS3::Buttons1::L1)
+        .button(Gamepad::BUTTON_RB,    1, PS3::Buttons1::R1)
+        .button(Gamepad::BUTTON_BACK,  0, PS3::Buttons0::SELECT)
+        .button(Gamepad::BUTTON_START, 0, PS3::Buttons0::START)
+        .button(Gamepad::BUTTON_L3,    0, PS3::Buttons0::L3)
+        .button(Gamepad::BUTTON_R3,    0, PS3::Buttons0::R3)
+        .button(Gamepad::BUTTON_SYS,   2, PS3::Buttons2::SYS)
+        .button(Gamepad::BUTTON_MISC,  2, PS3::Buttons2::TP);
+
+    //Chatpad style, key codes to words of a 3 word report, some keys sharing a bit
+    constexpr KeyMap<6> KEY_MAP = KeyMap<6>()
+        .key(17, 0, 0x0001).key(18, 0, 0x0100).key(19, 1, 0x0080).key(20, 2, 0x0001)
+        .key(21, 2, 0x0001).key(55, 4, 0x8000).key(70, 5, 0x0010).key(99, 3, 0x0002)
+        .key(100, 3, 0x0002).key(127, 0, 0x0004);
+
+    struct KeyRule
+    {
+        uint8_t key;
+        uint8_t byte;
+        uint8_t mask;
+    };
+
+    constexpr KeyRule KEY_RULES[] =
+    {
+        { 17, 0, 0x01 }, { 18, 1, 0x01 }, { 19, 1, 0x80 }, { 20, 2, 0x01 }, { 21, 2, 0x01 },
+        { 55, 5, 0x80 }, { 70, 5, 0x10 }, { 99, 3, 0x02 }, { 100, 3, 0x02 }, { 127, 0, 0x04 }
+    };
+
+    MappingPlan::Pad legacy_ps4(const LegacyMap& map, const uint8_t* buttons)
+    {
+        MappingPlan::Pad pad;
+        switch (buttons[0] & PS4::DPAD_MASK)
+        {
+            case PS4::Buttons0::DPAD_UP:         pad.dpad |= map.up;         break;
+            case PS4::Buttons0::DPAD_DOWN:       pad.dpad |= map.down;       break;
+            case PS4::Buttons0::DPAD_LEFT:       pad.dpad |= map.left;       break;
+            case PS4::Buttons0::DPAD_RIGHT:      pad.dpad |= map.right;      break;
+            case PS4::Buttons0::DPAD_UP_RIGHT:   pad.dpad |= map.up_right;   break;
+            case PS4::Buttons0::DPAD_RIGHT_DOWN: pad.dpad |= map.down_right; break;
+            case PS4::Buttons0::DPAD_DOWN_LEFT:  pad.dpad |= map.down_left;  break;
+            case PS4::Buttons0::DPAD_LEFT_UP:    pad.dpad |= map.up_left;    break;
+            default: break;
+        }
+        if (buttons[0] & PS4::Buttons0::SQUARE)   pad.buttons |= map.x;
+        if (buttons[0] & PS4::Buttons0::CROSS)    pad.buttons |= map.a;
+        if (buttons[0] & PS4::Buttons0::CIRCLE)   pad.buttons |= map.b;
+        if (buttons[0] & PS4::Buttons0::TRIANGLE) pad.buttons |= map.y;
+        if (buttons[1] & PS4::Buttons1::L1)       pad.buttons |= map.lb;
+        if (buttons[1] & PS4::Buttons1::R1)       pad.buttons |= map.rb;
+        if (buttons[1] & PS4::Buttons1::L3)       pad.buttons |= map.l3;
+        if (buttons[1] & PS4::Buttons1::R3)       pad.buttons |= map.r3;
+        if (buttons[1] & PS4::Buttons1::SHARE)    pad.buttons |= map.back;
+        if (buttons[1] & PS4::Buttons1::OPTIONS)  pad.buttons |= map.start;
+        if (buttons[2] & PS4::Buttons2::PS)       pad.buttons |= map.sys;
+        if (buttons[2] & PS4::Buttons2::TP)       pad.buttons |= map.misc;
+        return pad;
+    }
+
+    MappingPlan::Pad legacy_psclassic(const LegacyMap& map, uint16_t buttons)
+    {
+        MappingPlan::Pad pad;
+        switch (buttons & PSClassic::DPAD_MASK)
+        {
+            case PSClassic::Buttons::UP:         pad.dpad |= map.up;         break;
+            case PSClassic::Buttons::DOWN:       pad.dpad |= map.down;       break;
+            case PSClassic::Buttons::LEFT:       pad.dpad |= map.left;       break;
+            case PSClassic::Buttons::RIGHT:      pad.dpad |= map.right;      break;
+            case PSClassic::Buttons::UP_RIGHT:   pad.dpad |= map.up_right;   break;
+            case PSClassic::Buttons::DOWN_RIGHT: pad.dpad |= map.down_right; break;
+            case PSClassic::Buttons::DOWN_LEFT:  pad.dpad |= map.down_left;  break;
+            case PSClassic::Buttons::UP_LEFT:    pad.dpad |= map.up_left;    break;
+            default: break;
+        }
+        if (buttons & PSClassic::Buttons::SQUARE)   pad.buttons |= map.x;
+        if (buttons & PSClassic::Buttons::CROSS)    pad.buttons |= map.a;
+        if (buttons & PSClassic::Buttons::CIRCLE)   pad.buttons |= map.b;
+        if (buttons & PSClassic::Buttons::TRIANGLE) pad.buttons |= map.y;
+        if (buttons & PSClassic::Buttons::L1)       pad.buttons |= map.lb;
+        if (buttons & PSClassic::Buttons::R1)       pad.buttons |= map.rb;
+        if (buttons & PSClassic::Buttons::SELECT)   pad.buttons |= map.back;
+        if (buttons & PSClassic::Buttons::START)    pad.buttons |= map.start;
+        return pad;
+    }
+
+    void legacy_ps3(uint16_t buttons, uint8_t dpad, uint8_t* out)
+    {
+        out[0] = out[1] = out[2] = 0;
+        switch (dpad)
+        {
+            case Gamepad::DPAD_UP:         out[0] = PS3::Buttons0::DPAD_UP;                             break;
+            case Gamepad::DPAD_DOWN:       out[0] = PS3::Buttons0::DPAD_DOWN;                           break;
+            case Gamepad::DPAD_LEFT:       out[0] = PS3::Buttons0::DPAD_LEFT;                           break;
+            case Gamepad::DPAD_RIGHT:      out[0] = PS3::Buttons0::DPAD_RIGHT;                          break;
+            case Gamepad::DPAD_UP_LEFT:    out[0] = PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_LEFT;    break;
+            case Gamepad::DPAD_UP_RIGHT:   out[0] = PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_RIGHT;   break;
+            case Gamepad::DPAD_DOWN_LEFT:  out[0] = PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT;  break;
+            case Gamepad::DPAD_DOWN_RIGHT: out[0] = PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_RIGHT; break;
+            default: break;
+        }
+        if (buttons & Gamepad::BUTTON_X)     out[1] |= PS3::Buttons1::SQUARE;
+        if (buttons & Gamepad::BUTTON_A)     out[1] |= PS3::Buttons1::CROSS;
+        if (buttons & Gamepad::BUTTON_Y)     out[1] |= PS3::Buttons1::TRIANGLE;
+        if (buttons & Gamepad::BUTTON_B)     out[1] |= PS3::Buttons1::CIRCLE;
+        if (buttons & Gamepad::BUTTON_LB)    out[1] |= PS3::Buttons1::L1;
+        if (buttons & Gamepad::BUTTON_RB)    out[1] |= PS3::Buttons1::R1;
+        if (buttons & Gamepad::BUTTON_BACK)  out[0] |= PS3::Buttons0::SELECT;
+        if (buttons & Gamepad::BUTTON_START) out[0] |= PS3::Buttons0::START;
+        if (buttons & Gamepad::BUTTON_L3)    out[0] |= PS3::Buttons0::L3;
+        if (buttons & Gamepad::BUTTON_R3)    out[0] |= PS3::Buttons0::R3;
+        if (buttons & Gamepad::BUTTON_SYS)   out[2] |= PS3::Buttons2::SYS;
+        if (buttons & Gamepad::BUTTON_MISC)  out[2] |= PS3::Buttons2::TP;
+    }
+
+    void legacy_keys(const uint8_t* keys, size_t count, uint8_t* out)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (const auto& rule : KEY_RULES)
+            {
+                if (keys[i] == rule.key)
+                {
+                    out[rule.byte] |= rule.mask;
+                }
+            }
+        }
+    }
+
+    //Mostly one button per button, then swaps, several at once and unmapped
+    UserProfile random_profile(std::mt19937& rng)
+    {
+        UserProfile profile;
+        auto button = [&rng](uint16_t own) -> uint16_t
+        {
+            switch (rng() % 4)
+            {
+                case 0:  return own;
+                case 1:  return static_cast<uint16_t>(1U << (rng() % 12));
+                case 2:  return static_cast<uint16_t>(rng() & 0x0FFF);
+                default: return 0;
+            }
+        };
+        auto dpad = [&rng](uint8_t own) -> uint8_t
+        {
+            return (rng() % 2) ? own : static_cast<uint8_t>(rng() & 0x0F);
+        };
+        profile.dpad_up      = dpad(Gamepad::DPAD_UP);
+        profile.dpad_down    = dpad(Gamepad::DPAD_DOWN);
+        profile.dpad_left    = dpad(Gamepad::DPAD_LEFT);
+        profile.dpad_right   = dpad(Gamepad::DPAD_RIGHT);
+        profile.button_a     = button(Gamepad::BUTTON_A);
+        profile.button_b     = button(Gamepad::BUTTON_B);
+        profile.button_x     = button(Gamepad::BUTTON_X);
+        profile.button_y     = button(Gamepad::BUTTON_Y);
+        profile.button_l3    = button(Gamepad::BUTTON_L3);
+        profile.button_r3    = button(Gamepad::BUTTON_R3);
+        profile.button_back  = button(Gamepad::BUTTON_BACK);
+        profile.button_start = button(Gamepad::BUTTON_START);
+        profile.button_lb    = button(Gamepad::BUTTON_LB);
+        profile.button_rb    = button(Gamepad::BUTTON_RB);
+        profile.button_sys   = button(Gamepad::BUTTON_SYS);
+        profile.button_misc  = button(Gamepad::BUTTON_MISC);
+        return profile;
+    }
+
+    bool same(const MappingPlan::Pad& pad, const Gamepad::PadIn& pad_in)
+    {
+        return pad.buttons == pad_in.buttons && pad.dpad == pad_in.dpad;
+    }
+
+} // namespace
+
+void bench_mapping()
+{
+    const char* suite = "mapping";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    std::mt19937 rng(0x4D415053);
+
+    //Button bytes with every dpad value, centered and out of range included
+    std::vector<std::array<uint8_t, 3>> reports(NUM_SAMPLES);
+    std::vector<std::pair<uint16_t, uint8_t>> pads(NUM_SAMPLES);
+    std::vector<std::array<uint8_t, 2>> keys(NUM_SAMPLES);
+    for (size_t i = 0; i < NUM_SAMPLES; ++i)
+    {
+        for (auto& byte : reports[i])
+        {
+            byte = static_cast<uint8_t>(rng());
+        }
+        pads[i] = { static_cast<uint16_t>(rng() & 0x0FFF), static_cast<uint8_t>(rng() & 0x0F) };
+        keys[i] = { static_cast<uint8_t>(rng() % 140), static_cast<uint8_t>((rng() % 2) ? 0 : (rng() % 140)) };
+    }
+
+    size_t host_mismatches = 0;
+    for (size_t p = 0; p < NUM_PROFILES; ++p)
+    {
+        const UserProfile profile = (p == 0) ? UserProfile() : random_profile(rng);
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_profile(profile);
+        const LegacyMap legacy(profile);
+
+        for (const auto& report : reports)
+        {
+            Gamepad::PadIn pad_in;
+            gamepad->remap(PS4_MAP.map(report.data()), pad_in);
+            host_mismatches += same(legacy_ps4(legacy, report.data()), pad_in) ? 0 : 1;
+
+            uint16_t buttons;
+            std::memcpy(&buttons, report.data(), sizeof(buttons));
+            gamepad->remap(PSCLASSIC_MAP.map(report.data()), pad_in);
+            host_mismatches += same(legacy_psclassic(legacy, buttons), pad_in) ? 0 : 1;
+        }
+    }
+    if (host_mismatches)
+    {
+        Bench::fail(suite, "host tables differ from the if-chains on " + std::to_string(host_mismatches) + " reports");
+    }
+
+    size_t device_mismatches = 0;
+    for (const auto& pad : pads)
+    {
+        uint8_t expected[3];
+        uint8_t mapped[3] = {};
+        legacy_ps3(pad.first, pad.second, expected);
+        PS3_MAP.apply(pad.first, pad.second, mapped);
+        device_mismatches += (std::memcmp(expected, mapped, sizeof(mapped)) == 0) ? 0 : 1;
+    }
+    for (const auto& key : keys)
+    {
+        uint8_t expected[6] = {};
+        uint8_t mapped[6] = {};
+        legacy_keys(key.data(), key.size(), expected);
+        KEY_MAP.apply(key.data(), key.size(), mapped);
+        device_mismatches += (std::memcmp(expected, mapped, sizeof(mapped)) == 0) ? 0 : 1;
+    }
+    if (device_mismatches)
+    {
+        Bench::fail(suite, "device tables differ from the if-chains on " + std::to_string(device_mismatches) + " reports");
+    }
+
+    Bench::print_header(suite);
+
+    UserProfile profile;
+    rng.seed(7);
+    profile = random_profile(rng);
+    auto gamepad = std::make_unique<Gamepad>();
+    gamepad->set_profile(profile);
+    const LegacyMap legacy(profile);
+
+    auto row = [&](const char* name, auto&& func)
+    {
+        if (Bench::enabled(suite, name))
+        {
+            Bench::print_row(suite, "remapped", name, Bench::run(NUM_SAMPLES, func));
+        }
+    };
+
+    row("ps4_host_if_chain", [&](size_t i)
+    {
+        Bench::do_not_optimize(legacy_ps4(legacy, reports[i].data()));
+    });
+    row("ps4_host_tables", [&](size_t i)
+    {
+        Gamepad::PadIn pad_in;
+        gamepad->remap(PS4_MAP.map(reports[i].data()), pad_in);
+        Bench::do_not_optimize(pad_in.buttons);
+        Bench::do_not_optimize(pad_in.dpad);
+    });
+    row("psclassic_host_if_chain", [&](size_t i)
+    {
+        uint16_t buttons;
+        std::memcpy(&buttons, reports[i].data(), sizeof(buttons));
+        Bench::do_not_optimize(legacy_psclassic(legacy, buttons));
+    });
+    row("psclassic_host_tables", [&](size_t i)
+    {
+        Gamepad::PadIn pad_in;
+        gamepad->remap(PSCLASSIC_MAP.map(reports[i].data()), pad_in);
+        Bench::do_not_optimize(pad_in.buttons);
+        Bench::do_not_optimize(pad_in.dpad);
+    });
+    row("ps3_device_if_chain", [&](size_t i)
+    {
+        uint8_t out[3];
+        legacy_ps3(pads[i].first, pads[i].second, out);
+        Bench::do_not_optimize(out);
+    });
+    row("ps3_device_tables", [&](size_t i)
+    {
+        uint8_t out[3] = {};
+        PS3_MAP.apply(pads[i].first, pads[i].second, out);
+        Bench::do_not_optimize(out);
+    });
+    row("chatpad_keys_loop", [&](size_t i)
+    {
+        uint8_t out[6] = {};
+        legacy_keys(keys[i].data(), keys[i].size(), out);
+        Bench::do_not_optimize(out);
+    });
+    row("chatpad_keys_table", [&](size_t i)
+    {
+        uint8_t out[6] = {};
+        KEY_MAP.apply(keys[i].data(), keys[i].size(), out);
+        Bench::do_not_optimize(out);
+    });
+}
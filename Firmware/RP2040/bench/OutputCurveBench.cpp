@@ -0,0 +1,307 @@
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "Gamepad/OutputCurve.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//OutputCurve against the float curves the XInput and PS4 device drivers used to run, with the
+//drivers' own settings and random profile settings, over a sweep of the whole stick square.
+//Fails if the fixed point output is further off than MAX_ERROR_INT16 on XInput's int16 axes or
+//MAX_ERROR_UINT8 on PS4's 8 bit axes. Timing is per stick; the host has an FPU, the RP2040
+//runs the float versions in software so the gap there is much wider
+
+namespace {
+
+    constexpr int32_t SWEEP_STEP = 64;
+    constexpr int32_t MAX_ERROR_INT16 = 16;
+    constexpr int32_t MAX_ERROR_UINT8 = 1;
+    constexpr size_t NUM_SAMPLES = 4096;
+    constexpr size_t NUM_PROFILES = 32;
+
+    //XInputDevice's apply_stick_curve_mixed, with the 80/20 mix as a setting
+    void float_xinput(int16_t in_x, int16_t in_y, float deadzone, float gamma, float linear_mix, float sensitivity,
+                      int16_t& out_x, int16_t& out_y)
+    {
+        constexpr float MAX_VAL = 32767.0f;
+        float vx = static_cast<float>(in_x) / MAX_VAL;
+        float vy = static_cast<float>(in_y) / MAX_VAL;
+        float mag = std::sqrt(vx * vx + vy * vy);
+        if (mag <= deadzone || mag < 0.001f)
+        {
+            out_x = 0; out_y = 0; return;
+        }
+        if (mag > 1.0f) mag = 1.0f;
+
+        float adj = (mag - deadzone) / (1.0f - deadzone);
+        adj = std::fmax(0.0f, std::fmin(1.0f, adj));
+        float out_frac = (std::pow(adj, gamma) * (1.0f - linear_mix)) + (adj * linear_mix);
+        out_frac *= sensitivity;
+
+        float scale = out_frac / mag;
+        auto clamp_int16 = [](int32_t val) { return static_cast<int16_t>(std::clamp(val, -32768, 32767)); };
+        out_x = clamp_int16(static_cast<int32_t>(vx * scale * MAX_VAL));
+        out_y = clamp_int16(static_cast<int32_t>(vy * scale * MAX_VAL));
+    }
+
+    uint8_t map_signed_to_uint8(float signed_val)
+    {
+        if (signed_val >= 0.99f) return 255;
+        if (signed_val <= -0.99f) return 0;
+        int out = static_cast<int>(std::round(signed_val * 127.5f + 127.5f));
+        return static_cast<uint8_t>(std::clamp(out, 0, 255));
+    }
+
+    //PS4Device's apply_stick_steam_radial
+    void float_ps4(int16_t in_x, int16_t in_y, float deadzone, float sensitivity, float curve, uint8_t& out_x, uint8_t& out_y)
+    {
+        constexpr float INT16_MAX_F = 32767.0f;
+        float vx = static_cast<float>(in_x) / INT16_MAX_F;
+        float vy = static_cast<float>(in_y) / INT16_MAX_F;
+        float mag = std::sqrt(vx * vx + vy * vy);
+        if (mag <= deadzone || mag < 0.001f)
+        {
+            out_x = 128; out_y = 128; return;
+        }
+        if (mag > 1.0f) mag = 1.0f;
+
+        float adj = (mag - deadzone) / (1.0f - deadzone);
+        adj = std::fmax(0.0f, std::fmin(1.0f, adj));
+        float out_frac = adj * sensitivity;
+        if (curve != 1.0f) out_frac = std::pow(out_frac, curve);
+        if (out_frac > 1.0f) out_frac = 1.0f;
+
+        float scale = out_frac / mag;
+        out_x = map_signed_to_uint8(std::clamp(vx * scale, -1.0f, 1.0f));
+        out_y = map_signed_to_uint8(std::clamp(vy * scale, -1.0f, 1.0f));
+    }
+
+    //Same as PS4Device
+    uint8_t stick_to_uint8(int16_t value)
+    {
+        constexpr int32_t SATURATE = 32440;
+        if (value >= SATURATE) return 255;
+        if (value <= -SATURATE) return 0;
+        return static_cast<uint8_t>(((static_cast<int32_t>(value) + 32767) * 255 + 32767) / (2 * 32767));
+    }
+
+    struct Curve
+    {
+        const char* name;
+        float deadzone;
+        float curve;
+        float linear_mix;
+        float sensitivity;
+        bool uncap_radius;
+        bool ps4;               //Checked on PS4's 8 bit axes, float_ps4 takes the sensitivity before the curve
+        float ps4_sensitivity;
+    };
+
+    OutputCurveRaw to_raw(const Curve& curve)
+    {
+        OutputCurveRaw raw;
+        raw.enabled = true;
+        raw.deadzone = fix16_from_float(curve.deadzone);
+        raw.curve = fix16_from_float(curve.curve);
+        raw.linear_mix = fix16_from_float(curve.linear_mix);
+        raw.sensitivity = fix16_from_float(curve.ps4 ? std::pow(curve.ps4_sensitivity, curve.curve) : curve.sensitivity);
+        raw.uncap_radius = curve.uncap_radius;
+        return raw;
+    }
+
+    struct Accuracy
+    {
+        int32_t max_error{0};
+        double mean_error{0.0};
+    };
+
+    Accuracy sweep(const Curve& curve, const OutputCurve& fixed)
+    {
+        Accuracy accuracy;
+        uint64_t total = 0;
+        uint64_t samples = 0;
+        for (int32_t y = INT16_MIN; y <= INT16_MAX; y += SWEEP_STEP)
+        {
+            for (int32_t x = INT16_MIN; x <= INT16_MAX; x += SWEEP_STEP)
+            {
+                const int16_t in_x = static_cast<int16_t>(x);
+                const int16_t in_y = static_cast<int16_t>(y);
+                int16_t shaped_x, shaped_y;
+                fixed.shape(in_x, in_y, shaped_x, shaped_y);
+
+                int32_t error = 0;
+                if (curve.ps4)
+                {
+                    uint8_t ref_x, ref_y;
+                    float_ps4(in_x, in_y, curve.deadzone, curve.ps4_sensitivity, curve.curve, ref_x, ref_y);
+                    error = std::max(std::abs(stick_to_uint8(shaped_x) - ref_x), std::abs(stick_to_uint8(shaped_y) - ref_y));
+                }
+                else
+                {
+                    int16_t ref_x, ref_y;
+                    float_xinput(in_x, in_y, curve.deadzone, curve.curve, curve.linear_mix, curve.sensitivity, ref_x, ref_y);
+                    error = std::max(std::abs(shaped_x - ref_x), std::abs(shaped_y - ref_y));
+                }
+                accuracy.max_error = std::max(accuracy.max_error, error);
+                total += static_cast<uint64_t>(error);
+                ++samples;
+            }
+        }
+        accuracy.mean_error = static_cast<double>(total) / static_cast<double>(samples);
+        return accuracy;
+    }
+
+    void print_accuracy_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,curve,units,max_error,mean_error\n");
+            return;
+        }
+        std::printf("\n[device.output_curve] accuracy vs float, max %d (int16) / %d (uint8)\n", MAX_ERROR_INT16, MAX_ERROR_UINT8);
+        std::printf("%-22s %8s %10s %12s\n", "curve", "units", "max err", "mean err");
+    }
+
+    void print_accuracy_row(const Curve& curve, const Accuracy& accuracy)
+    {
+        const char* units = curve.ps4 ? "uint8" : "int16";
+        if (Bench::csv())
+        {
+            std::printf("device.output_curve,%s,%s,%d,%.4f\n", curve.name, units, accuracy.max_error, accuracy.mean_error);
+            return;
+        }
+        std::printf("%-22s %8s %10d %12.4f\n", curve.name, units, accuracy.max_error, accuracy.mean_error);
+    }
+
+} // namespace
+
+void bench_output_curve()
+{
+    const char* suite = "device.output_curve";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    //The drivers' own curves, then random ones a profile could ask for
+    std::vector<Curve> curves =
+    {
+        { "xinput_left",  0.05f,  1.6f,  0.2f, 1.10f, true,  false, 0.0f  },
+        { "xinput_right", 0.05f,  1.5f,  0.2f, 1.10f, true,  false, 0.0f  },
+        { "ps4_left",     0.016f, 0.82f, 0.0f, 0.0f,  false, true,  1.08f },
+        { "ps4_right",    0.07f,  1.0f,  0.0f, 0.0f,  false, true,  1.02f },
+    };
+
+    std::mt19937 rng(0x43555256);
+    std::uniform_real_distribution<float> deadzone(0.0f, 0.3f);
+    std::uniform_real_distribution<float> gamma(0.5f, 3.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> sensitivity(0.5f, 1.5f);
+    for (size_t i = 0; i < NUM_PROFILES; ++i)
+    {
+        Curve curve{ (i % 2) ? "profile_ps4" : "profile_xinput", deadzone(rng), gamma(rng), 0.0f, 0.0f, true, (i % 2) != 0, 0.0f };
+        if (curve.ps4)
+        {
+            curve.uncap_radius = false;
+            //The profile's sensitivity is sensitivity^curve here, which only goes up to 2.0
+            curve.ps4_sensitivity = std::min(sensitivity(rng), std::pow(2.0f, 1.0f / curve.curve));
+        }
+        else
+        {
+            curve.linear_mix = unit(rng);
+            curve.sensitivity = sensitivity(rng);
+        }
+        curves.push_back(curve);
+    }
+
+    print_accuracy_header();
+
+    Accuracy profile_xinput, profile_ps4;
+    for (size_t i = 0; i < curves.size(); ++i)
+    {
+        const Curve& curve = curves[i];
+        OutputCurve fixed;
+        fixed.compile(to_raw(curve));
+        const Accuracy accuracy = sweep(curve, fixed);
+
+        if (accuracy.max_error > (curve.ps4 ? MAX_ERROR_UINT8 : MAX_ERROR_INT16))
+        {
+            char what[160];
+            std::snprintf(what, sizeof(what), "%s (dz %.3f curve %.3f mix %.3f) is off by %d",
+                curve.name, curve.deadzone, curve.curve, curve.linear_mix, accuracy.max_error);
+            Bench::fail(suite, what);
+        }
+
+        if (i < 4)
+        {
+            print_accuracy_row(curve, accuracy);
+            continue;
+        }
+        Accuracy& worst = curve.ps4 ? profile_ps4 : profile_xinput;
+        worst.max_error = std::max(worst.max_error, accuracy.max_error);
+        worst.mean_error = std::max(worst.mean_error, accuracy.mean_error);
+    }
+    print_accuracy_row({ "profile_xinput (worst)", 0.0f, 0.0f, 0.0f, 0.0f, true, false, 0.0f }, profile_xinput);
+    print_accuracy_row({ "profile_ps4 (worst)", 0.0f, 0.0f, 0.0f, 0.0f, false, true, 0.0f }, profile_ps4);
+
+    std::vector<std::pair<int16_t, int16_t>> samples(NUM_SAMPLES);
+    std::uniform_int_distribution<int32_t> axis(INT16_MIN, INT16_MAX);
+    for (auto& sample : samples)
+    {
+        sample = { static_cast<int16_t>(axis(rng)), static_cast<int16_t>(axis(rng)) };
+    }
+
+    OutputCurve xinput, ps4;
+    xinput.compile(to_raw(curves[0]));
+    ps4.compile(to_raw(curves[2]));
+
+    Bench::print_header(suite);
+
+    auto row = [&](const char* name, auto&& func)
+    {
+        if (Bench::enabled(suite, name))
+        {
+            Bench::print_row(suite, "driver", name, Bench::run(NUM_SAMPLES, func));
+        }
+    };
+
+    row("xinput_float", [&](size_t i)
+    {
+        int16_t out_x, out_y;
+        float_xinput(samples[i].first, samples[i].second, 0.05f, 1.6f, 0.2f, 1.10f, out_x, out_y);
+        Bench::do_not_optimize(out_x);
+        Bench::do_not_optimize(out_y);
+    });
+    row("xinput_fixed", [&](size_t i)
+    {
+        int16_t out_x, out_y;
+        xinput.shape(samples[i].first, samples[i].second, out_x, out_y);
+        Bench::do_not_optimize(out_x);
+        Bench::do_not_optimize(out_y);
+    });
+    row("ps4_float", [&](size_t i)
+    {
+        uint8_t out_x, out_y;
+        float_ps4(samples[i].first, samples[i].second, 0.016f, 1.08f, 0.82f, out_x, out_y);
+        Bench::do_not_optimize(out_x);
+        Bench::do_not_optimize(out_y);
+    });
+    row("ps4_fixed", [&](size_t i)
+    {
+        int16_t shaped_x, shaped_y;
+        ps4.shape(samples[i].first, samples[i].second, shaped_x, shaped_y);
+        Bench::do_not_optimize(stick_to_uint8(shaped_x));
+        Bench::do_not_optimize(stick_to_uint8(shaped_y));
+    });
+    row("compile", [&](size_t i)
+    {
+        OutputCurve curve;
+        curve.compile(to_raw(curves[i % curves.size()]));
+        Bench::do_not_optimize(curve.enabled());
+    });
+}
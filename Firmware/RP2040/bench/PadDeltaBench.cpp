@@ -0,0 +1,343 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "Gamepad/Gamepad.h"
+#include "Board/pad_delta.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Pad traces at 1 kHz through the 4-channel link's pad_delta layout. Each frame goes through a
+//channel that drops or truncates some, the receiver's resync flag goes back with the reply like
+//the PacketOut does. Whenever the receiver says it's in sync its state has to be the sender's.
+//With "sender knows" every loss is seen by the sender (I2C NACK or abort) and the receiver must
+//never be behind; with "silent" it only learns from the resync flag, so it may be behind for a few
+//frames. Frame sizes are turned into bus time at 400 kHz for one exchange: start, address, PacketIn,
+//restart, address, 8 byte PacketOut, stop, 9 bits a byte, and what that leaves per slave for 3
+
+namespace {
+
+    //Same as I2C::PadLayout in Four_Channel_I2C.cpp
+    using PadLayout = pad_delta::Layout<1, 2, 2, 4, 4, 10, 3>;
+    constexpr size_t STATE_SIZE = PadLayout::STATE_SIZE;
+    static_assert(STATE_SIZE == sizeof(Gamepad::PadIn) + sizeof(Gamepad::ChatpadIn));
+
+    constexpr size_t PACKET_HEADER = 2;     //packet_len, packet_id
+    constexpr size_t V2_PACKET_IN = 32;
+    constexpr size_t PACKET_OUT = 8;
+    constexpr uint32_t BUS_HZ = 400000;
+    constexpr uint32_t NUM_SLAVES = 3;
+    constexpr uint32_t FRAMES = 60000;
+    constexpr double DROP_RATE = 0.02;
+    constexpr double TRUNCATE_RATE = 0.005;
+
+    enum class Scenario { IDLE, BUTTONS, ONE_STICK, BUSY };
+
+    struct ScenarioInfo
+    {
+        Scenario scenario;
+        const char* name;
+    };
+
+    constexpr ScenarioInfo SCENARIOS[] =
+    {
+        { Scenario::IDLE,      "idle" },
+        { Scenario::BUTTONS,   "buttons" },
+        { Scenario::ONE_STICK, "one stick" },
+        { Scenario::BUSY,      "busy" },
+    };
+
+    class Trace
+    {
+    public:
+        Trace(Scenario scenario, uint32_t seed) : scenario_(scenario), rng_(seed) {}
+
+        void next(uint8_t* state)
+        {
+            switch (scenario_)
+            {
+                case Scenario::IDLE:
+                    break;
+                case Scenario::BUTTONS:
+                    maybe_toggle_button(50);
+                    break;
+                case Scenario::ONE_STICK:
+                    pad_.joystick_lx = moved(pad_.joystick_lx, 900);
+                    pad_.joystick_ly = moved(pad_.joystick_ly, 900);
+                    maybe_toggle_button(200);
+                    break;
+                case Scenario::BUSY:
+                    pad_.joystick_lx = moved(pad_.joystick_lx, 1500);
+                    pad_.joystick_ly = moved(pad_.joystick_ly, 1500);
+                    pad_.joystick_rx = moved(pad_.joystick_rx, 1500);
+                    pad_.joystick_ry = moved(pad_.joystick_ry, 1500);
+                    pad_.trigger_l = static_cast<uint8_t>(std::clamp<int>(pad_.trigger_l + step(12), 0, 255));
+                    pad_.trigger_r = static_cast<uint8_t>(std::clamp<int>(pad_.trigger_r + step(12), 0, 255));
+                    maybe_toggle_button(20);
+                    if (rng_() % 100 == 0)
+                    {
+                        pad_.dpad ^= static_cast<uint8_t>(1u << (rng_() % 4));
+                    }
+                    break;
+            }
+            std::memcpy(state, &pad_, sizeof(Gamepad::PadIn));
+            std::memcpy(&state[sizeof(Gamepad::PadIn)], chatpad_.data(), sizeof(Gamepad::ChatpadIn));
+        }
+
+    private:
+        Scenario scenario_;
+        std::mt19937 rng_;
+        Gamepad::PadIn pad_;
+        Gamepad::ChatpadIn chatpad_{0};
+
+        int32_t step(int32_t max)
+        {
+            return static_cast<int32_t>(rng_() % (2 * max + 1)) - max;
+        }
+        //PadIn is packed, no references into it
+        int16_t moved(int16_t axis, int32_t max)
+        {
+            return static_cast<int16_t>(std::clamp<int32_t>(axis + step(max), INT16_MIN, INT16_MAX));
+        }
+        //About once every period_ms frames
+        void maybe_toggle_button(uint32_t period_ms)
+        {
+            if (rng_() % period_ms == 0)
+            {
+                pad_.buttons ^= static_cast<uint16_t>(1u << (rng_() % 16));
+            }
+        }
+    };
+
+    struct Outcome
+    {
+        uint64_t bytes_sum{0};
+        size_t bytes_max{0};
+        uint32_t keyframes{0};
+        uint32_t lost{0};
+        uint32_t behind{0};         //Delivered frames after which the receiver's state wasn't the sender's
+        uint32_t behind_run_max{0};
+        uint32_t synced_mismatch{0};
+    };
+
+    Outcome simulate(Scenario scenario, bool sender_knows, bool lossy, uint32_t seed)
+    {
+        Trace trace(scenario, seed);
+        std::mt19937 channel(seed * 7919u + 1);
+        std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+        pad_delta::Encoder<PadLayout> encoder;
+        pad_delta::Decoder<PadLayout> decoder;
+        uint8_t state[STATE_SIZE];
+        uint8_t frame[PadLayout::FRAME_SIZE_MAX];
+        Outcome out;
+        uint32_t behind_run = 0;
+
+        for (uint32_t i = 0; i < FRAMES; ++i)
+        {
+            trace.next(state);
+            const size_t len = encoder.encode(state, 0, frame);
+            out.bytes_sum += PACKET_HEADER + len;
+            out.bytes_max = std::max(out.bytes_max, PACKET_HEADER + len);
+            if (frame[1] == PadLayout::ALL_FIELDS)
+            {
+                ++out.keyframes;
+            }
+
+            const double roll = chance(channel);
+            if (lossy && roll < DROP_RATE)
+            {
+                ++out.lost;
+                if (sender_knows)
+                {
+                    encoder.force_keyframe();
+                }
+                continue;
+            }
+            size_t delivered = len;
+            if (lossy && roll < DROP_RATE + TRUNCATE_RATE && len > pad_delta::HEADER_SIZE)
+            {
+                delivered = len - 1 - (channel() % (len - pad_delta::HEADER_SIZE));
+                ++out.lost;
+            }
+            decoder.decode(frame, delivered);
+            if (decoder.resync_needed())
+            {
+                encoder.force_keyframe();
+            }
+
+            const bool same = std::memcmp(decoder.state(), state, STATE_SIZE) == 0;
+            if (!decoder.resync_needed() && !same)
+            {
+                ++out.synced_mismatch;
+            }
+            if (!same && delivered == len)
+            {
+                ++out.behind;
+                out.behind_run_max = std::max(out.behind_run_max, ++behind_run);
+            }
+            else if (same)
+            {
+                behind_run = 0;
+            }
+        }
+        return out;
+    }
+
+    //One exchange on the bus in microseconds
+    double exchange_us(double packet_in_bytes)
+    {
+        const double bits = 1 + 9 + 9 * packet_in_bytes + 1 + 9 + 9 * PACKET_OUT + 1;
+        return bits * 1000000.0 / BUS_HZ;
+    }
+
+    std::string read_file(const char* path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream ss;
+        ss << file.rdbuf();
+        return file ? ss.str() : std::string();
+    }
+
+} // namespace
+
+void bench_pad_delta()
+{
+    const char* suite = "i2c.pad_delta";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    //Both firmwares build their own copy, they have to code frames the same way
+    const std::string rp2040_copy = read_file(PAD_DELTA_RP2040_PATH);
+    const std::string esp32_copy = read_file(PAD_DELTA_ESP32_PATH);
+    if (rp2040_copy.empty() || rp2040_copy != esp32_copy)
+    {
+        Bench::fail(suite, "RP2040 and ESP32 copies of pad_delta.h differ");
+    }
+
+    if (Bench::csv())
+    {
+        std::printf("suite,scenario,avg_bytes,max_bytes,keyframes,exchange_us,per_slave_hz,v2_per_slave_hz\n");
+    }
+    else
+    {
+        std::printf("\n[%s] %u frames at 1 kHz, 4-channel PacketIn bytes and bus time at %u kHz, %u slaves\n",
+            suite, FRAMES, BUS_HZ / 1000, NUM_SLAVES);
+        std::printf("%-10s %9s %9s %9s %12s %12s %12s\n",
+            "scenario", "avg B", "max B", "keyframes", "exchange us", "Hz/slave", "v2 Hz/slave");
+    }
+
+    const double v2_us = exchange_us(V2_PACKET_IN);
+    const double v2_hz = 1000000.0 / (v2_us * NUM_SLAVES);
+
+    for (const auto& info : SCENARIOS)
+    {
+        const Outcome clean = simulate(info.scenario, true, false, 1);
+        const double avg = static_cast<double>(clean.bytes_sum) / FRAMES;
+        const double us = exchange_us(avg);
+        const double hz = 1000000.0 / (us * NUM_SLAVES);
+
+        if (clean.behind || clean.synced_mismatch)
+        {
+            Bench::fail(suite, std::string(info.name) + ": lossless link fell behind");
+        }
+        //Everything but the keyframes has to be the 4 byte heartbeat
+        const uint64_t heartbeat_bytes = clean.bytes_sum - 
+            static_cast<uint64_t>(clean.keyframes) * (PACKET_HEADER + PadLayout::FRAME_SIZE_MAX);
+        if (info.scenario == Scenario::IDLE && 
+            heartbeat_bytes != static_cast<uint64_t>(FRAMES - clean.keyframes) * (PACKET_HEADER + pad_delta::HEADER_SIZE))
+        {
+            Bench::fail(suite, "idle: unchanged frames aren't heartbeats");
+        }
+
+        if (Bench::csv())
+        {
+            std::printf("%s,%s,%.2f,%zu,%u,%.1f,%.0f,%.0f\n", suite, info.name, avg, clean.bytes_max,
+                clean.keyframes, us, hz, v2_hz);
+            continue;
+        }
+        std::printf("%-10s %9.2f %9zu %9u %12.1f %12.0f %12.0f\n", info.name, avg, clean.bytes_max,
+            clean.keyframes, us, hz, v2_hz);
+    }
+
+    if (!Bench::csv())
+    {
+        std::printf("\n[%s] %.0f%% of frames dropped, %.1f%% truncated\n", suite, DROP_RATE * 100, TRUNCATE_RATE * 100);
+        std::printf("%-10s %-13s %8s %10s %12s %14s\n", "scenario", "loss", "lost", "behind", "behind run", "synced but off");
+    }
+    for (const auto& info : SCENARIOS)
+    {
+        for (bool sender_knows : { true, false })
+        {
+            const Outcome lossy = simulate(info.scenario, sender_knows, true, 2);
+            const char* loss = sender_knows ? "sender knows" : "silent";
+
+            //In sync has to mean the same state. A sender that sees every loss never leaves the
+            //receiver behind, a silent loss is caught on the next frame and fixed on the one after
+            //unless that's lost too
+            if (lossy.synced_mismatch)
+            {
+                Bench::fail(suite, std::string(info.name) + ", " + loss + ": in sync with a different state");
+            }
+            if (sender_knows && lossy.behind)
+            {
+                Bench::fail(suite, std::string(info.name) + ", " + loss + ": receiver fell behind");
+            }
+            if (!sender_knows && lossy.behind_run_max > pad_delta::KEYFRAME_INTERVAL)
+            {
+                Bench::fail(suite, std::string(info.name) + ", " + loss + ": behind longer than a keyframe interval");
+            }
+
+            if (Bench::csv())
+            {
+                std::printf("%s,%s %s,%u,%u,%u,%u\n", suite, info.name, loss, lossy.lost, lossy.behind,
+                    lossy.behind_run_max, lossy.synced_mismatch);
+                continue;
+            }
+            std::printf("%-10s %-13s %8u %10u %12u %14u\n", info.name, loss, lossy.lost, lossy.behind,
+                lossy.behind_run_max, lossy.synced_mismatch);
+        }
+    }
+
+    //Per frame cost on the sending and receiving side
+    Trace trace(Scenario::BUSY, 3);
+    std::vector<uint8_t> states(4096 * STATE_SIZE);
+    for (size_t i = 0; i < 4096; ++i)
+    {
+        trace.next(&states[i * STATE_SIZE]);
+    }
+    std::vector<uint8_t> frames(4096 * PadLayout::FRAME_SIZE_MAX);
+    std::vector<size_t> lens(4096);
+    pad_delta::Encoder<PadLayout> encoder;
+    for (size_t i = 0; i < 4096; ++i)
+    {
+        lens[i] = encoder.encode(&states[i * STATE_SIZE], 0, &frames[i * PadLayout::FRAME_SIZE_MAX]);
+    }
+
+    Bench::print_header(suite);
+    if (Bench::enabled(suite, "encode"))
+    {
+        pad_delta::Encoder<PadLayout> bench_encoder;
+        uint8_t frame[PadLayout::FRAME_SIZE_MAX];
+        Bench::print_row(suite, "busy", "encode", Bench::run(4096, [&](size_t i)
+        {
+            Bench::do_not_optimize(bench_encoder.encode(&states[i * STATE_SIZE], 0, frame));
+        }));
+    }
+    if (Bench::enabled(suite, "decode"))
+    {
+        pad_delta::Decoder<PadLayout> decoder;
+        Bench::print_row(suite, "busy", "decode", Bench::run(4096, [&](size_t i)
+        {
+            Bench::do_not_optimize(decoder.decode(&frames[i * PadLayout::FRAME_SIZE_MAX], lens[i]));
+        }));
+    }
+}
@@ -0,0 +1,433 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <csignal>
+#include <pthread.h>
+
+#include "Gamepad/Gamepad.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Cross thread checks and contention numbers for the Gamepad pad in/out snapshots.
+//Signals delivered to a thread stand in for an IRQ preempting code on the same core.
+
+namespace {
+
+    constexpr auto STRESS_DURATION = std::chrono::milliseconds(300);
+
+    //Every field is derived from one counter so a torn copy can't go unnoticed
+    Gamepad::PadIn make_pad_in(uint32_t k)
+    {
+        Gamepad::PadIn pad_in;
+        pad_in.dpad = static_cast<uint8_t>(k ^ 0xA5);
+        pad_in.buttons = static_cast<uint16_t>(k);
+        pad_in.trigger_l = static_cast<uint8_t>(k >> 8);
+        pad_in.trigger_r = static_cast<uint8_t>(k >> 24);
+        pad_in.joystick_lx = static_cast<int16_t>(k >> 16);
+        pad_in.joystick_ly = static_cast<int16_t>(~k);
+        pad_in.joystick_rx = static_cast<int16_t>(~(k >> 16));
+        pad_in.joystick_ry = static_cast<int16_t>(k ^ 0x5A5A);
+        for (uint8_t i = 0; i < sizeof(pad_in.analog); ++i)
+        {
+            pad_in.analog[i] = static_cast<uint8_t>(k + i);
+        }
+        return pad_in;
+    }
+
+    bool check_pad_in(const Gamepad::PadIn& pad_in, uint32_t& k)
+    {
+        k = static_cast<uint32_t>(pad_in.buttons) | (static_cast<uint32_t>(static_cast<uint16_t>(pad_in.joystick_lx)) << 16);
+        const Gamepad::PadIn expected = make_pad_in(k);
+        return std::memcmp(&expected, &pad_in, sizeof(Gamepad::PadIn)) == 0;
+    }
+
+    Gamepad::PadOut make_pad_out(uint8_t k)
+    {
+        Gamepad::PadOut pad_out;
+        pad_out.rumble_l = k;
+        pad_out.rumble_r = static_cast<uint8_t>(~k);
+        return pad_out;
+    }
+
+    bool check_pad_out(const Gamepad::PadOut& pad_out)
+    {
+        return pad_out.rumble_r == static_cast<uint8_t>(~pad_out.rumble_l);
+    }
+
+    //What Gamepad did before the latch, kept here for the comparison
+    class MutexPad
+    {
+    public:
+        void set_pad_in(const Gamepad::PadIn& pad_in)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pad_in_ = pad_in;
+            new_pad_in_.store(true);
+        }
+
+        Gamepad::PadIn get_pad_in()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            new_pad_in_.store(false);
+            return pad_in_;
+        }
+
+        void set_pad_out(const Gamepad::PadOut& pad_out)
+        {
+            std::lock_guard<std::mutex> lock(mutex_out_);
+            pad_out_ = pad_out;
+            new_pad_out_.store(true);
+        }
+
+    private:
+        std::mutex mutex_;
+        std::mutex mutex_out_;
+        Gamepad::PadIn pad_in_;
+        Gamepad::PadOut pad_out_;
+        std::atomic<bool> new_pad_in_{false};
+        std::atomic<bool> new_pad_out_{false};
+    };
+
+    struct StressResult
+    {
+        uint64_t writes{0};
+        uint64_t reads{0};
+        uint64_t torn{0};
+        uint64_t out_of_order{0};
+    };
+
+    void print_stress_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,scenario,writes,reads,torn,out_of_order\n");
+            return;
+        }
+        std::printf("\n[gamepad.snapshot.stress]\n");
+        std::printf("%-44s %12s %12s %8s %14s\n", "scenario", "writes", "reads", "torn", "out of order");
+    }
+
+    void print_stress_row(const char* scenario, const StressResult& result)
+    {
+        if (Bench::csv())
+        {
+            std::printf("gamepad.snapshot.stress,%s,%llu,%llu,%llu,%llu\n", scenario,
+                static_cast<unsigned long long>(result.writes), static_cast<unsigned long long>(result.reads),
+                static_cast<unsigned long long>(result.torn), static_cast<unsigned long long>(result.out_of_order));
+        }
+        else
+        {
+            std::printf("%-44s %12llu %12llu %8llu %14llu\n", scenario,
+                static_cast<unsigned long long>(result.writes), static_cast<unsigned long long>(result.reads),
+                static_cast<unsigned long long>(result.torn), static_cast<unsigned long long>(result.out_of_order));
+        }
+
+        if (result.torn > 0 || result.out_of_order > 0 || result.reads == 0 || result.writes == 0)
+        {
+            Bench::fail("gamepad.snapshot.stress", scenario);
+        }
+    }
+
+    //One writer core, readers on the others
+    StressResult stress_pad_in(Gamepad& gamepad, size_t num_readers)
+    {
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> writes{0}, reads{0}, torn{0}, out_of_order{0};
+
+        std::thread writer([&]
+        {
+            uint32_t k = 1;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                gamepad.set_pad_in(make_pad_in(k++));
+            }
+            writes.store(k - 1);
+        });
+
+        std::vector<std::thread> readers;
+        for (size_t r = 0; r < num_readers; ++r)
+        {
+            readers.emplace_back([&]
+            {
+                uint64_t local_reads = 0, local_torn = 0, local_ooo = 0;
+                uint32_t last_k = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    uint32_t k = 0;
+                    if (!check_pad_in(gamepad.get_pad_in(), k))
+                    {
+                        ++local_torn;
+                    }
+                    else if (k < last_k)
+                    {
+                        ++local_ooo;
+                    }
+                    else
+                    {
+                        last_k = k;
+                    }
+                    ++local_reads;
+                }
+                reads += local_reads;
+                torn += local_torn;
+                out_of_order += local_ooo;
+            });
+        }
+
+        std::this_thread::sleep_for(STRESS_DURATION);
+        stop.store(true);
+        writer.join();
+        for (auto& reader : readers)
+        {
+            reader.join();
+        }
+        return { writes.load(), reads.load(), torn.load(), out_of_order.load() };
+    }
+
+    //Two writers (core0 device driver, core1 host rumble reset) and a reader
+    StressResult stress_pad_out(Gamepad& gamepad)
+    {
+        std::atomic<bool> stop{false};
+        std::atomic<uint64_t> writes{0}, reads{0}, torn{0};
+
+        auto writer = [&](uint8_t start)
+        {
+            uint8_t k = start;
+            uint64_t local_writes = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                gamepad.set_pad_out(make_pad_out(k));
+                k += 2;
+                ++local_writes;
+            }
+            writes += local_writes;
+        };
+
+        std::thread writer_a(writer, 0);
+        std::thread writer_b(writer, 1);
+        std::thread reader([&]
+        {
+            uint64_t local_reads = 0, local_torn = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (!check_pad_out(gamepad.get_pad_out()))
+                {
+                    ++local_torn;
+                }
+                ++local_reads;
+            }
+            reads += local_reads;
+            torn += local_torn;
+        });
+
+        std::this_thread::sleep_for(STRESS_DURATION);
+        stop.store(true);
+        writer_a.join();
+        writer_b.join();
+        reader.join();
+        return { writes.load(), reads.load(), torn.load(), 0 };
+    }
+
+    //IRQ stand-in, runs on whichever thread the signal is sent to
+    std::atomic<Gamepad*> _irq_gamepad{nullptr};
+    std::atomic<bool> _irq_writes{false};
+    std::atomic<uint32_t> _irq_k{1};
+    std::atomic<uint64_t> _irq_count{0};
+    std::atomic<uint64_t> _irq_torn{0};
+
+    void irq_handler(int)
+    {
+        Gamepad* gamepad = _irq_gamepad.load();
+        if (!gamepad)
+        {
+            return;
+        }
+        if (_irq_writes.load())
+        {
+            gamepad->set_pad_in(make_pad_in(_irq_k.fetch_add(1)));
+        }
+        else
+        {
+            uint32_t k = 0;
+            if (!check_pad_in(gamepad->get_pad_in(), k))
+            {
+                _irq_torn.fetch_add(1);
+            }
+        }
+        _irq_count.fetch_add(1);
+    }
+
+    //irq_writes: the I2C slave IRQ writing pad in over a reader on the same core,
+    //otherwise an IRQ reading pad in over a writer on the same core
+    StressResult stress_irq(Gamepad& gamepad, bool irq_writes)
+    {
+        std::atomic<bool> stop{false};
+        std::atomic<bool> started{false};
+        std::atomic<uint64_t> thread_ops{0}, thread_torn{0};
+
+        _irq_gamepad.store(&gamepad);
+        _irq_writes.store(irq_writes);
+        _irq_k.store(1);
+        _irq_count.store(0);
+        _irq_torn.store(0);
+
+        struct sigaction action{};
+        struct sigaction old_action{};
+        action.sa_handler = irq_handler;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGUSR1, &action, &old_action);
+
+        std::thread target([&]
+        {
+            uint64_t ops = 0, local_torn = 0;
+            uint32_t k = 1;
+            started.store(true);
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                if (irq_writes)
+                {
+                    uint32_t read_k = 0;
+                    if (!check_pad_in(gamepad.get_pad_in(), read_k))
+                    {
+                        ++local_torn;
+                    }
+                }
+                else
+                {
+                    gamepad.set_pad_in(make_pad_in(k++));
+                }
+                ++ops;
+            }
+            thread_ops.store(ops);
+            thread_torn.store(local_torn);
+        });
+
+        while (!started.load())
+        {
+        }
+
+        const auto end = std::chrono::steady_clock::now() + STRESS_DURATION;
+        while (std::chrono::steady_clock::now() < end)
+        {
+            pthread_kill(target.native_handle(), SIGUSR1);
+            std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+
+        stop.store(true);
+        target.join();
+        _irq_gamepad.store(nullptr);
+        sigaction(SIGUSR1, &old_action, nullptr);
+
+        StressResult result;
+        result.writes = irq_writes ? _irq_count.load() : thread_ops.load();
+        result.reads = irq_writes ? thread_ops.load() : _irq_count.load();
+        result.torn = _irq_torn.load() + thread_torn.load();
+        return result;
+    }
+
+    //Runs func on a second thread for as long as the measurement takes
+    template <typename Background, typename Func>
+    Bench::Result run_contended(Background&& background, Func&& func)
+    {
+        std::atomic<bool> stop{false};
+        std::thread thread([&]
+        {
+            uint32_t k = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                background(k++);
+            }
+        });
+        Bench::Result result = Bench::run(256, func);
+        stop.store(true);
+        thread.join();
+        return result;
+    }
+
+} // namespace
+
+void bench_snapshot()
+{
+    const char* suite = "gamepad.snapshot";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    Bench::print_header(suite);
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        auto mutex_pad = std::make_unique<MutexPad>();
+        Gamepad::PadIn pad_in = make_pad_in(1);
+        Gamepad::PadOut pad_out = make_pad_out(1);
+
+        auto row = [&](const char* profile, const char* name, const Bench::Result& result)
+        {
+            Bench::print_row(suite, profile, name, result);
+        };
+
+        row("latch", "get_pad_in", Bench::run(256, [&](size_t) {
+            Bench::do_not_optimize(gamepad->get_pad_in());
+        }));
+        row("mutex", "get_pad_in", Bench::run(256, [&](size_t) {
+            Bench::do_not_optimize(mutex_pad->get_pad_in());
+        }));
+        row("latch", "set_pad_in", Bench::run(256, [&](size_t) {
+            gamepad->set_pad_in(pad_in);
+        }));
+        row("mutex", "set_pad_in", Bench::run(256, [&](size_t) {
+            mutex_pad->set_pad_in(pad_in);
+        }));
+
+        //Worst case, the other side hammering the same pad with no gap between reports
+        row("latch", "get_pad_in (writer on other core)", run_contended(
+            [&](uint32_t k) { gamepad->set_pad_in(make_pad_in(k)); },
+            [&](size_t) { Bench::do_not_optimize(gamepad->get_pad_in()); }));
+        row("mutex", "get_pad_in (writer on other core)", run_contended(
+            [&](uint32_t k) { mutex_pad->set_pad_in(make_pad_in(k)); },
+            [&](size_t) { Bench::do_not_optimize(mutex_pad->get_pad_in()); }));
+        row("latch", "set_pad_in (reader on other core)", run_contended(
+            [&](uint32_t) { Bench::do_not_optimize(gamepad->get_pad_in()); },
+            [&](size_t) { gamepad->set_pad_in(pad_in); }));
+        row("mutex", "set_pad_in (reader on other core)", run_contended(
+            [&](uint32_t) { Bench::do_not_optimize(mutex_pad->get_pad_in()); },
+            [&](size_t) { mutex_pad->set_pad_in(pad_in); }));
+        row("latch", "set_pad_out (writer on other core)", run_contended(
+            [&](uint32_t k) { gamepad->set_pad_out(make_pad_out(static_cast<uint8_t>(k))); },
+            [&](size_t) { gamepad->set_pad_out(pad_out); }));
+        row("mutex", "set_pad_out (writer on other core)", run_contended(
+            [&](uint32_t k) { mutex_pad->set_pad_out(make_pad_out(static_cast<uint8_t>(k))); },
+            [&](size_t) { mutex_pad->set_pad_out(pad_out); }));
+    }
+
+    print_stress_header();
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        print_stress_row("pad in, 1 writer 1 reader", stress_pad_in(*gamepad, 1));
+    }
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        print_stress_row("pad in, 1 writer 3 readers", stress_pad_in(*gamepad, 3));
+    }
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_pad_out(make_pad_out(0));
+        print_stress_row("pad out, 2 writers 1 reader", stress_pad_out(*gamepad));
+    }
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_pad_in(make_pad_in(1));
+        print_stress_row("pad in, IRQ reader over same core writer", stress_irq(*gamepad, false));
+    }
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_pad_in(make_pad_in(1));
+        print_stress_row("pad in, IRQ writer over same core reader", stress_irq(*gamepad, true));
+    }
+}
@@ -0,0 +1,321 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "USBDevice/SofSync.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Core0's device loop on simulated time against a console polling the gamepad endpoint at a fixed
+//offset into its frames, with pad data from core1 arriving on its own clock. Building on every pass
+//(queue a report as soon as the endpoint is free) is run against SofSync on the same timings. What's
+//compared is how old the report and the pad data in it are when the console takes it. Time starts
+//just short of the 32 bit wrap, like time_us_32() does after ~71 minutes
+
+namespace {
+
+    constexpr uint32_t FRAME_US = SofSync::FRAME_US;
+    constexpr uint32_t IDLE_TICK_US = 1000;     //CORE0_IDLE_TICK_US
+    constexpr uint32_t RUN_US = 20 * 1000 * 1000;
+    constexpr uint32_t START_US = UINT32_MAX - 5 * 1000 * 1000;
+    constexpr uint32_t IRQ_US = 5;              //Poll to completion IRQ, wake from WFE
+    constexpr uint32_t TUD_TASK_US = 8;
+
+    enum class Mode { FREE, SOF };
+
+    struct Scenario
+    {
+        const char* name;
+        uint8_t interval_frames;
+        uint32_t poll_offset_us;    //Console's poll, after SOF
+        uint32_t input_period_us;   //New pad data from core1
+        uint32_t build_min_us;      //Driver process() with a report to queue
+        uint32_t build_max_us;
+        uint32_t spike_per_mille;   //Frames core0 spends spike_us on something else
+        uint32_t spike_us;
+        uint32_t lead_us;           //SOF_SYNC_LEAD_US
+    };
+
+    struct Result
+    {
+        uint64_t polls{0};          //Console polls that found a report
+        uint64_t wait_total_us{0};  //Report queued to taken
+        uint32_t wait_max_us{0};
+        uint64_t age_total_us{0};   //Pad data arrived to taken
+        uint32_t age_max_us{0};
+        SofSync::Stats sync;
+        uint32_t lead_min_us{UINT32_MAX};
+        uint32_t lead_max_us{0};
+
+        inline uint32_t wait_avg_us() const { return polls ? static_cast<uint32_t>(wait_total_us / polls) : 0; }
+        inline uint32_t age_avg_us() const { return polls ? static_cast<uint32_t>(age_total_us / polls) : 0; }
+    };
+
+    Result simulate(Mode mode, const Scenario& scenario, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        SofSync sync(scenario.lead_us);
+        sync.set_interval_frames(scenario.interval_frames);
+        Result result;
+
+        auto us32 = [](uint64_t sim_us) { return static_cast<uint32_t>(START_US + sim_us); };
+        auto jitter = [&rng](uint32_t max_us) { return max_us ? static_cast<uint32_t>(rng() % (max_us + 1)) : 0; };
+
+        uint64_t next_sof = 0;
+        uint64_t next_poll = scenario.poll_offset_us;
+        uint64_t next_input = jitter(scenario.input_period_us);
+        uint64_t latest_input = 0;
+
+        bool queued = false;
+        uint64_t queued_at = 0;
+        uint64_t queued_input = 0;
+        bool ep_busy = false;
+        bool completion = false;
+        uint64_t completion_at = 0;
+
+        //Frames with core0 busy elsewhere for spike_us from somewhere in them
+        auto spike_after = [&](uint64_t after_us)
+        {
+            if (!scenario.spike_per_mille)
+            {
+                return UINT64_MAX;
+            }
+            uint64_t frame = after_us / FRAME_US + 1;
+            while (jitter(999) >= scenario.spike_per_mille)
+            {
+                ++frame;
+            }
+            return frame * FRAME_US + jitter(FRAME_US - 1);
+        };
+        uint64_t next_spike = spike_after(0);
+
+        uint64_t pass_at = 0;
+        while (pass_at < RUN_US)
+        {
+            //IRQs and core1 up to the start of this pass, in time order
+            while (true)
+            {
+                const uint64_t next = std::min({ next_sof, next_poll, next_input });
+                if (next > pass_at)
+                {
+                    break;
+                }
+                if (next == next_sof)
+                {
+                    if (mode == Mode::SOF)
+                    {
+                        sync.sof(us32(next_sof));
+                    }
+                    next_sof += FRAME_US;
+                }
+                else if (next == next_poll)
+                {
+                    if (queued && queued_at <= next_poll)
+                    {
+                        const uint32_t wait_us = static_cast<uint32_t>(next_poll - queued_at);
+                        const uint32_t age_us = static_cast<uint32_t>(next_poll - queued_input);
+                        ++result.polls;
+                        result.wait_total_us += wait_us;
+                        result.wait_max_us = std::max(result.wait_max_us, wait_us);
+                        result.age_total_us += age_us;
+                        result.age_max_us = std::max(result.age_max_us, age_us);
+                        queued = false;
+                        completion = true;
+                        completion_at = next_poll + IRQ_US;
+                    }
+                    next_poll += scenario.interval_frames * FRAME_US;
+                }
+                else
+                {
+                    latest_input = next_input;
+                    next_input += scenario.input_period_us - 20 + jitter(40);
+                }
+            }
+
+            //One pass of the board loop
+            uint64_t now = pass_at;
+            if (now >= next_spike)
+            {
+                now = std::max(now, next_spike + scenario.spike_us);
+                next_spike = spike_after(now);
+            }
+            now += TUD_TASK_US;
+            if (completion && completion_at <= now)
+            {
+                completion = false;
+                ep_busy = false;
+                if (mode == Mode::SOF)
+                {
+                    sync.polled(us32(now));
+                    result.lead_min_us = std::min(result.lead_min_us, sync.lead_us());
+                    result.lead_max_us = std::max(result.lead_max_us, sync.lead_us());
+                }
+            }
+
+            const bool build = (mode == Mode::FREE) || sync.begin(us32(now), ep_busy);
+            if (build && !ep_busy)
+            {
+                queued_input = latest_input;
+                now += scenario.build_min_us + jitter(scenario.build_max_us - scenario.build_min_us);
+                queued = true;
+                queued_at = now;
+                ep_busy = true;
+            }
+            else
+            {
+                now += 2;
+            }
+
+            //wait_for_work(), anything that would end the WFE
+            const uint32_t idle = (mode == Mode::SOF) ? sync.idle_us(us32(now), IDLE_TICK_US) : IDLE_TICK_US;
+            uint64_t wake = std::min(now + idle, next_input);
+            if (queued)
+            {
+                wake = std::min(wake, std::max(next_poll + IRQ_US, now));
+            }
+            if (completion)
+            {
+                wake = std::min(wake, completion_at);
+            }
+            if (mode == Mode::SOF)
+            {
+                wake = std::min(wake, next_sof);
+            }
+            pass_at = std::max(wake, now) + 1;
+        }
+
+        result.sync = sync.stats();
+        return result;
+    }
+
+    //Fallbacks that don't need the loop: no SOF yet, SOFs stopping (suspend)
+    void check_unsynced(const char* suite)
+    {
+        SofSync sync(300);
+        for (uint32_t now = 0; now < 10 * FRAME_US; now += 100)
+        {
+            if (!sync.begin(now, false) || sync.idle_us(now, IDLE_TICK_US) != IDLE_TICK_US)
+            {
+                Bench::fail(suite, "gated reports without SOFs or a poll");
+                return;
+            }
+        }
+
+        for (uint32_t frame = 0; frame < 10; ++frame)
+        {
+            sync.sof(frame * FRAME_US);
+            sync.polled(frame * FRAME_US + 200);
+        }
+        const uint32_t suspended_us = 9 * FRAME_US + 3 * FRAME_US + 1;
+        if (!sync.begin(suspended_us, false) || !sync.begin(suspended_us + 10, false))
+        {
+            Bench::fail(suite, "still gating reports after SOFs stopped");
+        }
+    }
+
+} // namespace
+
+void bench_sof_sync()
+{
+    const char* suite = "device.sof_sync";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    const std::vector<Scenario> scenarios =
+    {
+        //name              frames  offset  input   build       spikes      lead
+        { "1ms",            1,      150,    1000,   20,  60,    0,   0,     300 },
+        { "1ms_late_poll",  1,      900,    997,    20,  60,    0,   0,     300 },
+        { "1ms_busy",       1,      400,    1000,   20,  120,   10,  250,   300 },
+        { "1ms_slow_build", 1,      300,    1000,   350, 450,   0,   0,     50  },
+        { "2ms",            2,      150,    1000,   20,  60,    0,   0,     300 },
+        { "4ms",            4,      600,    4000,   20,  60,    0,   0,     300 },
+        { "4ms_late_poll",  4,      950,    1000,   20,  60,    5,   300,   300 },
+        { "8ms",            8,      250,    8000,   20,  60,    0,   0,     300 },
+    };
+
+    struct Row
+    {
+        const Scenario* scenario;
+        Result free;
+        Result sof;
+    };
+
+    std::vector<Row> rows;
+    for (size_t i = 0; i < scenarios.size(); ++i)
+    {
+        const uint32_t seed = 0x50F + static_cast<uint32_t>(i) * 31;
+        rows.push_back({ &scenarios[i], simulate(Mode::FREE, scenarios[i], seed), simulate(Mode::SOF, scenarios[i], seed) });
+    }
+
+    if (Bench::csv())
+    {
+        std::printf("suite,scenario,mode,polls,wait_avg_us,wait_max_us,age_avg_us,age_max_us,late,lead_us,jitter_us\n");
+        for (const Row& row : rows)
+        {
+            std::printf("%s,%s,free,%llu,%u,%u,%u,%u,0,0,0\n", suite, row.scenario->name,
+                        static_cast<unsigned long long>(row.free.polls), row.free.wait_avg_us(), row.free.wait_max_us,
+                        row.free.age_avg_us(), row.free.age_max_us);
+            std::printf("%s,%s,sof,%llu,%u,%u,%u,%u,%u,%u,%u\n", suite, row.scenario->name,
+                        static_cast<unsigned long long>(row.sof.polls), row.sof.wait_avg_us(), row.sof.wait_max_us,
+                        row.sof.age_avg_us(), row.sof.age_max_us, row.sof.sync.late, row.sof.sync.lead_us,
+                        row.sof.sync.jitter_us());
+        }
+    }
+    else
+    {
+        std::printf("\n[%s] report wait and pad data age at poll, us (avg/max)\n", suite);
+        std::printf("%-16s %8s %15s %15s %8s %15s %15s %6s %10s\n", "scenario", "polls", "free wait", "free age",
+                    "polls", "sof wait", "sof age", "late", "lead us");
+        for (const Row& row : rows)
+        {
+            const std::string free_wait = std::to_string(row.free.wait_avg_us()) + "/" + std::to_string(row.free.wait_max_us);
+            const std::string free_age = std::to_string(row.free.age_avg_us()) + "/" + std::to_string(row.free.age_max_us);
+            const std::string sof_wait = std::to_string(row.sof.wait_avg_us()) + "/" + std::to_string(row.sof.wait_max_us);
+            const std::string sof_age = std::to_string(row.sof.age_avg_us()) + "/" + std::to_string(row.sof.age_max_us);
+            const std::string lead = std::to_string(row.sof.lead_min_us) + "-" + std::to_string(row.sof.lead_max_us);
+            std::printf("%-16s %8llu %15s %15s %8llu %15s %15s %6u %10s\n", row.scenario->name,
+                        static_cast<unsigned long long>(row.free.polls), free_wait.c_str(), free_age.c_str(),
+                        static_cast<unsigned long long>(row.sof.polls), sof_wait.c_str(), sof_age.c_str(),
+                        row.sof.sync.late, lead.c_str());
+        }
+    }
+
+    for (const Row& row : rows)
+    {
+        const std::string name = row.scenario->name;
+        //Same report rate, a late report costs the console one poll
+        if (row.sof.polls * 100 < row.free.polls * 99)
+        {
+            Bench::fail(suite, name + " sent fewer reports than building every pass");
+        }
+        if (row.sof.sync.late * 100 > row.sof.sync.polls)
+        {
+            Bench::fail(suite, name + " more than 1% of reports late");
+        }
+        if (row.sof.wait_avg_us() * 2 > row.free.wait_avg_us() || row.sof.age_avg_us() >= row.free.age_avg_us())
+        {
+            Bench::fail(suite, name + " reports no fresher than building every pass");
+        }
+        if (row.sof.lead_min_us < SofSync::MIN_LEAD_US || row.sof.lead_max_us > SofSync::MAX_LEAD_US)
+        {
+            Bench::fail(suite, name + " lead out of bounds");
+        }
+    }
+
+    //Lead has to grow past a build that takes longer than it
+    for (const Row& row : rows)
+    {
+        if (row.scenario->build_max_us > row.scenario->lead_us && row.sof.sync.lead_us <= row.scenario->build_max_us)
+        {
+            Bench::fail(suite, std::string(row.scenario->name) + " lead didn't calibrate past the build time");
+        }
+    }
+
+    check_unsynced(suite);
+}
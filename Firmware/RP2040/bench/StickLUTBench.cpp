@@ -0,0 +1,220 @@
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "Gamepad/Gamepad.h"
+#include "UserSettings/UserProfile.h"
+#include "BenchProfiles.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//Accuracy of the compiled stick table against the Fix16 reference over a full sweep
+//of the stick range, plus what compiling costs at profile load. The table path is also
+//checked on a dense sweep of one quadrant, either sweep over max error fails the suite,
+//as does a profile with shaping enabled that isn't tabled. A compile cut short by its time
+//budget must only table cells the full compile tables, with the same output
+
+namespace {
+
+    struct LUTReport
+    {
+        double fallback_samples{0.0};
+        int32_t max_error{0};
+        int32_t dense_max_error{0};
+        double mean_error{0.0};
+        double compile_us{0.0};
+    };
+
+    constexpr int32_t SWEEP_STEP = 128;
+    constexpr int32_t DENSE_STEP = 16;
+
+    void print_lut_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,profile,grid,bytes,fallback_cells,unchecked_cells,fallback_samples_pct,max_error,dense_max_error,mean_error,compile_us_per_stick\n");
+            return;
+        }
+        std::printf("\n[gamepad.stick_lut] grid %u, %u bytes/stick, max error %u, compile budget %u us\n",
+            static_cast<unsigned>(JoystickLUT::GRID), static_cast<unsigned>(JoystickLUT::SIZE_BYTES),
+            static_cast<unsigned>(StickLUTConfig::MAX_ERROR), static_cast<unsigned>(StickLUTConfig::COMPILE_BUDGET_US));
+        std::printf("%-22s %16s %10s %14s %10s %10s %10s %16s\n",
+            "profile", "fallback cells", "unchecked", "fallback smp%", "max err", "dense err", "mean err", "compile us/stick");
+    }
+
+    void print_lut_row(const char* profile, const JoystickLUT::Stats& stats, const LUTReport& report)
+    {
+        if (Bench::csv())
+        {
+            std::printf("gamepad.stick_lut,%s,%u,%u,%u,%u,%.3f,%d,%d,%.3f,%.1f\n",
+                profile, stats.grid, static_cast<unsigned>(stats.size_bytes), stats.fallback_cells, stats.unchecked_cells,
+                report.fallback_samples, report.max_error, report.dense_max_error, report.mean_error, report.compile_us);
+            return;
+        }
+        char cells[32];
+        std::snprintf(cells, sizeof(cells), "%u/%u", stats.fallback_cells, stats.total_cells);
+        std::printf("%-22s %16s %10u %14.3f %10d %10d %10.3f %16.1f\n",
+            profile, cells, stats.unchecked_cells, report.fallback_samples, report.max_error, report.dense_max_error, report.mean_error, report.compile_us);
+    }
+
+    //Largest error of the table path alone over the first quadrant, the table is symmetric
+    int32_t dense_error(const JoystickLUT& lut, const JoystickSettings& settings)
+    {
+        JoystickSettings table_settings = settings;
+        table_settings.invert_x = false;
+        table_settings.invert_y = false;
+
+        int32_t max_error = 0;
+        for (int32_t y = 0; y <= Range::MAX<int16_t>; y += DENSE_STEP)
+        {
+            for (int32_t x = 0; x <= Range::MAX<int16_t>; x += DENSE_STEP)
+            {
+                int16_t out_x, out_y;
+                if (!lut.lookup(static_cast<int16_t>(x), static_cast<int16_t>(y), out_x, out_y))
+                {
+                    continue;
+                }
+                auto ref = Gamepad::apply_joystick_settings(static_cast<int16_t>(x), static_cast<int16_t>(y), table_settings, false);
+                max_error = std::max(max_error, std::max(std::abs(out_x - ref.first), std::abs(out_y - ref.second)));
+            }
+        }
+        return max_error;
+    }
+
+    //The clock ticks once per read, so a budget is a count of cells bounded whatever the host's speed
+    std::unique_ptr<JoystickLUT> compile_ticks(const JoystickSettings& settings, uint32_t budget_ticks)
+    {
+        JoystickSettings table_settings = settings;
+        table_settings.invert_x = false;
+        table_settings.invert_y = false;
+
+        auto lut = std::make_unique<JoystickLUT>();
+        uint32_t ticks = 0;
+        lut->compile([&table_settings](int16_t x, int16_t y)
+        {
+            return Gamepad::apply_joystick_settings(x, y, table_settings, false);
+        }, StickLUTConfig::MAX_ERROR, [&ticks] { return ticks++; }, budget_ticks);
+        return lut;
+    }
+
+    bool budget_cut_ok(const JoystickSettings& settings, uint16_t& unchecked_cells)
+    {
+        const auto full = compile_ticks(settings, UINT32_MAX);
+        const auto cut = compile_ticks(settings, JoystickLUT::NUM_CELLS / 2);
+
+        unchecked_cells = cut->stats().unchecked_cells;
+        if (full->stats().unchecked_cells != 0 || unchecked_cells == 0 || unchecked_cells == JoystickLUT::NUM_CELLS)
+        {
+            return false;
+        }
+        for (int32_t y = 0; y <= Range::MAX<int16_t>; y += DENSE_STEP)
+        {
+            for (int32_t x = 0; x <= Range::MAX<int16_t>; x += DENSE_STEP)
+            {
+                int16_t cut_x, cut_y, full_x, full_y;
+                if (cut->lookup(static_cast<int16_t>(x), static_cast<int16_t>(y), cut_x, cut_y) &&
+                    (!full->lookup(static_cast<int16_t>(x), static_cast<int16_t>(y), full_x, full_y) ||
+                     cut_x != full_x || cut_y != full_y))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+void bench_stick_lut()
+{
+    const char* suite = "gamepad.stick_lut";
+    if (!Bench::enabled(suite, "") || JoystickLUT::GRID == 0)
+    {
+        return;
+    }
+
+    print_lut_header();
+
+    for (const auto& joy_profile : BenchProfiles::joystick_profiles())
+    {
+        UserProfile profile;
+        profile.joystick_settings_l = joy_profile.settings;
+        profile.joystick_settings_r = joy_profile.settings;
+
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_profile(profile);
+
+        const JoystickLUT& lut = gamepad->joystick_lut_l();
+        if (!lut.compiled())
+        {
+            //Default settings skip shaping altogether
+            if (!JoystickSettings().is_same(joy_profile.settings))
+            {
+                Bench::fail(suite, std::string(joy_profile.name) + ": shaping enabled but no table compiled");
+            }
+            continue;
+        }
+
+        JoystickSettings settings;
+        Gamepad::load_joystick_settings(settings, joy_profile.settings);
+
+        LUTReport report;
+        uint64_t samples = 0;
+        uint64_t fallbacks = 0;
+        uint64_t total_error = 0;
+
+        for (int32_t y = Range::MIN<int16_t>; y <= Range::MAX<int16_t>; y += SWEEP_STEP)
+        {
+            for (int32_t x = Range::MIN<int16_t>; x <= Range::MAX<int16_t>; x += SWEEP_STEP)
+            {
+                const int16_t joy_x = static_cast<int16_t>(x);
+                const int16_t joy_y = static_cast<int16_t>(y);
+
+                for (bool invert_y : { false, true })
+                {
+                    auto shaped = gamepad->scale_joystick_l(joy_x, joy_y, invert_y);
+                    auto ref = Gamepad::apply_joystick_settings(joy_x, joy_y, settings, invert_y);
+                    const int32_t error = std::max(std::abs(shaped.first - ref.first), std::abs(shaped.second - ref.second));
+
+                    report.max_error = std::max(report.max_error, error);
+                    total_error += static_cast<uint64_t>(error);
+                    ++samples;
+                }
+
+                int16_t out_x, out_y;
+                if (!lut.lookup(joy_x, joy_y, out_x, out_y))
+                {
+                    ++fallbacks;
+                }
+            }
+        }
+
+        report.mean_error = static_cast<double>(total_error) / static_cast<double>(samples);
+        report.dense_max_error = dense_error(lut, settings);
+        report.fallback_samples = 100.0 * static_cast<double>(fallbacks) / static_cast<double>(samples / 2);
+
+        //Right stick left at default so set_profile compiles one table
+        UserProfile left_only;
+        left_only.joystick_settings_l = joy_profile.settings;
+        report.compile_us = Bench::run(1, [&](size_t)
+        {
+            auto compile_gamepad = std::make_unique<Gamepad>();
+            compile_gamepad->set_profile(left_only);
+            Bench::do_not_optimize(compile_gamepad->joystick_lut_l().compiled());
+        }, 200'000'000).ns_per_sample / 1000.0;
+
+        print_lut_row(joy_profile.name, lut.stats(), report);
+
+        if (report.max_error > StickLUTConfig::MAX_ERROR || report.dense_max_error > StickLUTConfig::MAX_ERROR)
+        {
+            Bench::fail(suite, std::string(joy_profile.name) + ": error over STICK_LUT_MAX_ERROR");
+        }
+        uint16_t unchecked_cells = 0;
+        if (!budget_cut_ok(settings, unchecked_cells))
+        {
+            Bench::fail(suite, std::string(joy_profile.name) + ": a compile cut short by its budget tabled a cell differently, " +
+                std::to_string(unchecked_cells) + " unchecked");
+        }
+    }
+}
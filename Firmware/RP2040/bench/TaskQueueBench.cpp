@@ -0,0 +1,404 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <array>
+#include <map>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <memory>
+
+#include "TaskQueue/InlineFunction.h"
+#include "TaskQueue/TaskHeap.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//TaskQueue's delayed task heap and inline callables against a mocked timer. The alarm IRQ is
+//simulated by jumping the clock to the next target plus some latency and popping what's due,
+//the same loop TaskQueue::timer_irq_handler runs.
+
+namespace {
+
+    constexpr uint8_t CAPACITY = 16;
+    using Function = InlineFunction<4 * sizeof(void*)>;
+    using Heap = TaskHeap<Function, CAPACITY>;
+
+    //Counts live copies so a leaked or double destroyed capture shows up
+    struct Tracker
+    {
+        static inline int64_t live = 0;
+        Tracker() { ++live; }
+        Tracker(const Tracker&) { ++live; }
+        Tracker(Tracker&&) { ++live; }
+        ~Tracker() { --live; }
+    };
+
+    struct SimResult
+    {
+        uint64_t fires{0};
+        uint64_t checks{0};
+        uint64_t errors{0};
+    };
+
+    void print_sim_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,scenario,fires,checks,errors\n");
+            return;
+        }
+        std::printf("\n[taskqueue.sim]\n");
+        std::printf("%-44s %12s %12s %8s\n", "scenario", "fires", "checks", "errors");
+    }
+
+    void print_sim_row(const char* scenario, const SimResult& result)
+    {
+        if (Bench::csv())
+        {
+            std::printf("taskqueue.sim,%s,%llu,%llu,%llu\n", scenario,
+                static_cast<unsigned long long>(result.fires), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+        else
+        {
+            std::printf("%-44s %12llu %12llu %8llu\n", scenario,
+                static_cast<unsigned long long>(result.fires), static_cast<unsigned long long>(result.checks),
+                static_cast<unsigned long long>(result.errors));
+        }
+
+        if (result.errors > 0 || result.fires == 0)
+        {
+            Bench::fail("taskqueue.sim", scenario);
+        }
+    }
+
+    //One shots with random delays, fired in target order and never early
+    SimResult sim_ordering()
+    {
+        SimResult result;
+        std::mt19937 rng(1);
+        std::uniform_int_distribution<uint64_t> delay(0, 5'000'000);
+        std::uniform_int_distribution<uint64_t> latency(0, 50);
+
+        for (uint32_t round = 0; round < 2000; ++round)
+        {
+            Heap heap;
+            uint64_t now = 1'000'000;
+            std::vector<uint64_t> targets(CAPACITY + 1, 0);
+            std::vector<uint32_t> fired_count(CAPACITY + 1, 0);
+            uint64_t last_target = 0;
+            uint32_t fired_id = 0;
+
+            for (uint32_t id = 1; id <= CAPACITY; ++id)
+            {
+                targets[id] = now + delay(rng);
+                heap.add(id, targets[id], 0, Function([id, &fired_id] { fired_id = id; }));
+            }
+            ++result.checks;
+            if (heap.add(CAPACITY + 1, now, 0, Function([] {})) != Heap::AddResult::FULL)
+            {
+                ++result.errors;
+            }
+
+            while (!heap.empty())
+            {
+                now = std::max(now, heap.next_target()) + latency(rng);
+                Function function;
+                while (heap.pop_due(now, function))
+                {
+                    function();
+                    ++result.fires;
+                    ++result.checks;
+                    if (targets[fired_id] > now || targets[fired_id] < last_target)
+                    {
+                        ++result.errors;
+                    }
+                    last_target = targets[fired_id];
+                    ++fired_count[fired_id];
+                }
+            }
+
+            for (uint32_t id = 1; id <= CAPACITY; ++id)
+            {
+                ++result.checks;
+                result.errors += (fired_count[id] == 1) ? 0 : 1;
+            }
+        }
+        return result;
+    }
+
+    //Repeating tasks at the board intervals over an hour of simulated IRQ latency,
+    //the n-th run must land within max latency of start + n * interval
+    SimResult sim_repeat_drift()
+    {
+        SimResult result;
+        std::mt19937 rng(2);
+        constexpr uint64_t MAX_LATENCY_US = 300;
+        std::uniform_int_distribution<uint64_t> latency(0, MAX_LATENCY_US);
+
+        const std::array<uint64_t, 5> intervals_us = { 1'000, 8'000, 200'000, 600'000, 5'000'000 };
+        std::array<uint64_t, 5> runs{0};
+        std::array<uint64_t, 5> first_target{0};
+
+        Heap heap;
+        uint64_t now = 123;
+        uint32_t fired_id = 0;
+
+        for (uint32_t i = 0; i < intervals_us.size(); ++i)
+        {
+            first_target[i] = now + intervals_us[i];
+            heap.add(i + 1, first_target[i], intervals_us[i], Function([i, &fired_id] { fired_id = i; }));
+        }
+
+        const uint64_t end = now + 3600ull * 1'000'000;
+        while (now < end)
+        {
+            now = std::max(now, heap.next_target()) + latency(rng);
+            Function function;
+            while (heap.pop_due(now, function))
+            {
+                function();
+                const uint64_t expected = first_target[fired_id] + runs[fired_id] * intervals_us[fired_id];
+                ++runs[fired_id];
+                ++result.fires;
+                ++result.checks;
+                if (now < expected || now - expected > MAX_LATENCY_US * 2)
+                {
+                    ++result.errors;
+                }
+            }
+        }
+
+        //No runs lost or added either
+        for (uint32_t i = 0; i < intervals_us.size(); ++i)
+        {
+            ++result.checks;
+            const uint64_t expected_runs = (end - first_target[i]) / intervals_us[i] + 1;
+            if (runs[i] + 1 < expected_runs || runs[i] > expected_runs + 1)
+            {
+                ++result.errors;
+            }
+        }
+        return result;
+    }
+
+    //Random adds, duplicate ids, cancels and overflow against a reference model,
+    //cancelled tasks must never run and captures must all be destroyed
+    SimResult sim_cancel_under_load()
+    {
+        struct ModelTask
+        {
+            uint64_t target_us;
+            uint64_t interval_us;
+        };
+
+        SimResult result;
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<uint32_t> op(0, 99);
+        std::uniform_int_distribution<uint32_t> task_id(1, 40);
+        std::uniform_int_distribution<uint64_t> delay(0, 20'000);
+        std::uniform_int_distribution<uint64_t> step(0, 3'000);
+
+        const int64_t live_before = Tracker::live;
+        {
+            Heap heap;
+            std::map<uint32_t, ModelTask> model;
+            uint64_t now = 0;
+            uint32_t fired_id = 0;
+
+            for (uint32_t i = 0; i < 2'000'000; ++i)
+            {
+                const uint32_t choice = op(rng);
+                const uint32_t id = task_id(rng);
+
+                if (choice < 45)
+                {
+                    const uint64_t interval = (choice < 15) ? (delay(rng) + 1) : 0;
+                    const uint64_t target = now + delay(rng);
+
+                    auto res = heap.add(id, target, interval, Function([id, &fired_id, tracker = Tracker()] { fired_id = id; }));
+                    Heap::AddResult expected = Heap::AddResult::OK;
+                    if (model.count(id))
+                    {
+                        expected = Heap::AddResult::DUPLICATE_ID;
+                    }
+                    else if (model.size() >= CAPACITY)
+                    {
+                        expected = Heap::AddResult::FULL;
+                    }
+                    else
+                    {
+                        model[id] = { target, interval };
+                    }
+                    ++result.checks;
+                    result.errors += (res == expected) ? 0 : 1;
+                }
+                else if (choice < 75)
+                {
+                    ++result.checks;
+                    result.errors += (heap.cancel(id) == (model.erase(id) > 0)) ? 0 : 1;
+                }
+                else
+                {
+                    now += step(rng);
+                    Function function;
+                    while (heap.pop_due(now, function))
+                    {
+                        function();
+                        ++result.fires;
+                        ++result.checks;
+
+                        auto it = model.find(fired_id);
+                        if (it == model.end() || it->second.target_us > now)
+                        {
+                            ++result.errors;
+                            continue;
+                        }
+                        for (const auto& [other_id, other] : model)
+                        {
+                            if (other.target_us < it->second.target_us)
+                            {
+                                ++result.errors;
+                                break;
+                            }
+                        }
+
+                        if (it->second.interval_us == 0)
+                        {
+                            model.erase(it);
+                        }
+                        else
+                        {
+                            it->second.target_us += it->second.interval_us;
+                            if (it->second.target_us <= now)
+                            {
+                                it->second.target_us = now + it->second.interval_us;
+                            }
+                        }
+                    }
+                }
+
+                if ((i & 0xFF) == 0)
+                {
+                    ++result.checks;
+                    result.errors += (heap.size() == model.size()) ? 0 : 1;
+                }
+            }
+        }
+        ++result.checks;
+        result.errors += (Tracker::live == live_before) ? 0 : 1;
+        return result;
+    }
+
+    //What TaskQueue did before, std::function slots and a scan for the earliest target
+    struct ScanQueue
+    {
+        struct Task
+        {
+            uint32_t task_id{0};
+            uint64_t target_us{0};
+            std::function<void()> function;
+        };
+        std::array<Task, CAPACITY> tasks;
+
+        bool add(uint32_t task_id, uint64_t target_us, const std::function<void()>& function)
+        {
+            for (auto& task : tasks)
+            {
+                if (!task.function)
+                {
+                    task = { task_id, target_us, function };
+                    //Next alarm, as queue_delayed_task did on every add
+                    Bench::do_not_optimize(next());
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        int64_t next()
+        {
+            auto it = std::min_element(tasks.begin(), tasks.end(), [](const Task& a, const Task& b)
+            {
+                return a.function && (!b.function || a.target_us < b.target_us);
+            });
+            return (it != tasks.end() && it->function) ? static_cast<int64_t>(it->target_us) : -1;
+        }
+
+        bool pop_due(uint64_t now, std::function<void()>& function)
+        {
+            for (auto& task : tasks)
+            {
+                if (task.function && task.target_us <= now)
+                {
+                    function = task.function;
+                    task.function = nullptr;
+                    Bench::do_not_optimize(next());
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+} // namespace
+
+void bench_taskqueue()
+{
+    const char* suite = "taskqueue";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    //Fill all slots then drain them in order. Captures are three words like the board feedback tasks,
+    //past what std::function stores without allocating
+    std::array<uint64_t, CAPACITY> targets;
+    std::mt19937 rng(4);
+    for (auto& target : targets)
+    {
+        target = rng() % 1'000'000;
+    }
+
+    Bench::print_header(suite);
+    {
+        uint32_t sink = 0;
+        auto heap = std::make_unique<Heap>();
+        Bench::print_row(suite, "16 tasks", "heap + inline function", Bench::run(1, [&](size_t)
+        {
+            for (uint32_t i = 0; i < CAPACITY; ++i)
+            {
+                heap->add(i + 1, targets[i], 0, Function([&sink, &targets, i] { sink += static_cast<uint32_t>(targets[i]); }));
+            }
+            Function function;
+            while (heap->pop_due(1'000'000, function))
+            {
+                function();
+            }
+        }, 100'000'000));
+        Bench::do_not_optimize(sink);
+    }
+    {
+        uint32_t sink = 0;
+        auto queue = std::make_unique<ScanQueue>();
+        Bench::print_row(suite, "16 tasks", "scan + std::function", Bench::run(1, [&](size_t)
+        {
+            for (uint32_t i = 0; i < CAPACITY; ++i)
+            {
+                queue->add(i + 1, targets[i], [&sink, &targets, i] { sink += static_cast<uint32_t>(targets[i]); });
+            }
+            std::function<void()> function;
+            while (queue->pop_due(1'000'000, function))
+            {
+                function();
+            }
+        }, 100'000'000));
+        Bench::do_not_optimize(sink);
+    }
+
+    print_sim_header();
+    print_sim_row("ordering, random one shots", sim_ordering());
+    print_sim_row("repeat drift, 1h with IRQ latency", sim_repeat_drift());
+    print_sim_row("add/cancel/overflow under load vs model", sim_cancel_under_load());
+}
@@ -0,0 +1,330 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <memory>
+
+#include "Gamepad/Gamepad.h"
+#include "Gamepad/TurboEngine.h"
+#include "UserSettings/UserProfile.h"
+#include "BenchSuites.h"
+#include "Bench.h"
+
+//A console polling at 125, 500 and 1000 Hz, a host that only reports when something changes and
+//buttons held for RUN_US, in simulated time starting just short of the 32 bit wrap. On every poll
+//the device side builds a report if the pad is new or turbo is due (DeviceDriver::pad_in_due), a
+//little before the poll like SofSync does. What the console sees per poll is checked against each
+//turbo's rate and duty: presses counted over the run, every on and off run within a poll interval
+//(plus build jitter) of what it should be. The old loop counter turbo is run on the same polls
+//with a host reporting every 4 ms to show how its rate followed the loop
+
+namespace {
+
+    constexpr uint32_t RUN_US = 10 * 1000 * 1000;
+    constexpr uint32_t START_US = UINT32_MAX - 3 * 1000 * 1000;
+    constexpr uint32_t BUILD_LEAD_MAX_US = 300;
+    constexpr uint32_t LEGACY_HOST_US = 4000;
+
+    struct Turbo
+    {
+        const char* name;
+        uint16_t trigger;
+        uint16_t output;
+        uint8_t rate_index;
+        uint8_t on_16ths;
+        uint32_t press_at_us;   //After the start of the run
+    };
+
+    //Profile turbo on A, B and X pressed at different times, plus a driver style channel (LB fires Y)
+    constexpr Turbo TURBOS[] =
+    {
+        { "A 10Hz 1/2",    Gamepad::BUTTON_A,  Gamepad::BUTTON_A, 6,  0,  0     },
+        { "B 20Hz 1/4",    Gamepad::BUTTON_B,  Gamepad::BUTTON_B, 10, 4,  1234  },
+        { "X 15Hz 3/4",    Gamepad::BUTTON_X,  Gamepad::BUTTON_X, 8,  12, 56789 },
+        { "LB->Y 25Hz 1/2", Gamepad::BUTTON_LB, Gamepad::BUTTON_Y, 12, 8,  3000  },
+    };
+
+    struct Observed
+    {
+        uint32_t presses{0};
+        uint32_t on_polls{0};
+        uint32_t polls{0};
+        int32_t on_error_max_us{0};     //Largest on run length error, complete runs only
+        int32_t off_error_max_us{0};
+    };
+
+    //Measured run length in polls against the expected length, within a poll either side is exact
+    int32_t run_error(uint32_t run_polls, uint32_t poll_us, uint32_t expected_us)
+    {
+        const int32_t measured = static_cast<int32_t>(run_polls * poll_us);
+        const int32_t diff = std::abs(measured - static_cast<int32_t>(expected_us));
+        return std::max(0, diff - static_cast<int32_t>(poll_us));
+    }
+
+    std::vector<Observed> simulate(uint32_t poll_hz, uint32_t seed, uint32_t& reports_built)
+    {
+        const uint32_t poll_us = 1000000 / poll_hz;
+        std::mt19937 rng(seed);
+
+        uint8_t settings[12] = {};
+        TurboEngine engine;
+        for (const auto& turbo : TURBOS)
+        {
+            if (turbo.trigger == turbo.output)
+            {
+                settings[__builtin_ctz(turbo.trigger)] = TurboEngine::setting(turbo.rate_index, turbo.on_16ths);
+            }
+        }
+        engine.compile(settings);
+        for (const auto& turbo : TURBOS)
+        {
+            if (turbo.trigger != turbo.output)
+            {
+                engine.add(turbo.trigger, turbo.output, TurboEngine::RATES_HZ[turbo.rate_index], turbo.on_16ths);
+            }
+        }
+
+        std::vector<Observed> observed(std::size(TURBOS));
+        std::vector<bool> last_on(std::size(TURBOS), false);
+        std::vector<uint32_t> run_polls(std::size(TURBOS), 0);
+        std::vector<bool> run_complete(std::size(TURBOS), false);
+
+        uint16_t pad_buttons = 0;
+        bool new_pad = true;
+        uint16_t report_buttons = 0;
+        reports_built = 0;
+
+        for (uint64_t poll = 1; poll * poll_us <= RUN_US; ++poll)
+        {
+            const uint64_t poll_at = poll * poll_us;
+
+            //Host reports on change only, each turbo button goes down once and stays down
+            uint16_t held = 0;
+            for (const auto& turbo : TURBOS)
+            {
+                held |= (poll_at >= turbo.press_at_us) ? turbo.trigger : 0;
+            }
+            if (held != pad_buttons)
+            {
+                pad_buttons = held;
+                new_pad = true;
+            }
+
+            const uint32_t build_us = static_cast<uint32_t>(START_US + poll_at - (rng() % (BUILD_LEAD_MAX_US + 1)));
+            if (new_pad || engine.due(build_us))
+            {
+                new_pad = false;
+                report_buttons = engine.apply(pad_buttons, build_us);
+                ++reports_built;
+            }
+
+            for (size_t i = 0; i < std::size(TURBOS); ++i)
+            {
+                const Turbo& turbo = TURBOS[i];
+                if (poll_at < turbo.press_at_us)
+                {
+                    continue;
+                }
+                const uint32_t period_us = 1000000 / TurboEngine::RATES_HZ[turbo.rate_index];
+                const uint32_t on_us = (period_us * (turbo.on_16ths ? turbo.on_16ths : 8)) / 16;
+                const bool on = (report_buttons & turbo.output) != 0;
+                Observed& obs = observed[i];
+
+                ++obs.polls;
+                obs.on_polls += on ? 1 : 0;
+                if (on && !last_on[i])
+                {
+                    ++obs.presses;
+                }
+                if (obs.polls > 1 && on != last_on[i])
+                {
+                    //A run ended, the first one started mid phase at the press
+                    if (run_complete[i])
+                    {
+                        const int32_t error = run_error(run_polls[i], poll_us, last_on[i] ? on_us : (period_us - on_us));
+                        int32_t& max_error = last_on[i] ? obs.on_error_max_us : obs.off_error_max_us;
+                        max_error = std::max(max_error, error);
+                    }
+                    run_complete[i] = true;
+                    run_polls[i] = 0;
+                }
+                ++run_polls[i];
+                last_on[i] = on;
+            }
+        }
+        return observed;
+    }
+
+    //Turbo on A counted per report built, reports built whenever the host sent one
+    double simulate_legacy(uint32_t poll_hz)
+    {
+        const uint32_t poll_us = 1000000 / poll_hz;
+        uint32_t turbo_tick = 0;
+        uint32_t presses = 0;
+        bool last_on = false;
+        uint64_t next_host = 0;
+        bool on = false;
+
+        for (uint64_t poll = 1; poll * poll_us <= RUN_US; ++poll)
+        {
+            const uint64_t poll_at = poll * poll_us;
+            if (poll_at >= next_host)
+            {
+                next_host = poll_at + LEGACY_HOST_US - (poll_at % LEGACY_HOST_US);
+                ++turbo_tick;
+                on = ((turbo_tick / 5) % 2) == 0;
+            }
+            presses += (on && !last_on) ? 1 : 0;
+            last_on = on;
+        }
+        return static_cast<double>(presses) * 1000000.0 / RUN_US;
+    }
+
+    void print_timing_header()
+    {
+        if (Bench::csv())
+        {
+            std::printf("suite,poll_hz,turbo,rate_hz,measured_hz,duty,measured_duty,on_error_us,off_error_us,reports\n");
+            return;
+        }
+        std::printf("\n[gamepad.turbo] %u s held, host reports on change only\n", RUN_US / 1000000);
+        std::printf("%-8s %-16s %8s %10s %8s %10s %10s %10s %8s\n",
+            "poll Hz", "turbo", "rate Hz", "seen Hz", "duty", "seen duty", "on err us", "off err us", "reports");
+    }
+
+    //A mode default (XInput's LB fires A) runs from the Gamepad engine across profile loads and a
+    //profile turbo on LB replaces it instead of running on top of it
+    const char* mode_default_error()
+    {
+        auto gamepad = std::make_unique<Gamepad>();
+        gamepad->set_mode_turbo({ Gamepad::BUTTON_LB, Gamepad::BUTTON_A, 20, 8 });
+
+        UserProfile profile;
+        gamepad->set_profile(profile);
+        Gamepad::PadIn pad_in;
+        pad_in.buttons = Gamepad::BUTTON_LB;
+        gamepad->apply_turbo(pad_in, 0);
+        if (pad_in.buttons != Gamepad::BUTTON_A)
+        {
+            return "mode default not applied";
+        }
+
+        profile.turbo[8] = TurboEngine::setting(6, 0);
+        gamepad->set_profile(profile);
+        for (uint32_t now_us = 0; now_us < 200000; now_us += 1000)
+        {
+            pad_in.buttons = Gamepad::BUTTON_LB;
+            gamepad->apply_turbo(pad_in, now_us);
+            if (pad_in.buttons & Gamepad::BUTTON_A)
+            {
+                return "mode default stacked on profile turbo";
+            }
+        }
+        return nullptr;
+    }
+
+} // namespace
+
+void bench_turbo()
+{
+    const char* suite = "gamepad.turbo";
+    if (!Bench::enabled(suite, ""))
+    {
+        return;
+    }
+
+    print_timing_header();
+
+    for (uint32_t poll_hz : { 125u, 500u, 1000u })
+    {
+        const uint32_t poll_us = 1000000 / poll_hz;
+        uint32_t reports = 0;
+        const auto observed = simulate(poll_hz, poll_hz, reports);
+
+        for (size_t i = 0; i < std::size(TURBOS); ++i)
+        {
+            const Turbo& turbo = TURBOS[i];
+            const Observed& obs = observed[i];
+            const uint32_t rate_hz = TurboEngine::RATES_HZ[turbo.rate_index];
+            const double duty = (turbo.on_16ths ? turbo.on_16ths : 8) / 16.0;
+            const double held_s = static_cast<double>(obs.polls) * poll_us / 1000000.0;
+            const double seen_hz = static_cast<double>(obs.presses) / held_s;
+            const double seen_duty = static_cast<double>(obs.on_polls) / obs.polls;
+
+            //Presses can't drift, a run is off by at most the build lead past quantizing to polls
+            const double expected_presses = held_s * rate_hz;
+            const char* error = nullptr;
+            if (std::abs(obs.presses - expected_presses) > 1.0)
+            {
+                error = "press count";
+            }
+            else if (obs.on_error_max_us > static_cast<int32_t>(BUILD_LEAD_MAX_US) ||
+                     obs.off_error_max_us > static_cast<int32_t>(BUILD_LEAD_MAX_US))
+            {
+                error = "run length";
+            }
+            else if (std::abs(seen_duty - duty) > (static_cast<double>(poll_us) * rate_hz / 1000000.0))
+            {
+                error = "duty";
+            }
+            if (error)
+            {
+                char what[128];
+                std::snprintf(what, sizeof(what), "%u Hz polls, %s: %s off", poll_hz, turbo.name, error);
+                Bench::fail(suite, what);
+            }
+
+            if (Bench::csv())
+            {
+                std::printf("%s,%u,%s,%u,%.3f,%.4f,%.4f,%d,%d,%u\n", suite, poll_hz, turbo.name, rate_hz, seen_hz,
+                    duty, seen_duty, obs.on_error_max_us, obs.off_error_max_us, reports);
+                continue;
+            }
+            std::printf("%-8u %-16s %8u %10.3f %8.4f %10.4f %10d %10d %8u\n", poll_hz, turbo.name, rate_hz, seen_hz,
+                duty, seen_duty, obs.on_error_max_us, obs.off_error_max_us, reports);
+        }
+
+        const double legacy_hz = simulate_legacy(poll_hz);
+        if (Bench::csv())
+        {
+            std::printf("%s,%u,legacy A per report,0,%.3f,0.5,0,0,0,0\n", suite, poll_hz, legacy_hz);
+        }
+        else
+        {
+            std::printf("%-8u %-16s %8s %10.3f   (host every %u us)\n", poll_hz, "legacy tick", "-", legacy_hz, LEGACY_HOST_US);
+        }
+    }
+
+    if (const char* error = mode_default_error())
+    {
+        Bench::fail(suite, error);
+    }
+
+    //Cost per report build with four turbos held
+    TurboEngine engine;
+    uint8_t settings[12] = {};
+    settings[0] = TurboEngine::setting(6, 0);
+    settings[1] = TurboEngine::setting(10, 4);
+    settings[2] = TurboEngine::setting(8, 12);
+    engine.compile(settings);
+    engine.add(Gamepad::BUTTON_LB, Gamepad::BUTTON_Y, 25, 8);
+    const uint16_t held = Gamepad::BUTTON_A | Gamepad::BUTTON_B | Gamepad::BUTTON_X | Gamepad::BUTTON_LB;
+
+    Bench::print_header(suite);
+    if (Bench::enabled(suite, "apply"))
+    {
+        Bench::print_row(suite, "4 held", "apply", Bench::run(4096, [&](size_t i)
+        {
+            Bench::do_not_optimize(engine.apply(held, static_cast<uint32_t>(i * 250)));
+        }));
+    }
+    if (Bench::enabled(suite, "due"))
+    {
+        Bench::print_row(suite, "4 held", "due", Bench::run(4096, [&](size_t i)
+        {
+            Bench::do_not_optimize(engine.due(static_cast<uint32_t>(i * 250)));
+        }));
+    }
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "BenchSuites.h"
+#include "Bench.h"
+
+static void print_usage(const char* argv0)
+{
+    std::printf("Usage: %s [--csv] [filter]\n", argv0);
+    std::printf("  --csv    Print results as CSV for diffing runs\n");
+    std::printf("  filter   Only run rows whose suite or function name contains this string\n");
+}
+
+int main(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            Bench::set_csv(true);
+        }
+        else if (std::strcmp(argv[i], "-h") == 0 || std::strcmp(argv[i], "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else
+        {
+            Bench::set_filter(argv[i]);
+        }
+    }
+
+    if (!Bench::instr_counter().available())
+    {
+        std::fprintf(stderr, "perf_event_open unavailable, instr/sample will be n/a (check /proc/sys/kernel/perf_event_paranoid)\n");
+    }
+
+    bench_gamepad();
+    bench_stick_lut();
+    bench_snapshot();
+    bench_taskqueue();
+    bench_hid_plan();
+    bench_hid_arena();
+    bench_hid_plan_cache();
+    bench_heap_soak();
+    bench_feedback();
+    bench_in_pipe();
+    bench_device_poll();
+    bench_sof_sync();
+    bench_mapping();
+    bench_output_curve();
+    bench_turbo();
+    bench_pad_delta();
+    bench_i2c_queue();
+    return Bench::failed() ? 1 : 0;
+}
@@ -0,0 +1,43 @@
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+//Host stand-in for the Pico SDK hardware spin locks, only what Gamepad.h needs
+
+#include <cstdint>
+#include <atomic>
+
+struct spin_lock_t
+{
+    std::atomic<bool> locked{false};
+};
+
+static inline spin_lock_t* spin_lock_instance(uint32_t lock_num)
+{
+    static spin_lock_t locks[32];
+    return &locks[lock_num % 32];
+}
+
+static inline int spin_lock_claim_unused(bool required)
+{
+    static std::atomic<int> next{0};
+    return next.fetch_add(1) % 32;
+}
+
+static inline void __sev()
+{
+}
+
+static inline uint32_t spin_lock_blocking(spin_lock_t* lock)
+{
+    while (lock->locked.exchange(true, std::memory_order_acquire))
+    {
+    }
+    return 0;
+}
+
+static inline void spin_unlock(spin_lock_t* lock, uint32_t saved_irq)
+{
+    lock->locked.store(false, std::memory_order_release);
+}
+
+#endif // _HARDWARE_SYNC_H
@@ -0,0 +1,15 @@
+#ifndef _HARDWARE_TIMER_H
+#define _HARDWARE_TIMER_H
+
+//Host stand-in for the Pico SDK timer, only what Gamepad.h needs
+
+#include <cstdint>
+#include <chrono>
+
+static inline uint32_t time_us_32()
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#endif // _HARDWARE_TIMER_H
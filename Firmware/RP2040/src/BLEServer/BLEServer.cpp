@@ -1,6 +1,6 @@
 #include <cstring>
-#include <string>
 #include <algorithm>
+#include <atomic>
 
 #include "att_delayed_response.h"
 #include "btstack.h"
@@ -43,8 +43,7 @@ namespace ADV {
             std::memcpy(flags, FLAGS, sizeof(flags));
             name_len = sizeof(FIRMWARE_NAME);
             name_type = NAME_TYPE;
-            std::string fw_name = FIRMWARE_NAME;
-            std::memcpy(name, fw_name.c_str(), std::min(sizeof(name), fw_name.size()));
+            std::memcpy(name, FIRMWARE_NAME, sizeof(name));
         }
     };
     static_assert(sizeof(Data) == 5 + sizeof(FIRMWARE_NAME) - 1, "BLEServer::ADV::Data struct size mismatch");
@@ -152,21 +151,34 @@ public:
         return ret;
     }
 
+    //Storing reboots, so the first commit wins. The profile is latched here since tasks can't capture one
     bool commit_profile() {
+        if (commit_pending_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        commit_setup_packet_ = setup_packet_;
+        commit_profile_ = profile_;
+
         bool success = false;
-        if (setup_packet_.device_type != DeviceDriverType::NONE) {
+        if (commit_setup_packet_.device_type != DeviceDriverType::NONE) {
             success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
-                [driver_type = setup_packet_.device_type, profile = profile_, index = setup_packet_.player_idx]
+                [this]
                 {
-                    UserSettings::get_instance().store_profile_and_driver_type(driver_type, index, profile);
+                    UserSettings::get_instance().store_profile_and_driver_type(commit_setup_packet_.device_type, commit_setup_packet_.player_idx, commit_profile_);
+                    //Still here if the store failed or didn't reboot, take the next commit
+                    commit_pending_.store(false, std::memory_order_release);
                 });
         } else {
             success = TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), 1000, false,
-                [index = setup_packet_.player_idx, profile = profile_]
+                [this]
                 {
-                    UserSettings::get_instance().store_profile(index, profile);
+                    UserSettings::get_instance().store_profile(commit_setup_packet_.player_idx, commit_profile_);
+                    commit_pending_.store(false, std::memory_order_release);
                 });
         }
+        if (success) {
+            commit_pending_.store(true, std::memory_order_release);
+        }
         return success;
     }
 
@@ -174,6 +186,11 @@ private:
     SetupPacket setup_packet_;
     UserProfile profile_;
     size_t current_offset_ = 0;
+
+    //Set by commit_profile on core1, cleared by the queued store on core0
+    std::atomic<bool> commit_pending_{false};
+    SetupPacket commit_setup_packet_;
+    UserProfile commit_profile_;
 };
 
 std::array<Gamepad*, MAX_GAMEPADS> gamepads_;
@@ -190,16 +207,17 @@ static int verify_write(const uint16_t buffer_size, const uint16_t expected_size
 static void disconnect_client_cb(btstack_timer_source_t *ts) {
     hci_con_handle_t connection_handle = *static_cast<hci_con_handle_t*>(ts->context);
     hci_send_cmd(&hci_disconnect, connection_handle);
-    delete static_cast<hci_con_handle_t*>(ts->context);
 }
 
 static void queue_disconnect(hci_con_handle_t connection_handle, uint32_t dealy_ms) {
     static btstack_timer_source_t disconnect_timer;
+    //Only one disconnect is ever pending, it shares the timer's lifetime
+    static hci_con_handle_t disconnect_handle;
 
-    hci_con_handle_t* connection_handle_ptr = new hci_con_handle_t(connection_handle);
+    disconnect_handle = connection_handle;
 
     disconnect_timer.process = disconnect_client_cb;
-    disconnect_timer.context = connection_handle_ptr;
+    disconnect_timer.context = &disconnect_handle;
 
     btstack_run_loop_set_timer(&disconnect_timer, dealy_ms);
     btstack_run_loop_add_timer(&disconnect_timer);
@@ -210,24 +228,22 @@ static uint16_t att_read_callback(  hci_con_handle_t connection_handle,
                                     uint16_t offset,
                                     uint8_t *buffer,
                                     uint16_t buffer_size) {
-    std::string fw_version;
-    std::string fw_name;
+    static constexpr char FW_VERSION[] = FIRMWARE_VERSION;
+    static constexpr char FW_NAME[] = FIRMWARE_NAME;
     Gamepad::PadIn pad_in;
 
     switch (att_handle) {
         case Handle::FW_VERSION:
-            fw_version = FIRMWARE_VERSION;
             if (buffer)  {
-                std::memcpy(buffer, reinterpret_cast<const uint8_t*>(fw_version.c_str()), fw_version.size());
+                std::memcpy(buffer, FW_VERSION, sizeof(FW_VERSION) - 1);
             }
-            return static_cast<uint16_t>(fw_version.size());
+            return static_cast<uint16_t>(sizeof(FW_VERSION) - 1);
 
         case Handle::FW_NAME:
-            fw_name = FIRMWARE_NAME;
             if (buffer) {
-                std::memcpy(buffer, reinterpret_cast<const uint8_t*>(fw_name.c_str()), fw_name.size());;
+                std::memcpy(buffer, FW_NAME, sizeof(FW_NAME) - 1);
             }
-            return static_cast<uint16_t>(fw_name.size());
+            return static_cast<uint16_t>(sizeof(FW_NAME) - 1);
 
         case Handle::GET_SETUP:
             if (buffer) {
@@ -2,6 +2,7 @@
 #include <cstring>
 #include <functional>
 #include <pico/mutex.h>
+#include <pico/time.h>
 #include <pico/cyw43_arch.h>
 
 #include "btstack_run_loop.h"
@@ -9,6 +10,7 @@
 
 #include "sdkconfig.h"
 #include "Bluepad32/Bluepad32.h"
+#include "Gamepad/FeedbackLimiter.h"
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
 
@@ -20,12 +22,40 @@ static_assert((CONFIG_BLUEPAD32_MAX_DEVICES == MAX_GAMEPADS), "Mismatch between
 
 namespace bluepad32 {
 
-static constexpr uint32_t FEEDBACK_TIME_MS = 250;
+//Rumble is checked every tick and sent once FeedbackLimiter says so, held rumble
+//is sent with a FEEDBACK_REFRESH_MS duration and resent that often
+static constexpr uint32_t FEEDBACK_TICK_MS = 1;
 static constexpr uint32_t LED_CHECK_TIME_MS = 500;
 
+using Feedback = FeedbackLimiter<FEEDBACK_MIN_INTERVAL_US, FEEDBACK_REFRESH_MS * 1000>;
+
+//uni_gamepad_t buttons are a uint16_t, misc_buttons and dpad a uint8_t each
+static constexpr SourceMap<2> BUTTON_MAP = SourceMap<2>()
+    .button(0, BUTTON_A,          Gamepad::BUTTON_A)
+    .button(0, BUTTON_B,          Gamepad::BUTTON_B)
+    .button(0, BUTTON_X,          Gamepad::BUTTON_X)
+    .button(0, BUTTON_Y,          Gamepad::BUTTON_Y)
+    .button(0, BUTTON_SHOULDER_L, Gamepad::BUTTON_LB)
+    .button(0, BUTTON_SHOULDER_R, Gamepad::BUTTON_RB)
+    .button(0, BUTTON_THUMB_L,    Gamepad::BUTTON_L3)
+    .button(0, BUTTON_THUMB_R,    Gamepad::BUTTON_R3);
+
+static constexpr SourceMap<1> MISC_MAP = SourceMap<1>()
+    .button(0, MISC_BUTTON_BACK,   Gamepad::BUTTON_BACK)
+    .button(0, MISC_BUTTON_START,  Gamepad::BUTTON_START)
+    .button(0, MISC_BUTTON_SYSTEM, Gamepad::BUTTON_SYS);
+
+//Bit per direction, only the 8 real ones count, same as a hat
+static constexpr SourceMap<1> DPAD_MAP = SourceMap<1>()
+    .hat(0, DPAD_UP | DPAD_DOWN | DPAD_LEFT | DPAD_RIGHT, 
+        {   DPAD_UP, DPAD_UP | DPAD_RIGHT, DPAD_RIGHT, DPAD_DOWN | DPAD_RIGHT,
+            DPAD_DOWN, DPAD_DOWN | DPAD_LEFT, DPAD_LEFT, DPAD_UP | DPAD_LEFT });
+
 struct BTDevice {
     bool connected{false};
+    bool rumbling{false};
     Gamepad* gamepad{nullptr};
+    Feedback feedback;
 };
 
 BTDevice bt_devices_[MAX_GAMEPADS];
@@ -87,24 +117,37 @@ void set_rumble(uni_hid_device_t* bp_device, uint16_t length, uint8_t rumble_l,
 
 static void send_feedback_cb(btstack_timer_source *ts)
 {
+    const uint64_t now_us = time_us_64();
     uni_hid_device_t* bp_device = nullptr;
 
     for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
     {
-        if (!bt_devices_[i].connected || 
+        BTDevice& device = bt_devices_[i];
+        if (!device.connected || 
             !(bp_device = uni_hid_device_get_instance_for_idx(i)))
         {
             continue;
         }
 
-        Gamepad::PadOut gp_out = bt_devices_[i].gamepad->get_pad_out();
-        if (gp_out.rumble_l > 0 || gp_out.rumble_r > 0)
+        //Held rumble times out on the controller, so it stays pending until it's stopped
+        const uint32_t event = device.gamepad->pad_out_event();
+        if (device.feedback.due(event, device.rumbling, now_us) == Feedback::Due::NONE)
+        {
+            continue;
+        }
+
+        Gamepad::PadOut gp_out = device.gamepad->get_pad_out();
+        const bool rumble = (gp_out.rumble_l > 0 || gp_out.rumble_r > 0);
+        //Zero is only sent to stop rumble early, the controller is idle otherwise
+        if (rumble || device.rumbling)
         {
-            set_rumble(bp_device, static_cast<uint16_t>(FEEDBACK_TIME_MS), gp_out.rumble_l, gp_out.rumble_r);
+            set_rumble(bp_device, static_cast<uint16_t>(FEEDBACK_REFRESH_MS), gp_out.rumble_l, gp_out.rumble_r);
         }
+        device.rumbling = rumble;
+        device.feedback.sent(event, now_us);
     }
 
-    btstack_run_loop_set_timer(ts, FEEDBACK_TIME_MS);
+    btstack_run_loop_set_timer(ts, FEEDBACK_TICK_MS);
     btstack_run_loop_add_timer(ts);
 }
 
@@ -170,6 +213,8 @@ static uni_error_t device_ready_cb(uni_hid_device_t* device) {
     }
 
     bt_devices_[idx].connected = true;
+    bt_devices_[idx].rumbling = false;
+    bt_devices_[idx].feedback.reset(bt_devices_[idx].gamepad->pad_out_event());
 
     if (led_timer_set_) {
         led_timer_set_ = false;
@@ -180,7 +225,7 @@ static uni_error_t device_ready_cb(uni_hid_device_t* device) {
         feedback_timer_set_ = true;
         feedback_timer_.process = send_feedback_cb;
         feedback_timer_.context = nullptr;
-        btstack_run_loop_set_timer(&feedback_timer_, FEEDBACK_TIME_MS);
+        btstack_run_loop_set_timer(&feedback_timer_, FEEDBACK_TICK_MS);
         btstack_run_loop_add_timer(&feedback_timer_);
     }
     return UNI_ERROR_SUCCESS;
@@ -203,47 +248,10 @@ static void controller_data_cb(uni_hid_device_t* device, uni_controller_t* contr
     Gamepad* gamepad = bt_devices_[idx].gamepad;
     Gamepad::PadIn gp_in;
 
-    switch (uni_gp->dpad) 
-    {
-        case DPAD_UP:
-            gp_in.dpad = gamepad->MAP_DPAD_UP;
-            break;
-        case DPAD_DOWN:
-            gp_in.dpad = gamepad->MAP_DPAD_DOWN;
-            break;
-        case DPAD_LEFT:
-            gp_in.dpad = gamepad->MAP_DPAD_LEFT;
-            break;
-        case DPAD_RIGHT:
-            gp_in.dpad = gamepad->MAP_DPAD_RIGHT;
-            break;
-        case DPAD_UP | DPAD_RIGHT:
-            gp_in.dpad = gamepad->MAP_DPAD_UP_RIGHT;
-            break;
-        case DPAD_DOWN | DPAD_RIGHT:
-            gp_in.dpad = gamepad->MAP_DPAD_DOWN_RIGHT;
-            break;
-        case DPAD_DOWN | DPAD_LEFT:
-            gp_in.dpad = gamepad->MAP_DPAD_DOWN_LEFT;
-            break;
-        case DPAD_UP | DPAD_LEFT:
-            gp_in.dpad = gamepad->MAP_DPAD_UP_LEFT;
-            break;
-        default:
-            break;
-    }
-
-    if (uni_gp->buttons & BUTTON_A) gp_in.buttons |= gamepad->MAP_BUTTON_A;
-    if (uni_gp->buttons & BUTTON_B) gp_in.buttons |= gamepad->MAP_BUTTON_B;
-    if (uni_gp->buttons & BUTTON_X) gp_in.buttons |= gamepad->MAP_BUTTON_X;
-    if (uni_gp->buttons & BUTTON_Y) gp_in.buttons |= gamepad->MAP_BUTTON_Y;
-    if (uni_gp->buttons & BUTTON_SHOULDER_L) gp_in.buttons |= gamepad->MAP_BUTTON_LB;
-    if (uni_gp->buttons & BUTTON_SHOULDER_R) gp_in.buttons |= gamepad->MAP_BUTTON_RB;
-    if (uni_gp->buttons & BUTTON_THUMB_L)    gp_in.buttons |= gamepad->MAP_BUTTON_L3;  
-    if (uni_gp->buttons & BUTTON_THUMB_R)    gp_in.buttons |= gamepad->MAP_BUTTON_R3;
-    if (uni_gp->misc_buttons & MISC_BUTTON_BACK)    gp_in.buttons |= gamepad->MAP_BUTTON_BACK;
-    if (uni_gp->misc_buttons & MISC_BUTTON_START)   gp_in.buttons |= gamepad->MAP_BUTTON_START;
-    if (uni_gp->misc_buttons & MISC_BUTTON_SYSTEM)  gp_in.buttons |= gamepad->MAP_BUTTON_SYS;
+    MappingPlan::Pad pad = BUTTON_MAP.map(&uni_gp->buttons);
+    pad.buttons |= MISC_MAP.map(&uni_gp->misc_buttons).buttons;
+    pad.dpad = DPAD_MAP.map(&uni_gp->dpad).dpad;
+    gamepad->remap(pad, gp_in);
 
     gp_in.trigger_l = gamepad->scale_trigger_l<10>(static_cast<uint16_t>(uni_gp->brake));
     gp_in.trigger_r = gamepad->scale_trigger_r<10>(static_cast<uint16_t>(uni_gp->throttle));
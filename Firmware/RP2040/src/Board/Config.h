@@ -17,6 +17,92 @@
     #define MAX_GAMEPADS 1
 #endif
 
+//Longest the core0 device loop idles without an event, in microseconds
+#ifndef CORE0_IDLE_TICK_US
+    #define CORE0_IDLE_TICK_US 1000
+#endif
+
+//With SOF sync (EN_SOF_SYNC) device reports are built this long before the console's next poll
+//to start with, the lead then calibrates itself against late reports
+#ifndef SOF_SYNC_LEAD_US
+    #define SOF_SYNC_LEAD_US 300
+#endif
+
+//How long a live mode switch keeps the device off the bus so the console sees it go
+#ifndef DEVICE_SWITCH_DISCONNECT_MS
+    #define DEVICE_SWITCH_DISCONNECT_MS 200
+#endif
+
+//The new type is stored this long after the switch reconnects, the flash write pauses core1
+//so it's kept clear of the console enumerating the new device
+#ifndef DEVICE_SWITCH_STORE_DELAY_MS
+    #define DEVICE_SWITCH_STORE_DELAY_MS 3000
+#endif
+
+//Shortest gap between two rumble sends to one controller, console writes in between are coalesced
+#ifndef FEEDBACK_MIN_INTERVAL_US
+    #define FEEDBACK_MIN_INTERVAL_US 8000
+#endif
+
+//How long a host driver's own rumble change (short rumble timing out) waits before it's sent,
+//Bluepad32 also resends held rumble this often
+#ifndef FEEDBACK_REFRESH_MS
+    #define FEEDBACK_REFRESH_MS 200
+#endif
+
+//RAM per stick for the compiled stick shaping table, 0 always runs the Fix16 shaping
+#ifndef STICK_LUT_BUDGET
+    #define STICK_LUT_BUDGET 4608
+#endif
+
+//Max error vs the Fix16 shaping allowed in a table cell, in int16 stick units (256 is one 8 bit step)
+#ifndef STICK_LUT_MAX_ERROR
+    #define STICK_LUT_MAX_ERROR 64
+#endif
+
+//Longest one stick's table may take to compile when a profile loads (at boot, before tud_init),
+//cells not bounded by then run the Fix16 shaping
+#ifndef STICK_LUT_COMPILE_BUDGET_US
+    #define STICK_LUT_COMPILE_BUDGET_US 50000
+#endif
+
+//How often debug builds print the latency trace histograms to the UART
+#ifndef LATENCY_TRACE_LOG_MS
+    #define LATENCY_TRACE_LOG_MS 5000
+#endif
+
+//How often debug builds print host IN pipe counters (reports, empty, unarmed frames) to the UART
+#ifndef HOST_POLL_STATS_LOG_MS
+    #define HOST_POLL_STATS_LOG_MS 5000
+#endif
+
+//How often debug builds print the poll interval the console actually uses to the UART
+#ifndef DEVICE_POLL_STATS_LOG_MS
+    #define DEVICE_POLL_STATS_LOG_MS 5000
+#endif
+
+//How often debug builds with the heap audit print allocation counts to the UART
+#ifndef HEAP_AUDIT_LOG_MS
+    #define HEAP_AUDIT_LOG_MS 10000
+#endif
+
+//Scratch RAM for parsing a generic HID report descriptor, shared by every interface.
+//Descriptors that don't fit aren't used, the debug log prints what each one needed
+#ifndef HID_DESCRIPTOR_ARENA_SIZE
+    #define HID_DESCRIPTOR_ARENA_SIZE 4096
+#endif
+
+//Flash sectors kept for compiled generic HID plans, one distinct descriptor each, 0 disables the cache.
+//They sit under the NVS_SECTORS at the end of flash
+#ifndef HID_PLAN_CACHE_SLOTS
+    #define HID_PLAN_CACHE_SLOTS 4
+#endif
+
+//How long after the last newly compiled plan the cache is written, core1 (the host) is paused for it
+#ifndef HID_PLAN_CACHE_FLUSH_DELAY_MS
+    #define HID_PLAN_CACHE_FLUSH_DELAY_MS 5000
+#endif
+
 #if defined(CONFIG_OGXM_BOARD_PI_PICO) || defined(CONFIG_OGXM_BOARD_PI_PICO2)
     #define OGXM_BOARD          PI_PICO
     #define PIO_USB_DP_PIN      9 // DM = 1
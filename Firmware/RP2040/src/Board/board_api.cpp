@@ -10,6 +10,9 @@
 #include "Board/ogxm_log.h"
 #include "Board/board_api_private/board_api_private.h"
 #include "TaskQueue/TaskQueue.h"
+#if defined(CONFIG_EN_USB_HOST)
+#include "USBHost/HIDParser/HIDPlanCache.h"
+#endif
 
 namespace board_api {
 
@@ -31,6 +34,11 @@ void usb::disconnect_all() {
     sleep_ms(500);
     tud_disconnect();
     sleep_ms(500);
+
+#if defined(CONFIG_EN_USB_HOST)
+    //Core1 is stopped and every caller reboots next, the only time it's safe to write flash
+    HIDPlanCache::get_instance().flush();
+#endif
 }
 
 // If using PicoW, only use this method from the core running btstack and after you've called init_bluetooth
@@ -65,6 +73,13 @@ uint32_t ms_since_boot() {
     return to_ms_since_boot(get_absolute_time());
 }
 
+//Idles the core0 device loop until there's something to do. Any IRQ taken on this core (USB, I2C slave, 
+//TaskQueue alarm) or a __sev() from core1 (new pad data, queued task) ends the wait, 
+//max_us is the fallback for anything polled on a timer, DeviceManager::idle_us() gives it
+void wait_for_work(uint32_t max_us) {
+    best_effort_wfe_or_timeout(make_timeout_time_us(max_us));
+}
+
 //Call after board is initialized
 void init_bluetooth() {
     if (board_api_bt::init) {
@@ -0,0 +1,107 @@
+#include <malloc.h>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+#include "Board/Config.h"
+#include "Board/ogxm_log.h"
+#include "Board/heap_audit.h"
+#include "TaskQueue/TaskQueue.h"
+
+namespace heap_audit {
+
+//Both cores allocate, so everything here is atomic
+static std::atomic<uint32_t> allocs_{0};
+static std::atomic<uint32_t> frees_{0};
+static std::atomic<uint32_t> live_bytes_{0};
+static std::atomic<uint32_t> peak_bytes_{0};
+static std::atomic<uint32_t> steady_allocs_{0};
+static std::atomic<bool> steady_{false};
+
+static inline void on_alloc(void* ptr) {
+    const uint32_t size = static_cast<uint32_t>(malloc_usable_size(ptr));
+    const uint32_t live = live_bytes_.fetch_add(size, std::memory_order_relaxed) + size;
+
+    uint32_t peak = peak_bytes_.load(std::memory_order_relaxed);
+    while (live > peak && !peak_bytes_.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    allocs_.fetch_add(1, std::memory_order_relaxed);
+    if (steady_.load(std::memory_order_relaxed)) {
+        steady_allocs_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static inline void on_free(void* ptr) {
+    live_bytes_.fetch_sub(static_cast<uint32_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+    frees_.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void* allocate(size_t size, bool nothrow) {
+    void* ptr = std::malloc(size ? size : 1);
+    if (!ptr) {
+        if (nothrow) {
+            return nullptr;
+        }
+        //Built without exceptions, running out of heap is fatal either way
+        OGXM_LOG("heap_audit: out of memory allocating %u bytes\n", static_cast<unsigned>(size));
+        std::abort();
+    }
+    on_alloc(ptr);
+    return ptr;
+}
+
+static void release(void* ptr) {
+    if (ptr) {
+        on_free(ptr);
+        std::free(ptr);
+    }
+}
+
+void mark_steady_state() {
+    steady_.store(true, std::memory_order_relaxed);
+
+#if defined(CONFIG_OGXM_DEBUG)
+    TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), HEAP_AUDIT_LOG_MS, true,
+    [] {
+        log_stats();
+    });
+#endif
+}
+
+Stats get_stats() {
+    Stats stats;
+    stats.allocs = allocs_.load(std::memory_order_relaxed);
+    stats.frees = frees_.load(std::memory_order_relaxed);
+    stats.live_bytes = live_bytes_.load(std::memory_order_relaxed);
+    stats.peak_bytes = peak_bytes_.load(std::memory_order_relaxed);
+    stats.steady_allocs = steady_allocs_.load(std::memory_order_relaxed);
+
+    const struct mallinfo info = mallinfo();
+    stats.heap_arena = static_cast<uint32_t>(info.arena);
+    stats.heap_used = static_cast<uint32_t>(info.uordblks);
+    stats.heap_free = static_cast<uint32_t>(info.fordblks);
+    return stats;
+}
+
+void log_stats() {
+#if defined(CONFIG_OGXM_DEBUG)
+    const Stats stats = get_stats();
+    OGXM_LOG("Heap: new %u, delete %u, live %u, peak %u, after boot %u\n",
+        stats.allocs, stats.frees, stats.live_bytes, stats.peak_bytes, stats.steady_allocs);
+    OGXM_LOG("Heap: arena %u, used %u, free %u bytes\n", stats.heap_arena, stats.heap_used, stats.heap_free);
+#endif
+}
+
+} // namespace heap_audit
+
+void* operator new(size_t size) { return heap_audit::allocate(size, false); }
+void* operator new[](size_t size) { return heap_audit::allocate(size, false); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return heap_audit::allocate(size, true); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return heap_audit::allocate(size, true); }
+
+void operator delete(void* ptr) noexcept { heap_audit::release(ptr); }
+void operator delete[](void* ptr) noexcept { heap_audit::release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { heap_audit::release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { heap_audit::release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { heap_audit::release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { heap_audit::release(ptr); }
@@ -0,0 +1,45 @@
+#ifndef _OGXM_HEAP_AUDIT_H_
+#define _OGXM_HEAP_AUDIT_H_
+
+#include <cstdint>
+
+/*  Heap usage audit, counts every C++ allocation made through operator new/delete.
+
+    Everything is supposed to be allocated by the time the board's run loop starts, drivers
+    come from fixed pools and strings live on the stack. mark_steady_state() is called right
+    before that loop, any allocation after it is counted in steady_allocs and should stay 0
+    no matter how many times a controller is plugged in.
+
+    C allocations (tinyusb, btstack, newlib) don't go through operator new, they only show up
+    in the heap_* totals read from mallinfo. */
+
+namespace heap_audit {
+    struct Stats {
+        uint32_t allocs{0};         //operator new calls since boot
+        uint32_t frees{0};          //operator delete calls since boot
+        uint32_t live_bytes{0};     //Currently allocated through operator new
+        uint32_t peak_bytes{0};     //High water mark of live_bytes
+        uint32_t steady_allocs{0};  //operator new calls after mark_steady_state()
+        uint32_t heap_arena{0};     //Bytes the allocator has taken from the heap region
+        uint32_t heap_used{0};      //Of heap_arena, in use by C and C++ allocations
+        uint32_t heap_free{0};      //Of heap_arena, free but fragmented between used blocks
+    };
+
+#if defined(CONFIG_EN_HEAP_AUDIT)
+
+    //Core0, right before the board's main loop
+    void mark_steady_state();
+    Stats get_stats();
+    void log_stats();
+
+#else // CONFIG_EN_HEAP_AUDIT
+
+    inline void mark_steady_state() {}
+    inline Stats get_stats() { return Stats(); }
+    inline void log_stats() {}
+
+#endif // CONFIG_EN_HEAP_AUDIT
+
+} // namespace heap_audit
+
+#endif // _OGXM_HEAP_AUDIT_H_
@@ -0,0 +1,252 @@
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+#include <hardware/structs/systick.h>
+
+#if defined(CONFIG_EN_I2C_SLAVE_DMA)
+#include <hardware/dma.h>
+#else
+#include <pico/i2c_slave.h>
+#endif
+
+#include "Board/ogxm_log.h"
+#include "Board/i2c_packet_slave.h"
+
+namespace i2c_packet_slave {
+
+static i2c_inst_t* i2c_{nullptr};
+static PacketCallback on_packet_{nullptr};
+
+static uint8_t rx_buffers_[2][RX_SIZE_MAX];
+static uint8_t rx_index_{0};
+static uint8_t tx_buffer_[TX_SIZE_MAX];
+static size_t tx_len_{0};
+
+//Written from the interrupt, read by log_stats on core0, a torn read only skews one log line
+static volatile uint32_t irqs_{0};
+static volatile uint32_t packets_{0};
+static volatile uint32_t isr_cycles_max_{0};
+
+static inline uint32_t isr_begin()
+{
+    return systick_hw->cvr;
+}
+
+//SysTick counts down
+static inline void isr_end(uint32_t started, bool packet)
+{
+    const uint32_t cycles = (started - systick_hw->cvr) & M0PLUS_SYST_CVR_BITS;
+    irqs_ = irqs_ + 1;
+    packets_ = packets_ + (packet ? 1 : 0);
+    if (cycles > isr_cycles_max_)
+    {
+        isr_cycles_max_ = cycles;
+    }
+}
+
+//A response longer than the TX FIFO would need the handler to wait on the bus
+static inline void stage_response(const uint8_t* rx, size_t rx_len)
+{
+    uint8_t tx[TX_SIZE_MAX];
+    const size_t tx_len = on_packet_(rx, rx_len, tx);
+    if (tx_len > 0 && tx_len <= TX_SIZE_MAX)
+    {
+        for (size_t i = 0; i < tx_len; ++i)
+        {
+            tx_buffer_[i] = tx[i];
+        }
+        tx_len_ = tx_len;
+    }
+}
+
+#if defined(CONFIG_EN_I2C_SLAVE_DMA)
+
+static int rx_chan_{-1};
+static dma_channel_config rx_config_;
+
+static inline void arm_rx()
+{
+    dma_channel_configure(rx_chan_, &rx_config_, rx_buffers_[rx_index_],
+                          &i2c_get_hw(i2c_)->data_cmd, RX_SIZE_MAX, true);
+}
+
+//Whatever the master wrote since the last packet, false if nothing
+static bool finish_rx()
+{
+    i2c_hw_t* hw = i2c_get_hw(i2c_);
+
+    //The master is done writing, DMA may still be a byte behind the FIFO
+    while (hw->rxflr && dma_channel_is_busy(rx_chan_))
+    {
+        tight_loop_contents();
+    }
+    const size_t rx_len = RX_SIZE_MAX - dma_channel_hw_addr(rx_chan_)->transfer_count;
+    if (rx_len == 0)
+    {
+        return false;
+    }
+
+    dma_channel_abort(rx_chan_);
+    //Past RX_SIZE_MAX, dropped
+    while (hw->rxflr)
+    {
+        (void)hw->data_cmd;
+    }
+
+    const uint8_t* rx = rx_buffers_[rx_index_];
+    rx_index_ ^= 1;
+    arm_rx();
+
+    stage_response(rx, rx_len);
+    return true;
+}
+
+static void irq_handler()
+{
+    const uint32_t started = isr_begin();
+    i2c_hw_t* hw = i2c_get_hw(i2c_);
+    const uint32_t status = hw->intr_stat;
+    bool packet = false;
+
+    if (status & I2C_IC_INTR_STAT_R_TX_ABRT_BITS)
+    {
+        (void)hw->clr_tx_abrt;
+    }
+    //Read after a restart, the write before it is the packet being answered
+    if (status & I2C_IC_INTR_STAT_R_RD_REQ_BITS)
+    {
+        packet = finish_rx();
+        for (size_t i = 0; i < tx_len_; ++i)
+        {
+            hw->data_cmd = tx_buffer_[i];
+        }
+        (void)hw->clr_rd_req;
+    }
+    if (status & I2C_IC_INTR_STAT_R_STOP_DET_BITS)
+    {
+        (void)hw->clr_stop_det;
+        packet = finish_rx() || packet;
+    }
+
+    isr_end(started, packet);
+}
+
+static void init_rx(uint8_t address)
+{
+    i2c_set_slave_mode(i2c_, true, address);
+
+    i2c_hw_t* hw = i2c_get_hw(i2c_);
+    //Stop interrupts for this slave's transactions only, the bus is shared
+    hw->enable = 0;
+    hw_set_bits(&hw->con, I2C_IC_CON_STOP_DET_IFADDRESSED_BITS);
+    hw->enable = 1;
+
+    hw->dma_rdlr = 0;
+    hw->dma_cr = I2C_IC_DMA_CR_RDMAE_BITS;
+
+    rx_chan_ = dma_claim_unused_channel(true);
+    rx_config_ = dma_channel_get_default_config(rx_chan_);
+    channel_config_set_transfer_data_size(&rx_config_, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_config_, false);
+    channel_config_set_write_increment(&rx_config_, true);
+    channel_config_set_dreq(&rx_config_, i2c_get_dreq(i2c_, false));
+    arm_rx();
+
+    hw->intr_mask = I2C_IC_INTR_MASK_M_RD_REQ_BITS | I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    const uint irq_num = I2C0_IRQ + i2c_hw_index(i2c_);
+    irq_set_exclusive_handler(irq_num, irq_handler);
+    irq_set_enabled(irq_num, true);
+}
+
+#else // CONFIG_EN_I2C_SLAVE_DMA
+
+static size_t rx_len_{0};
+
+static void byte_handler(i2c_inst_t* i2c, i2c_slave_event_t event)
+{
+    const uint32_t started = isr_begin();
+    bool packet = false;
+
+    switch (event)
+    {
+        case I2C_SLAVE_RECEIVE:
+            if (rx_len_ < RX_SIZE_MAX)
+            {
+                rx_buffers_[rx_index_][rx_len_++] = i2c_read_byte_raw(i2c);
+            }
+            else
+            {
+                (void)i2c_read_byte_raw(i2c);
+            }
+            break;
+
+        //Stop or restart
+        case I2C_SLAVE_FINISH:
+            if (rx_len_ > 0)
+            {
+                stage_response(rx_buffers_[rx_index_], rx_len_);
+                rx_len_ = 0;
+                packet = true;
+            }
+            break;
+
+        case I2C_SLAVE_REQUEST:
+            i2c_write_raw_blocking(i2c, tx_buffer_, tx_len_);
+            break;
+
+        default:
+            break;
+    }
+
+    isr_end(started, packet);
+}
+
+static void init_rx(uint8_t address)
+{
+    i2c_slave_init(i2c_, address, &byte_handler);
+}
+
+#endif // CONFIG_EN_I2C_SLAVE_DMA
+
+void init(i2c_inst_t* i2c, uint8_t address, PacketCallback on_packet)
+{
+    i2c_ = i2c;
+    on_packet_ = on_packet;
+
+    //Core local, only for the handler time
+    if (!(systick_hw->csr & M0PLUS_SYST_CSR_ENABLE_BITS))
+    {
+        systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+        systick_hw->cvr = 0;
+        systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+    }
+
+    init_rx(address);
+}
+
+Stats take_stats()
+{
+    Stats stats;
+    stats.irqs = irqs_;
+    stats.packets = packets_;
+    stats.isr_cycles_max = isr_cycles_max_;
+    irqs_ = 0;
+    packets_ = 0;
+    isr_cycles_max_ = 0;
+    return stats;
+}
+
+void log_stats()
+{
+    const Stats stats = take_stats();
+    if (stats.packets == 0)
+    {
+        return;
+    }
+    OGXM_LOG("I2C slave: %u packets, %u.%02u interrupts per packet, longest handler %u cycles\n",
+             stats.packets, stats.irqs / stats.packets, ((stats.irqs % stats.packets) * 100) / stats.packets,
+             stats.isr_cycles_max);
+}
+
+} // namespace i2c_packet_slave
@@ -0,0 +1,44 @@
+#ifndef _OGXM_I2C_PACKET_SLAVE_H_
+#define _OGXM_I2C_PACKET_SLAVE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <hardware/i2c.h>
+
+/*  I2C slave that hands the board whole packets instead of single bytes.
+
+    With EN_I2C_SLAVE_DMA, RX DMA moves every byte the master writes out of the RX FIFO into one of
+    two buffers, so bytes cost no interrupts. The packet is finished on the STOP after the write, or
+    on the read request if the master reads back after a restart: DMA is re-armed on the other
+    buffer and on_packet is called with what was received. The response it writes is staged then,
+    the read request only copies it into the TX FIFO. Two interrupts per write and read back.
+
+    Without it pico_i2c_slave takes an interrupt per byte plus start, restart and stop, packets are
+    collected byte by byte and on_packet is called the same way.
+
+    Either way interrupts and the longest handler time are counted, so the two can be compared on
+    the same board. Call init on the core that should take the interrupt. */
+
+namespace i2c_packet_slave {
+    static constexpr size_t RX_SIZE_MAX = 32;
+    static constexpr size_t TX_SIZE_MAX = 16;   //TX FIFO depth, staged responses go out in one go
+
+    //Interrupt context. rx holds rx_len bytes written by the master, write the response for the
+    //next read to tx and return its length, 0 keeps the last response
+    using PacketCallback = size_t (*)(const uint8_t* rx, size_t rx_len, uint8_t* tx);
+
+    struct Stats {
+        uint32_t irqs{0};
+        uint32_t packets{0};
+        uint32_t isr_cycles_max{0};    //Processor clocks, 24 bit SysTick
+    };
+
+    void init(i2c_inst_t* i2c, uint8_t address, PacketCallback on_packet);
+
+    //Counts since the last call
+    Stats take_stats();
+    void log_stats();
+
+} // namespace i2c_packet_slave
+
+#endif // _OGXM_I2C_PACKET_SLAVE_H_
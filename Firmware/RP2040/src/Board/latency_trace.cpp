@@ -0,0 +1,219 @@
+#include <pico/stdlib.h>
+#include <hardware/timer.h>
+
+#include <atomic>
+#include <limits>
+
+#include "Board/Config.h"
+#include "Board/ogxm_log.h"
+#include "Board/latency_trace.h"
+#include "TaskQueue/TaskQueue.h"
+
+namespace latency_trace {
+
+//Log scale, 4 buckets per octave from 4us, everything past ~1s lands in the last one
+static constexpr uint32_t SUB_BUCKET_BITS = 2;
+static constexpr uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+static constexpr uint32_t MAX_OCTAVE = 19;
+static constexpr uint32_t NUM_BUCKETS = (MAX_OCTAVE - 1) * SUB_BUCKETS + SUB_BUCKETS;
+static constexpr uint8_t NUM_STAGES = static_cast<uint8_t>(Stage::COUNT);
+static constexpr uint32_t MAGIC = 0x4C545201; //"LTR" v1, bump if Trace changes
+
+struct Histogram {
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t buckets[NUM_BUCKETS];
+};
+
+struct Trace {
+    uint32_t magic;
+    uint8_t driver_type;
+    Histogram stages[NUM_STAGES];
+};
+
+//Survives the reset from board_api::reboot, so a session can be read back from WebApp mode
+static Trace __uninitialized_ram(live_);
+static Trace last_boot_;
+static bool last_boot_valid_{false};
+
+//Host stack side, one writer per gamepad so a report from one pad is never taken for another's
+static std::atomic<uint32_t> host_us_[MAX_GAMEPADS]{};
+
+//Device side, core0 loop and tud_task only
+static Stamp pending_;
+static uint32_t pending_read_us_{0};
+static uint32_t last_read_pad_in_us_{0};
+
+static inline uint32_t now_us() {
+    const uint32_t now = time_us_32();
+    return (now == 0) ? 1 : now;
+}
+
+static inline uint32_t bucket_idx(uint32_t value_us) {
+    if (value_us < SUB_BUCKETS) {
+        return value_us;
+    }
+    const uint32_t octave = 31 - static_cast<uint32_t>(__builtin_clz(value_us));
+    const uint32_t sub = (value_us >> (octave - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    const uint32_t idx = (octave - 1) * SUB_BUCKETS + sub;
+    return (idx < NUM_BUCKETS) ? idx : (NUM_BUCKETS - 1);
+}
+
+static inline uint32_t bucket_mid(uint32_t idx) {
+    if (idx < SUB_BUCKETS) {
+        return idx;
+    }
+    const uint32_t octave = idx / SUB_BUCKETS + 1;
+    const uint32_t width = 1u << (octave - SUB_BUCKET_BITS);
+    return ((SUB_BUCKETS + (idx % SUB_BUCKETS)) * width) + (width / 2);
+}
+
+static inline uint16_t saturate(uint32_t value_us) {
+    return static_cast<uint16_t>((value_us > 0xFFFF) ? 0xFFFF : value_us);
+}
+
+static void record(Stage stage, uint32_t elapsed_us) {
+    Histogram& hist = live_.stages[static_cast<uint8_t>(stage)];
+    hist.buckets[bucket_idx(elapsed_us)]++;
+    hist.min_us = (elapsed_us < hist.min_us) ? elapsed_us : hist.min_us;
+    hist.max_us = (elapsed_us > hist.max_us) ? elapsed_us : hist.max_us;
+    hist.count++;
+}
+
+static uint32_t percentile(const Histogram& hist, uint32_t pct) {
+    const uint32_t target = static_cast<uint32_t>((static_cast<uint64_t>(hist.count) * pct + 99) / 100);
+    uint32_t seen = 0;
+
+    for (uint32_t i = 0; i < NUM_BUCKETS; ++i) {
+        seen += hist.buckets[i];
+        if (seen >= target) {
+            const uint32_t mid = bucket_mid(i);
+            if (mid < hist.min_us) {
+                return hist.min_us;
+            }
+            return (mid > hist.max_us) ? hist.max_us : mid;
+        }
+    }
+    return hist.max_us;
+}
+
+static Summary summarize(const Histogram& hist) {
+    Summary summary;
+    if (hist.count == 0) {
+        return summary;
+    }
+    summary.count = hist.count;
+    summary.min_us = saturate(hist.min_us);
+    summary.p50_us = saturate(percentile(hist, 50));
+    summary.p99_us = saturate(percentile(hist, 99));
+    summary.max_us = saturate(hist.max_us);
+    return summary;
+}
+
+void reset() {
+    for (auto& hist : live_.stages) {
+        hist.count = 0;
+        hist.min_us = std::numeric_limits<uint32_t>::max();
+        hist.max_us = 0;
+        for (auto& bucket : hist.buckets) {
+            bucket = 0;
+        }
+    }
+    pending_ = Stamp();
+    pending_read_us_ = 0;
+}
+
+void init(uint8_t driver_type) {
+    if (live_.magic == MAGIC) {
+        last_boot_ = live_;
+        last_boot_valid_ = (last_boot_.stages[static_cast<uint8_t>(Stage::TOTAL)].count > 0);
+    }
+
+    reset();
+    live_.driver_type = driver_type;
+    live_.magic = MAGIC;
+
+#if defined(CONFIG_OGXM_DEBUG)
+    TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), LATENCY_TRACE_LOG_MS, true,
+    [] {
+        log_summaries();
+    });
+#endif
+}
+
+void host_report(uint8_t idx) {
+    if (idx < MAX_GAMEPADS) {
+        host_us_[idx].store(now_us(), std::memory_order_relaxed);
+    }
+}
+
+Stamp pad_in_stamp(uint8_t idx) {
+    Stamp stamp;
+    stamp.pad_in_us = now_us();
+    stamp.host_us = (idx < MAX_GAMEPADS) ? host_us_[idx].exchange(0, std::memory_order_relaxed) : 0;
+
+    if (stamp.host_us != 0) {
+        record(Stage::HOST_TO_PAD_IN, stamp.pad_in_us - stamp.host_us);
+    }
+    return stamp;
+}
+
+void device_read(uint8_t idx, const Stamp& stamp) {
+    //Drivers that poll get_pad_in every pass read the same report more than once
+    if (idx != 0 || stamp.pad_in_us == 0 || stamp.pad_in_us == last_read_pad_in_us_) {
+        return;
+    }
+    last_read_pad_in_us_ = stamp.pad_in_us;
+    pending_read_us_ = now_us();
+    pending_ = stamp;
+
+    record(Stage::PAD_IN_TO_DEVICE, pending_read_us_ - stamp.pad_in_us);
+}
+
+//A read that didn't change the output report is never sent, its stamp is replaced by the next read
+void report_sent() {
+    if (pending_read_us_ == 0) {
+        return;
+    }
+    const uint32_t now = now_us();
+    const uint32_t start_us = (pending_.host_us != 0) ? pending_.host_us : pending_.pad_in_us;
+
+    record(Stage::DEVICE_TO_USB, now - pending_read_us_);
+    record(Stage::TOTAL, now - start_us);
+
+    pending_read_us_ = 0;
+}
+
+bool get_summaries(Set set, Summary (&summaries)[NUM_STAGES], uint8_t& driver_type) {
+    if (set == Set::LAST_BOOT && !last_boot_valid_) {
+        return false;
+    }
+
+    const Trace& trace = (set == Set::LAST_BOOT) ? last_boot_ : live_;
+    driver_type = trace.driver_type;
+
+    for (uint8_t i = 0; i < NUM_STAGES; ++i) {
+        summaries[i] = summarize(trace.stages[i]);
+    }
+    return true;
+}
+
+void log_summaries() {
+#if defined(CONFIG_OGXM_DEBUG)
+    static constexpr const char* STAGE_NAMES[NUM_STAGES] = {
+        "host->pad_in", "pad_in->device", "device->usb", "total"
+    };
+
+    Summary summaries[NUM_STAGES];
+    uint8_t driver_type = 0;
+    get_summaries(Set::CURRENT, summaries, driver_type);
+
+    for (uint8_t i = 0; i < NUM_STAGES; ++i) {
+        OGXM_LOG("Latency %s: n %u, min %u, p50 %u, p99 %u, max %u us\n", STAGE_NAMES[i],
+            summaries[i].count, summaries[i].min_us, summaries[i].p50_us, summaries[i].p99_us, summaries[i].max_us);
+    }
+#endif
+}
+
+} // namespace latency_trace
@@ -0,0 +1,82 @@
+#ifndef _OGXM_LATENCY_TRACE_H_
+#define _OGXM_LATENCY_TRACE_H_
+
+#include <cstdint>
+
+/*  Per stage input latency, host report in to device report out.
+
+    Stamps ride along with each PadIn through the Gamepad latch so every stage is measured on the
+    report that actually crossed it. Only gamepad 0 is traced on the device side. Histograms are kept
+    in RAM that isn't cleared on reboot, so the numbers from a session survive switching to WebApp
+    mode to read them.
+
+    Boards without a USB host (I2C, Bluetooth) have no host stamp, HOST_TO_PAD_IN stays empty
+    and TOTAL starts at set_pad_in. */
+
+namespace latency_trace {
+    enum class Stage : uint8_t {
+        HOST_TO_PAD_IN = 0, //tuh report callback -> Gamepad::set_pad_in
+        PAD_IN_TO_DEVICE,   //Gamepad::set_pad_in -> get_pad_in in DeviceDriver::process
+        DEVICE_TO_USB,      //get_pad_in -> IN transfer completion
+        TOTAL,              //tuh report callback -> IN transfer completion
+        COUNT
+    };
+
+    enum class Set : uint8_t {
+        CURRENT = 0,
+        LAST_BOOT
+    };
+
+    //Carried through the Gamepad latch with each PadIn, 0 is no stamp
+    struct Stamp {
+        uint32_t host_us{0};
+        uint32_t pad_in_us{0};
+    };
+
+    #pragma pack(push, 1)
+    //Microseconds, saturated at 65535. Percentiles are bucket midpoints, within ~12%
+    struct Summary {
+        uint32_t count{0};
+        uint16_t min_us{0};
+        uint16_t p50_us{0};
+        uint16_t p99_us{0};
+        uint16_t max_us{0};
+    };
+    static_assert(sizeof(Summary) == 12, "latency_trace::Summary size mismatch");
+    #pragma pack(pop)
+
+#if defined(CONFIG_EN_LATENCY_TRACE)
+
+    //Call once on core0 before the device stack starts, driver_type tags this boot's histograms
+    void init(uint8_t driver_type);
+    void reset();
+
+    //Host stack only, right before the report is handed to the host driver of gamepad idx
+    void host_report(uint8_t idx);
+    //Called by Gamepad::set_pad_in, picks up the host stamp of the same gamepad idx
+    Stamp pad_in_stamp(uint8_t idx);
+    //Device driver read of gamepad idx, only idx 0 is traced
+    void device_read(uint8_t idx, const Stamp& stamp);
+    //IN endpoint transfer completed
+    void report_sent();
+
+    //False if the set is empty or not available
+    bool get_summaries(Set set, Summary (&summaries)[static_cast<uint8_t>(Stage::COUNT)], uint8_t& driver_type);
+    void log_summaries();
+
+#else // CONFIG_EN_LATENCY_TRACE
+
+    inline void init(uint8_t) {}
+    inline void reset() {}
+    inline void host_report(uint8_t) {}
+    inline Stamp pad_in_stamp(uint8_t) { return Stamp(); }
+    inline void device_read(uint8_t, const Stamp&) {}
+    inline void report_sent() {}
+    inline bool get_summaries(Set, Summary (&)[static_cast<uint8_t>(Stage::COUNT)], uint8_t&) { return false; }
+    inline void log_summaries() {}
+
+#endif // CONFIG_EN_LATENCY_TRACE
+
+} // namespace latency_trace
+
+#endif // _OGXM_LATENCY_TRACE_H_
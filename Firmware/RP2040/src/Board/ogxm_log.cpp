@@ -39,22 +39,24 @@ void init() {
     gpio_set_function(PICO_DEFAULT_UART_RX_PIN, GPIO_FUNC_UART);
 }
 
-void log(const std::string& message) {
-    static mutex_t log_mutex;
+static mutex_t log_mutex;
 
+//Prefix and message straight to the UART, nothing is built on the heap
+static void write(const char* message) {
     if (!mutex_is_initialized(&log_mutex)) {
         mutex_init(&log_mutex);
     }
 
     mutex_enter_blocking(&log_mutex);
-
-    std::string formatted_msg = "OGXM: " + message;
-
-    uart_puts(DEBUG_UART_PORT, formatted_msg.c_str());
-
+    uart_puts(DEBUG_UART_PORT, "OGXM: ");
+    uart_puts(DEBUG_UART_PORT, message);
     mutex_exit(&log_mutex);
 }
 
+void log(const std::string& message) {
+    write(message.c_str());
+}
+
 void log(const char* fmt, ...) {
     va_list args;
     va_start(args, fmt);
@@ -62,26 +64,25 @@ void log(const char* fmt, ...) {
     char buffer[256];
     vsnprintf(buffer, sizeof(buffer), fmt, args);
 
-    std::string formatted_msg = std::string(buffer);
-
-    log(formatted_msg);
-
     va_end(args);
+
+    write(buffer);
 }
 
 void log_hex(const uint8_t* data, size_t size) {
-    std::ostringstream hex_stream;
-    hex_stream << std::hex << std::setfill('0');
-    int count = 0;
-    for (uint16_t i = 0; i < size; ++i) {
-        hex_stream << std::setw(2) << static_cast<int>(data[i]) << " ";
-        if (++count == 16) {
-            hex_stream << "\n";
-            count = 0;
+    //16 bytes a line, "xx " each
+    char line[16 * 3 + 2];
+    size_t pos = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        pos += snprintf(line + pos, sizeof(line) - pos, "%02x ", data[i]);
+        if ((i % 16) == 15 || i == size - 1) {
+            line[pos++] = '\n';
+            line[pos] = '\0';
+            write(line);
+            pos = 0;
         }
     }
-    hex_stream << "\n";
-    log(hex_stream.str());
 }
 
 } // namespace ogxm_log
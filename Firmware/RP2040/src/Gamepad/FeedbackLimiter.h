@@ -0,0 +1,80 @@
+#ifndef _FEEDBACK_LIMITER_H_
+#define _FEEDBACK_LIMITER_H_
+
+#include <cstdint>
+
+/*  Decides when the host side sends a gamepad's pad out (rumble) to one controller.
+
+    A console write (Gamepad::pad_out_event moved) is due as soon as the last send is
+    MIN_INTERVAL_US old, writes landing in between are coalesced since the driver reads the
+    latest value when it sends. Anything else pending (a host driver zeroing short rumble
+    through Gamepad::decay_pad_out, or a keep alive) is due REFRESH_US after the last send.
+
+    A failed send (busy endpoint) is retried once per USB frame rather than on every pass,
+    what's pending then goes out in the frame after the endpoint frees up.
+    One instance per controller, not thread safe. */
+
+template <uint32_t MIN_INTERVAL_US, uint32_t REFRESH_US>
+class FeedbackLimiter
+{
+public:
+    static_assert(MIN_INTERVAL_US <= REFRESH_US, "FeedbackLimiter: refresh can't be faster than the minimum interval");
+
+    enum class Due : uint8_t { NONE, EVENT, REFRESH };
+
+    static constexpr uint32_t RETRY_US = 1000;
+
+    inline Due due(uint32_t event, bool pending, uint64_t now_us) const
+    {
+        //Whatever failed was already past the min interval, only the retry rate applies
+        if (retry_)
+        {
+            const bool retry = (now_us - failed_us_) >= RETRY_US;
+            return !retry ? Due::NONE : ((event != event_) ? Due::EVENT : Due::REFRESH);
+        }
+        const uint64_t elapsed = armed_ ? (now_us - sent_us_) : UINT64_MAX;
+        if (event != event_)
+        {
+            return (elapsed >= MIN_INTERVAL_US) ? Due::EVENT : Due::NONE;
+        }
+        if (pending)
+        {
+            return (elapsed >= REFRESH_US) ? Due::REFRESH : Due::NONE;
+        }
+        return Due::NONE;
+    }
+
+    //event is what was read before the send, a write landing during it stays due
+    inline void sent(uint32_t event, uint64_t now_us)
+    {
+        event_ = event;
+        sent_us_ = now_us;
+        armed_ = true;
+        retry_ = false;
+    }
+
+    //The driver read (and cleared) new_pad_out before failing, remember it was pending.
+    //Retry timing only, the min interval still counts from the last send that went out
+    inline void failed(uint64_t now_us)
+    {
+        failed_us_ = now_us;
+        retry_ = true;
+    }
+
+    //New controller, the next due() sends whatever is pending straight away
+    inline void reset(uint32_t event)
+    {
+        event_ = event;
+        armed_ = false;
+        retry_ = false;
+    }
+
+private:
+    uint64_t sent_us_{0};
+    uint64_t failed_us_{0};
+    uint32_t event_{0};
+    bool armed_{false};
+    bool retry_{false};
+};
+
+#endif // _FEEDBACK_LIMITER_H_
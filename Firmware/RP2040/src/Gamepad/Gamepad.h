@@ -7,16 +7,23 @@
 #include <cstring>
 #include <array>
 #include <cmath>
-#include <pico/mutex.h>
+#include <hardware/sync.h>
+#include <hardware/timer.h>
 
 #include "libfixmath/fix16.hpp"
 
 #include "Gamepad/Range.h"
 #include "Gamepad/fix16ext.h"
+#include "Gamepad/StickLUT.h"
+#include "Gamepad/SnapshotLatch.h"
+#include "Gamepad/MappingPlan.h"
+#include "Gamepad/OutputCurve.h"
+#include "Gamepad/TurboEngine.h"
 #include "UserSettings/UserProfile.h"
 #include "UserSettings/JoystickSettings.h"
 #include "UserSettings/TriggerSettings.h"
 #include "Board/ogxm_log.h"
+#include "Board/latency_trace.h"
 
 class Gamepad 
 {
@@ -57,30 +64,15 @@ public:
     static constexpr uint8_t ANALOG_OFF_LB    = 8;
     static constexpr uint8_t ANALOG_OFF_RB    = 9;
 
-    //Mappings used by host to set buttons
-
-    uint8_t MAP_DPAD_UP         = DPAD_UP        ;
-    uint8_t MAP_DPAD_DOWN       = DPAD_DOWN      ;
-    uint8_t MAP_DPAD_LEFT       = DPAD_LEFT      ;
-    uint8_t MAP_DPAD_RIGHT      = DPAD_RIGHT     ;
-    uint8_t MAP_DPAD_UP_LEFT    = DPAD_UP_LEFT   ;
-    uint8_t MAP_DPAD_UP_RIGHT   = DPAD_UP_RIGHT  ;
-    uint8_t MAP_DPAD_DOWN_LEFT  = DPAD_DOWN_LEFT ;
-    uint8_t MAP_DPAD_DOWN_RIGHT = DPAD_DOWN_RIGHT;
-    uint8_t MAP_DPAD_NONE       = DPAD_NONE      ;
-
-    uint16_t MAP_BUTTON_A     = BUTTON_A    ;
-    uint16_t MAP_BUTTON_B     = BUTTON_B    ;
-    uint16_t MAP_BUTTON_X     = BUTTON_X    ;
-    uint16_t MAP_BUTTON_Y     = BUTTON_Y    ;
-    uint16_t MAP_BUTTON_L3    = BUTTON_L3   ;
-    uint16_t MAP_BUTTON_R3    = BUTTON_R3   ;
-    uint16_t MAP_BUTTON_BACK  = BUTTON_BACK ;
-    uint16_t MAP_BUTTON_START = BUTTON_START;
-    uint16_t MAP_BUTTON_LB    = BUTTON_LB   ;
-    uint16_t MAP_BUTTON_RB    = BUTTON_RB   ;
-    uint16_t MAP_BUTTON_SYS   = BUTTON_SYS  ;
-    uint16_t MAP_BUTTON_MISC  = BUTTON_MISC ;
+    static_assert(  DPAD_UP == MappingPlan::DPAD_UP && DPAD_DOWN == MappingPlan::DPAD_DOWN &&
+                    DPAD_LEFT == MappingPlan::DPAD_LEFT && DPAD_RIGHT == MappingPlan::DPAD_RIGHT,
+                    "Gamepad: dpad bits out of step with MappingPlan");
+    static_assert(  BUTTON_A == 1 << 0 && BUTTON_B == 1 << 1 && BUTTON_X == 1 << 2 && BUTTON_Y == 1 << 3 &&
+                    BUTTON_L3 == 1 << 4 && BUTTON_R3 == 1 << 5 && BUTTON_BACK == 1 << 6 && BUTTON_START == 1 << 7 &&
+                    BUTTON_LB == 1 << 8 && BUTTON_RB == 1 << 9 && BUTTON_SYS == 1 << 10 && BUTTON_MISC == 1 << 11,
+                    "Gamepad: MappingPlan expects buttons in profile order");
+
+    //Analog button offsets used by host, buttons and dpad go through remap()
 
     uint8_t MAP_ANALOG_OFF_UP    = ANALOG_OFF_UP   ;
     uint8_t MAP_ANALOG_OFF_DOWN  = ANALOG_OFF_DOWN ;
@@ -129,9 +121,7 @@ public:
 
     Gamepad()
     {
-        mutex_init(&pad_in_mutex_);
-        mutex_init(&pad_out_mutex_);
-        mutex_init(&chatpad_in_mutex_);
+        pad_out_lock_ = spin_lock_instance(spin_lock_claim_unused(true));
         reset_pad_in();
         reset_pad_out();
         reset_chatpad_in();
@@ -146,44 +136,67 @@ public:
     //True if both host and device have enabled analog
     inline bool analog_enabled() const { return analog_enabled_.load(std::memory_order_relaxed); }
 
+    //USB poll interval the profile asks the device driver for, 0 for the driver's own
+    inline uint8_t poll_interval_ms() const { return profile_poll_interval_ms_; }
+
+    //Stick response the profile asks the device driver for, not enabled() for the driver's own
+    inline const OutputCurve& output_curve_l() const { return output_curve_l_; }
+    inline const OutputCurve& output_curve_r() const { return output_curve_r_; }
+
+    //Device mode's turbo default, kept across profile loads. Core0, set when a device driver starts
+    inline void set_mode_turbo(const TurboEngine::ModeDefault& mode_turbo)
+    {
+        mode_turbo_ = mode_turbo;
+        compile_turbo();
+    }
+
+    //Profile and mode turbo, device side only. Due when a held turbo button turns on or off
+    inline bool turbo_due(uint32_t now_us) const { return turbo_.due(now_us); }
+    inline void apply_turbo(PadIn& pad_in, uint32_t now_us) { pad_in.buttons = turbo_.apply(pad_in.buttons, now_us); }
+
+    //Canonical buttons and dpad (a host driver's SourceMap) to what the profile maps them to
+    inline void remap(const MappingPlan::Pad& pad, PadIn& pad_in) const
+    {
+        pad_in.buttons = mapping_plan_.buttons(pad.buttons);
+        pad_in.dpad = mapping_plan_.dpad(pad.dpad);
+    }
+
+    //Getters never block, safe from IRQs. Flags are cleared before the copy 
+    //so a write landing during it is picked up on the next call
+
     inline PadIn get_pad_in()
     {
-        mutex_enter_blocking(&pad_in_mutex_);
-        PadIn pad_in = pad_in_;
         new_pad_in_.store(false);
-        mutex_exit(&pad_in_mutex_);
+        return pad_in_.load().pad_in;
+    }
 
-        return pad_in;
+    //Same as get_pad_in, also returns the latency trace stamp of the report read
+    inline PadIn get_pad_in(latency_trace::Stamp& stamp)
+    {
+        new_pad_in_.store(false);
+        const TracedPadIn traced = pad_in_.load();
+        stamp = traced.stamp;
+        return traced.pad_in;
     }
 
     inline PadOut get_pad_out()
     {
-        mutex_enter_blocking(&pad_out_mutex_);
-        PadOut pad_out = pad_out_;
         new_pad_out_.store(false);
-        mutex_exit(&pad_out_mutex_);
-
-        return pad_out;
+        return pad_out_.load();
     }
 
     inline ChatpadIn get_chatpad_in()
     {
-        mutex_enter_blocking(&chatpad_in_mutex_);
-        ChatpadIn chatpad_in = chatpad_in_;
-        mutex_exit(&chatpad_in_mutex_);
-
-        return chatpad_in;
+        return chatpad_in_.load();
     }
 
     //Set
 
+    //Also clears analog when a live mode switch moves to a digital device
     void set_analog_device(bool value) 
     { 
         analog_device_.store(value); 
-        if (analog_host_.load() && analog_device_.load() && profile_analog_enabled_)
-        {
-            analog_enabled_.store(true);
-        }
+        analog_enabled_.store(analog_host_.load() && value && profile_analog_enabled_);
     }
 
     void set_analog_host(bool value) 
@@ -201,52 +214,68 @@ public:
         set_profile_settings(user_profile);
     }
 
-    inline void set_pad_in(PadIn pad_in)
+    //Pad in and chatpad have one writer per board (host driver, Bluepad32 or the I2C slave IRQ), 
+    //so those setters never wait
+
+    inline void set_pad_in(const PadIn& pad_in)
     {
-        mutex_enter_blocking(&pad_in_mutex_);
-        pad_in_ = pad_in;
-        new_pad_in_.store(true);
-        mutex_exit(&pad_in_mutex_);
+        store_pad_in(pad_in, latency_trace::pad_in_stamp(trace_idx_));
     }
 
+    //Index of this gamepad for latency tracing, set by whoever stamps its host reports
+    inline void set_trace_idx(uint8_t idx) { trace_idx_ = idx; }
+
+    //Pad out is written by device drivers on core0 and by some host drivers on core1,
+    //writers are serialized with a spin lock held only for the copy, readers don't take it.
+    //A write from the console bumps pad_out_event so the host side sends it on its next pass
     inline void set_pad_out(const PadOut& pad_out)
     {
-        mutex_enter_blocking(&pad_out_mutex_);
-        pad_out_ = pad_out;
-        new_pad_out_.store(true);
-        mutex_exit(&pad_out_mutex_);
+        store_pad_out(pad_out);
+        pad_out_event_.fetch_add(1, std::memory_order_release);
+    }
+
+    //For host drivers changing the value themselves (short rumble timing out), sets new_pad_out
+    //but isn't an event, so it goes out on the slower refresh instead of straight away
+    inline void decay_pad_out(const PadOut& pad_out)
+    {
+        store_pad_out(pad_out);
     }
 
     inline void set_chatpad_in(const ChatpadIn& chatpad_in)
     {
-        mutex_enter_blocking(&chatpad_in_mutex_);
-        chatpad_in_ = chatpad_in;
-        mutex_exit(&chatpad_in_mutex_);
+        chatpad_in_.store(chatpad_in);
     }
 
+    //Not a report, left out of latency tracing
     inline void reset_pad_in() 
 	{ 
-        mutex_enter_blocking(&pad_in_mutex_);
-        pad_in_ = PadIn();
-        mutex_exit(&pad_in_mutex_);
-        new_pad_in_.store(true);
+        store_pad_in(PadIn(), latency_trace::Stamp());
     }
     
     inline void reset_pad_out()
     {
-        mutex_enter_blocking(&pad_out_mutex_);
-        pad_out_ = PadOut();
-        new_pad_out_.store(true);
-        mutex_exit(&pad_out_mutex_);
+        set_pad_out(PadOut());
     }
 
     inline void reset_chatpad_in()
     {
-        mutex_enter_blocking(&chatpad_in_mutex_);
-        chatpad_in_.fill(0);
-        mutex_exit(&chatpad_in_mutex_);
+        set_chatpad_in(ChatpadIn{0});
+    }
+
+    //Has the device driver build a report from the pad in as it is, a new driver after a mode switch
+    inline void refresh_pad_in()
+    {
+        new_pad_in_.store(true);
+        __sev();
     }
 
+    //Completed writes, for telling snapshots apart without comparing them
+    inline uint32_t pad_in_sequence() const { return pad_in_.sequence(); }
+    inline uint32_t pad_out_sequence() const { return pad_out_.sequence(); }
+
+    //Console writes to pad out, bumped after the value is stored
+    inline uint32_t pad_out_event() const { return pad_out_event_.load(std::memory_order_acquire); }
+
     template <uint8_t bits = 0, typename T>
     inline std::pair<int16_t, int16_t> scale_joystick_r(T x, T y, bool invert_y = false) const
     {
@@ -269,7 +298,7 @@ public:
         }
 
         return  joy_settings_r_en_ 
-                    ? apply_joystick_settings(joy_x, joy_y, joy_settings_r_, invert_y) 
+                    ? shape_joystick(joy_x, joy_y, joy_settings_r_, joy_lut_r_, invert_y) 
                     : std::make_pair(joy_x, invert_y ? Range::invert(joy_y) : joy_y);
     }
 
@@ -295,7 +324,7 @@ public:
         }
 
         return  joy_settings_l_en_ 
-                    ? apply_joystick_settings(joy_x, joy_y, joy_settings_l_, invert_y) 
+                    ? shape_joystick(joy_x, joy_y, joy_settings_l_, joy_lut_l_, invert_y) 
                     : std::make_pair(joy_x, invert_y ? Range::invert(joy_y) : joy_y);
     }
 
@@ -341,108 +370,20 @@ public:
                     : trigger_value;
     }
 
-private:    
-    mutex_t pad_in_mutex_;
-    mutex_t pad_out_mutex_;
-    mutex_t chatpad_in_mutex_;
-
-    PadOut pad_out_;
-    PadIn pad_in_;
-    ChatpadIn chatpad_in_{0};
-
-    std::atomic<bool> new_pad_in_{false};
-    std::atomic<bool> new_pad_out_{false};
-
-    std::atomic<bool> analog_enabled_{false};
-    std::atomic<bool> analog_host_{false};
-    std::atomic<bool> analog_device_{false};
-
-    bool profile_analog_enabled_{false};
+    inline const JoystickLUT& joystick_lut_l() const { return joy_lut_l_; }
+    inline const JoystickLUT& joystick_lut_r() const { return joy_lut_r_; }
 
-    JoystickSettings joy_settings_l_;
-    JoystickSettings joy_settings_r_;
-    TriggerSettings trig_settings_l_;
-    TriggerSettings trig_settings_r_;
-
-    bool joy_settings_l_en_{false};
-    bool joy_settings_r_en_{false};
-    bool trig_settings_l_en_{false};
-    bool trig_settings_r_en_{false};
-
-    void set_profile_settings(const UserProfile& profile)
+    //Profile values as the shaping functions expect them
+    static inline void load_joystick_settings(JoystickSettings& set, const JoystickSettingsRaw& raw)
     {
-        profile_analog_enabled_ = profile.analog_enabled ? true : false;
-        OGXM_LOG("profile_analog_enabled_: %d\n", profile_analog_enabled_);
-
-        if ((joy_settings_l_en_ = !joy_settings_l_.is_same(profile.joystick_settings_l)))
-        {
-            joy_settings_l_.set_from_raw(profile.joystick_settings_l);
-            //This needs to be addressed in the webapp, just multiply here for now
-            joy_settings_l_.axis_restrict *= static_cast<int16_t>(100);
-            joy_settings_l_.angle_restrict *= static_cast<int16_t>(100);
-            joy_settings_l_.anti_dz_angular *= static_cast<int16_t>(100);
-        }
-        if ((joy_settings_r_en_ = !joy_settings_r_.is_same(profile.joystick_settings_r)))
-        {
-            joy_settings_r_.set_from_raw(profile.joystick_settings_r);
-            //This needs to be addressed in the webapp, just multiply here for now
-            joy_settings_r_.axis_restrict *= static_cast<int16_t>(100);
-            joy_settings_r_.angle_restrict *= static_cast<int16_t>(100);
-            joy_settings_r_.anti_dz_angular *= static_cast<int16_t>(100);
-        }
-        if ((trig_settings_l_en_ = !trig_settings_l_.is_same(profile.trigger_settings_l)))
-        {
-            trig_settings_l_.set_from_raw(profile.trigger_settings_l);
-        }
-        if ((trig_settings_r_en_ = !trig_settings_r_.is_same(profile.trigger_settings_r)))
-        {
-            trig_settings_r_.set_from_raw(profile.trigger_settings_r);
-        }
-
-        OGXM_LOG("GamepadMapper: JoyL: %s, JoyR: %s, TrigL: %s, TrigR: %s\n",
-            joy_settings_l_en_ ? "Enabled" : "Disabled",
-            joy_settings_r_en_ ? "Enabled" : "Disabled",
-            trig_settings_l_en_ ? "Enabled" : "Disabled",
-            trig_settings_r_en_ ? "Enabled" : "Disabled");
-    }
-
-    void set_profile_mappings(const UserProfile& profile)
-    {
-        MAP_DPAD_UP         = profile.dpad_up;
-        MAP_DPAD_DOWN       = profile.dpad_down;
-        MAP_DPAD_LEFT       = profile.dpad_left;
-        MAP_DPAD_RIGHT      = profile.dpad_right;
-        MAP_DPAD_UP_LEFT    = profile.dpad_up | profile.dpad_left;
-        MAP_DPAD_UP_RIGHT   = profile.dpad_up | profile.dpad_right;
-        MAP_DPAD_DOWN_LEFT  = profile.dpad_down | profile.dpad_left;
-        MAP_DPAD_DOWN_RIGHT = profile.dpad_down | profile.dpad_right;
-        MAP_DPAD_NONE       = 0;
-
-        MAP_BUTTON_A     = profile.button_a;
-        MAP_BUTTON_B     = profile.button_b;
-        MAP_BUTTON_X     = profile.button_x;
-        MAP_BUTTON_Y     = profile.button_y;
-        MAP_BUTTON_L3    = profile.button_l3;
-        MAP_BUTTON_R3    = profile.button_r3;
-        MAP_BUTTON_BACK  = profile.button_back;
-        MAP_BUTTON_START = profile.button_start;
-        MAP_BUTTON_LB    = profile.button_lb;
-        MAP_BUTTON_RB    = profile.button_rb;
-        MAP_BUTTON_SYS   = profile.button_sys;
-        MAP_BUTTON_MISC  = profile.button_misc;
-
-        MAP_ANALOG_OFF_UP    = profile.analog_off_up;
-        MAP_ANALOG_OFF_DOWN  = profile.analog_off_down;
-        MAP_ANALOG_OFF_LEFT  = profile.analog_off_left;
-        MAP_ANALOG_OFF_RIGHT = profile.analog_off_right;
-        MAP_ANALOG_OFF_A     = profile.analog_off_a;
-        MAP_ANALOG_OFF_B     = profile.analog_off_b;
-        MAP_ANALOG_OFF_X     = profile.analog_off_x;
-        MAP_ANALOG_OFF_Y     = profile.analog_off_y;
-        MAP_ANALOG_OFF_LB    = profile.analog_off_lb;
-        MAP_ANALOG_OFF_RB    = profile.analog_off_rb;
+        set.set_from_raw(raw);
+        //This needs to be addressed in the webapp, just multiply here for now
+        set.axis_restrict *= static_cast<int16_t>(100);
+        set.angle_restrict *= static_cast<int16_t>(100);
+        set.anti_dz_angular *= static_cast<int16_t>(100);
     }
 
+    //Fix16 reference shaping, the stick tables are compiled from and verified against this
     static inline std::pair<int16_t, int16_t> apply_joystick_settings(
         int16_t gp_joy_x, 
         int16_t gp_joy_y, 
@@ -498,8 +439,8 @@ private:
 
         if (anti_r_scale > FIX_0 && anti_dz_c > FIX_0)
         {
-            Fix16 anti_ellip_scale = anti_ellip_scale / anti_dz_c;
-            Fix16 ellipse_angle = fix16::atan((FIX_1 / anti_ellip_scale) * fix16::tan(fix16::rad2deg(rAngle)));
+            Fix16 anti_ellip_scale = anti_r_scale / anti_dz_c;
+            Fix16 ellipse_angle = fix16::atan((FIX_1 / anti_ellip_scale) * fix16::tan(fix16::deg2rad(rAngle)));
             ellipse_angle = (ellipse_angle < FIX_0) ? FIX_ELLIPSE_DEF : ellipse_angle;
 
             Fix16 ellipse_x = fix16::cos(ellipse_angle);
@@ -602,7 +543,7 @@ private:
         return { static_cast<int16_t>(fix16_to_int(output_x)), static_cast<int16_t>(fix16_to_int(output_y)) };
     }
 
-    uint8_t apply_trigger_settings(uint8_t value, const TriggerSettings& set) const
+    static inline uint8_t apply_trigger_settings(uint8_t value, const TriggerSettings& set)
     {
         Fix16 abs_value = fix16::abs(Fix16(static_cast<int16_t>(value)) / static_cast<int16_t>(Range::MAX<uint8_t>));
 
@@ -635,6 +576,198 @@ private:
         value_out *= set.dz_outer;
         return static_cast<uint8_t>(fix16_to_int(value_out * static_cast<int16_t>(Range::MAX<uint8_t>)));
     }
+
+private:    
+    struct TracedPadIn
+    {
+        PadIn pad_in;
+        latency_trace::Stamp stamp;
+    };
+
+    spin_lock_t* pad_out_lock_{nullptr};
+
+    SnapshotLatch<PadOut> pad_out_;
+    SnapshotLatch<TracedPadIn> pad_in_;
+    SnapshotLatch<ChatpadIn> chatpad_in_;
+
+    std::atomic<bool> new_pad_in_{false};
+    std::atomic<bool> new_pad_out_{false};
+    std::atomic<uint32_t> pad_out_event_{0};
+
+    std::atomic<bool> analog_enabled_{false};
+    std::atomic<bool> analog_host_{false};
+    std::atomic<bool> analog_device_{false};
+
+    bool profile_analog_enabled_{false};
+    uint8_t profile_poll_interval_ms_{0};
+    uint8_t trace_idx_{0};
+
+    MappingPlan mapping_plan_;
+
+    JoystickSettings joy_settings_l_;
+    JoystickSettings joy_settings_r_;
+    TriggerSettings trig_settings_l_;
+    TriggerSettings trig_settings_r_;
+
+    bool joy_settings_l_en_{false};
+    bool joy_settings_r_en_{false};
+    bool trig_settings_l_en_{false};
+    bool trig_settings_r_en_{false};
+
+    JoystickLUT joy_lut_l_;
+    JoystickLUT joy_lut_r_;
+
+    OutputCurve output_curve_l_;
+    OutputCurve output_curve_r_;
+
+    TurboEngine turbo_;
+    TurboEngine::ModeDefault mode_turbo_;
+    uint8_t profile_turbo_[sizeof(UserProfile::turbo)]{};
+
+    inline void store_pad_out(const PadOut& pad_out)
+    {
+        uint32_t irq_state = spin_lock_blocking(pad_out_lock_);
+        pad_out_.store(pad_out);
+        new_pad_out_.store(true);
+        spin_unlock(pad_out_lock_, irq_state);
+    }
+
+    inline void store_pad_in(const PadIn& pad_in, const latency_trace::Stamp& stamp)
+    {
+        pad_in_.store({ pad_in, stamp });
+        new_pad_in_.store(true);
+        //Wake the device loop if it's waiting in board_api::wait_for_work
+        __sev();
+    }
+
+    void set_profile_settings(const UserProfile& profile)
+    {
+        profile_analog_enabled_ = profile.analog_enabled ? true : false;
+        OGXM_LOG("profile_analog_enabled_: %d\n", profile_analog_enabled_);
+
+        profile_poll_interval_ms_ = profile.poll_interval_ms;
+
+        output_curve_l_.compile(profile.output_curve_l);
+        output_curve_r_.compile(profile.output_curve_r);
+
+        std::memcpy(profile_turbo_, profile.turbo, sizeof(profile_turbo_));
+        compile_turbo();
+
+        joy_lut_l_.reset();
+        if ((joy_settings_l_en_ = !joy_settings_l_.is_same(profile.joystick_settings_l)))
+        {
+            load_joystick_settings(joy_settings_l_, profile.joystick_settings_l);
+            compile_joystick_lut(joy_lut_l_, joy_settings_l_);
+        }
+        joy_lut_r_.reset();
+        if ((joy_settings_r_en_ = !joy_settings_r_.is_same(profile.joystick_settings_r)))
+        {
+            load_joystick_settings(joy_settings_r_, profile.joystick_settings_r);
+            //Inverts are applied before the lookup, a right stick shaped like the left shares its table
+            if (joy_settings_l_en_ && same_shaping(profile.joystick_settings_l, profile.joystick_settings_r))
+            {
+                joy_lut_r_ = joy_lut_l_;
+            }
+            else
+            {
+                compile_joystick_lut(joy_lut_r_, joy_settings_r_);
+            }
+        }
+        if ((trig_settings_l_en_ = !trig_settings_l_.is_same(profile.trigger_settings_l)))
+        {
+            trig_settings_l_.set_from_raw(profile.trigger_settings_l);
+        }
+        if ((trig_settings_r_en_ = !trig_settings_r_.is_same(profile.trigger_settings_r)))
+        {
+            trig_settings_r_.set_from_raw(profile.trigger_settings_r);
+        }
+
+        OGXM_LOG("GamepadMapper: JoyL: %s, JoyR: %s, TrigL: %s, TrigR: %s\n",
+            joy_settings_l_en_ ? "Enabled" : "Disabled",
+            joy_settings_r_en_ ? "Enabled" : "Disabled",
+            trig_settings_l_en_ ? "Enabled" : "Disabled",
+            trig_settings_r_en_ ? "Enabled" : "Disabled");
+
+        if (joy_lut_l_.compiled() || joy_lut_r_.compiled())
+        {
+            OGXM_LOG("GamepadMapper: Stick LUT grid %d, %d bytes, JoyL: %d/%d fallback cells (%d unchecked) max err %d in %u us, JoyR: %d/%d fallback cells (%d unchecked) max err %d in %u us\n",
+                static_cast<int>(JoystickLUT::GRID), static_cast<int>(JoystickLUT::SIZE_BYTES),
+                joy_lut_l_.stats().fallback_cells, joy_lut_l_.stats().total_cells, joy_lut_l_.stats().unchecked_cells,
+                joy_lut_l_.stats().max_error, joy_lut_l_.stats().compile_us,
+                joy_lut_r_.stats().fallback_cells, joy_lut_r_.stats().total_cells, joy_lut_r_.stats().unchecked_cells,
+                joy_lut_r_.stats().max_error, joy_lut_r_.stats().compile_us);
+        }
+    }
+
+    //A profile turbo on the mode default's trigger replaces it
+    void compile_turbo()
+    {
+        turbo_.compile(profile_turbo_);
+        if (mode_turbo_.trigger && !turbo_.has_trigger(mode_turbo_.trigger))
+        {
+            turbo_.add(mode_turbo_.trigger, mode_turbo_.output, mode_turbo_.rate_hz, mode_turbo_.on_16ths);
+        }
+    }
+
+    static void compile_joystick_lut(JoystickLUT& lut, const JoystickSettings& set)
+    {
+        //Tabled on |x|, |y|, inverts are applied before the lookup
+        JoystickSettings table_set = set;
+        table_set.invert_x = false;
+        table_set.invert_y = false;
+
+        lut.compile([&table_set](int16_t x, int16_t y) 
+        { 
+            return apply_joystick_settings(x, y, table_set, false); 
+        }, StickLUTConfig::MAX_ERROR, [] { return time_us_32(); }, StickLUTConfig::COMPILE_BUDGET_US);
+    }
+
+    static bool same_shaping(JoystickSettingsRaw a, JoystickSettingsRaw b)
+    {
+        a.invert_x = b.invert_x = false;
+        a.invert_y = b.invert_y = false;
+        return std::memcmp(&a, &b, sizeof(JoystickSettingsRaw)) == 0;
+    }
+
+    static inline std::pair<int16_t, int16_t> shape_joystick(
+        int16_t gp_joy_x, 
+        int16_t gp_joy_y, 
+        const JoystickSettings& set, 
+        const JoystickLUT& lut, 
+        bool invert_y)
+    {
+        if (lut.compiled())
+        {
+            int16_t out_x, out_y;
+            if (lut.lookup( set.invert_x ? Range::invert(gp_joy_x) : gp_joy_x, 
+                            (set.invert_y ^ invert_y) ? Range::invert(gp_joy_y) : gp_joy_y, 
+                            out_x, out_y))
+            {
+                return { out_x, out_y };
+            }
+        }
+        return apply_joystick_settings(gp_joy_x, gp_joy_y, set, invert_y);
+    }
+
+    void set_profile_mappings(const UserProfile& profile)
+    {
+        mapping_plan_.compile(
+            {   profile.button_a, profile.button_b, profile.button_x, profile.button_y,
+                profile.button_l3, profile.button_r3, profile.button_back, profile.button_start,
+                profile.button_lb, profile.button_rb, profile.button_sys, profile.button_misc },
+            {   profile.dpad_up, profile.dpad_down, profile.dpad_left, profile.dpad_right });
+
+        MAP_ANALOG_OFF_UP    = profile.analog_off_up;
+        MAP_ANALOG_OFF_DOWN  = profile.analog_off_down;
+        MAP_ANALOG_OFF_LEFT  = profile.analog_off_left;
+        MAP_ANALOG_OFF_RIGHT = profile.analog_off_right;
+        MAP_ANALOG_OFF_A     = profile.analog_off_a;
+        MAP_ANALOG_OFF_B     = profile.analog_off_b;
+        MAP_ANALOG_OFF_X     = profile.analog_off_x;
+        MAP_ANALOG_OFF_Y     = profile.analog_off_y;
+        MAP_ANALOG_OFF_LB    = profile.analog_off_lb;
+        MAP_ANALOG_OFF_RB    = profile.analog_off_rb;
+    }
 };
 
 #endif // _GAMEPAD_H_
\ No newline at end of file
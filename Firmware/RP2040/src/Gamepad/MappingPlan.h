@@ -0,0 +1,414 @@
+#ifndef _MAPPING_PLAN_H_
+#define _MAPPING_PLAN_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <type_traits>
+
+/*  Button and dpad translation as table lookups instead of if-chains.
+
+    SourceMap:   a host report's button bytes to canonical Gamepad::BUTTON_* / DPAD_* bits.
+    MappingPlan: canonical bits to the ones the profile remaps them to, compiled in
+                 Gamepad::set_profile_mappings.
+    DeviceMap:   canonical bits to a device report's button bytes.
+    KeyMap:      chatpad key codes to a device report's button bytes.
+
+    SourceMap, DeviceMap and KeyMap are built with constexpr rule lists, the same (byte, mask,
+    button) triples the if-chains tested. Declare them static constexpr so they're flash tables and
+    a rule that doesn't fit fails the build. Every report nibble (or canonical nibble) indexes a 16
+    entry table, so a report is a handful of loads and ORs whatever its layout. Masks wider than a
+    byte are little endian from the byte given, like the uint16 button fields in the descriptors. */
+
+class MappingPlan
+{
+public:
+    static constexpr size_t NUM_BUTTONS = 12;
+    static constexpr size_t NUM_DPAD = 4;
+
+    //Canonical dpad bits, Gamepad::DPAD_* checks it matches
+    static constexpr uint8_t DPAD_UP    = 0x01;
+    static constexpr uint8_t DPAD_DOWN  = 0x02;
+    static constexpr uint8_t DPAD_LEFT  = 0x04;
+    static constexpr uint8_t DPAD_RIGHT = 0x08;
+
+    //Hat switch values in the order up, up right, right, down right, down, down left, left, up left.
+    //Where they sit in the report, so already masked, the way the descriptors define them
+    using Hat = std::array<uint32_t, 8>;
+
+    static constexpr std::array<uint8_t, 8> HAT_DPAD =
+    {
+        DPAD_UP, DPAD_UP | DPAD_RIGHT, DPAD_RIGHT, DPAD_DOWN | DPAD_RIGHT,
+        DPAD_DOWN, DPAD_DOWN | DPAD_LEFT, DPAD_LEFT, DPAD_UP | DPAD_LEFT
+    };
+
+    struct Pad
+    {
+        uint16_t buttons{0};
+        uint8_t dpad{0};
+    };
+
+    MappingPlan()
+    {
+        std::array<uint16_t, NUM_BUTTONS> buttons{};
+        std::array<uint8_t, NUM_DPAD> dpad{};
+        for (size_t i = 0; i < NUM_BUTTONS; ++i)
+        {
+            buttons[i] = static_cast<uint16_t>(1U << i);
+        }
+        for (size_t i = 0; i < NUM_DPAD; ++i)
+        {
+            dpad[i] = static_cast<uint8_t>(1U << i);
+        }
+        compile(buttons, dpad);
+    }
+
+    //buttons[i] is what canonical button bit i becomes (any bits, or none), same for dpad
+    void compile(const std::array<uint16_t, NUM_BUTTONS>& buttons, const std::array<uint8_t, NUM_DPAD>& dpad)
+    {
+        for (size_t nibble = 0; nibble < buttons_.size(); ++nibble)
+        {
+            for (uint32_t value = 0; value < 16; ++value)
+            {
+                uint16_t out = 0;
+                for (uint32_t bit = 0; bit < 4; ++bit)
+                {
+                    if (value & (1U << bit))
+                    {
+                        out |= buttons[nibble * 4 + bit];
+                    }
+                }
+                buttons_[nibble][value] = out;
+            }
+        }
+        for (uint32_t value = 0; value < 16; ++value)
+        {
+            uint8_t out = 0;
+            for (uint32_t bit = 0; bit < NUM_DPAD; ++bit)
+            {
+                if (value & (1U << bit))
+                {
+                    out |= dpad[bit];
+                }
+            }
+            dpad_[value] = out;
+        }
+    }
+
+    inline uint16_t buttons(uint16_t canonical) const
+    {
+        return  buttons_[0][canonical & 0x0F] |
+                buttons_[1][(canonical >> 4) & 0x0F] |
+                buttons_[2][(canonical >> 8) & 0x0F];
+    }
+
+    inline uint8_t dpad(uint8_t canonical) const
+    {
+        return dpad_[canonical & 0x0F];
+    }
+
+private:
+    std::array<std::array<uint16_t, 16>, NUM_BUTTONS / 4> buttons_{};
+    std::array<uint8_t, 16> dpad_{};
+};
+
+namespace mapping_detail
+{
+    //Never defined, reaching it while building a static constexpr map is a compile error
+    void invalid_rule();
+
+    constexpr uint32_t lowest_bit(uint32_t mask)
+    {
+        uint32_t bit = 0;
+        while (bit < 32 && !(mask & (1U << bit)))
+        {
+            ++bit;
+        }
+        return bit;
+    }
+
+    //mask at byte of a BYTES long report, it has to fit
+    template <typename Bits, size_t BYTES>
+    constexpr Bits place(size_t byte, uint64_t mask)
+    {
+        if (byte >= BYTES || ((BYTES - byte) < 8 && (mask >> ((BYTES - byte) * 8))))
+        {
+            invalid_rule();
+        }
+        return static_cast<Bits>(mask << (byte * 8));
+    }
+
+    //Index of a hat value in MappingPlan::Hat order, 8 if it's none of them
+    template <typename Values>
+    constexpr uint32_t hat_index(const Values& values, uint32_t value)
+    {
+        uint32_t index = 0;
+        while (index < values.size() && values[index] != value)
+        {
+            ++index;
+        }
+        return index;
+    }
+}
+
+template <size_t BYTES>
+class SourceMap
+{
+public:
+    static_assert(BYTES >= 1 && BYTES <= 8, "SourceMap: 1 to 8 report bytes");
+
+    constexpr SourceMap() = default;
+
+    //Any bit of mask set in the report sets button
+    constexpr SourceMap& button(size_t byte, uint32_t mask, uint16_t button)
+    {
+        add(byte, mask, button);
+        return *this;
+    }
+
+    //Any bit of mask set in the report sets dpad, for dpads reported as separate bits
+    constexpr SourceMap& dpad(size_t byte, uint32_t mask, uint8_t dpad)
+    {
+        add(byte, mask, static_cast<uint32_t>(dpad) << 16);
+        return *this;
+    }
+
+    //(report & mask) is a hat switch, values in MappingPlan::Hat order, anything else is centered.
+    //Folded into the nibble tables if the field sits in one nibble, else looked up on its own
+    constexpr SourceMap& hat(size_t byte, uint32_t mask, const MappingPlan::Hat& values)
+    {
+        const uint32_t shift = mapping_detail::lowest_bit(mask);
+        const size_t hat_byte = byte + shift / 8;
+        const uint32_t field = mask >> shift;
+        if (!mask || field > 0x0F || ((shift % 8) + (32 - __builtin_clz(field))) > 8 || hat_byte >= BYTES)
+        {
+            mapping_detail::invalid_rule();
+        }
+
+        const uint32_t nibble_shift = shift % 4;
+        if ((field << nibble_shift) <= 0x0F)
+        {
+            auto& table = nibbles_[byte * 2 + shift / 4];
+            for (uint32_t value = 0; value < 16; ++value)
+            {
+                const uint32_t index = mapping_detail::hat_index(values, (value << (shift - nibble_shift)) & mask);
+                if (index < MappingPlan::HAT_DPAD.size())
+                {
+                    table[value] |= static_cast<uint32_t>(MappingPlan::HAT_DPAD[index]) << 16;
+                }
+            }
+            return *this;
+        }
+
+        hat_byte_ = static_cast<uint8_t>(hat_byte);
+        hat_shift_ = static_cast<uint8_t>(shift % 8);
+        hat_mask_ = static_cast<uint8_t>(field);
+        for (uint32_t value = 0; value < 16; ++value)
+        {
+            const uint32_t index = mapping_detail::hat_index(values, (value << shift) & mask);
+            hat_dpad_[value] = (index < MappingPlan::HAT_DPAD.size()) ? MappingPlan::HAT_DPAD[index] : 0;
+        }
+        return *this;
+    }
+
+    //Canonical buttons and dpad, before the profile remaps them
+    inline MappingPlan::Pad map(const uint8_t* report) const
+    {
+        uint32_t bits = 0;
+        for (size_t i = 0; i < BYTES; ++i)
+        {
+            bits |= nibbles_[i * 2][report[i] & 0x0F] | nibbles_[i * 2 + 1][report[i] >> 4];
+        }
+        MappingPlan::Pad pad;
+        pad.buttons = static_cast<uint16_t>(bits);
+        pad.dpad = static_cast<uint8_t>(bits >> 16);
+        if (hat_mask_)
+        {
+            pad.dpad |= hat_dpad_[(report[hat_byte_] >> hat_shift_) & hat_mask_];
+        }
+        return pad;
+    }
+
+    inline MappingPlan::Pad map(const void* report) const
+    {
+        return map(static_cast<const uint8_t*>(report));
+    }
+
+private:
+    //Buttons in the low 16 bits, dpad above
+    std::array<std::array<uint32_t, 16>, BYTES * 2> nibbles_{};
+    std::array<uint8_t, 16> hat_dpad_{};
+    uint8_t hat_byte_{0};
+    uint8_t hat_shift_{0};
+    uint8_t hat_mask_{0};
+
+    constexpr void add(size_t byte, uint32_t mask, uint32_t bits)
+    {
+        if (!mask)
+        {
+            mapping_detail::invalid_rule();
+        }
+        for (uint32_t shift = 0; shift < 32; shift += 4)
+        {
+            const uint32_t nibble_mask = (mask >> shift) & 0x0F;
+            if (!nibble_mask)
+            {
+                continue;
+            }
+            const size_t nibble = byte * 2 + shift / 4;
+            if (nibble >= nibbles_.size())
+            {
+                mapping_detail::invalid_rule();
+            }
+            for (uint32_t value = 0; value < 16; ++value)
+            {
+                if (value & nibble_mask)
+                {
+                    nibbles_[nibble][value] |= bits;
+                }
+            }
+        }
+    }
+};
+
+template <size_t BYTES>
+class DeviceMap
+{
+public:
+    static_assert(BYTES >= 1 && BYTES <= 8, "DeviceMap: 1 to 8 report bytes");
+
+    using Bits = std::conditional_t<(BYTES <= 4), uint32_t, uint64_t>;
+
+    constexpr DeviceMap() = default;
+
+    //Any of the canonical buttons pressed sets mask in the report
+    constexpr DeviceMap& button(uint16_t button, size_t byte, uint64_t mask)
+    {
+        const Bits bits = place(byte, mask);
+        for (size_t nibble = 0; nibble < 3; ++nibble)
+        {
+            const uint32_t nibble_mask = (button >> (nibble * 4)) & 0x0F;
+            for (uint32_t value = 0; value < 16; ++value)
+            {
+                if (value & nibble_mask)
+                {
+                    nibbles_[nibble][value] |= bits;
+                }
+            }
+        }
+        return *this;
+    }
+
+    //Any of the canonical dpad bits set sets mask, for dpads reported as separate bits
+    constexpr DeviceMap& dpad(uint8_t dpad, size_t byte, uint64_t mask)
+    {
+        const Bits bits = place(byte, mask);
+        for (uint32_t value = 0; value < 16; ++value)
+        {
+            if (value & dpad)
+            {
+                nibbles_[3][value] |= bits;
+            }
+        }
+        return *this;
+    }
+
+    //The 8 directions to values (MappingPlan::Hat order) in the field at mask, anything else
+    //(nothing, or opposite directions held) to neutral. Values needn't be one bit each
+    constexpr DeviceMap& hat(size_t byte, uint32_t mask, const MappingPlan::Hat& values, uint32_t neutral)
+    {
+        for (uint32_t value = 0; value < 16; ++value)
+        {
+            const uint32_t index = mapping_detail::hat_index(MappingPlan::HAT_DPAD, value);
+            const uint32_t hat = (index < values.size()) ? values[index] : neutral;
+            if (hat & ~mask)
+            {
+                mapping_detail::invalid_rule();
+            }
+            nibbles_[3][value] |= place(byte, hat);
+        }
+        return *this;
+    }
+
+    inline Bits map(uint16_t buttons, uint8_t dpad) const
+    {
+        return  nibbles_[0][buttons & 0x0F] |
+                nibbles_[1][(buttons >> 4) & 0x0F] |
+                nibbles_[2][(buttons >> 8) & 0x0F] |
+                nibbles_[3][dpad & 0x0F];
+    }
+
+    //ORs the mapped bits into the report's button bytes
+    inline void apply(uint16_t buttons, uint8_t dpad, void* report) const
+    {
+        const Bits bits = map(buttons, dpad);
+        uint8_t* out = static_cast<uint8_t*>(report);
+        for (size_t i = 0; i < BYTES; ++i)
+        {
+            out[i] |= static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+private:
+    std::array<std::array<Bits, 16>, 4> nibbles_{};
+
+    static constexpr Bits place(size_t byte, uint64_t mask)
+    {
+        return mapping_detail::place<Bits, BYTES>(byte, mask);
+    }
+};
+
+template <size_t BYTES>
+class KeyMap
+{
+public:
+    static_assert(BYTES >= 1 && BYTES <= 8, "KeyMap: 1 to 8 report bytes");
+
+    using Bits = typename DeviceMap<BYTES>::Bits;
+
+    static constexpr size_t MAX_KEY = 128;
+    static constexpr size_t MAX_RULES = 31;
+
+    constexpr KeyMap() = default;
+
+    constexpr KeyMap& key(uint8_t key, size_t byte, uint64_t mask)
+    {
+        if (!key || key >= MAX_KEY || (!index_[key] && num_rules_ >= MAX_RULES))
+        {
+            mapping_detail::invalid_rule();
+        }
+        if (!index_[key])
+        {
+            index_[key] = ++num_rules_;
+        }
+        rules_[index_[key]] |= mapping_detail::place<Bits, BYTES>(byte, mask);
+        return *this;
+    }
+
+    inline Bits map(uint8_t key) const
+    {
+        return (key < MAX_KEY) ? rules_[index_[key]] : 0;
+    }
+
+    //ORs the bits of every key held into the report's button bytes
+    inline void apply(const uint8_t* keys, size_t count, void* report) const
+    {
+        Bits bits = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            bits |= map(keys[i]);
+        }
+        uint8_t* out = static_cast<uint8_t*>(report);
+        for (size_t i = 0; i < BYTES; ++i)
+        {
+            out[i] |= static_cast<uint8_t>(bits >> (i * 8));
+        }
+    }
+
+private:
+    std::array<uint8_t, MAX_KEY> index_{};          //0 is no rule
+    std::array<Bits, MAX_RULES + 1> rules_{};
+    uint8_t num_rules_{0};
+};
+
+#endif // _MAPPING_PLAN_H_
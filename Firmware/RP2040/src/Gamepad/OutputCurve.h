@@ -0,0 +1,158 @@
+#ifndef _OUTPUT_CURVE_H_
+#define _OUTPUT_CURVE_H_
+
+#include <cstdint>
+#include <array>
+
+#include "libfixmath/fix16.hpp"
+#include "Gamepad/fix16ext.h"
+#include "UserSettings/OutputCurveSettings.h"
+
+/*  A device driver's radial stick response in integer math.
+
+    The response only depends on the stick's magnitude, so it's tabled over the range past
+    the deadzone (SEGMENTS + 1 points, linearly interpolated) when the curve is compiled, and
+    a report is an integer square root, a table lookup and one divide. Curves under 1.0 are
+    steep right past the deadzone, so the first FINE_SPAN segments have a finer table of their
+    own. Direction is kept, magnitudes past 1.0 (stick corners) are clamped to 1.0 before
+    shaping, the same as the float curves did, and the output is clamped per axis. */
+
+class OutputCurve
+{
+public:
+    static constexpr uint32_t SEGMENTS = 128;
+    static constexpr uint32_t FINE_SPAN = 4;
+    static constexpr uint32_t FINE_BITS = 5;    //Fine segments per segment, log2
+    static constexpr uint32_t MAG_MAX = 32767;
+
+    OutputCurve() = default;
+
+    void compile(const OutputCurveRaw& raw)
+    {
+        enabled_ = raw.enabled ? true : false;
+        if (!enabled_)
+        {
+            return;
+        }
+
+        const Fix16 deadzone = fix16::clamp(Fix16(raw.deadzone), Fix16(0.0f), Fix16(0.9f));
+        const Fix16 curve = fix16::clamp(Fix16(raw.curve), Fix16(0.1f), Fix16(10.0f));
+        const Fix16 linear_mix = fix16::clamp(Fix16(raw.linear_mix), Fix16(0.0f), Fix16(1.0f));
+        const Fix16 sensitivity = fix16::clamp(Fix16(raw.sensitivity), Fix16(0.0f), Fix16(2.0f));
+        radius_max_ = raw.uncap_radius ? UINT16_MAX : MAG_MAX;
+
+        deadzone_ = static_cast<uint32_t>(to_mag(deadzone));
+        step_ = (SEGMENTS << 24) / (MAG_MAX - deadzone_);
+
+        for (uint32_t i = 0; i <= SEGMENTS; ++i)
+        {
+            table_[i] = response(Fix16(static_cast<int16_t>(i)) / Fix16(static_cast<int16_t>(SEGMENTS)),
+                                 curve, linear_mix, sensitivity);
+        }
+        for (uint32_t i = 0; i < fine_.size(); ++i)
+        {
+            //i / (SEGMENTS << FINE_BITS) is exact in raw Fix16 units
+            const Fix16 in = Fix16(static_cast<fix16_t>((i << 16) / (SEGMENTS << FINE_BITS)));
+            fine_[i] = response(in, curve, linear_mix, sensitivity);
+        }
+    }
+
+    //False until compiled from settings that ask for it
+    inline bool enabled() const { return enabled_; }
+
+    inline void shape(int16_t in_x, int16_t in_y, int16_t& out_x, int16_t& out_y) const
+    {
+        const int32_t x = in_x;
+        const int32_t y = in_y;
+        uint32_t mag = isqrt(static_cast<uint32_t>(x * x) + static_cast<uint32_t>(y * y));
+        if (mag > MAG_MAX)
+        {
+            mag = MAG_MAX;
+        }
+        if (mag <= deadzone_)
+        {
+            out_x = 0;
+            out_y = 0;
+            return;
+        }
+
+        //Position past the deadzone in segments, 24 fractional bits
+        const uint32_t pos = (mag - deadzone_) * step_;
+        int32_t radius;
+        if (pos < (FINE_SPAN << 24))
+        {
+            const uint32_t index = pos >> (24 - FINE_BITS);
+            const int32_t lo = fine_[index];
+            radius = lo + (((static_cast<int32_t>(fine_[index + 1]) - lo) * static_cast<int32_t>((pos >> (16 - FINE_BITS)) & 0xFF)) >> 8);
+        }
+        else
+        {
+            uint32_t index = pos >> 24;
+            uint32_t frac = (pos >> 16) & 0xFF;
+            if (index >= SEGMENTS)
+            {
+                index = SEGMENTS - 1;
+                frac = 0x100;
+            }
+            const int32_t lo = table_[index];
+            radius = lo + (((static_cast<int32_t>(table_[index + 1]) - lo) * static_cast<int32_t>(frac)) >> 8);
+        }
+
+        if (radius > radius_max_)
+        {
+            radius = radius_max_;
+        }
+
+        //radius / mag in Q14, |x| and |y| are at most mag so this can't overflow
+        const int32_t scale = (radius << 14) / static_cast<int32_t>(mag);
+        out_x = clamp((x * scale) >> 14);
+        out_y = clamp((y * scale) >> 14);
+    }
+
+private:
+    bool enabled_{false};
+    uint32_t deadzone_{0};
+    int32_t radius_max_{UINT16_MAX};
+    uint32_t step_{(SEGMENTS << 24) / MAG_MAX};
+    std::array<uint16_t, SEGMENTS + 1> table_{};
+    std::array<uint16_t, (FINE_SPAN << FINE_BITS) + 1> fine_{};
+
+    static inline int16_t clamp(int32_t value)
+    {
+        return static_cast<int16_t>((value > INT16_MAX) ? INT16_MAX : ((value < INT16_MIN) ? INT16_MIN : value));
+    }
+
+    //Fraction of full scale to stick units, rounded, 2.0 doesn't fit a Fix16 once scaled
+    static inline int32_t to_mag(Fix16 fraction)
+    {
+        return static_cast<int32_t>((static_cast<int64_t>(fraction.value) * MAG_MAX + 0x8000) >> 16);
+    }
+
+    //Uncapped, capping after interpolating keeps the corner where it starts
+    static inline uint16_t response(Fix16 in, Fix16 curve, Fix16 linear_mix, Fix16 sensitivity)
+    {
+        Fix16 out = ((Fix16(1.0f) - linear_mix) * fix16::pow(in, curve) + linear_mix * in) * sensitivity;
+        out = fix16::clamp(out, Fix16(0.0f), Fix16(2.0f));
+        const int32_t value = to_mag(out);
+        return static_cast<uint16_t>((value > UINT16_MAX) ? UINT16_MAX : value);
+    }
+
+    //Floor of the square root, value is at most 2 * 32768^2. Fixed 16 steps without branches,
+    //no hardware square root or clz on the M0+
+    static inline uint32_t isqrt(uint32_t value)
+    {
+        uint32_t root = 0;
+        uint32_t bit = 1u << 30;
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const uint32_t trial = root + bit;
+            const uint32_t mask = 0u - static_cast<uint32_t>(value >= trial);
+            value -= trial & mask;
+            root = (root >> 1) + (bit & mask);
+            bit >>= 2;
+        }
+        return root;
+    }
+};
+
+#endif // _OUTPUT_CURVE_H_
@@ -0,0 +1,75 @@
+#ifndef _SNAPSHOT_LATCH_H_
+#define _SNAPSHOT_LATCH_H_
+
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+/*  Two copy sequence latch for passing small structs between cores and IRQs.
+
+    The writer bumps the sequence before updating each copy, readers copy whichever
+    one the writer isn't touching and retry only if the writer moved on during the copy.
+    store() never waits, so it's safe from an IRQ. A reader that interrupts the writer
+    on the same core still gets a consistent (previous) value on the first pass,
+    since the sequence can't change under it.
+
+    One writer at a time, callers with more than one writer must serialize store(). */
+
+template <typename T>
+class SnapshotLatch
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SnapshotLatch: T must be trivially copyable");
+
+    SnapshotLatch() = default;
+
+    explicit SnapshotLatch(const T& value)
+    {
+        std::memcpy(&data_[0], &value, sizeof(T));
+        std::memcpy(&data_[1], &value, sizeof(T));
+    }
+
+    inline void store(const T& value)
+    {
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+
+        //Readers move to data_[1]
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_[0], &value, sizeof(T));
+
+        //Readers move back to data_[0]
+        std::atomic_thread_fence(std::memory_order_release);
+        seq_.store(seq + 2, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&data_[1], &value, sizeof(T));
+    }
+
+    inline T load() const
+    {
+        T value;
+        uint32_t seq;
+        do
+        {
+            seq = seq_.load(std::memory_order_acquire);
+            std::memcpy(&value, &data_[seq & 1], sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        while (seq != seq_.load(std::memory_order_relaxed));
+
+        return value;
+    }
+
+    //Number of completed stores, wraps
+    inline uint32_t sequence() const
+    {
+        return seq_.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    std::atomic<uint32_t> seq_{0};
+    T data_[2];
+};
+
+#endif // _SNAPSHOT_LATCH_H_
@@ -0,0 +1,297 @@
+#ifndef _STICK_LUT_H_
+#define _STICK_LUT_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <utility>
+#include <algorithm>
+
+#include "Board/Config.h"
+
+/*  Joystick shaping compiled into a lookup table when a profile is loaded.
+
+    The shaping in Gamepad::apply_joystick_settings is symmetric across quadrants
+    (output sign follows input sign), so only |x|, |y| in [0, 32768] is tabled, on a
+    (GRID + 1) x (GRID + 1) lattice, and bilinearly interpolated per report.
+
+    Cells where interpolation can't be shown to stay within max_error of the reference are
+    flagged at compile time and lookup() returns false for them so the caller runs the Fix16
+    reference instead. That's mostly the ring around the inner deadzone, the steps along the
+    axes and the kink where the outer deadzone caps the radius. See error_bound() for how a
+    cell's error is bounded between the points it's sampled at.
+
+    Bounding costs (SUB + 1)^2 - 4 reference calls per cell, so compile() takes a time budget.
+    Cells it doesn't get to in time stay on the reference, they're visited in an order spread
+    over the whole quadrant so a short budget doesn't leave one side of the stick untabled. */
+
+template <uint8_t GRID_BITS>
+class StickLUT
+{
+public:
+    static_assert(GRID_BITS >= 3 && GRID_BITS <= 7, "StickLUT: GRID_BITS must be 3 to 7");
+
+    static constexpr uint32_t GRID = 1u << GRID_BITS;
+    static constexpr uint32_t CELL_BITS = 15 - GRID_BITS;
+    static constexpr uint32_t CELL = 1u << CELL_BITS;
+    static constexpr uint32_t NUM_POINTS = (GRID + 1) * (GRID + 1);
+    static constexpr uint32_t NUM_CELLS = GRID * GRID;
+    static constexpr size_t SIZE_BYTES = (NUM_POINTS * 4) + (NUM_CELLS / 8);
+    //Reference samples per cell edge when bounding a cell's error
+    static constexpr uint32_t SUB = 4;
+    static constexpr uint32_t STEP = CELL / SUB;
+    //Odd, so stepping by it mod NUM_CELLS visits every cell once
+    static constexpr uint32_t CELL_ORDER_STRIDE = ((NUM_CELLS * 5) / 8) | 1;
+
+    struct Stats
+    {
+        uint16_t grid{0};
+        uint16_t fallback_cells{0};
+        uint16_t total_cells{0};
+        uint16_t max_error{0}; //Largest error bound of the cells that are tabled
+        uint16_t unchecked_cells{0}; //Left on the reference when the time budget ran out, part of fallback_cells
+        uint32_t size_bytes{0};
+        uint32_t compile_us{0};
+    };
+
+    StickLUT() = default;
+
+    //reference(x, y) must return the shaped output for x, y >= 0, now_us() a free running
+    //microsecond clock. Stops bounding cells once budget_us has passed
+    template <typename RefFunc, typename ClockFunc>
+    void compile(RefFunc&& reference, uint16_t max_error, ClockFunc&& now_us, uint32_t budget_us)
+    {
+        const uint32_t start_us = now_us();
+
+        stats_ = Stats();
+        stats_.grid = static_cast<uint16_t>(GRID);
+        stats_.total_cells = static_cast<uint16_t>(NUM_CELLS);
+        stats_.size_bytes = static_cast<uint32_t>(SIZE_BYTES);
+        stats_.fallback_cells = static_cast<uint16_t>(NUM_CELLS);
+        fallback_.fill(~0u);
+
+        for (uint32_t gy = 0; gy <= GRID; ++gy)
+        {
+            for (uint32_t gx = 0; gx <= GRID; ++gx)
+            {
+                auto out = reference(grid_coord(gx), grid_coord(gy));
+                points_[point_idx(gx, gy)] = { out.first, out.second };
+            }
+        }
+
+        uint32_t cell = 0;
+        uint32_t checked = 0;
+        for (; checked < NUM_CELLS && (now_us() - start_us) < budget_us; ++checked)
+        {
+            const uint32_t bound = error_bound(reference, cell % GRID, cell / GRID);
+            if (bound <= max_error)
+            {
+                fallback_[cell / 32] &= ~(1u << (cell % 32));
+                --stats_.fallback_cells;
+                stats_.max_error = std::max(stats_.max_error, static_cast<uint16_t>(bound));
+            }
+            cell = (cell + CELL_ORDER_STRIDE) % NUM_CELLS;
+        }
+
+        stats_.unchecked_cells = static_cast<uint16_t>(NUM_CELLS - checked);
+        stats_.compile_us = now_us() - start_us;
+        compiled_ = true;
+    }
+
+    inline void reset() { compiled_ = false; }
+    inline bool compiled() const { return compiled_; }
+    inline const Stats& stats() const { return stats_; }
+
+    //Returns false if this sample must go through the reference instead
+    inline bool lookup(int16_t x, int16_t y, int16_t& out_x, int16_t& out_y) const
+    {
+        const uint32_t abs_x = (x < 0) ? static_cast<uint32_t>(-static_cast<int32_t>(x)) : static_cast<uint32_t>(x);
+        const uint32_t abs_y = (y < 0) ? static_cast<uint32_t>(-static_cast<int32_t>(y)) : static_cast<uint32_t>(y);
+
+        uint32_t cx = abs_x >> CELL_BITS;
+        uint32_t cy = abs_y >> CELL_BITS;
+        uint32_t fx = abs_x & (CELL - 1);
+        uint32_t fy = abs_y & (CELL - 1);
+
+        //Only hit by -32768
+        if (cx >= GRID) { cx = GRID - 1; fx = CELL; }
+        if (cy >= GRID) { cy = GRID - 1; fy = CELL; }
+
+        const uint32_t cell = cy * GRID + cx;
+        if (fallback_[cell / 32] & (1u << (cell % 32)))
+        {
+            return false;
+        }
+
+        int32_t shaped_x, shaped_y;
+        interpolate(cx, cy, fx, fy, shaped_x, shaped_y);
+
+        out_x = static_cast<int16_t>((x < 0) ? -shaped_x : shaped_x);
+        out_y = static_cast<int16_t>((y < 0) ? -shaped_y : shaped_y);
+        return true;
+    }
+
+private:
+    struct Point
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    bool compiled_{false};
+    Stats stats_;
+    std::array<Point, NUM_POINTS> points_;
+    std::array<uint32_t, (NUM_CELLS + 31) / 32> fallback_{0};
+
+    static inline int16_t lattice_coord(uint32_t value)
+    {
+        return static_cast<int16_t>((value > 32767) ? 32767 : value);
+    }
+
+    static inline int16_t grid_coord(uint32_t g)
+    {
+        return lattice_coord(g << CELL_BITS);
+    }
+
+    static inline uint32_t point_idx(uint32_t gx, uint32_t gy)
+    {
+        return gy * (GRID + 1) + gx;
+    }
+
+    inline void interpolate(uint32_t cx, uint32_t cy, uint32_t fx, uint32_t fy, int32_t& out_x, int32_t& out_y) const
+    {
+        const Point& p00 = points_[point_idx(cx, cy)];
+        const Point& p10 = points_[point_idx(cx + 1, cy)];
+        const Point& p01 = points_[point_idx(cx, cy + 1)];
+        const Point& p11 = points_[point_idx(cx + 1, cy + 1)];
+
+        const int32_t wx = static_cast<int32_t>(fx);
+        const int32_t wy = static_cast<int32_t>(fy);
+
+        int32_t top = p00.x + (((p10.x - p00.x) * wx) >> CELL_BITS);
+        int32_t bot = p01.x + (((p11.x - p01.x) * wx) >> CELL_BITS);
+        out_x = top + (((bot - top) * wy) >> CELL_BITS);
+
+        top = p00.y + (((p10.y - p00.y) * wx) >> CELL_BITS);
+        bot = p01.y + (((p11.y - p01.y) * wx) >> CELL_BITS);
+        out_y = top + (((bot - top) * wy) >> CELL_BITS);
+    }
+
+    static inline int32_t abs_diff(int32_t a, int32_t b)
+    {
+        return (a > b) ? (a - b) : (b - a);
+    }
+
+    static inline int32_t second_diff(const Point& a, const Point& b, const Point& c)
+    {
+        const int32_t dx = abs_diff(a.x + c.x, 2 * b.x);
+        const int32_t dy = abs_diff(a.y + c.y, 2 * b.y);
+        return (dx > dy) ? dx : dy;
+    }
+
+    /*  Largest error interpolation can have anywhere in the cell. The reference is sampled on a
+        SUB x SUB lattice inside the cell. Between lattice points, the error is at most the largest
+        error at the points, plus the reference's own bilinear interpolation error over one lattice
+        square. That is at most (S^2 / 8) * (|f_xx| + |f_yy|) for side S, and the second differences
+        measure S^2 * f'' directly. The largest ones in the cell are used, doubled, so a kink or step
+        anywhere in the cell (the deadzone ring, the outer cap, angle restrict edges) counts in full. */
+    template <typename RefFunc>
+    inline uint32_t error_bound(RefFunc& reference, uint32_t cx, uint32_t cy) const
+    {
+        Point ref[SUB + 1][SUB + 1];
+        int32_t point_error = 0;
+
+        for (uint32_t j = 0; j <= SUB; ++j)
+        {
+            for (uint32_t i = 0; i <= SUB; ++i)
+            {
+                //Corners are table points, exact by definition
+                if ((i == 0 || i == SUB) && (j == 0 || j == SUB))
+                {
+                    ref[j][i] = points_[point_idx(cx + i / SUB, cy + j / SUB)];
+                    continue;
+                }
+                const uint32_t fx = i * STEP;
+                const uint32_t fy = j * STEP;
+                auto out = reference(lattice_coord((cx << CELL_BITS) + fx), lattice_coord((cy << CELL_BITS) + fy));
+                ref[j][i] = { out.first, out.second };
+
+                int32_t interp_x, interp_y;
+                interpolate(cx, cy, fx, fy, interp_x, interp_y);
+                const int32_t err_x = abs_diff(interp_x, out.first);
+                const int32_t err_y = abs_diff(interp_y, out.second);
+                point_error = std::max(point_error, std::max(err_x, err_y));
+            }
+        }
+
+        int32_t curve_x = 0;
+        int32_t curve_y = 0;
+        for (uint32_t j = 0; j <= SUB; ++j)
+        {
+            for (uint32_t i = 1; i < SUB; ++i)
+            {
+                curve_x = std::max(curve_x, second_diff(ref[j][i - 1], ref[j][i], ref[j][i + 1]));
+                curve_y = std::max(curve_y, second_diff(ref[i - 1][j], ref[i][j], ref[i + 1][j]));
+            }
+        }
+
+        return static_cast<uint32_t>(point_error + (curve_x + curve_y + 3) / 4);
+    }
+};
+
+//Budget too small for the smallest grid, shaping always runs the reference
+template <>
+class StickLUT<0>
+{
+public:
+    static constexpr uint32_t GRID = 0;
+    static constexpr size_t SIZE_BYTES = 0;
+
+    struct Stats
+    {
+        uint16_t grid{0};
+        uint16_t fallback_cells{0};
+        uint16_t total_cells{0};
+        uint16_t max_error{0};
+        uint16_t unchecked_cells{0};
+        uint32_t size_bytes{0};
+        uint32_t compile_us{0};
+    };
+
+    template <typename RefFunc, typename ClockFunc>
+    void compile(RefFunc&&, uint16_t, ClockFunc&&, uint32_t) {}
+
+    inline void reset() {}
+    inline bool compiled() const { return false; }
+    inline const Stats& stats() const { return stats_; }
+    inline bool lookup(int16_t, int16_t, int16_t&, int16_t&) const { return false; }
+
+private:
+    Stats stats_;
+};
+
+namespace StickLUTConfig {
+
+    //Largest grid that fits in the per stick RAM budget
+    constexpr uint8_t grid_bits(size_t budget)
+    {
+        for (uint8_t bits = 7; bits >= 3; --bits)
+        {
+            const size_t grid = size_t(1) << bits;
+            if ((((grid + 1) * (grid + 1) * 4) + ((grid * grid) / 8)) <= budget)
+            {
+                return bits;
+            }
+        }
+        return 0;
+    }
+
+    constexpr uint8_t GRID_BITS = grid_bits(STICK_LUT_BUDGET);
+    constexpr uint16_t MAX_ERROR = STICK_LUT_MAX_ERROR;
+    constexpr uint32_t COMPILE_BUDGET_US = STICK_LUT_COMPILE_BUDGET_US;
+
+} // namespace StickLUTConfig
+
+using JoystickLUT = StickLUT<StickLUTConfig::GRID_BITS>;
+
+#endif // _STICK_LUT_H_
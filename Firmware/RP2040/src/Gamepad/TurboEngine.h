@@ -0,0 +1,156 @@
+#ifndef _TURBO_ENGINE_H_
+#define _TURBO_ENGINE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+/*  Turbo scheduled from microsecond timestamps instead of counting loop passes.
+
+    A channel fires its output buttons while its trigger is held, on for on_us of every period_us,
+    with the phase starting at the press so the first press always goes out. The trigger itself is
+    taken out of the buttons, so a channel can turbo its own button or fire others (macro style).
+    Where a turbo is in the on or off part of its period only depends on the time since the press,
+    not on how often reports are built, so it runs at the same rate whatever the poll rate.
+
+    apply() keeps press times and the last on/off state, due() is true once that state is stale so
+    the device side rebuilds a report even if the host sent nothing new. Device side only (core0). */
+
+class TurboEngine
+{
+public:
+    static constexpr size_t MAX_CHANNELS = 16;
+
+    //Rate for the high nibble of a profile turbo byte, 0 is off
+    static constexpr std::array<uint8_t, 16> RATES_HZ = { 0, 2, 4, 5, 6, 8, 10, 12, 15, 16, 20, 24, 25, 30, 40, 50 };
+
+    //Profile turbo byte: high nibble RATES_HZ index, low nibble on time in 16ths of the period, 0 for half
+    static constexpr uint8_t setting(uint8_t rate_index, uint8_t on_16ths)
+    {
+        return static_cast<uint8_t>((rate_index << 4) | (on_16ths & 0x0F));
+    }
+
+    //A device mode's own turbo channel, on top of the profile's unless the profile turbos its trigger
+    struct ModeDefault
+    {
+        uint16_t trigger{0};
+        uint16_t output{0};
+        uint8_t rate_hz{0};
+        uint8_t on_16ths{0};
+    };
+
+    TurboEngine() = default;
+
+    inline void clear() { num_channels_ = 0; }
+
+    //One profile turbo byte per canonical button, bit i of the buttons is settings[i]
+    template <size_t N>
+    void compile(const uint8_t (&settings)[N])
+    {
+        clear();
+        for (size_t i = 0; i < N; ++i)
+        {
+            const uint8_t rate_hz = RATES_HZ[settings[i] >> 4];
+            if (rate_hz)
+            {
+                const uint16_t button = static_cast<uint16_t>(1U << i);
+                add(button, button, rate_hz, settings[i] & 0x0F);
+            }
+        }
+    }
+
+    //False if out of channels or the rate is 0
+    bool add(uint16_t trigger, uint16_t output, uint32_t rate_hz, uint32_t on_16ths)
+    {
+        if (num_channels_ >= MAX_CHANNELS || !trigger || !rate_hz)
+        {
+            return false;
+        }
+        Channel& channel = channels_[num_channels_++];
+        channel = Channel();
+        channel.trigger = trigger;
+        channel.output = output;
+        channel.period_us = 1000000 / rate_hz;
+        channel.on_us = (channel.period_us * (on_16ths ? on_16ths : 8)) / 16;
+        return true;
+    }
+
+    inline bool active() const { return num_channels_ != 0; }
+
+    //Some channel is triggered by one of these buttons
+    inline bool has_trigger(uint16_t buttons) const
+    {
+        for (size_t i = 0; i < num_channels_; ++i)
+        {
+            if (channels_[i].trigger & buttons)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //Buttons with every held trigger replaced by its channel's output as of now_us
+    inline uint16_t apply(uint16_t buttons, uint32_t now_us)
+    {
+        uint16_t consumed = 0;
+        uint16_t fired = 0;
+        for (size_t i = 0; i < num_channels_; ++i)
+        {
+            Channel& channel = channels_[i];
+            const bool held = (buttons & channel.trigger) != 0;
+            if (held && !channel.held)
+            {
+                channel.pressed_us = now_us;
+            }
+            channel.held = held;
+            if (!held)
+            {
+                continue;
+            }
+            consumed |= channel.trigger;
+            channel.on = on(channel, now_us);
+            if (channel.on)
+            {
+                fired |= channel.output;
+            }
+        }
+        return static_cast<uint16_t>((buttons & ~consumed) | fired);
+    }
+
+    //A held channel has turned on or off since the last apply()
+    inline bool due(uint32_t now_us) const
+    {
+        for (size_t i = 0; i < num_channels_; ++i)
+        {
+            const Channel& channel = channels_[i];
+            if (channel.held && on(channel, now_us) != channel.on)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Channel
+    {
+        uint16_t trigger{0};
+        uint16_t output{0};
+        uint32_t period_us{0};
+        uint32_t on_us{0};
+        uint32_t pressed_us{0};
+        bool held{false};
+        bool on{false};
+    };
+
+    std::array<Channel, MAX_CHANNELS> channels_;
+    size_t num_channels_{0};
+
+    static inline bool on(const Channel& channel, uint32_t now_us)
+    {
+        return ((now_us - channel.pressed_us) % channel.period_us) < channel.on_us;
+    }
+};
+
+#endif // _TURBO_ENGINE_H_
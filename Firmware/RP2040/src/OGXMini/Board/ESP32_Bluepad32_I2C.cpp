@@ -2,9 +2,10 @@
 #include "OGXMini/Board/ESP32_Bluepad32_I2C.h"
 #if (OGXM_BOARD == ESP32_BLUEPAD32_I2C)
 
+#include <algorithm>
 #include <cstring>
+#include <cstddef>
 #include <pico/multicore.h>
-#include <pico/i2c_slave.h>
 #include <hardware/gpio.h>
 #include <hardware/i2c.h>
 
@@ -15,6 +16,8 @@
 #include "UserSettings/UserSettings.h"
 #include "Board/board_api.h"
 #include "Board/esp32_api.h"
+#include "Board/i2c_packet_slave.h"
+#include "Board/pad_delta.h"
 #include "Gamepad/Gamepad.h"
 #include "TaskQueue/TaskQueue.h"
 
@@ -22,9 +25,14 @@ enum class PacketID : uint8_t {
     UNKNOWN = 0, 
     SET_PAD, 
     GET_PAD, 
-    SET_DRIVER 
+    SET_DRIVER,
+    SET_PAD_DELTA   //[packet_len][packet_id][pad_delta frame], stream is the pad index
 };
 
+//The start of PadIn: dpad, buttons, triggers, left stick, right stick. The ESP32 sends no analog buttons
+using PadLayout = pad_delta::Layout<1, 2, 2, 4, 4>;
+static_assert(PadLayout::STATE_SIZE == offsetof(Gamepad::PadIn, analog), "PadLayout doesn't match PadIn");
+
 #pragma pack(push, 1)
 struct PacketIn {
     uint8_t             packet_len{sizeof(PacketIn)};
@@ -41,7 +49,8 @@ struct PacketOut {
     PacketID        packet_id{PacketID::GET_PAD};
     uint8_t         index{0};
     Gamepad::PadOut pad_out{Gamepad::PadOut()};
-    uint8_t         reserved[3]{0};
+    bool            resync{false};  //Lost a delta for this index, the next one should be a keyframe
+    uint8_t         reserved[2]{0};
 };
 static_assert(sizeof(PacketOut) == 8, "i2c_driver_esp::PacketOut size mismatch");
 #pragma pack(pop)
@@ -52,60 +61,70 @@ constexpr uint8_t I2C_ADDR = 0x01;
 static Gamepad _gamepads[MAX_GAMEPADS];
 static bool _uart_bridge_mode = false;
 
-static inline void slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
-    static size_t count = 0;
-    static PacketIn packet_in;
-    static PacketOut packet_out;
+//Staged as soon as the write is in, the ESP32 reads it back right after
+static size_t on_packet(const uint8_t* rx, size_t rx_len, uint8_t* tx) {
     static DeviceDriverType current_device_type = 
         UserSettings::get_instance().get_current_driver();
+    static pad_delta::Decoder<PadLayout> decoders[MAX_GAMEPADS];
 
-    switch (event) {
-        case I2C_SLAVE_RECEIVE:
-            if (count < sizeof(PacketIn)) {
-                reinterpret_cast<uint8_t*>(&packet_in)[count] = i2c_read_byte_raw(i2c);
-                ++count;
+    if (rx_len >= 2 && static_cast<PacketID>(rx[1]) == PacketID::SET_PAD_DELTA) {
+        constexpr size_t HEADER_SIZE = 2;
+        if (rx[0] != rx_len || rx_len < HEADER_SIZE + pad_delta::HEADER_SIZE) {
+            return 0;
+        }
+        const uint8_t index = pad_delta::stream(&rx[HEADER_SIZE]);
+        if (index >= MAX_GAMEPADS) {
+            return 0;
+        }
+        pad_delta::Decoder<PadLayout>& decoder = decoders[index];
+        if (decoder.decode(&rx[HEADER_SIZE], rx_len - HEADER_SIZE) == pad_delta::Result::CHANGED) {
+            Gamepad::PadIn pad_in;
+            std::memcpy(reinterpret_cast<uint8_t*>(&pad_in), decoder.state(), PadLayout::STATE_SIZE);
+            _gamepads[index].set_pad_in(pad_in);
+        }
+        PacketOut packet_out;
+        packet_out.index = index;
+        packet_out.pad_out = _gamepads[index].get_pad_out();
+        packet_out.resync = decoder.resync_needed();
+        std::memcpy(tx, &packet_out, sizeof(PacketOut));
+        return sizeof(PacketOut);
+    }
+
+    PacketIn packet_in;
+    std::memcpy(&packet_in, rx, std::min(rx_len, sizeof(PacketIn)));
+
+    switch (packet_in.packet_id) {
+        case PacketID::SET_PAD:
+            if (packet_in.index < MAX_GAMEPADS) {
+                _gamepads[packet_in.index].set_pad_in(packet_in.pad_in);
             }
             break;
-        case I2C_SLAVE_FINISH:
-            if (count == 0) {
-                break;
-            }
-            switch (packet_in.packet_id) {
-                case PacketID::SET_PAD:
-                    if (packet_in.index < MAX_GAMEPADS) {
-                        _gamepads[packet_in.index].set_pad_in(packet_in.pad_in);
+        case PacketID::SET_DRIVER:
+            if (packet_in.device_type != DeviceDriverType::NONE &&
+                packet_in.device_type != current_device_type) {
+                OGXM_LOG("I2C: Driver change detected.\n");
+                //Any writes to flash should be done on Core0
+                TaskQueue::Core0::queue_delayed_task(
+                    TaskQueue::Core0::get_new_task_id(), 1000, false, 
+                    [new_device_type = packet_in.device_type] { 
+                        UserSettings::get_instance().store_driver_type(new_device_type);
                     }
-                    break;
-                case PacketID::SET_DRIVER:
-                    if (packet_in.device_type != DeviceDriverType::NONE &&
-                        packet_in.device_type != current_device_type) {
-                        OGXM_LOG("I2C: Driver change detected.\n");
-                        //Any writes to flash should be done on Core0
-                        TaskQueue::Core0::queue_delayed_task(
-                            TaskQueue::Core0::get_new_task_id(), 1000, false, 
-                            [new_device_type = packet_in.device_type] { 
-                                UserSettings::get_instance().store_driver_type(new_device_type);
-                            }
-                        );
-                    }
-                    break;
-                default:
-                    break;
+                );
             }
-            count = 0;
-            break;
-        case I2C_SLAVE_REQUEST:
-            if (packet_in.index < MAX_GAMEPADS) {
-                packet_out.index = packet_in.index;
-                packet_out.pad_out = _gamepads[packet_in.index].get_pad_out();
-            }
-            i2c_write_raw_blocking( i2c, 
-                                    reinterpret_cast<const uint8_t*>(&packet_out), 
-                                    packet_out.packet_len);
             break;
         default:
             break;
     }
+
+    if (packet_in.index >= MAX_GAMEPADS) {
+        return 0;
+    }
+    PacketOut packet_out;
+    packet_out.index = packet_in.index;
+    packet_out.pad_out = _gamepads[packet_in.index].get_pad_out();
+    packet_out.resync = decoders[packet_in.index].resync_needed();
+    std::memcpy(tx, &packet_out, sizeof(PacketOut));
+    return sizeof(PacketOut);
 }
 
 static void core1_task() {
@@ -118,7 +137,7 @@ static void core1_task() {
     gpio_pull_up(I2C_SDA_PIN);
     gpio_pull_up(I2C_SCL_PIN);
 
-    i2c_slave_init(I2C_PORT, I2C_ADDR, &slave_handler);
+    i2c_packet_slave::init(I2C_PORT, I2C_ADDR, &on_packet);
 
     OGXM_LOG("I2C Driver initialized\n");
 
@@ -178,18 +197,27 @@ void esp32_bp32_i2c::run() {
 
     esp32_api::reset();
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    DeviceManager& device_manager = DeviceManager::get_instance();
+    DeviceDriver* device_driver = device_manager.get_driver();
 
     tud_init(BOARD_TUD_RHPORT);
 
+#if defined(CONFIG_OGXM_DEBUG)
+    TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), DEVICE_POLL_STATS_LOG_MS, true, 
+                                         [] { i2c_packet_slave::log_stats(); });
+#endif
+
     while (true) {
         TaskQueue::Core0::process_tasks();
 
+        const bool build_reports = device_manager.begin_reports();
         for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+            if (build_reports) {
+                device_driver->process(i, _gamepads[i]);
+            }
             tud_task();
         }
-        sleep_ms(1);
+        board_api::wait_for_work(device_manager.idle_us());
     }
 }
 
@@ -180,15 +180,18 @@ void esp32_br_i2c::run() {
     uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
     set_gp_check_timer(tid_gp_check);
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    DeviceManager& device_manager = DeviceManager::get_instance();
+    DeviceDriver* device_driver = device_manager.get_driver();
 
     tud_init(BOARD_TUD_RHPORT);
 
     while (true) {
         TaskQueue::Core0::process_tasks();
-        device_driver->process(0, _gamepads[0]);
+        if (device_manager.begin_reports()) {
+            device_driver->process(0, _gamepads[0]);
+        }
         tud_task();
-        sleep_ms(1);
+        board_api::wait_for_work(device_manager.idle_us());
     }
 }
 
@@ -3,11 +3,16 @@
 #if ((OGXM_BOARD == INTERNAL_4CH_I2C) || (OGXM_BOARD == EXTERNAL_4CH_I2C))
 
 #include <atomic>
+#include <array>
+#include <algorithm>
 #include <cstring>
+#include <cstddef>
 #include <pico/multicore.h>
 #include <hardware/gpio.h>
 #include <hardware/i2c.h>
-#include <pico/i2c_slave.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/timer.h>
 
 #include "tusb.h"
 #include "bsp/board_api.h"
@@ -17,12 +22,12 @@
 #include "USBHost/HostManager.h"
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
+#include "Board/i2c_packet_slave.h"
+#include "Board/pad_delta.h"
 #include "UserSettings/UserSettings.h"
 #include "Gamepad/Gamepad.h"
 #include "TaskQueue/TaskQueue.h"
 
-constexpr uint32_t FEEDBACK_DELAY_MS = 250;
-
 Gamepad _gamepads[MAX_GAMEPADS];
 
 namespace I2C {
@@ -30,10 +35,14 @@ namespace I2C {
         SLAVE = 0,
         MASTER
     };
+    //v3: pads go both ways in one EXCHANGE, a PacketIn write and a PacketOut read after a restart,
+    //with the slave's status in the PacketOut. PAD and STATUS were v1's separate transactions,
+    //v2 sent the whole pad in every time, v3 sends a pad_delta frame
     enum class PacketID : uint8_t { 
         UNKNOWN = 0, 
         PAD, 
-        COMMAND 
+        COMMAND,
+        EXCHANGE
     };
     enum class Command : uint8_t { 
         UNKNOWN = 0, 
@@ -49,21 +58,26 @@ namespace I2C {
         NOT_READY 
     };
 
+    //PadIn then ChatpadIn: dpad, buttons, triggers, left stick, right stick, analog buttons, chatpad
+    using PadLayout = pad_delta::Layout<1, 2, 2, 4, 4, 10, 3>;
+    static_assert(PadLayout::STATE_SIZE == sizeof(Gamepad::PadIn) + sizeof(Gamepad::ChatpadIn), "I2C::PadLayout doesn't match PadIn");
+
     #pragma pack(push, 1)
+    //Only packet_len bytes go out, frame is as long as the fields that changed
     struct PacketIn {
-        uint8_t             packet_len{sizeof(PacketIn)};
-        PacketID            packet_id{PacketID::PAD};
-        Gamepad::PadIn      pad_in{Gamepad::PadIn()};
-        Gamepad::ChatpadIn  chatpad_in{0};
-        uint8_t             reserved[4]{0};
+        uint8_t     packet_len{0};
+        PacketID    packet_id{PacketID::EXCHANGE};
+        uint8_t     frame[PadLayout::FRAME_SIZE_MAX]{0};
     };
-    static_assert(sizeof(PacketIn) == 32, "I2CDriver::PacketIn is misaligned");
+    static_assert(sizeof(PacketIn) <= i2c_packet_slave::RX_SIZE_MAX, "I2CDriver::PacketIn is too long");
 
     struct PacketOut {
         uint8_t         packet_len{sizeof(PacketOut)};
-        PacketID        packet_id{PacketID::PAD};
+        PacketID        packet_id{PacketID::EXCHANGE};
         Gamepad::PadOut pad_out{Gamepad::PadOut()};
-        uint8_t         reserved[4]{0};
+        Status          status{Status::UNKNOWN};
+        bool            resync{false};  //Slave lost a frame, the next one should be a keyframe
+        uint8_t         reserved[2]{0};
     };
     static_assert(sizeof(PacketOut) == 8, "I2CDriver::PacketOut is misaligned");
 
@@ -82,11 +96,11 @@ namespace I2C {
     static Role _i2c_role = Role::SLAVE;
 
     namespace Slave {
-        static inline PacketID get_packet_id(uint8_t* buffer_in) {
+        static inline PacketID get_packet_id(const uint8_t* buffer_in, size_t rx_len) {
             switch (static_cast<PacketID>(buffer_in[1])) {
-                case PacketID::PAD:
-                    if (buffer_in[0] == sizeof(PacketIn)) {
-                        return PacketID::PAD;
+                case PacketID::EXCHANGE:
+                    if (buffer_in[0] == rx_len && rx_len >= offsetof(PacketIn, frame) + pad_delta::HEADER_SIZE) {
+                        return PacketID::EXCHANGE;
                     }
                     break;
                 case PacketID::COMMAND:
@@ -100,96 +114,125 @@ namespace I2C {
             return PacketID::UNKNOWN;
         }
 
-        static void slave_handler(i2c_inst_t *i2c, i2c_slave_event_t event) {
-            static size_t count = 0;
+        //Each master write has an ID indicating the type of data to send back on the next read request,
+        //for an exchange it's read after a restart and staged before the read request arrives
+        static size_t on_packet(const uint8_t* rx, size_t rx_len, uint8_t* tx) {
             static bool enabled = false;
-            static uint8_t buffer_in[MAX_PACKET_SIZE];
-            static uint8_t buffer_out[MAX_PACKET_SIZE];
-
-            PacketIn  *packet_in_p = reinterpret_cast<PacketIn*>(buffer_in);
-            PacketOut *packet_out_p = reinterpret_cast<PacketOut*>(buffer_out);
-            PacketCMD *packet_cmd_in_p = reinterpret_cast<PacketCMD*>(buffer_in);
-            PacketCMD *packet_cmd_out_p = reinterpret_cast<PacketCMD*>(buffer_out);
-
-            switch (event) {
-                case I2C_SLAVE_RECEIVE: // master has written
-                    if (count < MAX_PACKET_SIZE) {
-                        buffer_in[count] = i2c_read_byte_raw(i2c);
-                        ++count;
+            static bool applied = false;
+            static pad_delta::Decoder<PadLayout> decoder;
+            uint8_t buffer_in[MAX_PACKET_SIZE] = {0};
+            rx_len = std::min(rx_len, MAX_PACKET_SIZE);
+            std::memcpy(buffer_in, rx, rx_len);
+
+            switch (get_packet_id(buffer_in, rx_len)) {
+                case PacketID::EXCHANGE: {
+                    //Decoded even when not ready so the state is current once it is
+                    const size_t frame_len = rx_len - offsetof(PacketIn, frame);
+                    const pad_delta::Result result = decoder.decode(&buffer_in[offsetof(PacketIn, frame)], frame_len);
+
+                    //A slave with its own controller mounted takes no pads from the master
+                    const bool ready = !tuh_mounted(BOARD_TUH_RHPORT);
+                    if (ready && (result == pad_delta::Result::CHANGED || !applied)) {
+                        Gamepad::PadIn pad_in;
+                        std::memcpy(&pad_in, decoder.state(), sizeof(Gamepad::PadIn));
+                        _gamepads[0].set_pad_in(pad_in);
                     }
-                    break;
+                    applied = ready;
+                    if (ready && !enabled) {
+                        enabled = true;
+                        four_ch_i2c::host_mounted(true);
+                    }
+                    PacketOut packet_out;
+                    packet_out.pad_out = _gamepads[0].get_pad_out();
+                    packet_out.status = ready ? Status::READY : Status::NOT_READY;
+                    packet_out.resync = decoder.resync_needed();
+                    std::memcpy(tx, &packet_out, sizeof(PacketOut));
+                    return sizeof(PacketOut);
+                }
 
-                case I2C_SLAVE_FINISH:
-                    // Each master write has an ID indicating the type of data to send back on the next read request
-                    // Every write has an associated read
-                    switch (get_packet_id(buffer_in)) {
-                        case PacketID::PAD:
-                            // instance_->packet_in_ = *packet_in_p;
-                            // *packet_out_p = instance_->packet_out_;
-                            // instance_->new_pad_in_.store(true);
-                            _gamepads[0].set_pad_in(packet_in_p->pad_in);
-                            if (_gamepads[0].new_pad_out()) {
-                                packet_out_p->pad_out = _gamepads[0].get_pad_out();
-                            }
-                            break;
+                case PacketID::COMMAND: {
+                    PacketCMD packet_cmd_in;
+                    std::memcpy(&packet_cmd_in, buffer_in, sizeof(PacketCMD));
+
+                    switch (packet_cmd_in.command) {
+                        case Command::DISABLE: {
+                            PacketCMD packet_cmd_out;
+                            packet_cmd_out.command = Command::DISABLE;
+                            packet_cmd_out.status = Status::OK;
 
-                        case PacketID::COMMAND:
-                            switch (packet_cmd_in_p->command) {
-                                case Command::DISABLE:
-                                    packet_cmd_out_p->packet_len = sizeof(PacketCMD);
-                                    packet_cmd_out_p->packet_id = PacketID::COMMAND;
-                                    packet_cmd_out_p->command = Command::DISABLE;
-                                    packet_cmd_out_p->status = Status::OK;
-
-                                    if (!tuh_mounted(BOARD_TUH_RHPORT)) {
-                                        four_ch_i2c::host_mounted(false);
-                                    }
-                                    break;
-
-                                case Command::STATUS:
-                                    packet_cmd_out_p->packet_len = sizeof(PacketCMD);
-                                    packet_cmd_out_p->packet_id = PacketID::COMMAND;
-                                    packet_cmd_out_p->command = Command::STATUS;
-                                    packet_cmd_out_p->status = 
-                                        tuh_mounted(BOARD_TUH_RHPORT) ? Status::NOT_READY : Status::READY;
-
-                                    if (!tuh_mounted(BOARD_TUH_RHPORT) && !enabled) {
-                                        enabled = true;
-                                        four_ch_i2c::host_mounted(true);
-                                    }
-                                    break;
-
-                                default:
-                                    break;
+                            if (!tuh_mounted(BOARD_TUH_RHPORT)) {
+                                four_ch_i2c::host_mounted(false);
                             }
+                            std::memcpy(tx, &packet_cmd_out, sizeof(PacketCMD));
+                            return sizeof(PacketCMD);
+                        }
+
+                        default:
                             break;
                     }
-                    count = 0;
-                    std::memset(buffer_in, 0, sizeof(buffer_in));
-                    break;
-
-                case I2C_SLAVE_REQUEST:
-                    i2c_write_raw_blocking(i2c, buffer_out, buffer_out[0]);
                     break;
+                }
 
                 default:
                     break;
             }
+            return 0;
         }
     } // namespace Slave
 
     namespace Master {
+        //Exchanges that completed, failed and how long they took, per slave over DEVICE_POLL_STATS_LOG_MS
+        struct Stats {
+            uint32_t exchanges{0};
+            uint32_t failures{0};
+            uint32_t exchange_us_sum{0};
+            uint32_t exchange_us_max{0};
+            uint32_t gap_us_max{0};     //Longest between two completed exchanges, how stale a slave's pad can get
+            uint32_t bytes_in_sum{0};   //PacketIn bytes written, completed exchanges only
+            uint32_t keyframes{0};
+        };
+
         struct Slave {
             uint8_t address{0xFF};
             Status  status{Status::NC};
             bool    enabled{false};
+            bool    absent{false};      //Address NACK, left alone until retry_us
+            uint32_t retry_us{0};
+            uint32_t exchanged_us{0};
+            Gamepad::PadOut pad_out{Gamepad::PadOut()};
+            pad_delta::Encoder<PadLayout> encoder;
+            Stats   stats;
         };
 
         static constexpr size_t NUM_SLAVES = MAX_GAMEPADS - 1;
         static_assert(NUM_SLAVES > 0, "I2CMaster::NUM_SLAVES must be greater than 0 to use I2C");
 
+        static constexpr uint32_t EXCHANGE_TIMEOUT_US = 5000;
+        static constexpr uint32_t ABSENT_RETRY_US = 100 * 1000;
+
         std::array<Slave, NUM_SLAVES> _slaves; 
 
+        //The exchange in flight. Every byte of it is queued as an IC_DATA_CMD word, the PacketIn
+        //bytes then read commands with a restart on the first and a stop on the last, so TX DMA
+        //runs the whole transaction and RX DMA collects the PacketOut while core0 carries on
+        struct Exchange {
+            std::array<uint16_t, sizeof(PacketIn) + sizeof(PacketOut)> cmd{0};
+            size_t    cmd_len{0};
+            PacketIn  packet_in;
+            PacketOut packet_out;
+            uint32_t  started_us{0};
+            uint8_t   slot{0};
+            bool      busy{false};
+        };
+
+        static Exchange _exchange;
+        static uint8_t _next_slot{0};
+        static int _tx_chan{-1};
+        static int _rx_chan{-1};
+        static dma_channel_config _tx_config;
+        static dma_channel_config _rx_config;
+        static uint32_t _stats_started_us{0};
+
         static inline bool read_blocking(uint8_t address, void* buffer, size_t len) {
             return (i2c_read_blocking(  I2C_PORT, address, reinterpret_cast<uint8_t*>(buffer), 
                                         len, false) == static_cast<int>(len));
@@ -206,7 +249,195 @@ namespace I2C {
             return (result >= 0);
         }
 
+        //Only here so a finished exchange ends board_api::wait_for_work early
+        static void dma_irq_handler() {
+            dma_hw->ints1 = (1u << _tx_chan) | (1u << _rx_chan);
+        }
+
+        static void initialize() {
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                _slaves[i].address = i + 1;
+            }
+
+            i2c_hw_t* hw = i2c_get_hw(I2C_PORT);
+            //TX requests once the FIFO is half empty, RX for every byte
+            hw->dma_tdlr = 8;
+            hw->dma_rdlr = 0;
+            hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+
+            _tx_chan = dma_claim_unused_channel(true);
+            _tx_config = dma_channel_get_default_config(_tx_chan);
+            channel_config_set_transfer_data_size(&_tx_config, DMA_SIZE_16);
+            channel_config_set_read_increment(&_tx_config, true);
+            channel_config_set_write_increment(&_tx_config, false);
+            channel_config_set_dreq(&_tx_config, i2c_get_dreq(I2C_PORT, true));
+
+            _rx_chan = dma_claim_unused_channel(true);
+            _rx_config = dma_channel_get_default_config(_rx_chan);
+            channel_config_set_transfer_data_size(&_rx_config, DMA_SIZE_8);
+            channel_config_set_read_increment(&_rx_config, false);
+            channel_config_set_write_increment(&_rx_config, true);
+            channel_config_set_dreq(&_rx_config, i2c_get_dreq(I2C_PORT, false));
+
+            dma_channel_set_irq1_enabled(_tx_chan, true);
+            dma_channel_set_irq1_enabled(_rx_chan, true);
+            irq_add_shared_handler(DMA_IRQ_1, dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+            irq_set_enabled(DMA_IRQ_1, true);
+
+            _stats_started_us = time_us_32();
+        }
+
+        static void start_exchange(uint8_t slot) {
+            Exchange& exchange = _exchange;
+            Gamepad& gamepad = _gamepads[slot + 1];
+
+            uint8_t state[PadLayout::STATE_SIZE];
+            const Gamepad::PadIn pad_in = gamepad.get_pad_in();
+            const Gamepad::ChatpadIn chatpad_in = gamepad.get_chatpad_in();
+            std::memcpy(state, &pad_in, sizeof(Gamepad::PadIn));
+            std::memcpy(&state[sizeof(Gamepad::PadIn)], chatpad_in.data(), sizeof(Gamepad::ChatpadIn));
+
+            exchange.packet_in = PacketIn();
+            const size_t frame_len = _slaves[slot].encoder.encode(state, 0, exchange.packet_in.frame);
+            exchange.packet_in.packet_len = static_cast<uint8_t>(offsetof(PacketIn, frame) + frame_len);
+            exchange.packet_out = PacketOut();
+            exchange.packet_out.packet_id = PacketID::UNKNOWN;
+
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&exchange.packet_in);
+            const size_t packet_len = exchange.packet_in.packet_len;
+            for (size_t i = 0; i < packet_len; ++i) {
+                exchange.cmd[i] = bytes[i];
+            }
+            for (size_t i = 0; i < sizeof(PacketOut); ++i) {
+                exchange.cmd[packet_len + i] = 
+                    I2C_IC_DATA_CMD_CMD_BITS |
+                    ((i == 0) ? I2C_IC_DATA_CMD_RESTART_BITS : 0) |
+                    ((i == sizeof(PacketOut) - 1) ? I2C_IC_DATA_CMD_STOP_BITS : 0);
+            }
+            exchange.cmd_len = packet_len + sizeof(PacketOut);
+            if (frame_len == PadLayout::FRAME_SIZE_MAX) {
+                ++_slaves[slot].stats.keyframes;
+            }
+
+            i2c_hw_t* hw = i2c_get_hw(I2C_PORT);
+            hw->enable = 0;
+            hw->tar = _slaves[slot].address;
+            hw->enable = 1;
+
+            exchange.slot = slot;
+            exchange.busy = true;
+            exchange.started_us = time_us_32();
+
+            dma_channel_configure(_rx_chan, &_rx_config, &exchange.packet_out, &hw->data_cmd, sizeof(PacketOut), true);
+            dma_channel_configure(_tx_chan, &_tx_config, &hw->data_cmd, exchange.cmd.data(), exchange.cmd_len, true);
+        }
+
+        //Checks on the exchange in flight, true once there's none
+        static bool finish_exchange(uint32_t now_us) {
+            Exchange& exchange = _exchange;
+            if (!exchange.busy) {
+                return true;
+            }
+
+            i2c_hw_t* hw = i2c_get_hw(I2C_PORT);
+            const bool aborted = (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) != 0;
+            const bool timed_out = !aborted && dma_channel_is_busy(_rx_chan) && 
+                                   (now_us - exchange.started_us > EXCHANGE_TIMEOUT_US);
+
+            if (!aborted && !timed_out && dma_channel_is_busy(_rx_chan)) {
+                return false;
+            }
+
+            Slave& slave = _slaves[exchange.slot];
+            exchange.busy = false;
+
+            if (aborted || timed_out) {
+                if (timed_out) {
+                    //Stop the transfer, the controller sends a stop and flags an abort itself
+                    hw_set_bits(&hw->enable, I2C_IC_ENABLE_ABORT_BITS);
+                    while (hw->enable & I2C_IC_ENABLE_ABORT_BITS) {
+                        tight_loop_contents();
+                    }
+                }
+                const bool nack = (hw->tx_abrt_source & I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS) != 0;
+                dma_channel_abort(_tx_chan);
+                dma_channel_abort(_rx_chan);
+                (void)hw->clr_tx_abrt;
+
+                //Whether the slave got the frame is unknown, so the next one can't build on it
+                slave.encoder.force_keyframe();
+                ++slave.stats.failures;
+                if (nack) {
+                    slave.status = Status::NC;
+                    slave.absent = true;
+                    slave.retry_us = now_us + ABSENT_RETRY_US;
+                }
+                return true;
+            }
+
+            const PacketOut& packet_out = exchange.packet_out;
+            if (packet_out.packet_len != sizeof(PacketOut) || packet_out.packet_id != PacketID::EXCHANGE) {
+                slave.encoder.force_keyframe();
+                ++slave.stats.failures;
+                slave.status = Status::ERROR;
+                return true;
+            }
+
+            slave.absent = false;
+            slave.status = packet_out.status;
+            if (packet_out.resync) {
+                slave.encoder.force_keyframe();
+            }
+            //Only a change goes on as pad out, else the host side would send rumble every exchange
+            if (slave.status == Status::READY && 
+                std::memcmp(&slave.pad_out, &packet_out.pad_out, sizeof(Gamepad::PadOut)) != 0) {
+                slave.pad_out = packet_out.pad_out;
+                _gamepads[exchange.slot + 1].set_pad_out(packet_out.pad_out);
+            }
+
+            Stats& stats = slave.stats;
+            const uint32_t exchange_us = now_us - exchange.started_us;
+            ++stats.exchanges;
+            stats.exchange_us_sum += exchange_us;
+            stats.exchange_us_max = std::max(stats.exchange_us_max, exchange_us);
+            stats.bytes_in_sum += exchange.packet_in.packet_len;
+            if (slave.exchanged_us != 0) {
+                stats.gap_us_max = std::max(stats.gap_us_max, now_us - slave.exchanged_us);
+            }
+            slave.exchanged_us = now_us;
+            return true;
+        }
+
+        //Blocking transfers have to wait for the bus
+        static void wait_for_exchange() {
+            while (!finish_exchange(time_us_32())) {
+                tight_loop_contents();
+            }
+        }
+
+        static void log_stats(uint32_t now_us) {
+            const uint32_t elapsed_us = now_us - _stats_started_us;
+            if (elapsed_us < DEVICE_POLL_STATS_LOG_MS * 1000) {
+                return;
+            }
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                Stats& stats = _slaves[i].stats;
+                if (stats.exchanges || stats.failures) {
+                    OGXM_LOG("I2C slave %u: %u exchanges/s, %u failed, exchange %u/%u us (avg/max), %u us max between, "
+                             "%u bytes in avg, %u keyframes\n",
+                             _slaves[i].address, 
+                             static_cast<uint32_t>((static_cast<uint64_t>(stats.exchanges) * 1000000) / elapsed_us),
+                             stats.failures, stats.exchanges ? (stats.exchange_us_sum / stats.exchanges) : 0,
+                             stats.exchange_us_max, stats.gap_us_max, 
+                             stats.exchanges ? (stats.bytes_in_sum / stats.exchanges) : 0, stats.keyframes);
+                }
+                stats = Stats();
+            }
+            _stats_started_us = now_us;
+        }
+
         static void notify_disable(uint8_t address) {
+            wait_for_exchange();
             if (!slave_detected(address)) {
                 return;
             }
@@ -228,37 +459,29 @@ namespace I2C {
             }
         }
 
+        //Never blocks: finishes the exchange in flight if it's done and starts the next slave's, 
+        //round robin over the enabled ones, so the bus is kept busy without core0 waiting on it
         static void process() {
-            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
-                Slave& slave = _slaves[i];
-
-                if (!slave.enabled || !slave_detected(slave.address)) {
-                    continue;
-                }
+            const uint32_t now_us = time_us_32();
+            if (!finish_exchange(now_us)) {
+                return;
+            }
+            log_stats(now_us);
 
-                PacketCMD packet_cmd;
-                packet_cmd.packet_id = PacketID::COMMAND;
-                packet_cmd.command = Command::STATUS;
+            //The last stop may still be going out
+            if (i2c_get_hw(I2C_PORT)->status & I2C_IC_STATUS_ACTIVITY_BITS) {
+                return;
+            }
 
-                if (!write_blocking(slave.address, &packet_cmd, sizeof(PacketCMD)) ||
-                    !read_blocking(slave.address, &packet_cmd, sizeof(PacketCMD))) {
+            for (uint8_t i = 0; i < NUM_SLAVES; ++i) {
+                const uint8_t slot = (_next_slot + i) % NUM_SLAVES;
+                const Slave& slave = _slaves[slot];
+                if (!slave.enabled || (slave.absent && (static_cast<int32_t>(now_us - slave.retry_us) < 0))) {
                     continue;
                 }
-
-                if (packet_cmd.status == Status::READY) {
-                    Gamepad& gamepad = _gamepads[i + 1];
-                    PacketIn packet_in;
-                    packet_in.pad_in = gamepad.get_pad_in();
-                    packet_in.chatpad_in = gamepad.get_chatpad_in();
-
-                    if (write_blocking(slave.address, &packet_in, sizeof(PacketIn))) {
-                        PacketOut packet_out;
-                        if (read_blocking(slave.address, &packet_out, sizeof(PacketOut))) {
-                            gamepad.set_pad_out(packet_out.pad_out);
-                        }
-                    }
-                }
-                sleep_ms(1);
+                _next_slot = (slot + 1) % NUM_SLAVES;
+                start_exchange(slot);
+                return;
             }
         }
 
@@ -321,7 +544,8 @@ namespace I2C {
 
     void initialize() {
         uint8_t i2c_address = get_address();
-        _i2c_role = (i2c_address == 0xFF) ? Role::MASTER : _i2c_role = Role::SLAVE;
+        //Both pins left high is the master, 0x00 is the general call address and can't be a slave's
+        _i2c_role = (i2c_address == 0x00) ? Role::MASTER : Role::SLAVE;
 
         i2c_init(I2C_PORT, I2C_BAUDRATE);
 
@@ -333,12 +557,17 @@ namespace I2C {
         gpio_pull_up(I2C_SCL_PIN);
 
         if (_i2c_role == Role::SLAVE) {
-            i2c_slave_init(I2C_PORT, i2c_address, &Slave::slave_handler);
+            i2c_packet_slave::init(I2C_PORT, i2c_address, &Slave::on_packet);
+        } else {
+            Master::initialize();
         }
     }
 } // namespace I2C
 
 void core1_task() {
+    //Paused instead of reset when a live mode switch writes flash
+    multicore_lockout_victim_init();
+
     HostManager& host_manager = HostManager::get_instance();
     host_manager.initialize(_gamepads);
 
@@ -353,15 +582,11 @@ void core1_task() {
 
     tuh_init(BOARD_TUH_RHPORT);
 
-    uint32_t tid_feedback = TaskQueue::Core1::get_new_task_id();
-    TaskQueue::Core1::queue_delayed_task(tid_feedback, FEEDBACK_DELAY_MS, true, 
-    [&host_manager] {
-        host_manager.send_feedback();
-    });
-
+    //Stalled IN transfers are restarted and rumble goes out as soon as the console writes it
     while (true) {
         TaskQueue::Core1::process_tasks();
         tuh_task();
+        host_manager.task();
     }
 }
 
@@ -372,8 +597,11 @@ void set_gp_check_timer(uint32_t task_id) {
         //Check gamepad inputs for button combo to change usb device driver
         if (user_settings.check_for_driver_change(_gamepads[0]))
         {
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+            //Switched live with host controllers left mounted, else stored with a reboot
+            if (!DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads))
+            {
+                user_settings.store_driver_type(user_settings.get_current_driver());
+            }
         }
     });
 }
@@ -439,22 +667,31 @@ void four_ch_i2c::run() {
     uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
     set_gp_check_timer(tid_gp_check);
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
+    //The driver is fetched every pass, a mode switch in process_tasks replaces it
     if (I2C::role() == I2C::Role::MASTER) {
         while (true) {
             TaskQueue::Core0::process_tasks();
             I2C::Master::process();
-            device_driver->process(0, _gamepads[0]);
+            if (device_manager.begin_reports()) {
+                device_manager.get_driver()->process(0, _gamepads[0]);
+            }
             tud_task();
-            sleep_ms(1);
+            board_api::wait_for_work(device_manager.idle_us());
         }
     } else {
+#if defined(CONFIG_OGXM_DEBUG)
+        TaskQueue::Core0::queue_delayed_task(TaskQueue::Core0::get_new_task_id(), DEVICE_POLL_STATS_LOG_MS, true, 
+                                             [] { i2c_packet_slave::log_stats(); });
+#endif
         while (true) {
             TaskQueue::Core0::process_tasks();
-            device_driver->process(0, _gamepads[0]);
+            if (device_manager.begin_reports()) {
+                device_manager.get_driver()->process(0, _gamepads[0]);
+            }
             tud_task();
-            sleep_ms(1);
+            board_api::wait_for_work(device_manager.idle_us());
         }
     }
 }
@@ -19,6 +19,9 @@
 Gamepad _gamepads[MAX_GAMEPADS];
 
 void core1_task() {
+    //Paused instead of reset when a live mode switch writes flash
+    multicore_lockout_victim_init();
+
     board_api::init_bluetooth();
     board_api::set_led(true);
     BLEServer::init_server(_gamepads);
@@ -31,8 +34,10 @@ void set_gp_check_timer(uint32_t task_id) {
     [&user_settings] {
         //Check gamepad inputs for button combo to change usb device driver
         if (user_settings.check_for_driver_change(_gamepads[0])) {
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+            //Switched live with controllers left connected, else stored with a reboot
+            if (!DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads)) {
+                user_settings.store_driver_type(user_settings.get_current_driver());
+            }
         }
     });
 }
@@ -58,18 +63,23 @@ void pico_w::run() {
     uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
     set_gp_check_timer(tid_gp_check);
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     tud_init(BOARD_TUD_RHPORT);
 
     while (true) {
         TaskQueue::Core0::process_tasks();
 
+        //Fetched every pass, a mode switch in process_tasks replaces it
+        DeviceDriver* device_driver = device_manager.get_driver();
+        const bool build_reports = device_manager.begin_reports();
         for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+            if (build_reports) {
+                device_driver->process(i, _gamepads[i]);
+            }
             tud_task();
         }
-        sleep_ms(1);
+        board_api::wait_for_work(device_manager.idle_us());
     }
 }
 
@@ -15,11 +15,12 @@
 #include "Board/board_api.h"
 #include "Board/ogxm_log.h"
 
-constexpr uint32_t FEEDBACK_DELAY_MS = 200;
-
 Gamepad _gamepads[MAX_GAMEPADS];
 
 void core1_task() {
+    //Paused instead of reset when a live mode switch writes flash
+    multicore_lockout_victim_init();
+
     HostManager& host_manager = HostManager::get_instance();
     host_manager.initialize(_gamepads);
 
@@ -34,15 +35,11 @@ void core1_task() {
 
     tuh_init(BOARD_TUH_RHPORT);
 
-    uint32_t tid_feedback = TaskQueue::Core1::get_new_task_id();
-    TaskQueue::Core1::queue_delayed_task(tid_feedback, FEEDBACK_DELAY_MS, true, 
-    [&host_manager] {
-        host_manager.send_feedback();
-    });
-
+    //Stalled IN transfers are restarted and rumble goes out as soon as the console writes it
     while (true) {
         TaskQueue::Core1::process_tasks();
         tuh_task();
+        host_manager.task();
     }
 }
 
@@ -54,8 +51,10 @@ void set_gp_check_timer(uint32_t task_id) {
         //Check gamepad inputs for button combo to change usb device driver
         if (user_settings.check_for_driver_change(_gamepads[0])) {
             OGXM_LOG("Driver change detected, storing new driver.\n");
-            //This will store the new mode and reboot the pico
-            user_settings.store_driver_type(user_settings.get_current_driver());
+            //Switched live with host controllers left mounted, else stored with a reboot
+            if (!DeviceManager::get_instance().switch_driver(user_settings.get_current_driver(), _gamepads)) {
+                user_settings.store_driver_type(user_settings.get_current_driver());
+            }
         }
     });
 }
@@ -112,16 +111,20 @@ void standard::run() {
     uint32_t tid_gp_check = TaskQueue::Core0::get_new_task_id();
     set_gp_check_timer(tid_gp_check);
 
-    DeviceDriver* device_driver = DeviceManager::get_instance().get_driver();
+    DeviceManager& device_manager = DeviceManager::get_instance();
 
     while (true) {
         TaskQueue::Core0::process_tasks();
 
-        for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
-            device_driver->process(i, _gamepads[i]);
+        //Fetched every pass, a mode switch in process_tasks replaces it
+        DeviceDriver* device_driver = device_manager.get_driver();
+        if (device_manager.begin_reports()) {
+            for (uint8_t i = 0; i < MAX_GAMEPADS; ++i) {
+                device_driver->process(i, _gamepads[i]);
+            }
         }
         tud_task();
-        sleep_ms(1);
+        board_api::wait_for_work(device_manager.idle_us());
     }
 }
 
@@ -1,4 +1,5 @@
 #include "Board/Config.h"
+#include "Board/heap_audit.h"
 #include "OGXMini/Board/Standard.h"
 #include "OGXMini/Board/PicoW.h"
 #include "OGXMini/Board/Four_Channel_I2C.h"
@@ -75,6 +76,9 @@ namespace OGXMini {
     }
 
     void run() {
+        //Drivers, settings and buffers are all set up by now, nothing past here should allocate
+        heap_audit::mark_steady_state();
+
         if (run_func[OGXM_BOARD] != nullptr) {
             run_func[OGXM_BOARD]();
         }
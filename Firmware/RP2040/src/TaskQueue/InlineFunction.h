@@ -0,0 +1,143 @@
+#ifndef _INLINE_FUNCTION_H_
+#define _INLINE_FUNCTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*  void() callable stored in place, std::function without the heap.
+
+    A capture that doesn't fit in CAPACITY is a compile error rather than an allocation,
+    capture a pointer or reference to bigger state instead. */
+
+template <size_t CAPACITY>
+class InlineFunction
+{
+public:
+    InlineFunction() = default;
+    InlineFunction(std::nullptr_t) {}
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InlineFunction>>>
+    InlineFunction(F&& function)
+    {
+        emplace(std::forward<F>(function));
+    }
+
+    InlineFunction(const InlineFunction& other)
+    {
+        copy_from(other);
+    }
+
+    InlineFunction(InlineFunction&& other) noexcept
+    {
+        move_from(other);
+    }
+
+    InlineFunction& operator=(const InlineFunction& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(InlineFunction&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    InlineFunction& operator=(std::nullptr_t)
+    {
+        reset();
+        return *this;
+    }
+
+    ~InlineFunction()
+    {
+        reset();
+    }
+
+    template <typename F>
+    void emplace(F&& function)
+    {
+        using Fn = std::decay_t<F>;
+        static_assert(sizeof(Fn) <= CAPACITY, "InlineFunction: capture too big, capture a pointer or reference instead");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "InlineFunction: capture alignment not supported");
+        static_assert(std::is_copy_constructible_v<Fn>, "InlineFunction: capture must be copyable");
+
+        reset();
+        ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(function));
+        ops_ = &OPS<Fn>;
+    }
+
+    inline void reset()
+    {
+        if (ops_)
+        {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    inline explicit operator bool() const { return ops_ != nullptr; }
+
+    inline void operator()()
+    {
+        ops_->invoke(storage_);
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* function);
+        void (*copy)(void* dst, const void* src);
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* function);
+    };
+
+    template <typename Fn>
+    static constexpr Ops OPS =
+    {
+        [](void* function) { (*static_cast<Fn*>(function))(); },
+        [](void* dst, const void* src) { ::new (dst) Fn(*static_cast<const Fn*>(src)); },
+        [](void* dst, void* src)
+        {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* function) { static_cast<Fn*>(function)->~Fn(); }
+    };
+
+    alignas(std::max_align_t) uint8_t storage_[CAPACITY];
+    const Ops* ops_{nullptr};
+
+    inline void copy_from(const InlineFunction& other)
+    {
+        if (other.ops_)
+        {
+            other.ops_->copy(storage_, other.storage_);
+            ops_ = other.ops_;
+        }
+    }
+
+    inline void move_from(InlineFunction& other)
+    {
+        if (other.ops_)
+        {
+            other.ops_->move(storage_, other.storage_);
+            ops_ = other.ops_;
+            other.ops_ = nullptr;
+        }
+    }
+};
+
+#endif // _INLINE_FUNCTION_H_
@@ -0,0 +1,230 @@
+#ifndef _TASK_HEAP_H_
+#define _TASK_HEAP_H_
+
+#include <cstdint>
+#include <array>
+#include <utility>
+
+/*  Delayed tasks ordered by target time in a binary min-heap.
+
+    Tasks live in fixed slots, the heap only moves slot indices around so callables are never
+    copied to reorder. Adding, cancelling and popping are O(log n), the next alarm is the root.
+    Repeating tasks are rescheduled from their previous target rather than from when they ran,
+    so IRQ latency doesn't add up over time. Not thread safe, TaskQueue holds its spin lock around it. */
+
+template <typename Function, uint8_t CAPACITY>
+class TaskHeap
+{
+public:
+    static_assert(CAPACITY > 0 && CAPACITY < 0xFF, "TaskHeap: CAPACITY must be 1 to 254");
+
+    enum class AddResult : uint8_t
+    {
+        OK = 0,
+        FULL,
+        DUPLICATE_ID
+    };
+
+    TaskHeap()
+    {
+        for (uint8_t i = 0; i < CAPACITY; ++i)
+        {
+            slots_[i].heap_pos = NONE;
+        }
+    }
+
+    AddResult add(uint32_t task_id, uint64_t target_us, uint64_t interval_us, Function&& function)
+    {
+        if (find(task_id) != NONE)
+        {
+            return AddResult::DUPLICATE_ID;
+        }
+        if (size_ >= CAPACITY)
+        {
+            return AddResult::FULL;
+        }
+
+        uint8_t slot_idx = 0;
+        while (slots_[slot_idx].heap_pos != NONE)
+        {
+            ++slot_idx;
+        }
+
+        Slot& slot = slots_[slot_idx];
+        slot.task_id = task_id;
+        slot.target_us = target_us;
+        slot.interval_us = interval_us;
+        slot.function = std::move(function);
+
+        slot.heap_pos = size_;
+        heap_[size_++] = slot_idx;
+        sift_up(slot.heap_pos);
+        return AddResult::OK;
+    }
+
+    bool cancel(uint32_t task_id)
+    {
+        const uint8_t slot_idx = find(task_id);
+        if (slot_idx == NONE)
+        {
+            return false;
+        }
+        remove_at(slots_[slot_idx].heap_pos);
+        return true;
+    }
+
+    inline bool empty() const { return size_ == 0; }
+    inline uint8_t size() const { return size_; }
+
+    //Only valid if not empty
+    inline uint64_t next_target() const
+    {
+        return slots_[heap_[0]].target_us;
+    }
+
+    //Takes the earliest task if it's due, a repeating task stays queued and a copy is returned.
+    //Returns false if nothing is due
+    bool pop_due(uint64_t now_us, Function& function)
+    {
+        if (size_ == 0 || slots_[heap_[0]].target_us > now_us)
+        {
+            return false;
+        }
+
+        Slot& slot = slots_[heap_[0]];
+        if (slot.interval_us == 0)
+        {
+            function = std::move(slot.function);
+            remove_at(0);
+            return true;
+        }
+
+        function = slot.function;
+        slot.target_us += slot.interval_us;
+        if (slot.target_us <= now_us)
+        {
+            //Fell more than an interval behind (suspended), skip the missed runs instead of bursting them
+            slot.target_us = now_us + slot.interval_us;
+        }
+        sift_down(0);
+        return true;
+    }
+
+    //Pushes every target back by elapsed_us, but no earlier than min_target_us.
+    //Both are monotonic so heap order holds
+    void shift(uint64_t elapsed_us, uint64_t min_target_us)
+    {
+        for (uint8_t i = 0; i < size_; ++i)
+        {
+            Slot& slot = slots_[heap_[i]];
+            slot.target_us += elapsed_us;
+            if (slot.target_us < min_target_us)
+            {
+                slot.target_us = min_target_us;
+            }
+        }
+    }
+
+private:
+    static constexpr uint8_t NONE = 0xFF;
+
+    struct Slot
+    {
+        uint32_t task_id{0};
+        uint8_t heap_pos{NONE};
+        uint64_t target_us{0};
+        uint64_t interval_us{0};
+        Function function;
+    };
+
+    std::array<Slot, CAPACITY> slots_;
+    std::array<uint8_t, CAPACITY> heap_{0};
+    uint8_t size_{0};
+
+    inline uint8_t find(uint32_t task_id) const
+    {
+        for (uint8_t i = 0; i < size_; ++i)
+        {
+            if (slots_[heap_[i]].task_id == task_id)
+            {
+                return heap_[i];
+            }
+        }
+        return NONE;
+    }
+
+    inline bool earlier(uint8_t pos_a, uint8_t pos_b) const
+    {
+        return slots_[heap_[pos_a]].target_us < slots_[heap_[pos_b]].target_us;
+    }
+
+    inline void swap_pos(uint8_t pos_a, uint8_t pos_b)
+    {
+        std::swap(heap_[pos_a], heap_[pos_b]);
+        slots_[heap_[pos_a]].heap_pos = pos_a;
+        slots_[heap_[pos_b]].heap_pos = pos_b;
+    }
+
+    void sift_up(uint8_t pos)
+    {
+        while (pos > 0)
+        {
+            const uint8_t parent = static_cast<uint8_t>((pos - 1) / 2);
+            if (!earlier(pos, parent))
+            {
+                break;
+            }
+            swap_pos(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void sift_down(uint8_t pos)
+    {
+        while (true)
+        {
+            const uint32_t left = 2u * pos + 1;
+            const uint32_t right = left + 1;
+            uint8_t smallest = pos;
+
+            if (left < size_ && earlier(static_cast<uint8_t>(left), smallest))
+            {
+                smallest = static_cast<uint8_t>(left);
+            }
+            if (right < size_ && earlier(static_cast<uint8_t>(right), smallest))
+            {
+                smallest = static_cast<uint8_t>(right);
+            }
+            if (smallest == pos)
+            {
+                break;
+            }
+            swap_pos(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    void remove_at(uint8_t pos)
+    {
+        Slot& slot = slots_[heap_[pos]];
+        slot.function = nullptr;
+        slot.task_id = 0;
+        slot.heap_pos = NONE;
+
+        --size_;
+        if (pos == size_)
+        {
+            return;
+        }
+
+        const uint8_t moved_idx = heap_[size_];
+        heap_[pos] = moved_idx;
+        slots_[moved_idx].heap_pos = pos;
+
+        //The moved entry can belong above or below where it landed
+        sift_up(pos);
+        sift_down(slots_[moved_idx].heap_pos);
+    }
+};
+
+#endif // _TASK_HEAP_H_
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "TaskQueue/TaskQueue.h"
 
 TaskQueue::TaskQueue(CoreNum core_num) 
@@ -19,121 +21,118 @@ uint32_t TaskQueue::get_new_task_id()
     return new_task_id_++;
 }
 
-bool TaskQueue::queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, const std::function<void()>& function)
+bool TaskQueue::queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, TaskFunction&& function)
 {
-    uint32_t irq_state = spin_lock_blocking(spinlock_delayed_);
-    for (const auto& task : task_queue_delayed_) 
-    {
-        if (task.task_id == task_id)
-        {
-            spin_unlock(spinlock_delayed_, irq_state);
-            return false;
-        }
-    }
+    const uint64_t delay_us = static_cast<uint64_t>(delay_ms) * 1000;
 
-    hw_set_bits(&timer_hw->inte, 1u << alarm_num_);
-
-    //Might come back to this, there is overflow potential
-    uint64_t target_time = timer_hw->timerawl + static_cast<uint64_t>(delay_ms) * 1000;
+    uint32_t irq_state = spin_lock_blocking(spinlock_delayed_);
 
-    for (auto& task : task_queue_delayed_) 
+    auto result = task_queue_delayed_.add(task_id, get_time_64_us() + delay_us, repeating ? delay_us : 0, std::move(function));
+    switch (result)
     {
-        if (!task.function) 
-        {
-            task.target_time = target_time;
-            task.interval_ms = repeating ? delay_ms : 0;
-            task.function = function;
-            task.task_id = task_id;
-
-            auto it = std::min_element(task_queue_delayed_.begin(), task_queue_delayed_.end(), [](const DelayedTask& a, const DelayedTask& b) 
+        case TaskHeap<TaskFunction, MAX_DELAYED_TASKS>::AddResult::OK:
+            stats_.delayed_peak = std::max(stats_.delayed_peak, task_queue_delayed_.size());
+            if (!suspended_)
             {
-                return a.function && (!b.function || a.target_time < b.target_time);
-            });
-
-            if (it != task_queue_delayed_.end() && it->function) 
-            {
-                timer_hw->alarm[alarm_num_] = static_cast<uint32_t>(it->target_time);
+                set_alarm_unsafe();
             }
-
-            spin_unlock(spinlock_delayed_, irq_state);
-            return true;
-        }
+            break;
+        case TaskHeap<TaskFunction, MAX_DELAYED_TASKS>::AddResult::FULL:
+            ++stats_.delayed_full;
+            break;
+        case TaskHeap<TaskFunction, MAX_DELAYED_TASKS>::AddResult::DUPLICATE_ID:
+            ++stats_.duplicate_id;
+            break;
     }
 
     spin_unlock(spinlock_delayed_, irq_state);
-    return false;
+    return result == TaskHeap<TaskFunction, MAX_DELAYED_TASKS>::AddResult::OK;
 }
 
 void TaskQueue::cancel_delayed_task(uint32_t task_id)
 {
     uint32_t irq_state = spin_lock_blocking(spinlock_delayed_);
-    bool found = false;
-
-    for (auto& task : task_queue_delayed_) 
+    if (task_queue_delayed_.cancel(task_id) && !suspended_)
     {
-        if (task.task_id == task_id) 
-        {
-            task.function = nullptr;
-            task.task_id = 0;
-            task.interval_ms = 0;
-            found = true;
-        }
+        set_alarm_unsafe();
     }
+    spin_unlock(spinlock_delayed_, irq_state);
+}
 
-    if (!found)
+bool TaskQueue::queue_task(TaskFunction&& function)
+{
+    uint32_t irq_state = spin_lock_blocking(spinlock_queue_);
+    if (queue_count_ >= MAX_TASKS)
     {
-        spin_unlock(spinlock_delayed_, irq_state);
-        return;
+        ++stats_.queue_full;
+        spin_unlock(spinlock_queue_, irq_state);
+        return false;
     }
 
-    hw_set_bits(&timer_hw->inte, 1u << alarm_num_);
+    task_queue_[(queue_head_ + queue_count_) % MAX_TASKS] = std::move(function);
+    ++queue_count_;
+    stats_.queue_peak = std::max(stats_.queue_peak, queue_count_);
 
-    int64_t next_target_time = get_next_target_time_unsafe(task_queue_delayed_);
-    if (next_target_time >= 0) 
-    {
-        timer_hw->alarm[alarm_num_] = static_cast<uint32_t>(next_target_time);
-    }
-    
-    spin_unlock(spinlock_delayed_, irq_state);
+    spin_unlock(spinlock_queue_, irq_state);
+    //Tasks queued from the other core wake one waiting in board_api::wait_for_work
+    __sev();
+    return true;
 }
 
-bool TaskQueue::queue_task(const std::function<void()>& function)
+//Runs what was queued when called, tasks queued while running wait for the next call
+void TaskQueue::process_tasks()
 {
     uint32_t irq_state = spin_lock_blocking(spinlock_queue_);
-    for (auto& task : task_queue_)
+    uint8_t pending = queue_count_;
+
+    while (pending-- > 0 && queue_count_ > 0)
     {
-        if (!task.function)
-        {
-            task.function = function;
-            spin_unlock(spinlock_queue_, irq_state);
-            return true;
-        }
+        TaskFunction function = std::move(task_queue_[queue_head_]);
+        queue_head_ = static_cast<uint8_t>((queue_head_ + 1) % MAX_TASKS);
+        --queue_count_;
+        spin_unlock(spinlock_queue_, irq_state);
+
+        function();
+
+        irq_state = spin_lock_blocking(spinlock_queue_);
     }
     spin_unlock(spinlock_queue_, irq_state);
-    return false;
 }
 
-void TaskQueue::process_tasks()
+//Queue counters are written under spinlock_queue_, delayed counters under spinlock_delayed_
+TaskQueue::Stats TaskQueue::get_stats()
 {
+    Stats stats;
     uint32_t irq_state = spin_lock_blocking(spinlock_queue_);
-    for (auto& task : task_queue_)
+    stats.queue_full = stats_.queue_full;
+    stats.queue_peak = stats_.queue_peak;
+    spin_unlock(spinlock_queue_, irq_state);
+
+    irq_state = spin_lock_blocking(spinlock_delayed_);
+    stats.delayed_full = stats_.delayed_full;
+    stats.duplicate_id = stats_.duplicate_id;
+    stats.delayed_peak = stats_.delayed_peak;
+    spin_unlock(spinlock_delayed_, irq_state);
+    return stats;
+}
+
+//Call with spinlock_delayed_ held
+void TaskQueue::set_alarm_unsafe()
+{
+    if (task_queue_delayed_.empty())
     {
-        if (task.function)
-        {
-            auto function = task.function;
-            task.function = nullptr;
-            spin_unlock(spinlock_queue_, irq_state);
-
-            function();
-
-            irq_state = spin_lock_blocking(spinlock_queue_);
-        }
-        else
-        {
-            break; //No more tasks
-        }
+        return;
+    }
+
+    const uint64_t target = std::min(task_queue_delayed_.next_target(), get_time_64_us() + MAX_ALARM_SPAN_US);
+    timer_hw->alarm[alarm_num_] = static_cast<uint32_t>(target);
+
+    //If the target passed before the alarm was armed the 32 bit compare won't match 
+    //until the counter wraps, force the IRQ instead
+    if (get_time_64_us() >= target)
+    {
+        hw_set_bits(&timer_hw->intf, 1u << alarm_num_);
     }
-    spin_unlock(spinlock_queue_, irq_state);
 }
 
 uint64_t TaskQueue::get_time_64_us()
@@ -153,6 +152,7 @@ uint64_t TaskQueue::get_time_64_us()
 
 void TaskQueue::timer_irq_handler()
 {
+    hw_clear_bits(&timer_hw->intf, 1u << alarm_num_);
     hw_clear_bits(&timer_hw->intr, 1u << alarm_num_);
 
     uint64_t now = get_time_64_us();
@@ -163,33 +163,15 @@ void TaskQueue::timer_irq_handler()
         return;
     }
 
-    for (auto& task : task_queue_delayed_) 
+    TaskFunction function;
+    while (task_queue_delayed_.pop_due(now, function))
     {
-        if (task.function && task.target_time <= now) 
-        {
-            auto function = task.function;
-            if (task.interval_ms) 
-            {
-                task.target_time += (task.interval_ms * 1000);
-            } 
-            else 
-            {
-                task.function = nullptr;
-                task.task_id = 0;
-            }
-
-            spin_unlock(spinlock_delayed_, irq_state);
-            queue_task(function);
-            irq_state = spin_lock_blocking(spinlock_delayed_);
-        }
-    }
-
-    int64_t next_target_time = get_next_target_time_unsafe(task_queue_delayed_);
-    if (next_target_time >= 0) 
-    {
-        timer_hw->alarm[alarm_num_] = static_cast<uint32_t>(next_target_time);
+        spin_unlock(spinlock_delayed_, irq_state);
+        queue_task(std::move(function));
+        irq_state = spin_lock_blocking(spinlock_delayed_);
     }
 
+    set_alarm_unsafe();
     spin_unlock(spinlock_delayed_, irq_state);
 }
 
@@ -233,20 +215,8 @@ void TaskQueue::resume_delayed()
     }
 
     uint64_t now = get_time_64_us();
-    uint64_t elapsed_time = now - suspended_time_;
-
-    for (auto& task : task_queue_delayed_) 
-    {
-        if (task.function) 
-        {
-            task.target_time = std::max(task.target_time + elapsed_time, now + 10);
-        }
-    }
-    int64_t next_target_time = get_next_target_time_unsafe(task_queue_delayed_);
-    if (next_target_time >= 0) 
-    {
-        timer_hw->alarm[alarm_num_] = static_cast<uint32_t>(next_target_time);
-    }
+    task_queue_delayed_.shift(now - suspended_time_, now + 10);
+    set_alarm_unsafe();
     suspended_ = false;
     spin_unlock(spinlock_delayed_, irq_state);
 }
\ No newline at end of file
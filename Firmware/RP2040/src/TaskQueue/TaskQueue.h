@@ -2,18 +2,34 @@
 #define TASK_QUEUE_H
 
 #include <cstdint>
-#include <functional>
-#include <memory>
+#include <array>
+#include <utility>
 #include <pico/stdlib.h>
 #include <hardware/timer.h>
 #include <hardware/irq.h>
 #include <hardware/sync.h>
 
 #include "Board/Config.h"
+#include "TaskQueue/InlineFunction.h"
+#include "TaskQueue/TaskHeap.h"
 
 class TaskQueue
 {
 public:
+    //Tasks are stored inline, lambdas can capture up to this much
+    static constexpr size_t MAX_CAPTURE_BYTES = 4 * sizeof(void*);
+    using TaskFunction = InlineFunction<MAX_CAPTURE_BYTES>;
+
+    //Counters only go up, queue_task/queue_delayed_task still return false when they're hit
+    struct Stats
+    {
+        uint32_t queue_full{0};
+        uint32_t delayed_full{0};
+        uint32_t duplicate_id{0};
+        uint8_t queue_peak{0};
+        uint8_t delayed_peak{0};
+    };
+
     struct Core0
     {
         static inline uint32_t get_new_task_id()
@@ -24,13 +40,15 @@ public:
         {
             get_core0().cancel_delayed_task(task_id);
         }
-        static inline bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, const std::function<void()>& function)
+        template <typename F>
+        static inline bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, F&& function)
         {
-            return get_core0().queue_delayed_task(task_id, delay_ms, repeating, function);
+            return get_core0().queue_delayed_task(task_id, delay_ms, repeating, TaskFunction(std::forward<F>(function)));
         }
-        static inline bool queue_task(const std::function<void()>& function)
+        template <typename F>
+        static inline bool queue_task(F&& function)
         {
-            return get_core0().queue_task(function);
+            return get_core0().queue_task(TaskFunction(std::forward<F>(function)));
         }
         static inline void process_tasks()
         {
@@ -44,6 +62,10 @@ public:
         {
             get_core0().resume_delayed();
         }
+        static inline Stats stats()
+        {
+            return get_core0().get_stats();
+        }
     };
 
 #if (OGXM_BOARD != PI_PICOW) //BTstack uses core1
@@ -57,13 +79,15 @@ public:
         {
             get_core1().cancel_delayed_task(task_id);
         }
-        static inline bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, const std::function<void()>& function)
+        template <typename F>
+        static inline bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, F&& function)
         {
-            return get_core1().queue_delayed_task(task_id, delay_ms, repeating, function);
+            return get_core1().queue_delayed_task(task_id, delay_ms, repeating, TaskFunction(std::forward<F>(function)));
         }
-        static inline bool queue_task(const std::function<void()>& function)
+        template <typename F>
+        static inline bool queue_task(F&& function)
         {
-            return get_core1().queue_task(function);
+            return get_core1().queue_task(TaskFunction(std::forward<F>(function)));
         }
         static inline void process_tasks()
         {
@@ -77,6 +101,10 @@ public:
         {
             get_core1().resume_delayed();
         }
+        static inline Stats stats()
+        {
+            return get_core1().get_stats();
+        }
     }; // Core1
 #endif // OGXM_BOARD != PI_PICOW
 
@@ -97,22 +125,10 @@ private:
     TaskQueue(CoreNum core_num);
     ~TaskQueue() = default;
 
-    struct Task
-    {
-        // uint32_t task_id = 0;
-        std::function<void()> function = nullptr;
-    };
-
-    struct DelayedTask
-    {
-        uint32_t task_id = 0;
-        uint32_t interval_ms = 0;
-        uint64_t target_time = 0;
-        std::function<void()> function = nullptr;
-    };
-
     static constexpr uint8_t MAX_TASKS = 8;
     static constexpr uint8_t MAX_DELAYED_TASKS = MAX_TASKS * 2;
+    //The alarm compares the low 32 bits of the timer, never arm it further out than this
+    static constexpr uint64_t MAX_ALARM_SPAN_US = 1ull << 31;
 
     // CoreNum core_num_;
     uint32_t alarm_num_;
@@ -126,8 +142,14 @@ private:
     spin_lock_t* spinlock_queue_ = spin_lock_instance(static_cast<uint>(spinlock_queue_num_));
     spin_lock_t* spinlock_delayed_ = spin_lock_instance(static_cast<uint>(spinlock_delayed_num_));
 
-    std::array<Task, MAX_TASKS> task_queue_;
-    std::array<DelayedTask, MAX_DELAYED_TASKS> task_queue_delayed_;
+    //FIFO ring
+    std::array<TaskFunction, MAX_TASKS> task_queue_;
+    uint8_t queue_head_ = 0;
+    uint8_t queue_count_ = 0;
+
+    TaskHeap<TaskFunction, MAX_DELAYED_TASKS> task_queue_delayed_;
+
+    Stats stats_;
 
     static TaskQueue& get_core0()
     {
@@ -141,14 +163,16 @@ private:
     }
 
     uint32_t get_new_task_id();
-    bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, const std::function<void()>& function);
+    bool queue_delayed_task(uint32_t task_id, uint32_t delay_ms, bool repeating, TaskFunction&& function);
     void cancel_delayed_task(uint32_t task_id);
-    bool queue_task(const std::function<void()>& function);
+    bool queue_task(TaskFunction&& function);
     void process_tasks();
+    Stats get_stats();
 
     void suspend_delayed();
     void resume_delayed();
     void timer_irq_handler();
+    void set_alarm_unsafe();
     static uint64_t get_time_64_us();
 
     static inline void timer_irq_wrapper_c0()
@@ -163,20 +187,6 @@ private:
     {
         return timer_hardware_alarm_get_irq_num(timer_hw, alarm_num);
     }
-    static inline int64_t get_next_target_time_unsafe(std::array<DelayedTask, MAX_DELAYED_TASKS>& task_queue_delayed)
-    {
-        auto it = std::min_element(task_queue_delayed.begin(), task_queue_delayed.end(), [](const DelayedTask& a, const DelayedTask& b) 
-        {
-            //Get task with the earliest target time
-            return a.function && (!b.function || a.target_time < b.target_time);
-        });
-
-        if (it != task_queue_delayed.end() && it->function) 
-        {
-            return static_cast<int64_t>(it->target_time);
-        }
-        return -1;
-    }
 
 }; // class TaskQueue
 
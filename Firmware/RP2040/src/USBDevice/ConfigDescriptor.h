@@ -0,0 +1,99 @@
+#ifndef _CONFIG_DESCRIPTOR_H_
+#define _CONFIG_DESCRIPTOR_H_
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+
+/*  Configuration descriptor built once at DeviceManager::initialize_driver from the driver's
+    static one in Descriptors/, with the poll interval of the profile written into it.
+
+    bInterval is set on every interrupt endpoint of the interfaces matching the first one's
+    class/subclass/protocol, so all the gamepad interfaces of DInput/Switch get it but XInput's
+    audio and security interfaces are left alone. The RP2040 is full speed, bInterval is in ms.
+    A descriptor that doesn't fit or doesn't parse is served unchanged. */
+
+class ConfigDescriptor
+{
+public:
+    static constexpr uint16_t MAX_LEN = 256;
+
+    //0 leaves the template's intervals alone
+    static constexpr bool valid_interval(uint8_t interval_ms)
+    {
+        return (interval_ms == 1) || (interval_ms == 2) || (interval_ms == 4) || (interval_ms == 8);
+    }
+
+    //Returns false if the template is served as is
+    bool build(const uint8_t* desc, uint8_t interval_ms)
+    {
+        built_ = false;
+        in_endpoint_ = 0;
+        if (!desc || desc[1] != DESC_CONFIGURATION)
+        {
+            return false;
+        }
+
+        const uint16_t total_len = static_cast<uint16_t>(desc[2] | (desc[3] << 8));
+        if (total_len > MAX_LEN || total_len < desc[0])
+        {
+            return false;
+        }
+        std::memcpy(buffer_.data(), desc, total_len);
+
+        uint32_t gamepad_itf = NO_INTERFACE;
+        bool patch = false;
+
+        for (uint16_t offset = buffer_[0]; offset + 2 <= total_len; )
+        {
+            uint8_t* sub = &buffer_[offset];
+            if (sub[0] < 2 || offset + sub[0] > total_len)
+            {
+                in_endpoint_ = 0;
+                return false;
+            }
+
+            if (sub[1] == DESC_INTERFACE && sub[0] >= 9)
+            {
+                const uint32_t itf = (sub[5] << 16) | (sub[6] << 8) | sub[7];
+                gamepad_itf = (gamepad_itf == NO_INTERFACE) ? itf : gamepad_itf;
+                patch = (itf == gamepad_itf);
+            }
+            else if (sub[1] == DESC_ENDPOINT && sub[0] >= 7 && patch && (sub[3] & 0x03) == XFER_INTERRUPT)
+            {
+                if ((sub[2] & DIR_IN) && !in_endpoint_)
+                {
+                    in_endpoint_ = sub[2];
+                }
+                if (valid_interval(interval_ms))
+                {
+                    sub[6] = interval_ms;
+                }
+            }
+            offset += sub[0];
+        }
+
+        built_ = true;
+        return true;
+    }
+
+    //The template if build failed
+    const uint8_t* get(const uint8_t* desc) const { return built_ ? buffer_.data() : desc; }
+
+    //First interrupt IN endpoint of the gamepad interface, 0 if none
+    uint8_t in_endpoint() const { return in_endpoint_; }
+
+private:
+    static constexpr uint8_t DESC_CONFIGURATION = 0x02;
+    static constexpr uint8_t DESC_INTERFACE = 0x04;
+    static constexpr uint8_t DESC_ENDPOINT = 0x05;
+    static constexpr uint8_t XFER_INTERRUPT = 0x03;
+    static constexpr uint8_t DIR_IN = 0x80;
+    static constexpr uint32_t NO_INTERFACE = 0xFFFFFFFF;
+
+    std::array<uint8_t, MAX_LEN> buffer_{0};
+    uint8_t in_endpoint_{0};
+    bool built_{false};
+};
+
+#endif // _CONFIG_DESCRIPTOR_H_
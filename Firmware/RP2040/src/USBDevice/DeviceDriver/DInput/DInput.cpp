@@ -5,6 +5,23 @@
 #include "Descriptors/PS3.h"
 #include "USBDevice/DeviceDriver/DInput/DInput.h"
 
+static constexpr DeviceMap<3> BUTTON_MAP = DeviceMap<3>()
+    .hat(2, DInput::DPAD_MASK,
+        {   DInput::DPad::UP, DInput::DPad::UP_RIGHT, DInput::DPad::RIGHT, DInput::DPad::DOWN_RIGHT,
+            DInput::DPad::DOWN, DInput::DPad::DOWN_LEFT, DInput::DPad::LEFT, DInput::DPad::UP_LEFT }, DInput::DPad::CENTER)
+    .button(Gamepad::BUTTON_A,     0, DInput::Buttons0::CROSS)
+    .button(Gamepad::BUTTON_B,     0, DInput::Buttons0::CIRCLE)
+    .button(Gamepad::BUTTON_X,     0, DInput::Buttons0::SQUARE)
+    .button(Gamepad::BUTTON_Y,     0, DInput::Buttons0::TRIANGLE)
+    .button(Gamepad::BUTTON_LB,    0, DInput::Buttons0::L1)
+    .button(Gamepad::BUTTON_RB,    0, DInput::Buttons0::R1)
+    .button(Gamepad::BUTTON_L3,    1, DInput::Buttons1::L3)
+    .button(Gamepad::BUTTON_R3,    1, DInput::Buttons1::R3)
+    .button(Gamepad::BUTTON_BACK,  1, DInput::Buttons1::SELECT)
+    .button(Gamepad::BUTTON_START, 1, DInput::Buttons1::START)
+    .button(Gamepad::BUTTON_SYS,   1, DInput::Buttons1::SYS)
+    .button(Gamepad::BUTTON_MISC,  1, DInput::Buttons1::TP);
+
 bool DInputDevice::control_xfer_cb(uint8_t rhport, uint8_t stage, tusb_control_request_t const * request)
 {
 	if (request->bmRequestType == 0xA1 &&
@@ -44,56 +61,13 @@ void DInputDevice::process(const uint8_t idx, Gamepad& gamepad)
 {
     DInput::InReport& in_report = in_reports_[idx];
 
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
-
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:
-                in_report.dpad = DInput::DPad::UP;
-                break;
-            case Gamepad::DPAD_DOWN:
-                in_report.dpad = DInput::DPad::DOWN;
-                break;
-            case Gamepad::DPAD_LEFT:
-                in_report.dpad = DInput::DPad::LEFT;
-                break;
-            case Gamepad::DPAD_RIGHT:
-                in_report.dpad = DInput::DPad::RIGHT;
-                break;
-            case Gamepad::DPAD_UP_LEFT:
-                in_report.dpad = DInput::DPad::UP_LEFT;
-                break;
-            case Gamepad::DPAD_UP_RIGHT:
-                in_report.dpad = DInput::DPad::UP_RIGHT;
-                break;
-            case Gamepad::DPAD_DOWN_LEFT:
-                in_report.dpad = DInput::DPad::DOWN_LEFT;
-                break;
-            case Gamepad::DPAD_DOWN_RIGHT:
-                in_report.dpad = DInput::DPad::DOWN_RIGHT;
-                break;
-            default:
-                in_report.dpad = DInput::DPad::CENTER;
-                break;
-        }
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
 
         std::memset(in_report.buttons, 0, sizeof(in_report.buttons));
-
-        if (gp_in.buttons & Gamepad::BUTTON_A)   in_report.buttons[0] |= DInput::Buttons0::CROSS;
-        if (gp_in.buttons & Gamepad::BUTTON_B)   in_report.buttons[0] |= DInput::Buttons0::CIRCLE;
-        if (gp_in.buttons & Gamepad::BUTTON_X)   in_report.buttons[0] |= DInput::Buttons0::SQUARE;
-        if (gp_in.buttons & Gamepad::BUTTON_Y)   in_report.buttons[0] |= DInput::Buttons0::TRIANGLE;
-        if (gp_in.buttons & Gamepad::BUTTON_LB)  in_report.buttons[0] |= DInput::Buttons0::L1;
-        if (gp_in.buttons & Gamepad::BUTTON_RB)  in_report.buttons[0] |= DInput::Buttons0::R1;
-
-        if (gp_in.buttons & Gamepad::BUTTON_L3)    in_report.buttons[1] |= DInput::Buttons1::L3;
-        if (gp_in.buttons & Gamepad::BUTTON_R3)    in_report.buttons[1] |= DInput::Buttons1::R3;
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)  in_report.buttons[1] |= DInput::Buttons1::SELECT;
-        if (gp_in.buttons & Gamepad::BUTTON_START) in_report.buttons[1] |= DInput::Buttons1::START;
-        if (gp_in.buttons & Gamepad::BUTTON_SYS)   in_report.buttons[1] |= DInput::Buttons1::SYS;
-        if (gp_in.buttons & Gamepad::BUTTON_MISC)  in_report.buttons[1] |= DInput::Buttons1::TP;
+        in_report.dpad = 0;
+        BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, &in_report);
 
         if (gamepad.analog_enabled())
         {
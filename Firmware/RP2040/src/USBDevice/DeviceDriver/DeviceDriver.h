@@ -2,12 +2,14 @@
 #define _DEVICE_DRIVER_H_
 
 #include <cstdint>
+#include <hardware/timer.h>
 
 #include "tusb.h"
 #include "class/hid/hid.h"
 #include "device/usbd_pvt.h"
 
 #include "Gamepad/Gamepad.h"
+#include "Board/latency_trace.h"
 
 #if CFG_TUSB_DEBUG >= CFG_TUD_LOG_LEVEL
     #define TUD_DRV_NAME(name) name
@@ -18,6 +20,9 @@
 class DeviceDriver
 {
 public:
+    //Destroyed on a live mode switch, DeviceManager::switch_driver
+    virtual ~DeviceDriver() = default;
+
     virtual void initialize() = 0;
     virtual void process(const uint8_t idx, Gamepad& gamepad) = 0;
     virtual uint16_t get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer, uint16_t req_len) = 0;
@@ -31,10 +36,29 @@ public:
     
     const usbd_class_driver_t* get_class_driver() { return &class_driver_; };
 
+    //Turbo the mode runs through the Gamepad engine, DeviceManager hands it to every gamepad
+    virtual TurboEngine::ModeDefault mode_turbo() const { return TurboEngine::ModeDefault(); }
+
 protected:
     usbd_class_driver_t class_driver_;
 
     uint16_t* get_string_descriptor(const char* value, uint8_t index);
+
+    //Use this for the pad read that builds the device report so latency tracing sees it and turbo is applied
+    static inline Gamepad::PadIn read_pad_in(uint8_t idx, Gamepad& gamepad)
+    {
+        latency_trace::Stamp stamp;
+        Gamepad::PadIn pad_in = gamepad.get_pad_in(stamp);
+        latency_trace::device_read(idx, stamp);
+        gamepad.apply_turbo(pad_in, time_us_32());
+        return pad_in;
+    }
+
+    //New pad in, or a held turbo button changing, either way the report needs building
+    static inline bool pad_in_due(Gamepad& gamepad)
+    {
+        return gamepad.new_pad_in() || gamepad.turbo_due(time_us_32());
+    }
 };
 
 #endif // _DEVICE_DRIVER_H_
\ No newline at end of file
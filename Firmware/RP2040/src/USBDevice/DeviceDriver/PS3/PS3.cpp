@@ -3,6 +3,29 @@
 
 #include "USBDevice/DeviceDriver/PS3/PS3.h"
 
+static constexpr DeviceMap<3> BUTTON_MAP = DeviceMap<3>()
+    .hat(0, PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT | PS3::Buttons0::DPAD_RIGHT,
+        {   PS3::Buttons0::DPAD_UP,
+            PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_RIGHT,
+            PS3::Buttons0::DPAD_RIGHT,
+            PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_RIGHT,
+            PS3::Buttons0::DPAD_DOWN,
+            PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT,
+            PS3::Buttons0::DPAD_LEFT,
+            PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_LEFT }, 0)
+    .button(Gamepad::BUTTON_X,     1, PS3::Buttons1::SQUARE)
+    .button(Gamepad::BUTTON_A,     1, PS3::Buttons1::CROSS)
+    .button(Gamepad::BUTTON_Y,     1, PS3::Buttons1::TRIANGLE)
+    .button(Gamepad::BUTTON_B,     1, PS3::Buttons1::CIRCLE)
+    .button(Gamepad::BUTTON_LB,    1, PS3::Buttons1::L1)
+    .button(Gamepad::BUTTON_RB,    1, PS3::Buttons1::R1)
+    .button(Gamepad::BUTTON_BACK,  0, PS3::Buttons0::SELECT)
+    .button(Gamepad::BUTTON_START, 0, PS3::Buttons0::START)
+    .button(Gamepad::BUTTON_L3,    0, PS3::Buttons0::L3)
+    .button(Gamepad::BUTTON_R3,    0, PS3::Buttons0::R3)
+    .button(Gamepad::BUTTON_SYS,   2, PS3::Buttons2::SYS)
+    .button(Gamepad::BUTTON_MISC,  2, PS3::Buttons2::TP);
+
 void PS3Device::initialize() 
 {
 	class_driver_ = 
@@ -20,53 +43,12 @@ void PS3Device::initialize()
 
 void PS3Device::process(const uint8_t idx, Gamepad& gamepad) 
 {
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
         report_in_ = PS3::InReport();
 
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_UP;
-                break;
-            case Gamepad::DPAD_DOWN:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_DOWN;
-                break;
-            case Gamepad::DPAD_LEFT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_RIGHT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_RIGHT;
-                break;
-            case Gamepad::DPAD_UP_LEFT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_UP_RIGHT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_UP | PS3::Buttons0::DPAD_RIGHT;
-                break;
-            case Gamepad::DPAD_DOWN_LEFT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_DOWN_RIGHT:
-                report_in_.buttons[0] = PS3::Buttons0::DPAD_DOWN | PS3::Buttons0::DPAD_RIGHT;
-                break;
-            default:
-                break;
-        }
-
-        if (gp_in.buttons & Gamepad::BUTTON_X)        report_in_.buttons[1] |= PS3::Buttons1::SQUARE;
-        if (gp_in.buttons & Gamepad::BUTTON_A)        report_in_.buttons[1] |= PS3::Buttons1::CROSS;
-        if (gp_in.buttons & Gamepad::BUTTON_Y)        report_in_.buttons[1] |= PS3::Buttons1::TRIANGLE;
-        if (gp_in.buttons & Gamepad::BUTTON_B)        report_in_.buttons[1] |= PS3::Buttons1::CIRCLE;
-        if (gp_in.buttons & Gamepad::BUTTON_LB)       report_in_.buttons[1] |= PS3::Buttons1::L1;
-        if (gp_in.buttons & Gamepad::BUTTON_RB)       report_in_.buttons[1] |= PS3::Buttons1::R1;
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)     report_in_.buttons[0] |= PS3::Buttons0::SELECT;
-        if (gp_in.buttons & Gamepad::BUTTON_START)    report_in_.buttons[0] |= PS3::Buttons0::START;
-        if (gp_in.buttons & Gamepad::BUTTON_L3)       report_in_.buttons[0] |= PS3::Buttons0::L3;
-        if (gp_in.buttons & Gamepad::BUTTON_R3)       report_in_.buttons[0] |= PS3::Buttons0::R3;
-        if (gp_in.buttons & Gamepad::BUTTON_SYS)      report_in_.buttons[2] |= PS3::Buttons2::SYS;
-        if (gp_in.buttons & Gamepad::BUTTON_MISC)     report_in_.buttons[2] |= PS3::Buttons2::TP;
+        BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, report_in_.buttons);
 
         if (gp_in.trigger_l) report_in_.buttons[1] |= PS3::Buttons1::L2;
         if (gp_in.trigger_r) report_in_.buttons[1] |= PS3::Buttons1::R2;
@@ -5,56 +5,35 @@
 #include "pico/time.h"
 #include "USBDevice/DeviceDriver/PS4/PS4.h"
 
+// El dpad es un campo de 4 bits, se arma solo el hat y se copia al bitfield
+static constexpr DeviceMap<1> DPAD_MAP = DeviceMap<1>()
+    .hat(0, 0x0F,
+        {   PS4Dev::HAT_UP, PS4Dev::HAT_UP_RIGHT, PS4Dev::HAT_RIGHT, PS4Dev::HAT_DOWN_RIGHT,
+            PS4Dev::HAT_DOWN, PS4Dev::HAT_DOWN_LEFT, PS4Dev::HAT_LEFT, PS4Dev::HAT_UP_LEFT }, PS4Dev::HAT_CENTER);
+
 // ===================================================================
-// HELPERS: MATEMÁTICAS (sin cambios)
+// HELPERS: STICKS
 // ===================================================================
-static inline uint8_t map_signed_to_uint8(float signed_val)
+// Curvas propias del modo (zona muerta, curva, mezcla lineal, sensibilidad), el radio no
+// pasa de 1.0. Antes era pow(adj * sens, curve), que es sens^curve * adj^curve
+static constexpr OutputCurveRaw CURVE_L = { true, F16(0.016), F16(0.82), F16(0.0), F16(1.0651), false };
+static constexpr OutputCurveRaw CURVE_R = { true, F16(0.07),  F16(1.0),  F16(0.0), F16(1.02),   false };
+
+// -1.0..1.0 a 0..255 redondeando, los extremos (±0.99) saturan
+static inline uint8_t stick_to_uint8(int16_t value)
 {
-    if (signed_val >= 0.99f) return 255;
-    if (signed_val <= -0.99f) return 0;
-    float mapped = signed_val * 127.5f + 127.5f;
-    int out = static_cast<int>(std::round(mapped));
-    if (out < 0) out = 0;
-    if (out > 255) out = 255;
-    return static_cast<uint8_t>(out);
+    constexpr int32_t SATURATE = 32440;
+    if (value >= SATURATE) return 255;
+    if (value <= -SATURATE) return 0;
+    return static_cast<uint8_t>(((static_cast<int32_t>(value) + 32767) * 255 + 32767) / (2 * 32767));
 }
 
-static inline void apply_stick_steam_radial(int16_t in_x, int16_t in_y,
-                                            float deadzone_fraction, float sensitivity,
-                                            float curve,
-                                            uint8_t &out_x, uint8_t &out_y)
+static inline void shape_stick(const OutputCurve& curve, int16_t in_x, int16_t in_y, uint8_t& out_x, uint8_t& out_y)
 {
-    constexpr float INT16_MAX_F = 32767.0f;
-    float vx = static_cast<float>(in_x) / INT16_MAX_F;
-    float vy = static_cast<float>(in_y) / INT16_MAX_F;
-    float mag = std::sqrt(vx * vx + vy * vy);
-
-    if (mag <= deadzone_fraction || mag < 0.001f)
-    {
-        out_x = PS4Dev::JOYSTICK_MID;
-        out_y = PS4Dev::JOYSTICK_MID;
-        return;
-    }
-
-    if (mag > 1.0f) mag = 1.0f;
-    float adj = (mag - deadzone_fraction) / (1.0f - deadzone_fraction);
-    adj = std::fmax(0.0f, std::fmin(1.0f, adj));
-
-    float out_frac = adj * sensitivity;
-    if (curve != 1.0f) out_frac = std::pow(out_frac, curve);
-    if (out_frac > 1.0f) out_frac = 1.0f;
-
-    float scale = out_frac / mag;
-    float sx = vx * scale;
-    float sy = vy * scale;
-
-    if (sx > 1.0f) sx = 1.0f;
-    if (sx < -1.0f) sx = -1.0f;
-    if (sy > 1.0f) sy = 1.0f;
-    if (sy < -1.0f) sy = -1.0f;
-
-    out_x = map_signed_to_uint8(sx);
-    out_y = map_signed_to_uint8(sy);
+    int16_t shaped_x, shaped_y;
+    curve.shape(in_x, in_y, shaped_x, shaped_y);
+    out_x = stick_to_uint8(shaped_x);
+    out_y = stick_to_uint8(shaped_y);
 }
 
 // ===================================================================
@@ -72,6 +51,8 @@ void PS4Device::initialize()
         .xfer_cb = hidd_xfer_cb,
         .sof = nullptr
     };
+    curve_l_.compile(CURVE_L);
+    curve_r_.compile(CURVE_R);
 }
 
 void PS4Device::process(const uint8_t idx, Gamepad& gamepad)
@@ -89,7 +70,7 @@ void PS4Device::process(const uint8_t idx, Gamepad& gamepad)
     // ================== MODO TEST / DEBUG (para ver si el PC recibe algo) ==================
     static bool testMode = true;          // ←←← CAMBIA A false cuando quieras modo normal
 
-    Gamepad::PadIn gp_in = gamepad.get_pad_in();
+    Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
     const uint16_t btn = gp_in.buttons;
 
     std::memset(&report_in_, 0, sizeof(report_in_));
@@ -107,8 +88,8 @@ void PS4Device::process(const uint8_t idx, Gamepad& gamepad)
         int16_t fake_x = static_cast<int16_t>(32767.0f * radius * std::sin(angle));
         int16_t fake_y = static_cast<int16_t>(32767.0f * radius * std::cos(angle));
 
-        apply_stick_steam_radial(fake_x, fake_y, 0.0f, 1.0f, 1.0f,
-                                 report_in_.leftStickX, report_in_.leftStickY);
+        report_in_.leftStickX = stick_to_uint8(fake_x);
+        report_in_.leftStickY = stick_to_uint8(fake_y);
 
         // Botón X (Cross) presionado y soltado rápidamente
         report_in_.buttonSouth = (frame % 8 < 4) ? 1 : 0;   // parpadeo visible
@@ -134,33 +115,14 @@ void PS4Device::process(const uint8_t idx, Gamepad& gamepad)
         if (muteActive && time_reached(muteEndTime)) muteActive = false;
 
         // Sticks
-        constexpr float left_deadzone   = 0.016f;
-        constexpr float left_sensitivity = 1.08f;
-        constexpr float left_curve      = 0.82f;
-        constexpr float right_deadzone  = 0.07f;
-        constexpr float right_sensitivity = 1.02f;
+        const OutputCurve& curve_l = gamepad.output_curve_l().enabled() ? gamepad.output_curve_l() : curve_l_;
+        const OutputCurve& curve_r = gamepad.output_curve_r().enabled() ? gamepad.output_curve_r() : curve_r_;
 
-        apply_stick_steam_radial(gp_in.joystick_lx, gp_in.joystick_ly,
-                                 left_deadzone, left_sensitivity, left_curve,
-                                 report_in_.leftStickX, report_in_.leftStickY);
-
-        apply_stick_steam_radial(gp_in.joystick_rx, gp_in.joystick_ry,
-                                 right_deadzone, right_sensitivity, 1.0f,
-                                 report_in_.rightStickX, report_in_.rightStickY);
+        shape_stick(curve_l, gp_in.joystick_lx, gp_in.joystick_ly, report_in_.leftStickX, report_in_.leftStickY);
+        shape_stick(curve_r, gp_in.joystick_rx, gp_in.joystick_ry, report_in_.rightStickX, report_in_.rightStickY);
 
         // D-Pad
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:        report_in_.dpad = PS4Dev::HAT_UP;        break;
-            case Gamepad::DPAD_UP_RIGHT:  report_in_.dpad = PS4Dev::HAT_UP_RIGHT;  break;
-            case Gamepad::DPAD_RIGHT:     report_in_.dpad = PS4Dev::HAT_RIGHT;     break;
-            case Gamepad::DPAD_DOWN_RIGHT:report_in_.dpad = PS4Dev::HAT_DOWN_RIGHT;break;
-            case Gamepad::DPAD_DOWN:      report_in_.dpad = PS4Dev::HAT_DOWN;      break;
-            case Gamepad::DPAD_DOWN_LEFT: report_in_.dpad = PS4Dev::HAT_DOWN_LEFT; break;
-            case Gamepad::DPAD_LEFT:      report_in_.dpad = PS4Dev::HAT_LEFT;      break;
-            case Gamepad::DPAD_UP_LEFT:   report_in_.dpad = PS4Dev::HAT_UP_LEFT;   break;
-            default:                      report_in_.dpad = PS4Dev::HAT_CENTER;     break;
-        }
+        report_in_.dpad = static_cast<uint8_t>(DPAD_MAP.map(0, gp_in.dpad));
 
         const bool baseSquare = (btn & Gamepad::BUTTON_X) != 0;
         const bool baseCircle = (btn & Gamepad::BUTTON_B) != 0;
@@ -32,6 +32,8 @@ public:
 
 private:
     PS4Dev::InReport report_in_;
+    OutputCurve curve_l_;
+    OutputCurve curve_r_;
 };
 
 #endif // _PS4_DEVICE_H_
@@ -2,6 +2,19 @@
 
 #include "USBDevice/DeviceDriver/PSClassic/PSClassic.h"
 
+static constexpr DeviceMap<2> BUTTON_MAP = DeviceMap<2>()
+    .hat(0, PSClassic::DPAD_MASK,
+        {   PSClassic::Buttons::UP, PSClassic::Buttons::UP_RIGHT, PSClassic::Buttons::RIGHT, PSClassic::Buttons::DOWN_RIGHT,
+            PSClassic::Buttons::DOWN, PSClassic::Buttons::DOWN_LEFT, PSClassic::Buttons::LEFT, PSClassic::Buttons::UP_LEFT }, PSClassic::Buttons::CENTER)
+    .button(Gamepad::BUTTON_A,     0, PSClassic::Buttons::CROSS)
+    .button(Gamepad::BUTTON_B,     0, PSClassic::Buttons::CIRCLE)
+    .button(Gamepad::BUTTON_X,     0, PSClassic::Buttons::SQUARE)
+    .button(Gamepad::BUTTON_Y,     0, PSClassic::Buttons::TRIANGLE)
+    .button(Gamepad::BUTTON_LB,    0, PSClassic::Buttons::L1)
+    .button(Gamepad::BUTTON_RB,    0, PSClassic::Buttons::R1)
+    .button(Gamepad::BUTTON_BACK,  0, PSClassic::Buttons::SELECT)
+    .button(Gamepad::BUTTON_START, 0, PSClassic::Buttons::START);
+
 void PSClassicDevice::initialize()
 {
 	class_driver_ = 
@@ -19,39 +32,10 @@ void PSClassicDevice::initialize()
 
 void PSClassicDevice::process(const uint8_t idx, Gamepad& gamepad)
 {
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:
-                in_report_.buttons = PSClassic::Buttons::UP;
-                break;
-            case Gamepad::DPAD_DOWN:
-                in_report_.buttons = PSClassic::Buttons::DOWN;
-                break;
-            case Gamepad::DPAD_LEFT:
-                in_report_.buttons = PSClassic::Buttons::LEFT;
-                break;
-            case Gamepad::DPAD_RIGHT:
-                in_report_.buttons = PSClassic::Buttons::RIGHT;
-                break;
-            case Gamepad::DPAD_UP_LEFT:
-                in_report_.buttons = PSClassic::Buttons::UP_LEFT;
-                break;
-            case Gamepad::DPAD_UP_RIGHT:
-                in_report_.buttons = PSClassic::Buttons::UP_RIGHT;
-                break;
-            case Gamepad::DPAD_DOWN_LEFT:
-                in_report_.buttons = PSClassic::Buttons::DOWN_LEFT;
-                break;
-            case Gamepad::DPAD_DOWN_RIGHT:
-                in_report_.buttons = PSClassic::Buttons::DOWN_RIGHT;
-                break;
-            default:
-                in_report_.buttons = PSClassic::Buttons::CENTER;
-                break;
-        }
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
+        uint8_t dpad = gp_in.dpad;
 
         int16_t joy_lx = gp_in.joystick_lx;
         int16_t joy_ly = Range::invert(gp_in.joystick_ly);
@@ -62,49 +46,43 @@ void PSClassicDevice::process(const uint8_t idx, Gamepad& gamepad)
         {
             if (meets_neg_45_threshold(joy_ly, joy_ry))
             {
-                in_report_.buttons = PSClassic::Buttons::DOWN_RIGHT;
+                dpad = Gamepad::DPAD_DOWN_RIGHT;
             }
             else if (meets_pos_45_threshold(joy_ly, joy_ry))
             {
-                in_report_.buttons = PSClassic::Buttons::UP_RIGHT;
+                dpad = Gamepad::DPAD_UP_RIGHT;
             }
             else
             {
-                in_report_.buttons = PSClassic::Buttons::RIGHT;
+                dpad = Gamepad::DPAD_RIGHT;
             }
         }
         else if (meets_neg_threshold(joy_lx, joy_rx))
         {
             if (meets_neg_45_threshold(joy_ly, joy_ry))
             {
-                in_report_.buttons = PSClassic::Buttons::DOWN_LEFT;
+                dpad = Gamepad::DPAD_DOWN_LEFT;
             }
             else if (meets_pos_45_threshold(joy_ly, joy_ry))
             {
-                in_report_.buttons = PSClassic::Buttons::UP_LEFT;
+                dpad = Gamepad::DPAD_UP_LEFT;
             }
             else
             {
-                in_report_.buttons = PSClassic::Buttons::LEFT;
+                dpad = Gamepad::DPAD_LEFT;
             }
         }
         else if (meets_neg_threshold(joy_ly, joy_ry))
         {
-            in_report_.buttons = PSClassic::Buttons::DOWN;
+            dpad = Gamepad::DPAD_DOWN;
         }
         else if (meets_pos_threshold(joy_ly, joy_ry))
         {
-            in_report_.buttons = PSClassic::Buttons::UP;
+            dpad = Gamepad::DPAD_UP;
         }
 
-        if (gp_in.buttons & Gamepad::BUTTON_A) in_report_.buttons |= PSClassic::Buttons::CROSS;
-        if (gp_in.buttons & Gamepad::BUTTON_B) in_report_.buttons |= PSClassic::Buttons::CIRCLE;
-        if (gp_in.buttons & Gamepad::BUTTON_X) in_report_.buttons |= PSClassic::Buttons::SQUARE;
-        if (gp_in.buttons & Gamepad::BUTTON_Y) in_report_.buttons |= PSClassic::Buttons::TRIANGLE;
-        if (gp_in.buttons & Gamepad::BUTTON_LB)    in_report_.buttons |= PSClassic::Buttons::L1;
-        if (gp_in.buttons & Gamepad::BUTTON_RB)    in_report_.buttons |= PSClassic::Buttons::R1;
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)  in_report_.buttons |= PSClassic::Buttons::SELECT;
-        if (gp_in.buttons & Gamepad::BUTTON_START) in_report_.buttons |= PSClassic::Buttons::START;
+        in_report_.buttons = 0;
+        BUTTON_MAP.apply(gp_in.buttons, dpad, &in_report_.buttons);
         
         if (gp_in.trigger_l) in_report_.buttons |= PSClassic::Buttons::L2;
         if (gp_in.trigger_r) in_report_.buttons |= PSClassic::Buttons::R2;
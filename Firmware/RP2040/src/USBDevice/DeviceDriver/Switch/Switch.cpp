@@ -2,6 +2,23 @@
 
 #include "USBDevice/DeviceDriver/Switch/Switch.h"
 
+static constexpr DeviceMap<3> BUTTON_MAP = DeviceMap<3>()
+    .hat(2, 0x0F,
+        {   SwitchWired::DPad::UP, SwitchWired::DPad::UP_RIGHT, SwitchWired::DPad::RIGHT, SwitchWired::DPad::DOWN_RIGHT,
+            SwitchWired::DPad::DOWN, SwitchWired::DPad::DOWN_LEFT, SwitchWired::DPad::LEFT, SwitchWired::DPad::UP_LEFT }, SwitchWired::DPad::CENTER)
+    .button(Gamepad::BUTTON_X,     0, SwitchWired::Buttons::Y)
+    .button(Gamepad::BUTTON_A,     0, SwitchWired::Buttons::B)
+    .button(Gamepad::BUTTON_Y,     0, SwitchWired::Buttons::X)
+    .button(Gamepad::BUTTON_B,     0, SwitchWired::Buttons::A)
+    .button(Gamepad::BUTTON_LB,    0, SwitchWired::Buttons::L)
+    .button(Gamepad::BUTTON_RB,    0, SwitchWired::Buttons::R)
+    .button(Gamepad::BUTTON_BACK,  0, SwitchWired::Buttons::MINUS)
+    .button(Gamepad::BUTTON_START, 0, SwitchWired::Buttons::PLUS)
+    .button(Gamepad::BUTTON_L3,    0, SwitchWired::Buttons::L3)
+    .button(Gamepad::BUTTON_R3,    0, SwitchWired::Buttons::R3)
+    .button(Gamepad::BUTTON_SYS,   0, SwitchWired::Buttons::HOME)
+    .button(Gamepad::BUTTON_MISC,  0, SwitchWired::Buttons::CAPTURE);
+
 void SwitchDevice::initialize() 
 {
 	class_driver_ = 
@@ -23,55 +40,13 @@ void SwitchDevice::process(const uint8_t idx, Gamepad& gamepad)
 {
     SwitchWired::InReport& in_report = in_report_[idx];
 
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
     
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:
-                in_report.dpad = SwitchWired::DPad::UP;
-                break;
-            case Gamepad::DPAD_DOWN:
-                in_report.dpad = SwitchWired::DPad::DOWN;
-                break;
-            case Gamepad::DPAD_LEFT:
-                in_report.dpad = SwitchWired::DPad::LEFT;
-                break;
-            case Gamepad::DPAD_RIGHT:
-                in_report.dpad = SwitchWired::DPad::RIGHT;
-                break;
-            case Gamepad::DPAD_UP_LEFT:
-                in_report.dpad = SwitchWired::DPad::UP_LEFT;
-                break;
-            case Gamepad::DPAD_UP_RIGHT:
-                in_report.dpad = SwitchWired::DPad::UP_RIGHT;
-                break;
-            case Gamepad::DPAD_DOWN_LEFT:
-                in_report.dpad = SwitchWired::DPad::DOWN_LEFT;
-                break;
-            case Gamepad::DPAD_DOWN_RIGHT:
-                in_report.dpad = SwitchWired::DPad::DOWN_RIGHT;
-                break;
-            default:
-                in_report.dpad = SwitchWired::DPad::CENTER;
-                break;
-        }
-
         in_report.buttons = 0;
-
-        if (gp_in.buttons & Gamepad::BUTTON_X)        in_report.buttons |= SwitchWired::Buttons::Y;
-        if (gp_in.buttons & Gamepad::BUTTON_A)        in_report.buttons |= SwitchWired::Buttons::B;
-        if (gp_in.buttons & Gamepad::BUTTON_Y)        in_report.buttons |= SwitchWired::Buttons::X;
-        if (gp_in.buttons & Gamepad::BUTTON_B)        in_report.buttons |= SwitchWired::Buttons::A;
-        if (gp_in.buttons & Gamepad::BUTTON_LB)       in_report.buttons |= SwitchWired::Buttons::L;
-        if (gp_in.buttons & Gamepad::BUTTON_RB)       in_report.buttons |= SwitchWired::Buttons::R;
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)     in_report.buttons |= SwitchWired::Buttons::MINUS;
-        if (gp_in.buttons & Gamepad::BUTTON_START)    in_report.buttons |= SwitchWired::Buttons::PLUS;
-        if (gp_in.buttons & Gamepad::BUTTON_L3)       in_report.buttons |= SwitchWired::Buttons::L3;
-        if (gp_in.buttons & Gamepad::BUTTON_R3)       in_report.buttons |= SwitchWired::Buttons::R3;
-        if (gp_in.buttons & Gamepad::BUTTON_SYS)      in_report.buttons |= SwitchWired::Buttons::HOME;
-        if (gp_in.buttons & Gamepad::BUTTON_MISC)     in_report.buttons |= SwitchWired::Buttons::CAPTURE;
+        in_report.dpad = 0;
+        BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, &in_report);
 
         if (gp_in.trigger_l) in_report.buttons |= SwitchWired::Buttons::ZL;
         if (gp_in.trigger_r) in_report.buttons |= SwitchWired::Buttons::ZR;
@@ -2,6 +2,7 @@
 #include "bsp/board_api.h"
 
 #include "Board/ogxm_log.h"
+#include "Board/latency_trace.h"
 #include "Descriptors/CDCDev.h"
 #include "USBDevice/DeviceDriver/WebApp/WebApp.h"
 
@@ -212,6 +213,30 @@ bool WebAppDevice::write_gamepad(uint8_t index, const Gamepad::PadIn& pad_in)
     return true;
 }
 
+//player_idx picks the set, 0 for this boot, 1 for the boot before the switch to WebApp mode.
+//device_driver in the reply is the mode the numbers were taken in
+bool WebAppDevice::write_latency(uint8_t set)
+{
+    latency_trace::Summary summaries[static_cast<uint8_t>(latency_trace::Stage::COUNT)];
+    static_assert(sizeof(summaries) <= sizeof(Packet::data), "WebApp latency summaries don't fit in a packet");
+
+    uint8_t driver_type = 0;
+    if (!latency_trace::get_summaries(static_cast<latency_trace::Set>(set), summaries, driver_type))
+    {
+        return false;
+    }
+
+    Packet packet_in;
+    packet_in.header.packet_id = PacketID::GET_LATENCY;
+    packet_in.header.device_driver = static_cast<DeviceDriverType>(driver_type);
+    packet_in.header.player_idx = set;
+    packet_in.header.chunks_total = 1;
+    packet_in.header.chunk_len = static_cast<uint8_t>(sizeof(summaries));
+
+    std::memcpy(packet_in.data.data(), summaries, sizeof(summaries));
+    return write_packet(packet_in);
+}
+
 void WebAppDevice::write_error()
 {
     Packet packet_in;
@@ -289,6 +314,21 @@ void WebAppDevice::process(const uint8_t idx, Gamepad& gamepad)
                 }
                 break;
 
+            case PacketID::GET_LATENCY:
+                OGXM_LOG("Getting latency trace set: %i\n", packet_out.header.player_idx);
+
+                if (packet_out.header.player_idx > static_cast<uint8_t>(latency_trace::Set::LAST_BOOT) ||
+                    !write_latency(packet_out.header.player_idx))
+                {
+                    write_error();
+                    return;
+                }
+                break;
+
+            case PacketID::RESET_LATENCY:
+                latency_trace::reset();
+                break;
+
             default:
                 // write_response(PacketID::RESP_ERROR);
                 return;
@@ -297,7 +337,7 @@ void WebAppDevice::process(const uint8_t idx, Gamepad& gamepad)
     else if (gamepad.new_pad_in())
     {
         OGXM_LOG("Writing gamepad input\n");
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
         write_gamepad(idx, gp_in);
     }
 }
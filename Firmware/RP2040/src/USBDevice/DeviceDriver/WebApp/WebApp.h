@@ -31,6 +31,8 @@ private:
         SET_PROFILE = 0x61,
         SET_GP_IN = 0x80,
         SET_GP_OUT = 0x81,
+        GET_LATENCY = 0x90,
+        RESET_LATENCY = 0x91,
         RESP_ERROR = 0xFF
     };
     
@@ -67,6 +69,7 @@ private:
     bool write_packet(const Packet& packet);
     bool write_profile(uint8_t index, const UserProfile& profile, PacketID packet_id);
     bool write_gamepad(uint8_t index, const Gamepad::PadIn& pad_in);
+    bool write_latency(uint8_t set);
     void write_error();  
 };
 
@@ -1,11 +1,38 @@
 #include <cstring>
-#include <cmath>
 #include <algorithm>
 #include "USBDevice/DeviceDriver/XInput/tud_xinput/tud_xinput.h"
 #include "USBDevice/DeviceDriver/XInput/XInput.h"
 
-// Variable estática para la velocidad del Turbo
-static uint32_t turbo_tick = 0;
+static constexpr DeviceMap<2> BUTTON_MAP = DeviceMap<2>()
+    .hat(0, XInput::Buttons0::DPAD_UP | XInput::Buttons0::DPAD_DOWN | XInput::Buttons0::DPAD_LEFT | XInput::Buttons0::DPAD_RIGHT,
+        {   XInput::Buttons0::DPAD_UP,
+            XInput::Buttons0::DPAD_UP | XInput::Buttons0::DPAD_RIGHT,
+            XInput::Buttons0::DPAD_RIGHT,
+            XInput::Buttons0::DPAD_DOWN | XInput::Buttons0::DPAD_RIGHT,
+            XInput::Buttons0::DPAD_DOWN,
+            XInput::Buttons0::DPAD_DOWN | XInput::Buttons0::DPAD_LEFT,
+            XInput::Buttons0::DPAD_LEFT,
+            XInput::Buttons0::DPAD_UP | XInput::Buttons0::DPAD_LEFT }, 0)
+    .button(Gamepad::BUTTON_BACK,  1, XInput::Buttons1::LB)
+    .button(Gamepad::BUTTON_MISC,  0, XInput::Buttons0::BACK)
+    .button(Gamepad::BUTTON_START, 0, XInput::Buttons0::START)
+    .button(Gamepad::BUTTON_L3,    0, XInput::Buttons0::L3)
+    .button(Gamepad::BUTTON_R3,    0, XInput::Buttons0::R3)
+    .button(Gamepad::BUTTON_X,     1, XInput::Buttons1::X)
+    .button(Gamepad::BUTTON_A,     1, XInput::Buttons1::A)
+    .button(Gamepad::BUTTON_Y,     1, XInput::Buttons1::Y)
+    .button(Gamepad::BUTTON_B,     1, XInput::Buttons1::B)
+    .button(Gamepad::BUTTON_RB,    1, XInput::Buttons1::RB)
+    .button(Gamepad::BUTTON_SYS,   1, XInput::Buttons1::HOME);
+
+// Curvas de los sticks del modo (zona muerta, gamma, mezcla lineal 20%, sensibilidad),
+// el perfil las reemplaza si trae las suyas
+static constexpr OutputCurveRaw CURVE_L = { true, F16(0.05), F16(1.6), F16(0.2), F16(1.10), true };
+static constexpr OutputCurveRaw CURVE_R = { true, F16(0.05), F16(1.5), F16(0.2), F16(1.10), true };
+
+// Turbo del modo: LB mantenido dispara A a 20 Hz, mitad del periodo pulsado.
+// Lo aplica el Gamepad, un turbo del perfil sobre LB lo reemplaza
+static constexpr TurboEngine::ModeDefault MODE_TURBO = { Gamepad::BUTTON_LB, Gamepad::BUTTON_A, 20, 8 };
 
 // Variable para el "Temblor" (Shake) del Aim Assist
 static bool shake_toggle = false; 
@@ -21,49 +48,6 @@ static inline int16_t clamp_int16(int32_t val) {
     return (int16_t)val;
 }
 
-static void apply_stick_curve_mixed(int16_t in_x, int16_t in_y, 
-                                   float deadzone, float gamma, float sensitivity,
-                                   int16_t &out_x, int16_t &out_y)
-{
-    constexpr float MAX_VAL = 32767.0f;
-
-    // 1. Normalizar
-    float vx = static_cast<float>(in_x) / MAX_VAL;
-    float vy = static_cast<float>(in_y) / MAX_VAL;
-
-    // 2. Magnitud
-    float mag = std::sqrt(vx*vx + vy*vy);
-
-    // 3. Deadzone
-    if (mag <= deadzone || mag < 0.001f) {
-        out_x = 0; out_y = 0; return;
-    }
-
-    if (mag > 1.0f) mag = 1.0f;
-
-    // 4. Mapeo y Curva Mixta
-    float adj = (mag - deadzone) / (1.0f - deadzone);
-    adj = std::fmax(0.0f, std::fmin(1.0f, adj));
-
-    float response_curve = std::pow(adj, gamma); 
-    float response_linear = adj;                  
-    
-    // Mezcla 80/20
-    float out_frac = (response_curve * 0.8f) + (response_linear * 0.2f);
-
-    // Sensibilidad
-    out_frac *= sensitivity; 
-
-    // 5. Reconstrucción Segura
-    float scale = out_frac / mag;
-    float final_x = vx * scale * MAX_VAL;
-    float final_y = vy * scale * MAX_VAL;
-
-    // Convertimos a int32 primero para poder clipear sin error
-    out_x = clamp_int16((int32_t)final_x);
-    out_y = clamp_int16((int32_t)final_y);
-}
-
 // --------------------------------------------------------------------------------
 // CLASE XINPUT
 // --------------------------------------------------------------------------------
@@ -71,51 +55,28 @@ static void apply_stick_curve_mixed(int16_t in_x, int16_t in_y,
 void XInputDevice::initialize() 
 {
     class_driver_ = *tud_xinput::class_driver();
+    curve_l_.compile(CURVE_L);
+    curve_r_.compile(CURVE_R);
+}
+
+TurboEngine::ModeDefault XInputDevice::mode_turbo() const
+{
+    return MODE_TURBO;
 }
 
 void XInputDevice::process(const uint8_t idx, Gamepad& gamepad)
 {
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
         in_report_.buttons[0] = 0;
         in_report_.buttons[1] = 0;
 
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
-
-        // --- 1. DPAD ---
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:         in_report_.buttons[0] = XInput::Buttons0::DPAD_UP; break;
-            case Gamepad::DPAD_DOWN:       in_report_.buttons[0] = XInput::Buttons0::DPAD_DOWN; break;
-            case Gamepad::DPAD_LEFT:       in_report_.buttons[0] = XInput::Buttons0::DPAD_LEFT; break;
-            case Gamepad::DPAD_RIGHT:      in_report_.buttons[0] = XInput::Buttons0::DPAD_RIGHT; break;
-            case Gamepad::DPAD_UP_LEFT:    in_report_.buttons[0] = XInput::Buttons0::DPAD_UP | XInput::Buttons0::DPAD_LEFT; break;
-            case Gamepad::DPAD_UP_RIGHT:   in_report_.buttons[0] = XInput::Buttons0::DPAD_UP | XInput::Buttons0::DPAD_RIGHT; break;
-            case Gamepad::DPAD_DOWN_LEFT:  in_report_.buttons[0] = XInput::Buttons0::DPAD_DOWN | XInput::Buttons0::DPAD_LEFT; break;
-            case Gamepad::DPAD_DOWN_RIGHT: in_report_.buttons[0] = XInput::Buttons0::DPAD_DOWN | XInput::Buttons0::DPAD_RIGHT; break;
-            default: break;
-        }
-
-        // --- 2. BOTONES Y TURBO ---
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)  in_report_.buttons[1] |= XInput::Buttons1::LB;
-        if (gp_in.buttons & Gamepad::BUTTON_MISC)  in_report_.buttons[0] |= XInput::Buttons0::BACK;
-
-        if (gp_in.buttons & Gamepad::BUTTON_LB) {
-            turbo_tick++;
-            if ((turbo_tick / 5) % 2 == 0) in_report_.buttons[1] |= XInput::Buttons1::A; 
-        } else {
-            turbo_tick = 0; 
-        }
+        // Solo un pad nuevo alterna el temblor, los cambios de turbo no
+        const bool new_pad_in = gamepad.new_pad_in();
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
 
-        if (gp_in.buttons & Gamepad::BUTTON_START) in_report_.buttons[0] |= XInput::Buttons0::START;
-        if (gp_in.buttons & Gamepad::BUTTON_L3)    in_report_.buttons[0] |= XInput::Buttons0::L3;
-        if (gp_in.buttons & Gamepad::BUTTON_R3)    in_report_.buttons[0] |= XInput::Buttons0::R3;
-        if (gp_in.buttons & Gamepad::BUTTON_X)     in_report_.buttons[1] |= XInput::Buttons1::X;
-        if (gp_in.buttons & Gamepad::BUTTON_A)     in_report_.buttons[1] |= XInput::Buttons1::A;
-        if (gp_in.buttons & Gamepad::BUTTON_Y)     in_report_.buttons[1] |= XInput::Buttons1::Y;
-        if (gp_in.buttons & Gamepad::BUTTON_B)     in_report_.buttons[1] |= XInput::Buttons1::B;
-        if (gp_in.buttons & Gamepad::BUTTON_RB)    in_report_.buttons[1] |= XInput::Buttons1::RB;
-        if (gp_in.buttons & Gamepad::BUTTON_SYS)   in_report_.buttons[1] |= XInput::Buttons1::HOME;
+        // --- 2. BOTONES (el turbo ya viene aplicado) ---
+        BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, in_report_.buttons);
 
         in_report_.trigger_l = (gp_in.trigger_l > 13) ? 255 : 0;
         in_report_.trigger_r = (gp_in.trigger_r > 13) ? 255 : 0;
@@ -125,11 +86,11 @@ void XInputDevice::process(const uint8_t idx, Gamepad& gamepad)
         // Variables raw tras aplicar curva
         int16_t curve_lx, curve_ly, curve_rx, curve_ry;
         
-        apply_stick_curve_mixed(gp_in.joystick_lx, Range::invert(gp_in.joystick_ly), 
-                               0.05f, 1.6f, 1.10f, curve_lx, curve_ly);
-                               
-        apply_stick_curve_mixed(gp_in.joystick_rx, Range::invert(gp_in.joystick_ry), 
-                               0.05f, 1.5f, 1.10f, curve_rx, curve_ry);
+        const OutputCurve& curve_l = gamepad.output_curve_l().enabled() ? gamepad.output_curve_l() : curve_l_;
+        const OutputCurve& curve_r = gamepad.output_curve_r().enabled() ? gamepad.output_curve_r() : curve_r_;
+
+        curve_l.shape(gp_in.joystick_lx, Range::invert(gp_in.joystick_ly), curve_lx, curve_ly);
+        curve_r.shape(gp_in.joystick_rx, Range::invert(gp_in.joystick_ry), curve_rx, curve_ry);
 
         // Usamos int32_t para acumular modificaciones (Aim Assist / Anti-Recoil) de forma segura
         int32_t final_lx = curve_lx;
@@ -146,7 +107,9 @@ void XInputDevice::process(const uint8_t idx, Gamepad& gamepad)
             // Si el personaje se mueve visiblemente, reduce este valor (ej. a 300).
             const int32_t SHAKE_FORCE = 450; 
 
-            shake_toggle = !shake_toggle; // Alternar dirección cada frame
+            if (new_pad_in) {
+                shake_toggle = !shake_toggle; // Alternar dirección con cada pad nuevo
+            }
 
             if (shake_toggle) {
                 final_lx += SHAKE_FORCE;
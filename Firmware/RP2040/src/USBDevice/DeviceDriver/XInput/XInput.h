@@ -17,10 +17,13 @@ public:
     const uint8_t* get_hid_descriptor_report_cb(uint8_t itf)  override;
     const uint8_t* get_descriptor_configuration_cb(uint8_t index) override;
     const uint8_t* get_descriptor_device_qualifier_cb() override;
+    TurboEngine::ModeDefault mode_turbo() const override;
 
 private:
     XInput::InReport in_report_;
     XInput::OutReport out_report_;
+    OutputCurve curve_l_;
+    OutputCurve curve_r_;
 };
 
 #endif // _XINPUT_DEVICE_H_
@@ -4,6 +4,21 @@
 #include "USBDevice/DeviceDriver/XboxOG/tud_xid/tud_xid.h"
 #include "USBDevice/DeviceDriver/XboxOG/XboxOG_GP.h"
 
+static constexpr DeviceMap<1> BUTTON_MAP = DeviceMap<1>()
+    .hat(0, XboxOG::GP::Buttons::DPAD_UP | XboxOG::GP::Buttons::DPAD_DOWN | XboxOG::GP::Buttons::DPAD_LEFT | XboxOG::GP::Buttons::DPAD_RIGHT,
+        {   XboxOG::GP::Buttons::DPAD_UP,
+            XboxOG::GP::Buttons::DPAD_UP | XboxOG::GP::Buttons::DPAD_RIGHT,
+            XboxOG::GP::Buttons::DPAD_RIGHT,
+            XboxOG::GP::Buttons::DPAD_DOWN | XboxOG::GP::Buttons::DPAD_RIGHT,
+            XboxOG::GP::Buttons::DPAD_DOWN,
+            XboxOG::GP::Buttons::DPAD_DOWN | XboxOG::GP::Buttons::DPAD_LEFT,
+            XboxOG::GP::Buttons::DPAD_LEFT,
+            XboxOG::GP::Buttons::DPAD_UP | XboxOG::GP::Buttons::DPAD_LEFT }, 0)
+    .button(Gamepad::BUTTON_BACK,  0, XboxOG::GP::Buttons::BACK)
+    .button(Gamepad::BUTTON_START, 0, XboxOG::GP::Buttons::START)
+    .button(Gamepad::BUTTON_L3,    0, XboxOG::GP::Buttons::L3)
+    .button(Gamepad::BUTTON_R3,    0, XboxOG::GP::Buttons::R3);
+
 void XboxOGDevice::initialize() 
 {
     tud_xid::initialize(tud_xid::Type::GAMEPAD);
@@ -15,45 +30,12 @@ void XboxOGDevice::initialize()
 
 void XboxOGDevice::process(const uint8_t idx, Gamepad& gamepad)
 {
-    if (gamepad.new_pad_in())
+    if (pad_in_due(gamepad))
     {
         std::memset(&in_report_.buttons, 0, 8);
-        Gamepad::PadIn gp_in = gamepad.get_pad_in();
+        Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
 
-        switch (gp_in.dpad)
-        {
-            case Gamepad::DPAD_UP:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_UP;
-                break;
-            case Gamepad::DPAD_DOWN:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_DOWN;
-                break;
-            case Gamepad::DPAD_LEFT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_RIGHT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_RIGHT;
-                break;
-            case Gamepad::DPAD_UP_LEFT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_UP | XboxOG::GP::Buttons::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_UP_RIGHT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_UP | XboxOG::GP::Buttons::DPAD_RIGHT;
-                break;
-            case Gamepad::DPAD_DOWN_LEFT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_DOWN | XboxOG::GP::Buttons::DPAD_LEFT;
-                break;
-            case Gamepad::DPAD_DOWN_RIGHT:
-                in_report_.buttons = XboxOG::GP::Buttons::DPAD_DOWN | XboxOG::GP::Buttons::DPAD_RIGHT;
-                break;
-            default:
-                break;
-        }
-        
-        if (gp_in.buttons & Gamepad::BUTTON_BACK)     in_report_.buttons |= XboxOG::GP::Buttons::BACK;
-        if (gp_in.buttons & Gamepad::BUTTON_START)    in_report_.buttons |= XboxOG::GP::Buttons::START;
-        if (gp_in.buttons & Gamepad::BUTTON_L3)       in_report_.buttons |= XboxOG::GP::Buttons::L3;
-        if (gp_in.buttons & Gamepad::BUTTON_R3)       in_report_.buttons |= XboxOG::GP::Buttons::R3;
+        BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, &in_report_.buttons);
 
         if (gamepad.analog_enabled())
         {
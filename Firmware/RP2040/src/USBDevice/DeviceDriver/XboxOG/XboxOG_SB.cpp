@@ -6,63 +6,56 @@
 #include "USBDevice/DeviceDriver/XboxOG/tud_xid/tud_xid.h"
 #include "USBDevice/DeviceDriver/XboxOG/XboxOG_SB.h"
 
-static constexpr std::array<XboxOGSBDevice::ButtonMap, 9> GP_MAP = 
-{{
-    {Gamepad::BUTTON_START,   XboxOG::SB::Buttons0::START,              0},
-    {Gamepad::BUTTON_LB,      XboxOG::SB::Buttons0::RIGHTJOYFIRE,       0},
-    {Gamepad::BUTTON_R3,      XboxOG::SB::Buttons0::RIGHTJOYLOCKON,     0},
-    {Gamepad::BUTTON_B,       XboxOG::SB::Buttons0::RIGHTJOYLOCKON,     0},
-    {Gamepad::BUTTON_RB,      XboxOG::SB::Buttons0::RIGHTJOYMAINWEAPON, 0},
-    {Gamepad::BUTTON_A,       XboxOG::SB::Buttons0::RIGHTJOYMAINWEAPON, 0},
-    {Gamepad::BUTTON_SYS,     XboxOG::SB::Buttons0::EJECT,              0},
-    {Gamepad::BUTTON_L3,      XboxOG::SB::Buttons2::LEFTJOYSIGHTCHANGE, 2},
-    {Gamepad::BUTTON_Y,       XboxOG::SB::Buttons1::CHAFF,              1}
-}};
-
-static constexpr std::array<XboxOGSBDevice::ButtonMap, 19> CHATPAD_MAP =
-{{
-    {XInput::Chatpad::CODE_0,      XboxOG::SB::Buttons0::EJECT,                0},
-    {XInput::Chatpad::CODE_D,      XboxOG::SB::Buttons1::WASHING,              1},
-    {XInput::Chatpad::CODE_F,      XboxOG::SB::Buttons1::EXTINGUISHER,         1},
-    {XInput::Chatpad::CODE_G,      XboxOG::SB::Buttons1::CHAFF,                1},
-    {XInput::Chatpad::CODE_X,      XboxOG::SB::Buttons1::WEAPONCONMAIN,        1},
-    {XInput::Chatpad::CODE_RIGHT,  XboxOG::SB::Buttons1::WEAPONCONMAIN,        1},
-    {XInput::Chatpad::CODE_C,      XboxOG::SB::Buttons1::WEAPONCONSUB,         1},
-    {XInput::Chatpad::CODE_LEFT,   XboxOG::SB::Buttons1::WEAPONCONSUB,         1},
-    {XInput::Chatpad::CODE_V,      XboxOG::SB::Buttons1::WEAPONCONMAGAZINE,    1},
-    {XInput::Chatpad::CODE_SPACE,  XboxOG::SB::Buttons1::WEAPONCONMAGAZINE,    1},
-    {XInput::Chatpad::CODE_U,      XboxOG::SB::Buttons0::MULTIMONOPENCLOSE,    0},
-    {XInput::Chatpad::CODE_J,      XboxOG::SB::Buttons0::MULTIMONMODESELECT,   0},
-    {XInput::Chatpad::CODE_N,      XboxOG::SB::Buttons0::MAINMONZOOMIN,        0},
-    {XInput::Chatpad::CODE_I,      XboxOG::SB::Buttons0::MULTIMONMAPZOOMINOUT, 0},
-    {XInput::Chatpad::CODE_K,      XboxOG::SB::Buttons0::MULTIMONSUBMONITOR,   0},
-    {XInput::Chatpad::CODE_M,      XboxOG::SB::Buttons0::MAINMONZOOMOUT,       0},
-    {XInput::Chatpad::CODE_ENTER,  XboxOG::SB::Buttons0::START,                0},
-    {XInput::Chatpad::CODE_P,      XboxOG::SB::Buttons0::COCKPITHATCH,         0},
-    {XInput::Chatpad::CODE_COMMA,  XboxOG::SB::Buttons0::IGNITION,             0}
-}};
-
-static constexpr std::array<XboxOGSBDevice::ButtonMap, 5> CHATPAD_MAP_ALT1 =
-{{
-    {XInput::Chatpad::CODE_1, XboxOG::SB::Buttons1::COMM1, 1},
-    {XInput::Chatpad::CODE_2, XboxOG::SB::Buttons1::COMM2, 1},
-    {XInput::Chatpad::CODE_3, XboxOG::SB::Buttons1::COMM3, 1},
-    {XInput::Chatpad::CODE_4, XboxOG::SB::Buttons1::COMM4, 1},
-    {XInput::Chatpad::CODE_5, XboxOG::SB::Buttons2::COMM5, 2}
-}};
-
-static constexpr std::array<XboxOGSBDevice::ButtonMap, 9> CHATPAD_MAP_ALT2=
-{{
-    {XInput::Chatpad::CODE_1, XboxOG::SB::Buttons1::FUNCTIONF1,               1},
-    {XInput::Chatpad::CODE_2, XboxOG::SB::Buttons1::FUNCTIONTANKDETACH,       1},
-    {XInput::Chatpad::CODE_3, XboxOG::SB::Buttons0::FUNCTIONFSS,              0},
-    {XInput::Chatpad::CODE_4, XboxOG::SB::Buttons1::FUNCTIONF2,               1},
-    {XInput::Chatpad::CODE_5, XboxOG::SB::Buttons1::FUNCTIONOVERRIDE,         1},
-    {XInput::Chatpad::CODE_6, XboxOG::SB::Buttons0::FUNCTIONMANIPULATOR,      0},
-    {XInput::Chatpad::CODE_7, XboxOG::SB::Buttons1::FUNCTIONF3,               1},
-    {XInput::Chatpad::CODE_8, XboxOG::SB::Buttons1::FUNCTIONNIGHTSCOPE,       1},
-    {XInput::Chatpad::CODE_9, XboxOG::SB::Buttons0::FUNCTIONLINECOLORCHANGE,  0}
-}};
+//dButtons are 3 uint16_t, the maps go by byte so word n starts at byte n * 2
+static constexpr DeviceMap<6> GP_MAP = DeviceMap<6>()
+    .button(Gamepad::BUTTON_START, 0, XboxOG::SB::Buttons0::START)
+    .button(Gamepad::BUTTON_LB,    0, XboxOG::SB::Buttons0::RIGHTJOYFIRE)
+    .button(Gamepad::BUTTON_R3,    0, XboxOG::SB::Buttons0::RIGHTJOYLOCKON)
+    .button(Gamepad::BUTTON_B,     0, XboxOG::SB::Buttons0::RIGHTJOYLOCKON)
+    .button(Gamepad::BUTTON_RB,    0, XboxOG::SB::Buttons0::RIGHTJOYMAINWEAPON)
+    .button(Gamepad::BUTTON_A,     0, XboxOG::SB::Buttons0::RIGHTJOYMAINWEAPON)
+    .button(Gamepad::BUTTON_SYS,   0, XboxOG::SB::Buttons0::EJECT)
+    .button(Gamepad::BUTTON_L3,    4, XboxOG::SB::Buttons2::LEFTJOYSIGHTCHANGE)
+    .button(Gamepad::BUTTON_Y,     2, XboxOG::SB::Buttons1::CHAFF);
+
+static constexpr KeyMap<6> CHATPAD_MAP = KeyMap<6>()
+    .key(XInput::Chatpad::CODE_0,     0, XboxOG::SB::Buttons0::EJECT)
+    .key(XInput::Chatpad::CODE_D,     2, XboxOG::SB::Buttons1::WASHING)
+    .key(XInput::Chatpad::CODE_F,     2, XboxOG::SB::Buttons1::EXTINGUISHER)
+    .key(XInput::Chatpad::CODE_G,     2, XboxOG::SB::Buttons1::CHAFF)
+    .key(XInput::Chatpad::CODE_X,     2, XboxOG::SB::Buttons1::WEAPONCONMAIN)
+    .key(XInput::Chatpad::CODE_RIGHT, 2, XboxOG::SB::Buttons1::WEAPONCONMAIN)
+    .key(XInput::Chatpad::CODE_C,     2, XboxOG::SB::Buttons1::WEAPONCONSUB)
+    .key(XInput::Chatpad::CODE_LEFT,  2, XboxOG::SB::Buttons1::WEAPONCONSUB)
+    .key(XInput::Chatpad::CODE_V,     2, XboxOG::SB::Buttons1::WEAPONCONMAGAZINE)
+    .key(XInput::Chatpad::CODE_SPACE, 2, XboxOG::SB::Buttons1::WEAPONCONMAGAZINE)
+    .key(XInput::Chatpad::CODE_U,     0, XboxOG::SB::Buttons0::MULTIMONOPENCLOSE)
+    .key(XInput::Chatpad::CODE_J,     0, XboxOG::SB::Buttons0::MULTIMONMODESELECT)
+    .key(XInput::Chatpad::CODE_N,     0, XboxOG::SB::Buttons0::MAINMONZOOMIN)
+    .key(XInput::Chatpad::CODE_I,     0, XboxOG::SB::Buttons0::MULTIMONMAPZOOMINOUT)
+    .key(XInput::Chatpad::CODE_K,     0, XboxOG::SB::Buttons0::MULTIMONSUBMONITOR)
+    .key(XInput::Chatpad::CODE_M,     0, XboxOG::SB::Buttons0::MAINMONZOOMOUT)
+    .key(XInput::Chatpad::CODE_ENTER, 0, XboxOG::SB::Buttons0::START)
+    .key(XInput::Chatpad::CODE_P,     0, XboxOG::SB::Buttons0::COCKPITHATCH)
+    .key(XInput::Chatpad::CODE_COMMA, 0, XboxOG::SB::Buttons0::IGNITION);
+
+static constexpr KeyMap<6> CHATPAD_MAP_ALT1 = KeyMap<6>()
+    .key(XInput::Chatpad::CODE_1, 2, XboxOG::SB::Buttons1::COMM1)
+    .key(XInput::Chatpad::CODE_2, 2, XboxOG::SB::Buttons1::COMM2)
+    .key(XInput::Chatpad::CODE_3, 2, XboxOG::SB::Buttons1::COMM3)
+    .key(XInput::Chatpad::CODE_4, 2, XboxOG::SB::Buttons1::COMM4)
+    .key(XInput::Chatpad::CODE_5, 4, XboxOG::SB::Buttons2::COMM5);
+
+static constexpr KeyMap<6> CHATPAD_MAP_ALT2 = KeyMap<6>()
+    .key(XInput::Chatpad::CODE_1, 2, XboxOG::SB::Buttons1::FUNCTIONF1)
+    .key(XInput::Chatpad::CODE_2, 2, XboxOG::SB::Buttons1::FUNCTIONTANKDETACH)
+    .key(XInput::Chatpad::CODE_3, 0, XboxOG::SB::Buttons0::FUNCTIONFSS)
+    .key(XInput::Chatpad::CODE_4, 2, XboxOG::SB::Buttons1::FUNCTIONF2)
+    .key(XInput::Chatpad::CODE_5, 2, XboxOG::SB::Buttons1::FUNCTIONOVERRIDE)
+    .key(XInput::Chatpad::CODE_6, 0, XboxOG::SB::Buttons0::FUNCTIONMANIPULATOR)
+    .key(XInput::Chatpad::CODE_7, 2, XboxOG::SB::Buttons1::FUNCTIONF3)
+    .key(XInput::Chatpad::CODE_8, 2, XboxOG::SB::Buttons1::FUNCTIONNIGHTSCOPE)
+    .key(XInput::Chatpad::CODE_9, 0, XboxOG::SB::Buttons0::FUNCTIONLINECOLORCHANGE);
 
 static constexpr std::array<XboxOGSBDevice::ButtonMap, 5> CHATPAD_TOGGLE_MAP =
 {{
@@ -87,28 +80,15 @@ void XboxOGSBDevice::initialize()
 
 void XboxOGSBDevice::process(const uint8_t idx, Gamepad& gamepad) 
 {
-    Gamepad::PadIn gp_in = gamepad.get_pad_in();
+    Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
     Gamepad::ChatpadIn gp_in_chatpad = gamepad.get_chatpad_in();
 
     in_report_.dButtons[0] = 0;
     in_report_.dButtons[1] = 0;
     in_report_.dButtons[2] &= XboxOG::SB::BUTTONS2_TOGGLE_MID;
 
-    for (const auto& map : GP_MAP)
-    {
-        if (gp_in.buttons & map.gp_mask)
-        {
-            in_report_.dButtons[map.button_offset] |= map.sb_mask;
-        }
-    }
-
-    for (const auto& map : CHATPAD_MAP)
-    {
-        if (chatpad_pressed(gp_in_chatpad, map.gp_mask))
-        {
-            in_report_.dButtons[map.button_offset] |= map.sb_mask;
-        }
-    }
+    GP_MAP.apply(gp_in.buttons, gp_in.dpad, in_report_.dButtons);
+    CHATPAD_MAP.apply(&gp_in_chatpad[1], 2, in_report_.dButtons);
 
     static std::array<bool, CHATPAD_TOGGLE_MAP.size() + 1> toggle_pressed{false};
 
@@ -166,13 +146,7 @@ void XboxOGSBDevice::process(const uint8_t idx, Gamepad& gamepad)
 
     if (chatpad_pressed(gp_in_chatpad, XInput::Chatpad::CODE_MESSENGER) || gp_in.buttons & Gamepad::BUTTON_BACK)
     {
-        for (const auto& map : CHATPAD_MAP_ALT1)
-        {
-            if (chatpad_pressed(gp_in_chatpad, map.gp_mask))
-            {
-                in_report_.dButtons[map.button_offset] |= map.sb_mask;
-            }
-        }
+        CHATPAD_MAP_ALT1.apply(&gp_in_chatpad[1], 2, in_report_.dButtons);
 
         if (gp_in.dpad & Gamepad::DPAD_UP && dpad_reset_)
         {
@@ -191,13 +165,7 @@ void XboxOGSBDevice::process(const uint8_t idx, Gamepad& gamepad)
     }
     else if (chatpad_pressed(gp_in_chatpad, XInput::Chatpad::CODE_ORANGE))
     {
-        for (const auto& map : CHATPAD_MAP_ALT2)
-        {
-            if (chatpad_pressed(gp_in_chatpad, map.gp_mask))
-            {
-                in_report_.dButtons[map.button_offset] |= map.sb_mask;
-            }
-        }
+        CHATPAD_MAP_ALT2.apply(&gp_in_chatpad[1], 2, in_report_.dButtons);
 
         // if (!(gp_in.dpad & Gamepad::DPAD_LEFT) && !(gp_in.dpad & Gamepad::DPAD_RIGHT))
         // {
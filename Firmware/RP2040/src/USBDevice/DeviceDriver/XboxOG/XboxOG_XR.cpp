@@ -4,6 +4,21 @@
 #include "USBDevice/DeviceDriver/XboxOG/tud_xid/tud_xid.h"
 #include "USBDevice/DeviceDriver/XboxOG/XboxOG_XR.h"
 
+static constexpr DeviceMap<2> BUTTON_MAP = DeviceMap<2>()
+    .dpad(Gamepad::DPAD_UP,    0, XboxOG::XR::ButtonCode::UP)
+    .dpad(Gamepad::DPAD_DOWN,  0, XboxOG::XR::ButtonCode::DOWN)
+    .dpad(Gamepad::DPAD_LEFT,  0, XboxOG::XR::ButtonCode::LEFT)
+    .dpad(Gamepad::DPAD_RIGHT, 0, XboxOG::XR::ButtonCode::RIGHT)
+    .button(Gamepad::BUTTON_SYS,   0, XboxOG::XR::ButtonCode::DISPLAY)
+    .button(Gamepad::BUTTON_START, 0, XboxOG::XR::ButtonCode::PLAY)
+    .button(Gamepad::BUTTON_BACK,  0, XboxOG::XR::ButtonCode::STOP)
+    .button(Gamepad::BUTTON_A,     0, XboxOG::XR::ButtonCode::SELECT)
+    .button(Gamepad::BUTTON_Y,     0, XboxOG::XR::ButtonCode::PAUSE)
+    .button(Gamepad::BUTTON_X,     0, XboxOG::XR::ButtonCode::DISPLAY)
+    .button(Gamepad::BUTTON_B,     0, XboxOG::XR::ButtonCode::BACK)
+    .button(Gamepad::BUTTON_L3 | Gamepad::BUTTON_R3, 0, XboxOG::XR::ButtonCode::INFO)
+    .button(Gamepad::BUTTON_LB | Gamepad::BUTTON_RB, 0, XboxOG::XR::ButtonCode::DISPLAY);
+
 void XboxOGXRDevice::initialize() 
 {
     tud_xid::initialize(tud_xid::Type::XREMOTE);
@@ -23,36 +38,22 @@ void XboxOGXRDevice::process(const uint8_t idx, Gamepad& gamepad)
     uint32_t time_elapsed = board_api::ms_since_boot() - ms_timer_;
     uint8_t index = tud_xid::get_index_by_type(0, tud_xid::Type::XREMOTE);
 
-    if (index == 0xFF || !gamepad.new_pad_in() || time_elapsed < 64)
+    if (index == 0xFF || !pad_in_due(gamepad) || time_elapsed < 64)
     {
         return;
     }
 
-    Gamepad::PadIn gp_in = gamepad.get_pad_in();
+    Gamepad::PadIn gp_in = read_pad_in(idx, gamepad);
 
     in_report_.buttonCode = 0;
 
-    if (gp_in.dpad & Gamepad::DPAD_UP)    in_report_.buttonCode |= XboxOG::XR::ButtonCode::UP   ;
-    if (gp_in.dpad & Gamepad::DPAD_DOWN)  in_report_.buttonCode |= XboxOG::XR::ButtonCode::DOWN ;
-    if (gp_in.dpad & Gamepad::DPAD_LEFT)  in_report_.buttonCode |= XboxOG::XR::ButtonCode::LEFT ;
-    if (gp_in.dpad & Gamepad::DPAD_RIGHT) in_report_.buttonCode |= XboxOG::XR::ButtonCode::RIGHT;
-
-    if (gp_in.buttons & Gamepad::BUTTON_SYS)   in_report_.buttonCode |= XboxOG::XR::ButtonCode::DISPLAY;
-    if (gp_in.buttons & Gamepad::BUTTON_START) in_report_.buttonCode |= XboxOG::XR::ButtonCode::PLAY   ;
-    if (gp_in.buttons & Gamepad::BUTTON_BACK)  in_report_.buttonCode |= XboxOG::XR::ButtonCode::STOP   ;
+    BUTTON_MAP.apply(gp_in.buttons, gp_in.dpad, &in_report_.buttonCode);
 
+    //One of a pair held on its own
     if (gp_in.buttons & Gamepad::BUTTON_L3 && !(gp_in.buttons & Gamepad::BUTTON_R3)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::TITLE;
     if (gp_in.buttons & Gamepad::BUTTON_R3 && !(gp_in.buttons & Gamepad::BUTTON_L3)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::MENU;
-    if (gp_in.buttons & (Gamepad::BUTTON_L3 | Gamepad::BUTTON_R3)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::INFO;
-
-    if (gp_in.buttons & Gamepad::BUTTON_A) in_report_.buttonCode |= XboxOG::XR::ButtonCode::SELECT ;
-    if (gp_in.buttons & Gamepad::BUTTON_Y) in_report_.buttonCode |= XboxOG::XR::ButtonCode::PAUSE  ;
-    if (gp_in.buttons & Gamepad::BUTTON_X) in_report_.buttonCode |= XboxOG::XR::ButtonCode::DISPLAY;
-    if (gp_in.buttons & Gamepad::BUTTON_B) in_report_.buttonCode |= XboxOG::XR::ButtonCode::BACK   ;
-
     if (gp_in.buttons & Gamepad::BUTTON_LB && !(gp_in.buttons & Gamepad::BUTTON_RB)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::SKIP_MINUS;
     if (gp_in.buttons & Gamepad::BUTTON_RB && !(gp_in.buttons & Gamepad::BUTTON_LB)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::SKIP_PLUS ;
-    if (gp_in.buttons & (Gamepad::BUTTON_LB | Gamepad::BUTTON_RB)) in_report_.buttonCode |= XboxOG::XR::ButtonCode::DISPLAY;
 
     if (gp_in.trigger_l >= 100) in_report_.buttonCode |= XboxOG::XR::ButtonCode::REVERSE;
     if (gp_in.trigger_r >= 100) in_report_.buttonCode |= XboxOG::XR::ButtonCode::FORWARD;
@@ -1,6 +1,16 @@
+#include <algorithm>
+#include <new>
+
+#include "pico/time.h"
 #include "tusb.h"
+#include "device/usbd_pvt.h"
 
 #include "Board/Config.h"
+#include "Board/board_api.h"
+#include "Board/ogxm_log.h"
+#include "Board/latency_trace.h"
+#include "UserSettings/UserSettings.h"
+#include "TaskQueue/TaskQueue.h"
 #include "USBDevice/DeviceDriver/PSClassic/PSClassic.h"
 #include "USBDevice/DeviceDriver/XInput/XInput.h"   
 #include "USBDevice/DeviceDriver/Switch/Switch.h"
@@ -17,6 +27,29 @@
 #include "USBDevice/DeviceDriver/UARTBridge/UARTBridge.h"
 #endif // defined(CONFIG_EN_UART_BRIDGE)
 
+namespace {
+    //One device driver at a time, a live mode switch destroys it before the next is built in
+    //the same place, so one slot big enough for any of them is all that's needed
+    template <typename... Types>
+    struct DriverStorage {
+        alignas(Types...) uint8_t data[std::max({ sizeof(Types)... })];
+    };
+
+    DriverStorage<DInputDevice, PS3Device, PSClassicDevice, SwitchDevice, XInputDevice, XboxOGDevice,
+                  XboxOGSBDevice, XboxOGXRDevice, WebAppDevice,
+#if defined(CONFIG_EN_UART_BRIDGE)
+                  UARTBridgeDevice,
+#endif // defined(CONFIG_EN_UART_BRIDGE)
+                  PS4Device> driver_storage;
+
+    template <typename T>
+    DeviceDriver* create_driver() {
+        static_assert(sizeof(T) <= sizeof(driver_storage.data) && alignof(T) <= alignof(decltype(driver_storage)),
+                      "DeviceManager: driver missing from driver_storage");
+        return ::new (static_cast<void*>(driver_storage.data)) T();
+    }
+}
+
 void DeviceManager::initialize_driver(DeviceDriverType driver_type, 
                                       Gamepad(&gamepads)[MAX_GAMEPADS]) {
     //TODO: Put gamepad setup in the drivers themselves
@@ -25,51 +58,51 @@ void DeviceManager::initialize_driver(DeviceDriverType driver_type,
     switch (driver_type) {
         case DeviceDriverType::DINPUT:
             has_analog = true;
-            device_driver_ = std::make_unique<DInputDevice>();
+            device_driver_ = create_driver<DInputDevice>();
             break;
 
         case DeviceDriverType::PS3:
             has_analog = true;
-            device_driver_ = std::make_unique<PS3Device>();
+            device_driver_ = create_driver<PS3Device>();
             break;
 
         case DeviceDriverType::PSCLASSIC:
-            device_driver_ = std::make_unique<PSClassicDevice>();
+            device_driver_ = create_driver<PSClassicDevice>();
             break;
 
         case DeviceDriverType::SWITCH:
-            device_driver_ = std::make_unique<SwitchDevice>();
+            device_driver_ = create_driver<SwitchDevice>();
             break;
 
         case DeviceDriverType::XINPUT:
-            device_driver_ = std::make_unique<XInputDevice>();
+            device_driver_ = create_driver<XInputDevice>();
             break;
 
         case DeviceDriverType::XBOXOG:
             has_analog = true;
-            device_driver_ = std::make_unique<XboxOGDevice>();
+            device_driver_ = create_driver<XboxOGDevice>();
             break;
 
         case DeviceDriverType::XBOXOG_SB:
-            device_driver_ = std::make_unique<XboxOGSBDevice>();
+            device_driver_ = create_driver<XboxOGSBDevice>();
             break;
 
         case DeviceDriverType::XBOXOG_XR:
-            device_driver_ = std::make_unique<XboxOGXRDevice>();
+            device_driver_ = create_driver<XboxOGXRDevice>();
             break;
 
         case DeviceDriverType::WEBAPP:
-            device_driver_ = std::make_unique<WebAppDevice>();
+            device_driver_ = create_driver<WebAppDevice>();
             break;
 
         case DeviceDriverType::PS4:                     // <<< NUEVO
             has_analog = true;                          // sticks + triggers analógicos
-            device_driver_ = std::make_unique<PS4Device>();
+            device_driver_ = create_driver<PS4Device>();
             break;
 
 #if defined(CONFIG_EN_UART_BRIDGE)
         case DeviceDriverType::UART_BRIDGE:
-            device_driver_ = std::make_unique<UARTBridgeDevice>();
+            device_driver_ = create_driver<UARTBridgeDevice>();
             break;
 #endif //defined(CONFIG_EN_UART_BRIDGE)
 
@@ -77,11 +110,147 @@ void DeviceManager::initialize_driver(DeviceDriverType driver_type,
             return;
     }
 
-    if (has_analog) {
-        for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
-            gamepads[i].set_analog_device(true);
-        }
+    for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
+        gamepads[i].set_analog_device(has_analog);
+        gamepads[i].set_mode_turbo(device_driver_->mode_turbo());
     }
 
+    driver_type_ = driver_type;
     device_driver_->initialize();
+    latency_trace::init(static_cast<uint8_t>(driver_type));
+
+    //Profile of the first gamepad decides, the web app and UART bridge keep their own
+    switch (driver_type) {
+        case DeviceDriverType::WEBAPP:
+#if defined(CONFIG_EN_UART_BRIDGE)
+        case DeviceDriverType::UART_BRIDGE:
+#endif // defined(CONFIG_EN_UART_BRIDGE)
+            poll_interval_ms_ = 0;
+            break;
+        default:
+            poll_interval_ms_ = ConfigDescriptor::valid_interval(gamepads[0].poll_interval_ms())
+                                ? gamepads[0].poll_interval_ms() : 0;
+            break;
+    }
+    config_descriptor_.build(device_driver_->get_descriptor_configuration_cb(0), poll_interval_ms_);
+    poll_meter_.restart();
+    poll_meter_started_ms_ = board_api::ms_since_boot();
+
+    sof_sync_en_ = false;
+#if defined(CONFIG_EN_SOF_SYNC)
+    sof_sync_.restart_stats();
+    sof_sync_en_ = (driver_type != DeviceDriverType::WEBAPP) && (config_descriptor_.in_endpoint() != 0);
+#if defined(CONFIG_EN_UART_BRIDGE)
+    sof_sync_en_ = sof_sync_en_ && (driver_type != DeviceDriverType::UART_BRIDGE);
+#endif // defined(CONFIG_EN_UART_BRIDGE)
+    sof_sync_.set_interval_frames(poll_interval_ms_ ? poll_interval_ms_ : 1);
+#endif // defined(CONFIG_EN_SOF_SYNC)
+}
+
+bool DeviceManager::switch_driver(DeviceDriverType driver_type, Gamepad(&gamepads)[MAX_GAMEPADS]) {
+    if (!device_driver_ || !tud_inited() || driver_type == driver_type_ ||
+        !UserSettings::get_instance().is_valid_driver(driver_type)) {
+        return false;
+    }
+#if defined(CONFIG_EN_UART_BRIDGE)
+    //The bridge takes the UART over for good
+    if (driver_type == DeviceDriverType::UART_BRIDGE || driver_type_ == DeviceDriverType::UART_BRIDGE) {
+        return false;
+    }
+#endif // defined(CONFIG_EN_UART_BRIDGE)
+
+    const uint32_t started_ms = board_api::ms_since_boot();
+    OGXM_LOG("Switching device driver live\n");
+
+    tud_disconnect();
+    //Completions already queued go to the driver they belong to
+    tud_task();
+
+    device_driver_->~DeviceDriver();
+    device_driver_ = nullptr;
+    initialize_driver(driver_type, gamepads);
+    tud_app_driver_refresh();
+
+    //A report from the pads as they are goes out as soon as the console polls
+    for (size_t i = 0; i < MAX_GAMEPADS; ++i) {
+        gamepads[i].refresh_pad_in();
+    }
+
+    //Long enough off the bus for the console to see a disconnect
+    const uint32_t elapsed_ms = board_api::ms_since_boot() - started_ms;
+    if (elapsed_ms < DEVICE_SWITCH_DISCONNECT_MS) {
+        sleep_ms(DEVICE_SWITCH_DISCONNECT_MS - elapsed_ms);
+    }
+    tud_connect();
+
+    OGXM_LOG("Device driver switched in %u ms\n", board_api::ms_since_boot() - started_ms);
+    store_driver_later(driver_type);
+    return true;
+}
+
+void DeviceManager::store_driver_later(DeviceDriverType driver_type) {
+    static const uint32_t task_id = TaskQueue::Core0::get_new_task_id();
+
+    TaskQueue::Core0::cancel_delayed_task(task_id);
+    TaskQueue::Core0::queue_delayed_task(task_id, DEVICE_SWITCH_STORE_DELAY_MS, false, [this, driver_type] {
+        //Pauses core1 for the erase and program, logged so the pause can be read off a real board
+        const uint32_t started_us = time_us_32();
+        if (!UserSettings::get_instance().write_driver_type(driver_type)) {
+            //Still running as the new type, tried again until it sticks
+            store_driver_later(driver_type);
+            return;
+        }
+        OGXM_LOG("Device driver stored, core1 paused up to %u us\n", time_us_32() - started_us);
+    });
+}
+
+bool DeviceManager::begin_reports() {
+    return !sof_sync_en_ ||
+           sof_sync_.begin(time_us_32(), usbd_edpt_busy(BOARD_TUD_RHPORT, config_descriptor_.in_endpoint()));
+}
+
+uint32_t DeviceManager::idle_us() {
+    return sof_sync_en_ ? sof_sync_.idle_us(time_us_32(), CORE0_IDLE_TICK_US) : CORE0_IDLE_TICK_US;
+}
+
+const uint8_t* DeviceManager::get_descriptor_configuration(uint8_t index) {
+    const uint8_t* desc = device_driver_->get_descriptor_configuration_cb(index);
+    return (index == 0) ? config_descriptor_.get(desc) : desc;
+}
+
+void DeviceManager::report_sent(uint8_t ep_addr) {
+    if (ep_addr != config_descriptor_.in_endpoint()) {
+        return;
+    }
+    const uint32_t now_us = time_us_32();
+    poll_meter_.completed(now_us);
+    if (sof_sync_en_) {
+        sof_sync_.polled(now_us);
+    }
+
+    const uint32_t now_ms = board_api::ms_since_boot();
+    if (now_ms - poll_meter_started_ms_ < DEVICE_POLL_STATS_LOG_MS) {
+        return;
+    }
+    last_poll_meter_ = poll_meter_;
+    poll_meter_.restart();
+    poll_meter_started_ms_ = now_ms;
+
+    OGXM_LOG("Console polls every %u ms (%u Hz), asked for %u ms, %u reports\n",
+             last_poll_meter_.interval_ms(), last_poll_meter_.rate_hz(),
+             poll_interval_ms_, last_poll_meter_.completions());
+
+    if (!sof_sync_en_) {
+        return;
+    }
+    if (last_poll_meter_.interval_ms()) {
+        sof_sync_.set_interval_frames(last_poll_meter_.interval_ms());
+    }
+    last_sof_stats_ = sof_sync_.stats();
+    sof_sync_.restart_stats();
+
+    OGXM_LOG("SOF sync: lead %u us, age at poll %u/%u/%u us (min/avg/max), %u late, poll %u us after SOF, jitter %u us\n",
+             last_sof_stats_.lead_us, last_sof_stats_.age_min_us, last_sof_stats_.age_avg_us(),
+             last_sof_stats_.age_max_us, last_sof_stats_.late, last_sof_stats_.phase_min_us,
+             last_sof_stats_.jitter_us());
 }
@@ -2,10 +2,18 @@
 #define _DEVICE_MANAGER_H_
 
 #include <cstdint>
-#include <memory>
 
+#include "pico/time.h"
+
+#include "Board/Config.h"
 #include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
 #include "USBDevice/DeviceDriver/DeviceDriver.h"
+#include "USBDevice/ConfigDescriptor.h"
+#include "USBDevice/PollMeter.h"
+#include "USBDevice/SofSync.h"
+
+//tud_callbacks.cpp, points the class driver TinyUSB was given at the current device driver
+void tud_app_driver_refresh();
 
 class DeviceManager {
 public:
@@ -20,13 +28,55 @@ public:
 	//Must be called before any other method
 	void initialize_driver(DeviceDriverType driver_type, Gamepad(&gamepads)[MAX_GAMEPADS]);
 	
-	DeviceDriver* get_driver() { return device_driver_.get(); }
+	DeviceDriver* get_driver() { return device_driver_; }
+
+	//Tears down the current driver and re-enumerates as driver_type, host side and gamepads are
+	//left alone. The type is stored DEVICE_SWITCH_STORE_DELAY_MS after reconnecting. Call from core0
+	//outside tud_task, false if it can't be done live (stack not up yet, UART bridge) and nothing changed
+	bool switch_driver(DeviceDriverType driver_type, Gamepad(&gamepads)[MAX_GAMEPADS]);
+
+	//The driver's configuration descriptor with the profile's poll interval in it
+	const uint8_t* get_descriptor_configuration(uint8_t index);
+
+	//Completed IN transfer, from the class driver's xfer_cb
+	void report_sent(uint8_t ep_addr);
+
+	//What the console polls at, measured over the last DEVICE_POLL_STATS_LOG_MS
+	const PollMeter& get_poll_meter() const { return last_poll_meter_; }
+
+	//USB IRQ, from the class driver's sof
+	void sof() { sof_sync_.sof(time_us_32()); }
+
+	//Call once per core0 pass, false if device reports shouldn't be built on this one.
+	//Always true unless SOF sync is enabled and has the console's polls to go by, then
+	//true once per poll, lead us ahead of it
+	bool begin_reports();
+
+	//How long core0 may idle before reports are due, for board_api::wait_for_work
+	uint32_t idle_us();
+
+	//SOF sync age at poll and jitter over the last DEVICE_POLL_STATS_LOG_MS, lead is the current one
+	const SofSync::Stats& get_sof_stats() const { return last_sof_stats_; }
 	
 private:
     DeviceManager() = default;
 	~DeviceManager() = default;
 
-	std::unique_ptr<DeviceDriver> device_driver_{nullptr};
+	//Queues the flash write of a switched to type, a newer switch replaces one still waiting
+	void store_driver_later(DeviceDriverType driver_type);
+
+	DeviceDriver* device_driver_{nullptr}; //Lives in static storage in DeviceManager.cpp
+	DeviceDriverType driver_type_{DeviceDriverType::NONE};
+	ConfigDescriptor config_descriptor_;
+	uint8_t poll_interval_ms_{0};
+
+	PollMeter poll_meter_;
+	PollMeter last_poll_meter_;
+	uint32_t poll_meter_started_ms_{0};
+
+	SofSync sof_sync_{SOF_SYNC_LEAD_US};
+	SofSync::Stats last_sof_stats_;
+	bool sof_sync_en_{false};
 };
 
 #endif // _DEVICE_MANAGER_H_
\ No newline at end of file
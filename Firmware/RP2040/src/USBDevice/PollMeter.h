@@ -0,0 +1,74 @@
+#ifndef _POLL_METER_H_
+#define _POLL_METER_H_
+
+#include <cstdint>
+#include <array>
+
+/*  Measures how often the console actually polls the gamepad's IN endpoint, which can be
+    slower (or, for hosts that round bInterval down, faster) than what the descriptor asks for.
+
+    Every completed IN transfer is a poll that found a report queued. Drivers only queue a
+    report when they have one, so gaps between completions are the poll interval times the
+    polls that found nothing. The shortest gap seen MIN_HITS times is taken as the interval,
+    a single gap shortened by callback jitter doesn't count. Gaps are rounded to whole frames
+    and longer than MAX_INTERVAL_MS are the pad sitting idle, those are ignored. */
+
+class PollMeter
+{
+public:
+    static constexpr uint32_t FRAME_US = 1000;
+    static constexpr uint8_t MAX_INTERVAL_MS = 16;
+    static constexpr uint32_t MIN_HITS = 4;
+
+    //Call on every completed IN transfer of the gamepad endpoint
+    inline void completed(uint32_t now_us)
+    {
+        if (started_)
+        {
+            const uint32_t gap_ms = (now_us - last_us_ + FRAME_US / 2) / FRAME_US;
+            if (gap_ms >= 1 && gap_ms <= MAX_INTERVAL_MS)
+            {
+                ++histogram_[gap_ms - 1];
+            }
+        }
+        last_us_ = now_us;
+        started_ = true;
+        ++completions_;
+    }
+
+    //Effective poll interval in ms, 0 until there's enough to tell
+    inline uint8_t interval_ms() const
+    {
+        for (uint8_t i = 0; i < MAX_INTERVAL_MS; ++i)
+        {
+            if (histogram_[i] >= MIN_HITS)
+            {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    inline uint32_t rate_hz() const
+    {
+        const uint8_t interval = interval_ms();
+        return interval ? (1000 / interval) : 0;
+    }
+
+    inline uint32_t completions() const { return completions_; }
+
+    //New measuring window, the last completion still counts as the start of the next gap
+    inline void restart()
+    {
+        histogram_.fill(0);
+        completions_ = 0;
+    }
+
+private:
+    std::array<uint32_t, MAX_INTERVAL_MS> histogram_{0};
+    uint32_t completions_{0};
+    uint32_t last_us_{0};
+    bool started_{false};
+};
+
+#endif // _POLL_METER_H_
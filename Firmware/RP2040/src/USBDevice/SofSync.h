@@ -0,0 +1,233 @@
+#ifndef _SOF_SYNC_H_
+#define _SOF_SYNC_H_
+
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+
+/*  Times device report building against the console's polls instead of core0's loop.
+
+    A report queued on the IN endpoint waits there until the console polls, and a newer
+    Gamepad snapshot can't replace it. Built on every pass it's up to a whole poll interval
+    old when it goes out. Here the SOF IRQ stamps each frame start, IN completions give the
+    poll's offset into the frame and its frame parity, and reports are built once per poll,
+    lead_us ahead of it.
+
+    The lead calibrates itself. A report that only went out a poll after the one it was built
+    for (the console polled before it was queued) adds LEAD_STEP_US, LEAD_RELAX_POLLS on time
+    polls in a row take one step back off. Completions are seen from tud_task, a little after the
+    poll, so the offset tracks the earliest ones and only drifts up slowly.
+
+    While the last report is still queued (a late one, waiting for the next poll) building
+    is held off, and after BUSY_TIMEOUT_POLLS of that the driver runs anyway for whatever
+    else it does in process(), OUT reports and such.
+
+    Until there are SOFs and a poll to go by (not mounted, suspended, nothing sent yet)
+    begin() is always true, same as building on every pass. sof() is IRQ safe, the rest is
+    core0 only. */
+
+class SofSync
+{
+public:
+    static constexpr uint32_t FRAME_US = 1000;
+    static constexpr uint32_t LEAD_STEP_US = 50;
+    static constexpr uint32_t LEAD_RELAX_POLLS = 1000;
+    static constexpr uint32_t MIN_LEAD_US = 50;
+    static constexpr uint32_t MAX_LEAD_US = FRAME_US - 100;
+    static constexpr uint32_t BUSY_TIMEOUT_POLLS = 4;
+
+    struct Stats
+    {
+        uint32_t polls{0};
+        uint32_t late{0};                   //Built after the poll it was meant for
+        uint32_t age_min_us{UINT32_MAX};    //Build to IN completion
+        uint32_t age_max_us{0};
+        uint64_t age_total_us{0};
+        uint32_t phase_min_us{UINT32_MAX};  //IN completion after SOF, max - min is the jitter
+        uint32_t phase_max_us{0};
+        uint32_t lead_us{0};
+
+        inline uint32_t age_avg_us() const { return polls ? static_cast<uint32_t>(age_total_us / polls) : 0; }
+        inline uint32_t jitter_us() const { return (phase_max_us >= phase_min_us) ? (phase_max_us - phase_min_us) : 0; }
+    };
+
+    explicit SofSync(uint32_t lead_us)
+        : lead_us_(std::clamp(lead_us, MIN_LEAD_US, MAX_LEAD_US)) {}
+
+    //USB IRQ, start of every frame
+    inline void sof(uint32_t now_us)
+    {
+        sof_us_.store(now_us, std::memory_order_relaxed);
+        sof_seen_.store(true, std::memory_order_release);
+    }
+
+    //Poll interval in frames, from what the console was measured at
+    inline void set_interval_frames(uint8_t frames)
+    {
+        interval_frames_ = std::max(frames, static_cast<uint8_t>(1));
+    }
+
+    //True if reports should be built on this pass, once per poll. While the last report is
+    //still queued nothing new can go out, the slot stays open for when it's taken
+    inline bool begin(uint32_t now_us, bool ep_busy)
+    {
+        if (!synced(now_us))
+        {
+            busy_ = false;
+            return true;
+        }
+        if (ep_busy)
+        {
+            if (!busy_)
+            {
+                busy_ = true;
+                busy_since_us_ = now_us;
+            }
+            //Console stopped taking reports, let the driver run for whatever else it does
+            return (now_us - busy_since_us_) >= BUSY_TIMEOUT_POLLS * interval_frames_ * FRAME_US;
+        }
+        busy_ = false;
+        const uint32_t next_us = next_poll_us(now_us);
+        if ((built_ && same_slot(next_us, built_for_us_)) ||
+            static_cast<int32_t>(next_us - lead_us_ - now_us) > 0)
+        {
+            return false;
+        }
+        built_for_us_ = next_us;
+        built_us_ = now_us;
+        built_ = true;
+        return true;
+    }
+
+    //How long core0 can idle before the next build, at most max_us
+    inline uint32_t idle_us(uint32_t now_us, uint32_t max_us) const
+    {
+        if (!synced(now_us))
+        {
+            return max_us;
+        }
+        uint32_t next_us = next_poll_us(now_us);
+        if (built_ && same_slot(next_us, built_for_us_))
+        {
+            next_us += interval_frames_ * FRAME_US;
+        }
+        const int32_t wait_us = static_cast<int32_t>(next_us - lead_us_ - now_us);
+        return (wait_us <= 0) ? 0 : std::min(static_cast<uint32_t>(wait_us), max_us);
+    }
+
+    //IN transfer of the gamepad endpoint completed
+    inline void polled(uint32_t now_us)
+    {
+        if (!sof_seen_.load(std::memory_order_acquire))
+        {
+            return;
+        }
+        const uint32_t phase_us = (now_us - sof_us_.load(std::memory_order_relaxed)) % FRAME_US;
+
+        //Circular, a poll late in the frame can complete after the next SOF
+        int32_t behind_us = polled_ ? frame_diff(phase_us, poll_offset_us_) : 0;
+        if (behind_us <= 0)
+        {
+            poll_offset_us_ = phase_us;
+            behind_us = 0;
+        }
+        else
+        {
+            const uint32_t step_us = (behind_us + 15) / 16;
+            poll_offset_us_ = (poll_offset_us_ + step_us) % FRAME_US;
+            behind_us -= step_us;
+        }
+        last_poll_sof_us_ = now_us - behind_us - poll_offset_us_;
+        polled_ = true;
+
+        ++stats_.polls;
+        stats_.phase_min_us = std::min(stats_.phase_min_us, phase_us);
+        stats_.phase_max_us = std::max(stats_.phase_max_us, phase_us);
+
+        if (!built_)
+        {
+            return;
+        }
+        const uint32_t age_us = now_us - built_us_;
+        stats_.age_min_us = std::min(stats_.age_min_us, age_us);
+        stats_.age_max_us = std::max(stats_.age_max_us, age_us);
+        stats_.age_total_us += age_us;
+
+        if (static_cast<int32_t>(now_us - built_for_us_) >= static_cast<int32_t>(FRAME_US / 2))
+        {
+            ++stats_.late;
+            on_time_ = 0;
+            lead_us_ = std::min(lead_us_ + LEAD_STEP_US, MAX_LEAD_US);
+        }
+        else if (++on_time_ >= LEAD_RELAX_POLLS)
+        {
+            on_time_ = 0;
+            lead_us_ = std::max(lead_us_ - LEAD_STEP_US, MIN_LEAD_US);
+        }
+    }
+
+    inline Stats stats() const
+    {
+        Stats stats = stats_;
+        stats.lead_us = lead_us_;
+        return stats;
+    }
+
+    inline void restart_stats() { stats_ = Stats(); }
+
+    inline uint32_t lead_us() const { return lead_us_; }
+
+private:
+    std::atomic<uint32_t> sof_us_{0};
+    std::atomic<bool> sof_seen_{false};
+
+    uint32_t lead_us_;
+    uint32_t poll_offset_us_{0};
+    uint32_t last_poll_sof_us_{0};
+    uint32_t built_for_us_{0};
+    uint32_t built_us_{0};
+    uint32_t on_time_{0};
+    uint32_t busy_since_us_{0};
+    uint8_t interval_frames_{1};
+    bool polled_{false};
+    bool built_{false};
+    bool busy_{false};
+
+    Stats stats_;
+
+    //A few frames without SOF is a suspended or unplugged bus
+    inline bool synced(uint32_t now_us) const
+    {
+        return polled_ && sof_seen_.load(std::memory_order_acquire) &&
+               ((now_us - sof_us_.load(std::memory_order_relaxed)) < 3 * FRAME_US);
+    }
+
+    //a - b within a frame, -FRAME_US / 2 to FRAME_US / 2
+    static inline int32_t frame_diff(uint32_t a_us, uint32_t b_us)
+    {
+        int32_t diff = static_cast<int32_t>((a_us + FRAME_US - b_us) % FRAME_US);
+        return (diff >= static_cast<int32_t>(FRAME_US / 2)) ? (diff - static_cast<int32_t>(FRAME_US)) : diff;
+    }
+
+    static inline bool same_slot(uint32_t a_us, uint32_t b_us)
+    {
+        const int32_t diff = static_cast<int32_t>(a_us - b_us);
+        return (diff < static_cast<int32_t>(FRAME_US / 2)) && (diff > -static_cast<int32_t>(FRAME_US / 2));
+    }
+
+    //First poll after now_us, on the frames the console polls
+    inline uint32_t next_poll_us(uint32_t now_us) const
+    {
+        const uint32_t sof_us = sof_us_.load(std::memory_order_relaxed);
+        const uint32_t frames = (sof_us - last_poll_sof_us_ + FRAME_US / 2) / FRAME_US;
+        const uint32_t ahead = (interval_frames_ - (frames % interval_frames_)) % interval_frames_;
+        uint32_t next_us = sof_us + ahead * FRAME_US + poll_offset_us_;
+        while (static_cast<int32_t>(next_us - now_us) <= 0)
+        {
+            next_us += interval_frames_ * FRAME_US;
+        }
+        return next_us;
+    }
+};
+
+#endif // _SOF_SYNC_H_
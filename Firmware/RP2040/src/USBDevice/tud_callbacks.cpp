@@ -5,11 +5,71 @@
 #include "device/usbd_pvt.h"
 
 #include "USBDevice/DeviceManager.h"
+#include "Board/latency_trace.h"
+
+//The driver's class driver with xfer_cb wrapped so IN completions reach latency tracing and the poll meter
+static usbd_class_driver_t wrapped_class_driver_;
+static decltype(usbd_class_driver_t::xfer_cb) driver_xfer_cb_{nullptr};
+
+static bool wrapped_xfer_cb(uint8_t rhport, uint8_t ep_addr, xfer_result_t result, uint32_t xferred_bytes)
+{
+	if ((tu_edpt_dir(ep_addr) == TUSB_DIR_IN) && (result == XFER_RESULT_SUCCESS))
+	{
+		latency_trace::report_sent();
+		DeviceManager::get_instance().report_sent(ep_addr);
+	}
+	return driver_xfer_cb_(rhport, ep_addr, result, xferred_bytes);
+}
+
+#if defined(CONFIG_EN_SOF_SYNC)
+
+static decltype(usbd_class_driver_t::sof) driver_sof_{nullptr};
+
+//Called from the USB IRQ, stamps the frame start for SOF synced reports
+static void wrapped_sof(uint8_t rhport, uint32_t frame_count)
+{
+	DeviceManager::get_instance().sof();
+	if (driver_sof_)
+	{
+		driver_sof_(rhport, frame_count);
+	}
+}
+
+void tud_mount_cb()
+{
+	tud_sof_cb_enable(true);
+}
+
+#endif // CONFIG_EN_SOF_SYNC
+
+static void wrap_class_driver()
+{
+	wrapped_class_driver_ = *DeviceManager::get_instance().get_driver()->get_class_driver();
+	driver_xfer_cb_ = wrapped_class_driver_.xfer_cb;
+	wrapped_class_driver_.xfer_cb = wrapped_xfer_cb;
+#if defined(CONFIG_EN_SOF_SYNC)
+	driver_sof_ = wrapped_class_driver_.sof;
+	wrapped_class_driver_.sof = wrapped_sof;
+#endif // CONFIG_EN_SOF_SYNC
+}
 
 const usbd_class_driver_t *usbd_app_driver_get_cb(uint8_t *driver_count) 
 {
 	*driver_count = 1;
-	return DeviceManager::get_instance().get_driver()->get_class_driver();
+	wrap_class_driver();
+	return &wrapped_class_driver_;
+}
+
+//TinyUSB only asks for the app driver in tud_init and keeps the pointer, so a new device driver
+//is swapped in behind it: the old class is deinitialized and the new one initialized in its place
+void tud_app_driver_refresh()
+{
+	if (wrapped_class_driver_.deinit)
+	{
+		wrapped_class_driver_.deinit();
+	}
+	wrap_class_driver();
+	wrapped_class_driver_.init();
 }
 
 uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen) 
@@ -45,7 +105,7 @@ uint8_t const *tud_hid_descriptor_report_cb(uint8_t itf)
 
 uint8_t const *tud_descriptor_configuration_cb(uint8_t index) 
 {
-	return DeviceManager::get_instance().get_driver()->get_descriptor_configuration_cb(index);
+	return DeviceManager::get_instance().get_descriptor_configuration(index);
 }
 
 uint8_t const* tud_descriptor_device_qualifier_cb() 
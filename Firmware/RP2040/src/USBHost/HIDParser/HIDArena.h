@@ -0,0 +1,66 @@
+#ifndef _HID_ARENA_H_
+#define _HID_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+/*  Bump allocator over a caller supplied buffer, for parsing HID descriptors without the heap.
+
+    Nothing is freed on its own, reset() drops everything at once. When the buffer runs out
+    create() returns nullptr and exhausted() latches so the parser can bail out cleanly.
+    peak() is the most that was in use since construction, across resets. */
+
+class HIDArena
+{
+public:
+    HIDArena(uint8_t* buffer, size_t size)
+        : buffer_(buffer), size_(size) {}
+
+    template <typename T>
+    T* create()
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "HIDArena: types are never destroyed");
+        void* memory = allocate(sizeof(T), alignof(T));
+        return memory ? ::new (memory) T() : nullptr;
+    }
+
+    void* allocate(size_t size, size_t align)
+    {
+        const uintptr_t base = reinterpret_cast<uintptr_t>(buffer_);
+        const uintptr_t start = (base + used_ + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        const size_t end = static_cast<size_t>(start - base) + size;
+        if (end > size_)
+        {
+            exhausted_ = true;
+            return nullptr;
+        }
+        used_ = end;
+        if (peak_ < used_)
+        {
+            peak_ = used_;
+        }
+        return reinterpret_cast<void*>(start);
+    }
+
+    inline void reset()
+    {
+        used_ = 0;
+        exhausted_ = false;
+    }
+
+    inline size_t used() const { return used_; }
+    inline size_t peak() const { return peak_; }
+    inline size_t size() const { return size_; }
+    inline bool exhausted() const { return exhausted_; }
+
+private:
+    uint8_t* buffer_{nullptr};
+    size_t size_{0};
+    size_t used_{0};
+    size_t peak_{0};
+    bool exhausted_{false};
+};
+
+#endif // _HID_ARENA_H_
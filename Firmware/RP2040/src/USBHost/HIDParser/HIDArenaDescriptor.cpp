@@ -0,0 +1,323 @@
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "USBHost/HIDParser/HIDReportDescriptorElements.h"
+
+//Same item and usage handling as HIDReportDescriptorElements, HIDReportDescriptorUsages::parse
+//and HIDReportDescriptor::parse, quirks included, so the two give the same reports
+
+namespace
+{
+    constexpr uint8_t ITEM_TYPE_MASK = 0xFC;
+    constexpr uint8_t ITEM_SIZE_MASK = 0x03;
+    constexpr uint32_t COLLECTION_APPLICATION = 0x01;
+
+    constexpr uint32_t USAGE_PAGE_GENERIC_DESKTOP = 0x01;
+    constexpr uint32_t USAGE_PAGE_BUTTON = 0x09;
+    constexpr uint32_t USAGE_PAGE_VENDOR_DEFINED = 0xFF00;
+
+    HIDUsageType usage_page_type(uint32_t usage_page)
+    {
+        switch (usage_page)
+        {
+            case USAGE_PAGE_BUTTON:
+                return HIDUsageType::Button;
+            case USAGE_PAGE_GENERIC_DESKTOP:
+                return HIDUsageType::GenericDesktop;
+            case USAGE_PAGE_VENDOR_DEFINED:
+                return HIDUsageType::VendorDefined;
+            default:
+                return HIDUsageType::Unknown;
+        }
+    }
+
+    HIDIOType io_type(HIDUsageType type, uint32_t sub_type)
+    {
+        switch (type)
+        {
+            case HIDUsageType::GenericDesktop:
+                switch (static_cast<HIDUsageGenericDesktopSubType>(sub_type))
+                {
+                    case HIDUsageGenericDesktopSubType::X:
+                        return HIDIOType::X;
+                    case HIDUsageGenericDesktopSubType::Y:
+                        return HIDIOType::Y;
+                    case HIDUsageGenericDesktopSubType::Z:
+                        return HIDIOType::Z;
+                    case HIDUsageGenericDesktopSubType::Rx:
+                        return HIDIOType::Rx;
+                    case HIDUsageGenericDesktopSubType::Ry:
+                        return HIDIOType::Ry;
+                    case HIDUsageGenericDesktopSubType::Rz:
+                        return HIDIOType::Rz;
+                    case HIDUsageGenericDesktopSubType::Slider:
+                        return HIDIOType::Slider;
+                    case HIDUsageGenericDesktopSubType::Dial:
+                        return HIDIOType::Dial;
+                    case HIDUsageGenericDesktopSubType::HatSwitch:
+                        return HIDIOType::HatSwitch;
+                    case HIDUsageGenericDesktopSubType::Wheel:
+                        return HIDIOType::Wheel;
+                    default:
+                        return HIDIOType::Unknown;
+                }
+            case HIDUsageType::Button:
+                return HIDIOType::Button;
+            case HIDUsageType::ReportId:
+                return HIDIOType::ReportId;
+            case HIDUsageType::Padding:
+                return HIDIOType::Padding;
+            case HIDUsageType::VendorDefined:
+                return HIDIOType::VendorDefined;
+            default:
+                return HIDIOType::Unknown;
+        }
+    }
+}
+
+HIDArenaDescriptor::Status HIDArenaDescriptor::fail(Status status)
+{
+    first_report_ = nullptr;
+    last_report_ = nullptr;
+    stats_.status = status;
+    return status;
+}
+
+HIDArenaDescriptor::Status HIDArenaDescriptor::parse(const uint8_t* data, uint16_t len, HIDArena& arena)
+{
+    first_report_ = nullptr;
+    last_report_ = nullptr;
+    stats_ = Stats();
+    stats_.arena_size = static_cast<uint32_t>(arena.size());
+
+    const size_t arena_start = arena.used();
+
+    PendingUsage usages[MAX_PENDING_USAGES];
+    uint8_t num_usages = 0;
+    Property property;
+    HIDUsageType page_type = HIDUsageType::Unknown;
+    uint8_t report_id = 0;
+
+    uint32_t offset = 0;
+    while (offset < len)
+    {
+        const uint8_t prefix = data[offset];
+        const uint8_t item_size = ((prefix & ITEM_SIZE_MASK) == 3) ? 4 : (prefix & ITEM_SIZE_MASK);
+        if (offset + 1 + item_size > len)
+        {
+            //Truncated last item
+            break;
+        }
+
+        const uint8_t* item = &data[offset + 1];
+        offset += 1 + item_size;
+
+        uint32_t value = 0;
+        for (uint8_t i = 0; i < item_size; ++i)
+        {
+            value |= static_cast<uint32_t>(item[i]) << (8 * i);
+        }
+        const int32_t value_signed = (item_size == 1) ? static_cast<int8_t>(value)
+                                   : (item_size == 2) ? static_cast<int16_t>(value)
+                                   : static_cast<int32_t>(value);
+
+        switch (static_cast<HIDElementType>(prefix & ITEM_TYPE_MASK))
+        {
+            case HIDElementType::HID_USAGE_PAGE:
+                page_type = usage_page_type(value);
+                break;
+
+            case HIDElementType::HID_USAGE:
+                if (num_usages >= MAX_PENDING_USAGES)
+                {
+                    return fail(Status::TOO_MANY_USAGES);
+                }
+                usages[num_usages++] = { page_type, value, value, value };
+                break;
+
+            case HIDElementType::HID_USAGE_MINIMUM:
+            case HIDElementType::HID_USAGE_MAXIMUM:
+                if (num_usages == 0)
+                {
+                    usages[num_usages++] = { page_type, 0, 0, 0 };
+                }
+                for (uint8_t i = 0; i < num_usages; ++i)
+                {
+                    if ((prefix & ITEM_TYPE_MASK) == static_cast<uint8_t>(HIDElementType::HID_USAGE_MINIMUM))
+                    {
+                        usages[i].usage_min = value;
+                    }
+                    else
+                    {
+                        usages[i].usage_max = value;
+                    }
+                }
+                break;
+
+            case HIDElementType::HID_REPORT_ID:
+                report_id = static_cast<uint8_t>(value);
+                break;
+
+            case HIDElementType::HID_LOGICAL_MINIMUM:
+                property.logical_min = value_signed;
+                property.logical_min_unsigned = value;
+                break;
+
+            case HIDElementType::HID_LOGICAL_MAXIMUM:
+                property.logical_max = value_signed;
+                property.logical_max_unsigned = value;
+                break;
+
+            case HIDElementType::HID_REPORT_SIZE:
+                property.size = value;
+                break;
+
+            case HIDElementType::HID_REPORT_COUNT:
+                property.count = value;
+                break;
+
+            case HIDElementType::HID_INPUT:
+            case HIDElementType::HID_OUTPUT:
+            case HIDElementType::HID_FEATURE:
+            {
+                if (num_usages == 0)
+                {
+                    usages[num_usages++] = { HIDUsageType::Padding, 0, 0, 0 };
+                }
+
+                //Some controllers give unsigned maximums that read as negative
+                if (property.logical_max < property.logical_min)
+                {
+                    property.logical_max = static_cast<int32_t>(property.logical_max_unsigned);
+                }
+
+                const IO io = (prefix & ITEM_TYPE_MASK) == static_cast<uint8_t>(HIDElementType::HID_INPUT) ? IO::INPUT
+                            : (prefix & ITEM_TYPE_MASK) == static_cast<uint8_t>(HIDElementType::HID_OUTPUT) ? IO::OUTPUT
+                            : IO::FEATURE;
+
+                if (last_report_)
+                {
+                    if (report_id != 0)
+                    {
+                        Property id_property;
+                        id_property.size = 8;
+                        if (!add_usage({ HIDUsageType::ReportId, report_id, report_id, report_id }, io, id_property, 1, arena))
+                        {
+                            return fail(Status::ARENA_FULL);
+                        }
+                    }
+                    for (uint8_t i = 0; i < num_usages; ++i)
+                    {
+                        if (!add_usage(usages[i], io, property, property.count / num_usages, arena))
+                        {
+                            return fail(Status::ARENA_FULL);
+                        }
+                    }
+                }
+                report_id = 0;
+                num_usages = 0;
+                break;
+            }
+
+            case HIDElementType::HID_COLLECTION:
+                if (value == COLLECTION_APPLICATION)
+                {
+                    Report* report = arena.create<Report>();
+                    if (!report)
+                    {
+                        return fail(Status::ARENA_FULL);
+                    }
+                    if (last_report_)
+                    {
+                        last_report_->next = report;
+                    }
+                    else
+                    {
+                        first_report_ = report;
+                    }
+                    last_report_ = report;
+                    ++stats_.reports;
+                }
+                if (last_report_)
+                {
+                    for (uint8_t i = 0; i < num_usages; ++i)
+                    {
+                        add_usage(usages[i], NO_IO, property, 0, arena);
+                    }
+                }
+                num_usages = 0;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    stats_.arena_used = static_cast<uint32_t>(arena.used() - arena_start);
+    stats_.status = first_report_ ? Status::OK : Status::NO_REPORTS;
+    return stats_.status;
+}
+
+bool HIDArenaDescriptor::add_usage(const PendingUsage& usage, IO io, const Property& property, uint32_t count, HIDArena& arena)
+{
+    Report& report = *last_report_;
+
+    //The first usage in a collection names its type and is not a value
+    if (!report.has_type)
+    {
+        report.has_type = true;
+        report.report_type = static_cast<HIDIOReportType>(usage.sub_type);
+        return true;
+    }
+    if (io == NO_IO || count == 0)
+    {
+        return true;
+    }
+
+    const uint8_t io_idx = static_cast<uint8_t>(io);
+    const HIDIOType type = io_type(usage.type, usage.sub_type);
+
+    if (type == HIDIOType::ReportId || !report.last_block[io_idx])
+    {
+        Block* block = arena.create<Block>();
+        if (!block)
+        {
+            return false;
+        }
+        if (report.last_block[io_idx])
+        {
+            report.last_block[io_idx]->next = block;
+        }
+        else
+        {
+            report.first_block[io_idx] = block;
+        }
+        report.last_block[io_idx] = block;
+        ++stats_.blocks;
+    }
+
+    Run* run = arena.create<Run>();
+    if (!run)
+    {
+        return false;
+    }
+    run->type = type;
+    run->size = property.size;
+    run->count = count;
+    run->id = usage.usage_min;
+    run->logical_min = property.logical_min;
+    run->logical_max = property.logical_max;
+
+    Block& block = *report.last_block[io_idx];
+    if (block.last_run)
+    {
+        block.last_run->next = run;
+    }
+    else
+    {
+        block.first_run = run;
+    }
+    block.last_run = run;
+
+    ++stats_.runs;
+    stats_.values += count;
+    return true;
+}
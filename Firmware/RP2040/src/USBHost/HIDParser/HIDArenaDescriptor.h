@@ -0,0 +1,118 @@
+#ifndef _HID_ARENA_DESCRIPTOR_H_
+#define _HID_ARENA_DESCRIPTOR_H_
+
+#include <cstdint>
+
+#include "USBHost/HIDParser/HIDArena.h"
+#include "USBHost/HIDParser/HIDReportDescriptor.h"
+#include "USBHost/HIDParser/HIDReportDescriptorUsages.h"
+
+/*  HIDReportDescriptor parsed in one pass into a caller's HIDArena instead of nested vectors.
+
+    Gives the same reports, blocks and inputs/outputs as HIDReportDescriptor::GetReports, but a
+    Report Count of values with consecutive ids is kept as one Run instead of one HIDInputOutput
+    each, and only the logical range is kept. Everything points into the arena, so the result is
+    valid until the arena is reset. If the arena or the pending usage list fills up, parse fails
+    and nothing in the result is usable. */
+
+class HIDArenaDescriptor
+{
+public:
+    //Descriptors listing more Usages than this before one main item fail to parse
+    static constexpr uint8_t MAX_PENDING_USAGES = 32;
+
+    enum class Status : uint8_t
+    {
+        OK = 0,
+        NO_REPORTS,
+        ARENA_FULL,
+        TOO_MANY_USAGES
+    };
+
+    enum class IO : uint8_t
+    {
+        INPUT = 0,
+        OUTPUT,
+        FEATURE,
+        COUNT
+    };
+
+    //count values of size bits each, the n-th value's id is id + n
+    struct Run
+    {
+        Run* next;
+        HIDIOType type;
+        uint32_t size;
+        uint32_t count;
+        uint32_t id;
+        int32_t logical_min;
+        int32_t logical_max;
+    };
+
+    //Values sharing a report ID, a new block starts at each Report ID
+    struct Block
+    {
+        Block* next;
+        Run* first_run;
+        Run* last_run;
+    };
+
+    //One application collection
+    struct Report
+    {
+        Report* next;
+        HIDIOReportType report_type;
+        bool has_type;
+        Block* first_block[static_cast<uint8_t>(IO::COUNT)];
+        Block* last_block[static_cast<uint8_t>(IO::COUNT)];
+
+        inline const Block* blocks(IO io) const { return first_block[static_cast<uint8_t>(io)]; }
+    };
+
+    struct Stats
+    {
+        Status status{Status::NO_REPORTS};
+        uint16_t reports{0};
+        uint16_t blocks{0};
+        uint16_t runs{0};
+        uint32_t values{0};         //What HIDReportDescriptor would have made a HIDInputOutput each
+        uint32_t arena_used{0};     //Bytes, peak since nothing is freed mid parse
+        uint32_t arena_size{0};
+    };
+
+    Status parse(const uint8_t* data, uint16_t len, HIDArena& arena);
+
+    inline const Report* reports() const { return (stats_.status == Status::OK) ? first_report_ : nullptr; }
+    inline const Stats& stats() const { return stats_; }
+
+private:
+    //Usages attached by a Collection rather than a main item
+    static constexpr IO NO_IO = IO::COUNT;
+
+    struct PendingUsage
+    {
+        HIDUsageType type;
+        uint32_t sub_type;
+        uint32_t usage_min;
+        uint32_t usage_max;
+    };
+
+    struct Property
+    {
+        int32_t logical_min{0};
+        uint32_t logical_min_unsigned{0};
+        int32_t logical_max{0};
+        uint32_t logical_max_unsigned{0};
+        uint32_t size{0};
+        uint32_t count{0};
+    };
+
+    Report* first_report_{nullptr};
+    Report* last_report_{nullptr};
+    Stats stats_;
+
+    bool add_usage(const PendingUsage& usage, IO io, const Property& property, uint32_t count, HIDArena& arena);
+    Status fail(Status status);
+};
+
+#endif // _HID_ARENA_DESCRIPTOR_H_
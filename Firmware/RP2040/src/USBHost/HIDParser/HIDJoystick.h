@@ -22,6 +22,8 @@
     SOFTWARE.
 */
 
+#pragma once
+
 #include "USBHost/HIDParser/HIDReportDescriptor.h"
 #include <memory>
 #include <vector>
@@ -0,0 +1,409 @@
+#include <cstring>
+#include <limits>
+
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
+
+namespace
+{
+    //Indexed by Target - Target::X
+    constexpr int16_t HIDJoystickData::* AXES[] =
+    {
+        &HIDJoystickData::X,
+        &HIDJoystickData::Y,
+        &HIDJoystickData::Z,
+        &HIDJoystickData::Rx,
+        &HIDJoystickData::Ry,
+        &HIDJoystickData::Rz,
+        &HIDJoystickData::Slider,
+        &HIDJoystickData::Dial
+    };
+
+    //Longest report the plan can index, uint16_t byte offsets
+    constexpr uint64_t MAX_REPORT_BITS = static_cast<uint64_t>(std::numeric_limits<uint16_t>::max()) * 8;
+
+    //Types compile_field can turn into a field, the rest are only skipped over
+    inline bool plan_type(HIDIOType type)
+    {
+        switch (type)
+        {
+            case HIDIOType::Button:
+            case HIDIOType::HatSwitch:
+            case HIDIOType::X:
+            case HIDIOType::Y:
+            case HIDIOType::Z:
+            case HIDIOType::Rx:
+            case HIDIOType::Ry:
+            case HIDIOType::Rz:
+            case HIDIOType::Slider:
+            case HIDIOType::Dial:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    constexpr uint16_t AXIS_SUPPORT[] =
+    {
+        JOYSTICK_SUPPORT_X,
+        JOYSTICK_SUPPORT_Y,
+        JOYSTICK_SUPPORT_Z,
+        JOYSTICK_SUPPORT_Rx,
+        JOYSTICK_SUPPORT_Ry,
+        JOYSTICK_SUPPORT_Rz,
+        JOYSTICK_SUPPORT_Slider,
+        JOYSTICK_SUPPORT_Dial
+    };
+}
+
+void HIDJoystickPlan::clear()
+{
+    num_fields_ = 0;
+    num_reports_ = 0;
+    no_id_report_ = NONE;
+    joystick_count_ = 0;
+    report_lookup_.fill(NONE);
+}
+
+bool HIDJoystickPlan::compile(const HIDArenaDescriptor& descriptor)
+{
+    clear();
+
+    for (auto report = descriptor.reports(); report; report = report->next)
+    {
+        if (report->report_type != HIDIOReportType::Joystick &&
+            report->report_type != HIDIOReportType::GamePad)
+        {
+            continue;
+        }
+
+        const uint8_t joystick_index = joystick_count_++;
+
+        for (auto block = report->blocks(HIDArenaDescriptor::IO::INPUT); block; block = block->next)
+        {
+            if (num_reports_ >= MAX_REPORTS)
+            {
+                return valid();
+            }
+            compile_block(*block, joystick_index);
+        }
+    }
+    return valid();
+}
+
+bool HIDJoystickPlan::compile_block(const HIDArenaDescriptor::Block& block, uint8_t joystick_index)
+{
+    Report report = {};
+    report.joystick_index = joystick_index;
+    report.first_field = num_fields_;
+
+    uint32_t bit_offset = 0;
+
+    for (auto run = block.first_run; run; run = run->next)
+    {
+        if (run->type == HIDIOType::ReportId)
+        {
+            //Always the first byte of the block
+            if (run != block.first_run || run->size != 8 || run->id == 0 || run->id > 0xFF)
+            {
+                num_fields_ = report.first_field;
+                return false;
+            }
+            report.report_id = static_cast<uint8_t>(run->id);
+            bit_offset += run->size;
+            continue;
+        }
+
+        const uint64_t run_end = bit_offset + static_cast<uint64_t>(run->size) * run->count;
+        if (run_end > MAX_REPORT_BITS)
+        {
+            num_fields_ = report.first_field;
+            return false;
+        }
+
+        for (uint32_t i = 0; i < run->count && plan_type(run->type); ++i, bit_offset += run->size)
+        {
+            Field field;
+            if (!compile_field(*run, run->id + i, bit_offset, field))
+            {
+                continue;
+            }
+            if (num_fields_ >= MAX_FIELDS)
+            {
+                //Out of room, a partial report would read stale values so drop all of it
+                num_fields_ = report.first_field;
+                return false;
+            }
+            fields_[num_fields_++] = field;
+
+            if (field.target == Target::BUTTON)
+            {
+                if (report.button_count < field.button)
+                {
+                    report.button_count = field.button;
+                }
+            }
+            else if (field.target == Target::HAT)
+            {
+                report.support |= JOYSTICK_SUPPORT_HatSwitch;
+            }
+            else
+            {
+                report.support |= AXIS_SUPPORT[static_cast<uint8_t>(field.target) - static_cast<uint8_t>(Target::X)];
+            }
+        }
+        bit_offset = static_cast<uint32_t>(run_end);
+    }
+
+    report.num_fields = static_cast<uint8_t>(num_fields_ - report.first_field);
+    report.min_len = static_cast<uint16_t>((bit_offset + 7) / 8);
+
+    //First block wins for repeated IDs, same as HIDJoystick walking the reports in order
+    if (report.report_id == 0)
+    {
+        if (no_id_report_ != NONE)
+        {
+            num_fields_ = report.first_field;
+            return false;
+        }
+        no_id_report_ = num_reports_;
+    }
+    else if (report_lookup_[report.report_id] == NONE)
+    {
+        report_lookup_[report.report_id] = num_reports_;
+    }
+    else
+    {
+        num_fields_ = report.first_field;
+        return false;
+    }
+
+    reports_[num_reports_++] = report;
+    return true;
+}
+
+bool HIDJoystickPlan::compile_field(const HIDArenaDescriptor::Run& run, uint32_t id, uint32_t bit_offset, Field& field)
+{
+    if (run.size == 0 || run.size > 32)
+    {
+        return false;
+    }
+
+    field = {};
+    field.byte_offset = static_cast<uint16_t>(bit_offset / 8);
+    field.bit_shift = static_cast<uint8_t>(bit_offset % 8);
+    field.bit_size = static_cast<uint8_t>(run.size);
+    field.mask = (run.size == 32) ? 0xFFFFFFFF : ((1u << run.size) - 1);
+
+    switch (run.type)
+    {
+        case HIDIOType::Button:
+            if (id >= MAX_BUTTONS)
+            {
+                return false;
+            }
+            field.target = Target::BUTTON;
+            field.button = static_cast<uint8_t>(id);
+            return true;
+        case HIDIOType::HatSwitch:
+            field.target = Target::HAT;
+            return true;
+        case HIDIOType::X:
+            field.target = Target::X;
+            break;
+        case HIDIOType::Y:
+            field.target = Target::Y;
+            break;
+        case HIDIOType::Z:
+            field.target = Target::Z;
+            break;
+        case HIDIOType::Rx:
+            field.target = Target::RX;
+            break;
+        case HIDIOType::Ry:
+            field.target = Target::RY;
+            break;
+        case HIDIOType::Rz:
+            field.target = Target::RZ;
+            break;
+        case HIDIOType::Slider:
+            field.target = Target::SLIDER;
+            break;
+        case HIDIOType::Dial:
+            field.target = Target::DIAL;
+            break;
+        default:
+            return false;
+    }
+
+    int64_t range = static_cast<int64_t>(run.logical_max) - run.logical_min;
+    if (range > 0)
+    {
+        field.logical_min = run.logical_min;
+        field.is_signed = (run.logical_min < 0);
+    }
+    else
+    {
+        //No usable logical range, assume the field's full unsigned width
+        range = field.mask;
+        field.logical_min = 0;
+    }
+
+    field.range = static_cast<uint32_t>(range);
+    while ((field.range >> field.pre_shift) > 0xFFFF)
+    {
+        ++field.pre_shift;
+    }
+    field.scale = 0xFFFF0000u / (field.range >> field.pre_shift);
+    return true;
+}
+
+size_t HIDJoystickPlan::save(uint8_t* buffer, size_t size) const
+{
+    const size_t reports_len = sizeof(Report) * num_reports_;
+    const size_t fields_len = sizeof(Field) * num_fields_;
+    const size_t len = sizeof(ImageHeader) + reports_len + fields_len;
+    if (!valid() || len > size)
+    {
+        return 0;
+    }
+
+    const ImageHeader header = { num_fields_, num_reports_, joystick_count_, 0 };
+    std::memcpy(buffer, &header, sizeof(header));
+    std::memcpy(buffer + sizeof(header), reports_.data(), reports_len);
+    std::memcpy(buffer + sizeof(header) + reports_len, fields_.data(), fields_len);
+    return len;
+}
+
+bool HIDJoystickPlan::load(const uint8_t* data, size_t len)
+{
+    clear();
+
+    ImageHeader header;
+    if (len < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.num_reports == 0 || header.num_reports > MAX_REPORTS || header.num_fields > MAX_FIELDS ||
+        len != sizeof(header) + sizeof(Report) * header.num_reports + sizeof(Field) * header.num_fields)
+    {
+        return false;
+    }
+
+    std::memcpy(reports_.data(), data + sizeof(header), sizeof(Report) * header.num_reports);
+    std::memcpy(fields_.data(), data + sizeof(header) + sizeof(Report) * header.num_reports, sizeof(Field) * header.num_fields);
+
+    //parse trusts every offset, so anything compile couldn't have produced is rejected
+    for (uint8_t i = 0; i < header.num_reports; ++i)
+    {
+        const Report& report = reports_[i];
+        if (report.first_field + report.num_fields > header.num_fields ||
+            report.joystick_index >= header.joystick_count ||
+            report.button_count > MAX_BUTTONS)
+        {
+            clear();
+            return false;
+        }
+
+        for (uint8_t j = report.first_field; j < report.first_field + report.num_fields; ++j)
+        {
+            const Field& field = fields_[j];
+            const bool axis = (field.target >= Target::X);
+            if (field.bit_size == 0 || field.bit_size > 32 || field.bit_shift > 7 ||
+                field.mask != ((field.bit_size == 32) ? 0xFFFFFFFF : ((1u << field.bit_size) - 1)) ||
+                field.target > Target::DIAL || (field.target == Target::BUTTON && field.button >= MAX_BUTTONS) ||
+                field.byte_offset + ((field.bit_shift + field.bit_size + 7u) / 8) > report.min_len ||
+                *reinterpret_cast<const uint8_t*>(&field.is_signed) > 1 ||
+                (axis && (field.pre_shift > 16 || (field.range >> field.pre_shift) == 0 || (field.range >> field.pre_shift) > 0xFFFF)))
+            {
+                clear();
+                return false;
+            }
+        }
+
+        uint8_t& lookup = (report.report_id == 0) ? no_id_report_ : report_lookup_[report.report_id];
+        if (lookup != NONE)
+        {
+            clear();
+            return false;
+        }
+        lookup = i;
+    }
+
+    num_fields_ = header.num_fields;
+    num_reports_ = header.num_reports;
+    joystick_count_ = header.joystick_count;
+    return true;
+}
+
+static inline uint32_t read_field(const uint8_t* data, uint16_t byte_offset, uint8_t bit_shift, uint8_t bit_size, uint32_t mask)
+{
+    const uint8_t* bytes = data + byte_offset;
+    uint32_t value = bytes[0] >> bit_shift;
+    for (uint32_t bits = 8u - bit_shift, i = 1; bits < bit_size; bits += 8, ++i)
+    {
+        value |= static_cast<uint32_t>(bytes[i]) << bits;
+    }
+    return value & mask;
+}
+
+bool HIDJoystickPlan::parse(const uint8_t* data, uint16_t len, HIDJoystickData& joystick_data) const
+{
+    uint8_t report_idx = no_id_report_;
+    if (len > 0)
+    {
+        const uint8_t id_report_idx = report_lookup_[data[0]];
+        if (id_report_idx < report_idx)
+        {
+            report_idx = id_report_idx;
+        }
+    }
+    if (report_idx == NONE || len < reports_[report_idx].min_len)
+    {
+        return false;
+    }
+
+    const Report& report = reports_[report_idx];
+    const Field* field = &fields_[report.first_field];
+    const Field* end = field + report.num_fields;
+
+    for (; field != end; ++field)
+    {
+        const uint32_t raw = read_field(data, field->byte_offset, field->bit_shift, field->bit_size, field->mask);
+
+        if (field->target == Target::BUTTON)
+        {
+            joystick_data.buttons[field->button] = static_cast<uint8_t>(raw);
+            continue;
+        }
+        if (field->target == Target::HAT)
+        {
+            joystick_data.hat_switch = static_cast<HIDJoystickHatSwitch>(raw);
+            continue;
+        }
+
+        int64_t value = raw;
+        if (field->is_signed && (raw & ~(field->mask >> 1)))
+        {
+            value = static_cast<int32_t>(raw | ~field->mask);
+        }
+
+        int16_t axis = std::numeric_limits<int16_t>::min();
+        if (value > field->logical_min)
+        {
+            const uint64_t offset = static_cast<uint64_t>(value - field->logical_min);
+            axis = (offset >= field->range)
+                ? std::numeric_limits<int16_t>::max()
+                : static_cast<int16_t>(static_cast<int32_t>(((static_cast<uint32_t>(offset) >> field->pre_shift) * field->scale) >> 16) - 32768);
+        }
+        joystick_data.*AXES[static_cast<uint8_t>(field->target) - static_cast<uint8_t>(Target::X)] = axis;
+    }
+
+    joystick_data.index = report.joystick_index;
+    joystick_data.support |= report.support;
+    if (joystick_data.button_count < report.button_count)
+    {
+        joystick_data.button_count = report.button_count;
+    }
+    return true;
+}
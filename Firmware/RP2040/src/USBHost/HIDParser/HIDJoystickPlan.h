@@ -0,0 +1,109 @@
+#ifndef _HID_JOYSTICK_PLAN_H_
+#define _HID_JOYSTICK_PLAN_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystick.h"
+
+/*  HIDJoystick::parseData flattened into a table when the device mounts.
+
+    Each joystick/gamepad input report gets a run of fields with their byte offset, shift and
+    mask worked out, and axes get a reciprocal scale so mapping to int16 is a multiply and a shift
+    instead of a divide. Reports are looked up by report ID, parsing one is a single walk over its
+    fields with no allocation or copying. Fields the output can't hold (padding, vendor defined,
+    buttons past MAX_BUTTONS, wider than 32 bits) are dropped at compile time. */
+
+class HIDJoystickPlan
+{
+public:
+    static constexpr uint8_t MAX_FIELDS = 64;
+    static constexpr uint8_t MAX_REPORTS = 8;
+
+    HIDJoystickPlan() { clear(); }
+
+    //Builds the plan from the parsed descriptor, returns false if it has no usable joystick/gamepad report.
+    //The descriptor and its arena can be dropped afterwards
+    bool compile(const HIDArenaDescriptor& descriptor);
+    void clear();
+
+    inline bool valid() const { return num_reports_ > 0; }
+    inline uint8_t joystick_count() const { return joystick_count_; }
+    inline uint8_t field_count() const { return num_fields_; }
+
+    //Same results as HIDJoystick::parseData, but fails before touching joystick_data if the report is too short
+    bool parse(const uint8_t* data, uint16_t len, HIDJoystickData& joystick_data) const;
+
+    //Flat copy of a compiled plan for HIDPlanCache, only readable by the same firmware build.
+    //save returns the bytes written or 0 if buffer is too small, load checks every index and
+    //offset before using it and leaves the plan cleared if anything is off
+    size_t save(uint8_t* buffer, size_t size) const;
+    bool load(const uint8_t* data, size_t len);
+    static constexpr size_t max_image_size() { return sizeof(ImageHeader) + sizeof(Report) * MAX_REPORTS + sizeof(Field) * MAX_FIELDS; }
+
+private:
+    static constexpr uint8_t NONE = 0xFF;
+
+    enum class Target : uint8_t
+    {
+        BUTTON = 0,
+        HAT,
+        X,
+        Y,
+        Z,
+        RX,
+        RY,
+        RZ,
+        SLIDER,
+        DIAL
+    };
+
+    struct Field
+    {
+        uint16_t byte_offset;
+        uint8_t bit_shift;
+        uint8_t bit_size;
+        Target target;
+        uint8_t button;     //Button index, BUTTON only
+        uint8_t pre_shift;  //Axis range is shifted down to 16 bits before scaling
+        bool is_signed;     //Sign extend, logical min is negative
+        uint32_t mask;
+        int32_t logical_min;
+        uint32_t range;     //logical max - logical min
+        uint32_t scale;     //0xFFFF0000 / (range >> pre_shift), (offset * scale) >> 16 maps to 0..0xFFFF
+    };
+
+    struct Report
+    {
+        uint8_t report_id;      //0 if the block has no report ID
+        uint8_t joystick_index;
+        uint8_t first_field;
+        uint8_t num_fields;
+        uint16_t min_len;       //Bytes needed to cover the whole block
+        uint16_t support;       //JOYSTICK_SUPPORT_ bits the fields set
+        uint8_t button_count;
+    };
+
+    struct ImageHeader
+    {
+        uint8_t num_fields;
+        uint8_t num_reports;
+        uint8_t joystick_count;
+        uint8_t reserved;
+    };
+
+    std::array<Field, MAX_FIELDS> fields_;
+    std::array<Report, MAX_REPORTS> reports_;
+    std::array<uint8_t, 0x100> report_lookup_; //Report ID to reports_ index
+    uint8_t num_fields_{0};
+    uint8_t num_reports_{0};
+    uint8_t no_id_report_{NONE};
+    uint8_t joystick_count_{0};
+
+    bool compile_block(const HIDArenaDescriptor::Block& block, uint8_t joystick_index);
+    static bool compile_field(const HIDArenaDescriptor::Run& run, uint32_t id, uint32_t bit_offset, Field& field);
+};
+
+#endif // _HID_JOYSTICK_PLAN_H_
@@ -0,0 +1,188 @@
+#include <cstring>
+
+#include "USBHost/HIDParser/HIDPlanCache.h"
+
+namespace
+{
+    //Bumped when HIDJoystickPlan's image changes shape without the build tag changing
+    constexpr uint32_t FORMAT_VERSION = 1;
+
+    constexpr uint32_t FNV_OFFSET = 0x811C9DC5;
+    constexpr uint32_t FNV_PRIME = 0x01000193;
+
+    //FNV-1a a word at a time, a quarter of the multiplies of the byte wise hash. Each step is
+    //a bijection of the running hash, so any single changed word always changes the result
+    inline uint32_t hash_words(uint32_t hash, const uint8_t* data, size_t len)
+    {
+        size_t i = 0;
+        for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t))
+        {
+            uint32_t word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+        for (; i < len; ++i)
+        {
+            hash = (hash ^ data[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    //Spreads the high bits back down, the multiply only carries upwards
+    inline uint32_t finalize(uint32_t hash)
+    {
+        hash ^= hash >> 16;
+        hash *= 0x85EBCA6B;
+        hash ^= hash >> 13;
+        return hash;
+    }
+}
+
+HIDPlanCache::Key HIDPlanCache::make_key(uint16_t vid, uint16_t pid, const uint8_t* report_desc, uint16_t desc_len)
+{
+    return { vid, pid, desc_len, 0, finalize(hash_words(FNV_OFFSET, report_desc, desc_len)) };
+}
+
+uint32_t HIDPlanCache::make_version(const char* build_tag)
+{
+    const uint32_t hash = hash_words(FNV_OFFSET, reinterpret_cast<const uint8_t*>(build_tag), std::strlen(build_tag));
+    return finalize(hash_words(hash, reinterpret_cast<const uint8_t*>(&FORMAT_VERSION), sizeof(FORMAT_VERSION)));
+}
+
+uint32_t HIDPlanCache::entry_check(const Header& header, const uint8_t* image)
+{
+    const uint32_t hash = hash_words(FNV_OFFSET, reinterpret_cast<const uint8_t*>(&header), offsetof(Header, check));
+    return hash_words(hash, image, header.image_len);
+}
+
+bool HIDPlanCache::valid_entry(const uint8_t* entry) const
+{
+    Header header;
+    std::memcpy(&header, entry, sizeof(header));
+    return header.magic == MAGIC && header.version == version_ &&
+           sizeof(Header) + header.image_len <= ENTRY_SIZE &&
+           header.check == entry_check(header, entry + sizeof(Header));
+}
+
+const HIDPlanCache::Header* HIDPlanCache::find(const Key& key) const
+{
+    for (uint8_t i = 0; i < num_pending_; ++i)
+    {
+        const Header* header = reinterpret_cast<const Header*>(pending_[i].data.data());
+        if (header->key == key)
+        {
+            return header;
+        }
+    }
+
+    //Key first so a miss only reads the headers
+    for (uint8_t i = 0; i < num_slots_; ++i)
+    {
+        const uint8_t* entry = slots_ + i * SLOT_SIZE;
+        const Header* header = reinterpret_cast<const Header*>(entry);
+        if (header->magic == MAGIC && header->key == key && valid_entry(entry))
+        {
+            return header;
+        }
+    }
+    return nullptr;
+}
+
+bool HIDPlanCache::load(const Key& key, HIDJoystickPlan& plan) const
+{
+    const Header* header = find(key);
+    if (!header)
+    {
+        plan.clear();
+        return false;
+    }
+    return plan.load(reinterpret_cast<const uint8_t*>(header) + sizeof(Header), header->image_len);
+}
+
+bool HIDPlanCache::store(const Key& key, const HIDJoystickPlan& plan)
+{
+    if (num_slots_ == 0 || num_pending_ >= MAX_PENDING || find(key))
+    {
+        return false;
+    }
+
+    Entry& entry = pending_[num_pending_];
+    entry.data.fill(0xFF);
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = version_;
+    header.key = key;
+
+    const size_t image_len = plan.save(entry.data.data() + sizeof(Header), ENTRY_SIZE - sizeof(Header));
+    if (image_len == 0)
+    {
+        return false;
+    }
+    header.image_len = static_cast<uint16_t>(image_len);
+    std::memcpy(entry.data.data(), &header, sizeof(header));
+
+    ++num_pending_;
+    return true;
+}
+
+uint8_t HIDPlanCache::flush()
+{
+    if (num_pending_ == 0 || !write_slot_)
+    {
+        return 0;
+    }
+
+    //Sequence numbers carry on from what's in flash, empty or stale slots go first
+    uint32_t next_sequence = 0;
+    std::array<bool, 256> slot_valid{};
+    for (uint8_t i = 0; i < num_slots_; ++i)
+    {
+        const uint8_t* entry = slots_ + i * SLOT_SIZE;
+        slot_valid[i] = valid_entry(entry);
+        if (slot_valid[i])
+        {
+            const uint32_t sequence = reinterpret_cast<const Header*>(entry)->sequence;
+            if (next_sequence <= sequence)
+            {
+                next_sequence = sequence + 1;
+            }
+        }
+    }
+
+    uint8_t written = 0;
+    for (uint8_t p = 0; p < num_pending_; ++p)
+    {
+        uint8_t victim = 0;
+        uint32_t oldest = UINT32_MAX;
+        for (uint8_t i = 0; i < num_slots_; ++i)
+        {
+            if (!slot_valid[i])
+            {
+                victim = i;
+                break;
+            }
+            const uint32_t sequence = reinterpret_cast<const Header*>(slots_ + i * SLOT_SIZE)->sequence;
+            if (sequence < oldest)
+            {
+                oldest = sequence;
+                victim = i;
+            }
+        }
+
+        uint8_t* data = pending_[p].data.data();
+        Header header;
+        std::memcpy(&header, data, sizeof(header));
+        header.sequence = next_sequence++;
+        header.check = entry_check(header, data + sizeof(Header));
+        std::memcpy(data, &header, sizeof(header));
+
+        const size_t len = ((sizeof(Header) + header.image_len + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+        write_slot_(victim, data, len);
+        slot_valid[victim] = true;
+        ++written;
+    }
+
+    num_pending_ = 0;
+    return written;
+}
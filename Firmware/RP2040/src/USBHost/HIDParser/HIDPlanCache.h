@@ -0,0 +1,106 @@
+#ifndef _HID_PLAN_CACHE_H_
+#define _HID_PLAN_CACHE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
+
+/*  Compiled HIDJoystickPlans kept in flash, keyed by VID/PID and a hash of the report descriptor,
+    so a pad that was seen before mounts without parsing its descriptor again.
+
+    Each slot is one flash sector holding a header and HIDJoystickPlan::save's image. Slots are
+    only readable by the build that wrote them, the version is a hash of the build tag, so a
+    firmware update drops the whole cache. Newly compiled plans wait in RAM (and are already
+    hits from there) until flush() writes them over the oldest slots, which has to be done from
+    core0 with core1 stopped or locked out. schedule_flush() does that a few seconds after a new
+    plan is stored, board_api::usb::disconnect_all flushes whatever is left before a reboot. */
+
+class HIDPlanCache
+{
+public:
+    //Plans compiled in one session that can wait for a flush, more are dropped until the next one
+    static constexpr uint8_t MAX_PENDING = 2;
+    static constexpr size_t SLOT_SIZE = 4096;   //One flash sector
+    static constexpr size_t PAGE_SIZE = 256;    //Flash program granularity
+
+    struct Key
+    {
+        uint16_t vid;
+        uint16_t pid;
+        uint16_t desc_len;
+        uint16_t reserved;
+        uint32_t desc_hash;
+
+        inline bool operator==(const Key& other) const
+        {
+            return vid == other.vid && pid == other.pid && desc_len == other.desc_len && desc_hash == other.desc_hash;
+        }
+    };
+
+    //Erases slot and programs len bytes (a multiple of PAGE_SIZE) from its start
+    using WriteSlot = void (*)(uint8_t slot, const uint8_t* data, size_t len);
+
+    //slots points at num_slots * SLOT_SIZE bytes of memory mapped storage
+    HIDPlanCache(const uint8_t* slots, uint8_t num_slots, uint32_t version, WriteSlot write_slot)
+        : slots_(slots), num_slots_(num_slots), version_(version), write_slot_(write_slot) {}
+
+    //The firmware's cache, HID_PLAN_CACHE_SLOTS sectors under the NVSTool sectors
+    static HIDPlanCache& get_instance();
+
+    static Key make_key(uint16_t vid, uint16_t pid, const uint8_t* report_desc, uint16_t desc_len);
+    static uint32_t make_version(const char* build_tag);
+
+    //Restores the plan stored for key, from RAM or flash, plan is cleared on a miss
+    bool load(const Key& key, HIDJoystickPlan& plan) const;
+
+    //Queues a compiled plan for the next flush, false if it's already cached or there's no room
+    bool store(const Key& key, const HIDJoystickPlan& plan);
+
+    //Core0 only, with core1 stopped or locked out. Writes the queued plans, returns how many slots were written
+    uint8_t flush();
+
+    //Firmware only. Flushes from a core0 task HID_PLAN_CACHE_FLUSH_DELAY_MS from now, core1 locked
+    //out through flash_safe_execute, another call before then pushes it back. Callable from either core
+    static void schedule_flush();
+
+    inline uint8_t pending() const { return num_pending_; }
+    inline uint8_t num_slots() const { return num_slots_; }
+
+private:
+    static constexpr uint32_t MAGIC = 0x4D50474F; //"OGPM"
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t sequence;  //Higher was written later, the lowest is replaced first
+        Key key;
+        uint16_t image_len;
+        uint16_t reserved;
+        uint32_t check;     //Over the header up to here and the image
+    };
+
+    static constexpr size_t ENTRY_SIZE = ((sizeof(Header) + HIDJoystickPlan::max_image_size() + PAGE_SIZE - 1) / PAGE_SIZE) * PAGE_SIZE;
+    static_assert(ENTRY_SIZE <= SLOT_SIZE, "HIDPlanCache: plan image doesn't fit a slot");
+
+    struct alignas(4) Entry
+    {
+        std::array<uint8_t, ENTRY_SIZE> data;
+    };
+
+    const uint8_t* slots_{nullptr};
+    uint8_t num_slots_{0};
+    uint32_t version_{0};
+    WriteSlot write_slot_{nullptr};
+
+    std::array<Entry, MAX_PENDING> pending_;
+    uint8_t num_pending_{0};
+
+    const Header* find(const Key& key) const;
+    bool valid_entry(const uint8_t* entry) const;
+    static uint32_t entry_check(const Header& header, const uint8_t* image);
+};
+
+#endif // _HID_PLAN_CACHE_H_
@@ -0,0 +1,56 @@
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include <pico/flash.h>
+
+#include "Board/Config.h"
+#include "Board/ogxm_log.h"
+#include "TaskQueue/TaskQueue.h"
+#include "USBHost/HIDParser/HIDPlanCache.h"
+
+//The cache sectors sit right under NVSTool's, at the end of flash and well clear of the firmware image
+
+static_assert(HIDPlanCache::SLOT_SIZE == FLASH_SECTOR_SIZE, "HIDPlanCache: slots must be one flash sector");
+static_assert(HIDPlanCache::PAGE_SIZE == FLASH_PAGE_SIZE, "HIDPlanCache: page size mismatch");
+
+static constexpr uint32_t PLAN_CACHE_START_OFFSET = PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE * (NVS_SECTORS + HID_PLAN_CACHE_SLOTS);
+static constexpr uint32_t FLUSH_LOCKOUT_TIMEOUT_MS = 100;
+
+//Only called from HIDPlanCache::flush, core1 is reset or locked out so only this core's IRQs need holding off
+static void write_slot(uint8_t slot, const uint8_t* data, size_t len)
+{
+    const uint32_t offset = PLAN_CACHE_START_OFFSET + slot * FLASH_SECTOR_SIZE;
+    const uint32_t irq_state = save_and_disable_interrupts();
+    flash_range_erase(offset, FLASH_SECTOR_SIZE);
+    flash_range_program(offset, data, len);
+    restore_interrupts(irq_state);
+}
+
+HIDPlanCache& HIDPlanCache::get_instance()
+{
+    static HIDPlanCache instance(reinterpret_cast<const uint8_t*>(XIP_BASE + PLAN_CACHE_START_OFFSET),
+                                 HID_PLAN_CACHE_SLOTS, make_version(BUILD_DATETIME), &write_slot);
+    return instance;
+}
+
+void HIDPlanCache::schedule_flush()
+{
+    static const uint32_t task_id = TaskQueue::Core0::get_new_task_id();
+
+    TaskQueue::Core0::cancel_delayed_task(task_id);
+    TaskQueue::Core0::queue_delayed_task(task_id, HID_PLAN_CACHE_FLUSH_DELAY_MS, false, []
+    {
+        uint8_t written = 0;
+        const int result = flash_safe_execute([](void* param)
+        {
+            *static_cast<uint8_t*>(param) = HIDPlanCache::get_instance().flush();
+        }, &written, FLUSH_LOCKOUT_TIMEOUT_MS);
+
+        //Still pending on a failure, the next schedule_flush or reboot writes it
+        if (result != PICO_OK)
+        {
+            OGXM_LOG("HID plan cache not flushed, flash_safe_execute: %d\n", result);
+            return;
+        }
+        OGXM_LOG("HID plan cache: %u plans written\n", written);
+    });
+}
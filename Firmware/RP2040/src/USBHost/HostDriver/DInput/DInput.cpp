@@ -5,10 +5,25 @@
 
 #include "USBHost/HostDriver/DInput/DInput.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .hat(2, DInput::DPAD_MASK, { DInput::DPad::UP, DInput::DPad::UP_RIGHT, DInput::DPad::RIGHT, DInput::DPad::DOWN_RIGHT,
+                                 DInput::DPad::DOWN, DInput::DPad::DOWN_LEFT, DInput::DPad::LEFT, DInput::DPad::UP_LEFT })
+    .button(0, DInput::Buttons0::SQUARE,   Gamepad::BUTTON_X)
+    .button(0, DInput::Buttons0::CROSS,    Gamepad::BUTTON_A)
+    .button(0, DInput::Buttons0::CIRCLE,   Gamepad::BUTTON_B)
+    .button(0, DInput::Buttons0::TRIANGLE, Gamepad::BUTTON_Y)
+    .button(0, DInput::Buttons0::L1,       Gamepad::BUTTON_LB)
+    .button(0, DInput::Buttons0::R1,       Gamepad::BUTTON_RB)
+    .button(1, DInput::Buttons1::L3,       Gamepad::BUTTON_L3)
+    .button(1, DInput::Buttons1::R3,       Gamepad::BUTTON_R3)
+    .button(1, DInput::Buttons1::SELECT,   Gamepad::BUTTON_BACK)
+    .button(1, DInput::Buttons1::START,    Gamepad::BUTTON_START)
+    .button(1, DInput::Buttons1::SYS,      Gamepad::BUTTON_SYS)
+    .button(1, DInput::Buttons1::TP,       Gamepad::BUTTON_MISC);
+
 void DInputHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) 
 {
     gamepad.set_analog_host(true);
-    tuh_hid_receive_report(address, instance);
 }
 
 void DInputHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -16,54 +31,12 @@ void DInputHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t insta
     const DInput::InReport* in_report = reinterpret_cast<const DInput::InReport*>(report);
     if (std::memcmp(&prev_in_report_, in_report, sizeof(DInput::InReport)) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;
 
-    switch (in_report->dpad & DInput::DPAD_MASK)
-    {
-        case DInput::DPad::UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP;
-            break;
-        case DInput::DPad::DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-            break;
-        case DInput::DPad::LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-            break;
-        case DInput::DPad::RIGHT: 
-            gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-            break;
-        case DInput::DPad::UP_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT;
-            break;
-        case DInput::DPad::DOWN_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT;
-            break;
-        case DInput::DPad::DOWN_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT;
-            break;
-        case DInput::DPad::UP_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT;
-            break;
-        default:
-            break;
-    }
-
-    if (in_report->buttons[0] & DInput::Buttons0::SQUARE)   gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->buttons[0] & DInput::Buttons0::CROSS)    gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons[0] & DInput::Buttons0::CIRCLE)   gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons[0] & DInput::Buttons0::TRIANGLE) gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->buttons[0] & DInput::Buttons0::L1)       gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons[0] & DInput::Buttons0::R1)       gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons[1] & DInput::Buttons1::L3)       gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons[1] & DInput::Buttons1::R3)       gp_in.buttons |= gamepad.MAP_BUTTON_R3; 
-    if (in_report->buttons[1] & DInput::Buttons1::SELECT)   gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons[1] & DInput::Buttons1::START)    gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons[1] & DInput::Buttons1::SYS)      gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report->buttons[1] & DInput::Buttons1::TP)       gp_in.buttons |= gamepad.MAP_BUTTON_MISC;
+    gamepad.remap(BUTTON_MAP.map(in_report), gp_in);
 
     if (gamepad.analog_enabled())
     {
@@ -101,7 +74,6 @@ void DInputHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t insta
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(DInput::InReport));
 }
 
@@ -1,94 +1,120 @@
 #include <cstring>
-#include <memory>
+#include <array>
 
+#include <hardware/timer.h>
+#include <hardware/sync.h>
 #include "host/usbh.h"
 #include "class/hid/hid_host.h"
 
-#include "USBHost/HIDParser/HIDReportDescriptor.h"
+#include "Board/Config.h"
+#include "Board/ogxm_log.h"
+#include "USBHost/HIDParser/HIDPlanCache.h"
 #include "USBHost/HostDriver/HIDGeneric/HIDGeneric.h"
 
+//The parsed descriptor only lives until the plan is compiled, and interfaces mount one at a time on the host core
+static uint8_t descriptor_arena_buffer[HID_DESCRIPTOR_ARENA_SIZE] __attribute__((aligned(8)));
+
+//Canonical button for each parsed button, 7 and 8 are the triggers
+static constexpr std::array<uint16_t, 15> HID_BUTTONS =
+{
+    0, Gamepad::BUTTON_X, Gamepad::BUTTON_A, Gamepad::BUTTON_B, Gamepad::BUTTON_Y, Gamepad::BUTTON_LB, Gamepad::BUTTON_RB,
+    0, 0, Gamepad::BUTTON_BACK, Gamepad::BUTTON_START, Gamepad::BUTTON_L3, Gamepad::BUTTON_R3, Gamepad::BUTTON_SYS, Gamepad::BUTTON_MISC
+};
+
 void HIDHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
     if (!report_desc || desc_len == 0)
     {
         return;
     }
-    
-    report_desc_len_ = desc_len;
-    std::memcpy(report_desc_buffer_.data(), report_desc, std::min(static_cast<size_t>(report_desc_len_), report_desc_buffer_.size()));
-    hid_joystick_ = std::make_unique<HIDJoystick>(std::make_shared<HIDReportDescriptor>(report_desc_buffer_.data(), report_desc_len_));
 
-    tuh_hid_receive_report(address, instance);
+    const uint32_t start_us = time_us_32();
+
+    uint16_t vid = 0;
+    uint16_t pid = 0;
+    tuh_vid_pid_get(address, &vid, &pid);
+
+    //A pad seen before skips the descriptor entirely
+    HIDPlanCache& plan_cache = HIDPlanCache::get_instance();
+    const HIDPlanCache::Key cache_key = HIDPlanCache::make_key(vid, pid, report_desc, desc_len);
+    descriptor_stats_.cached = plan_cache.load(cache_key, hid_joystick_plan_);
+
+    if (descriptor_stats_.cached)
+    {
+        descriptor_stats_.parse = HIDArenaDescriptor::Stats();
+    }
+    else
+    {
+        HIDArena arena(descriptor_arena_buffer, sizeof(descriptor_arena_buffer));
+        HIDArenaDescriptor descriptor;
+        if (descriptor.parse(report_desc, desc_len, arena) == HIDArenaDescriptor::Status::OK &&
+            hid_joystick_plan_.compile(descriptor))
+        {
+            //The flush locks this core out from an IRQ, it mustn't land halfway through a store
+            const uint32_t irq_state = save_and_disable_interrupts();
+            const bool stored = plan_cache.store(cache_key, hid_joystick_plan_);
+            restore_interrupts(irq_state);
+            if (stored)
+            {
+                HIDPlanCache::schedule_flush();
+            }
+        }
+        descriptor_stats_.parse = descriptor.stats();
+    }
+
+    descriptor_stats_.compile_us = time_us_32() - start_us;
+
+    if (descriptor_stats_.cached)
+    {
+        OGXM_LOG("HID descriptor %04x:%04x %u bytes: cached plan, %u us, %u plan fields\n",
+            vid, pid, desc_len, descriptor_stats_.compile_us, hid_joystick_plan_.field_count());
+    }
+    else
+    {
+        OGXM_LOG("HID descriptor %04x:%04x %u bytes: status %u, %u reports, %u runs, arena %u/%u bytes, %u us, %u plan fields\n",
+            vid, pid, desc_len, static_cast<unsigned>(descriptor_stats_.parse.status), descriptor_stats_.parse.reports,
+            descriptor_stats_.parse.runs, descriptor_stats_.parse.arena_used, descriptor_stats_.parse.arena_size,
+            descriptor_stats_.compile_us, hid_joystick_plan_.field_count());
+    }
 }
 
 void HIDHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
 {
     if (std::memcmp(prev_report_in_.data(), report, len) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     std::memcpy(prev_report_in_.data(), report, len);
-    if (!hid_joystick_->parseData(const_cast<uint8_t*>(report), len, &hid_joystick_data_))
+    if (!hid_joystick_plan_.parse(report, len, hid_joystick_data_))
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
-    switch (hid_joystick_data_.hat_switch)
-    {
-        case HIDJoystickHatSwitch::UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP;
-            break;
-        case HIDJoystickHatSwitch::UP_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT;
-            break;
-        case HIDJoystickHatSwitch::RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-            break;
-        case HIDJoystickHatSwitch::DOWN_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT;
-            break;
-        case HIDJoystickHatSwitch::DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-            break;
-        case HIDJoystickHatSwitch::DOWN_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT;
-            break;
-        case HIDJoystickHatSwitch::LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-            break;
-        case HIDJoystickHatSwitch::UP_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT;
-            break;
-        default:
-            break;
-    }
-
     std::tie(gp_in.joystick_lx, gp_in.joystick_ly) = gamepad.scale_joystick_l(hid_joystick_data_.X, hid_joystick_data_.Y);
     std::tie(gp_in.joystick_rx, gp_in.joystick_ry) = gamepad.scale_joystick_r(hid_joystick_data_.Z, hid_joystick_data_.Rz);
 
-    if (hid_joystick_data_.buttons[1])  gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (hid_joystick_data_.buttons[2])  gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (hid_joystick_data_.buttons[3])  gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (hid_joystick_data_.buttons[4])  gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (hid_joystick_data_.buttons[5])  gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (hid_joystick_data_.buttons[6])  gp_in.buttons |= gamepad.MAP_BUTTON_RB;
+    MappingPlan::Pad pad;
+    const uint8_t hat = static_cast<uint8_t>(hid_joystick_data_.hat_switch);
+    if (hat < MappingPlan::HAT_DPAD.size())
+    {
+        pad.dpad = MappingPlan::HAT_DPAD[hat];
+    }
+    for (size_t i = 0; i < HID_BUTTONS.size(); ++i)
+    {
+        if (hid_joystick_data_.buttons[i])
+        {
+            pad.buttons |= HID_BUTTONS[i];
+        }
+    }
+    gamepad.remap(pad, gp_in);
+
     if (hid_joystick_data_.buttons[7])  gp_in.trigger_l = Range::MAX<uint8_t>;
     if (hid_joystick_data_.buttons[8])  gp_in.trigger_r = Range::MAX<uint8_t>;
-    if (hid_joystick_data_.buttons[9])  gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (hid_joystick_data_.buttons[10]) gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (hid_joystick_data_.buttons[11]) gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (hid_joystick_data_.buttons[12]) gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (hid_joystick_data_.buttons[13]) gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (hid_joystick_data_.buttons[14]) gp_in.buttons |= gamepad.MAP_BUTTON_MISC;
 
     gamepad.set_pad_in(gp_in);
-
-    tuh_hid_receive_report(address, instance);
 }
 
 bool HIDHost::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
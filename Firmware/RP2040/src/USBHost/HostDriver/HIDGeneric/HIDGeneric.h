@@ -3,11 +3,11 @@
 
 #include <cstdint>
 #include <array>
-#include <memory>
 
 #include "tusb_option.h"
 
-#include "USBHost/HIDParser/HIDJoystick.h"
+#include "USBHost/HIDParser/HIDArenaDescriptor.h"
+#include "USBHost/HIDParser/HIDJoystickPlan.h"
 #include "USBHost/HostDriver/HostDriver.h"
 
 class HIDHost : public HostDriver
@@ -20,11 +20,19 @@ public:
     void process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len) override;
     bool send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance) override;
 
+    struct DescriptorStats
+    {
+        HIDArenaDescriptor::Stats parse;
+        uint32_t compile_us{0}; //Parse and plan compile together, or the cache lookup
+        bool cached{false};     //Plan came from HIDPlanCache, parse is empty
+    };
+
+    inline const DescriptorStats& descriptor_stats() const { return descriptor_stats_; }
+
 private:
-    std::array<uint8_t, 0x100> report_desc_buffer_;
-    uint16_t report_desc_len_{0};
+    DescriptorStats descriptor_stats_;
     std::array<uint8_t, CFG_TUH_HID_EPIN_BUFSIZE> prev_report_in_{0};
-    std::unique_ptr<HIDJoystick> hid_joystick_;
+    HIDJoystickPlan hid_joystick_plan_;
     HIDJoystickData hid_joystick_data_;
 };
 
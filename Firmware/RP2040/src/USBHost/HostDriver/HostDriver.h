@@ -43,7 +43,7 @@ protected:
         }
         if (reset)
         {
-            gamepad.set_pad_out(gp_out);
+            gamepad.decay_pad_out(gp_out);
         }
     }
 };
@@ -0,0 +1,92 @@
+#ifndef _HOST_DRIVER_POOL_H_
+#define _HOST_DRIVER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/*  Fixed storage for polymorphic drivers, make_unique without the heap.
+
+    Every slot is big enough for the largest of Types, so mounting and unmounting any mix of
+    them only constructs and destroys in place. create() returns nullptr when all COUNT slots
+    are in use, a type that isn't listed is a compile error. */
+
+template <typename Base, size_t COUNT, typename... Types>
+class HostDriverPool
+{
+public:
+    static_assert((std::is_base_of_v<Base, Types> && ...), "HostDriverPool: every type must derive from Base");
+    static_assert(std::has_virtual_destructor_v<Base>, "HostDriverPool: drivers are destroyed through Base");
+
+    static constexpr size_t SLOT_SIZE = std::max({ sizeof(Types)... });
+
+    HostDriverPool() = default;
+    ~HostDriverPool()
+    {
+        for (auto& slot : slots_)
+        {
+            if (slot.object)
+            {
+                slot.object->~Base();
+            }
+        }
+    }
+
+    HostDriverPool(const HostDriverPool&) = delete;
+    HostDriverPool& operator=(const HostDriverPool&) = delete;
+
+    template <typename T, typename... Args>
+    Base* create(Args&&... args)
+    {
+        static_assert((std::is_same_v<T, Types> || ...), "HostDriverPool: type isn't in the pool");
+
+        for (auto& slot : slots_)
+        {
+            if (!slot.object)
+            {
+                slot.object = ::new (static_cast<void*>(slot.storage)) T(std::forward<Args>(args)...);
+                return slot.object;
+            }
+        }
+        return nullptr;
+    }
+
+    //Anything create() didn't return is ignored
+    void destroy(Base* object)
+    {
+        for (auto& slot : slots_)
+        {
+            if (object && slot.object == object)
+            {
+                slot.object->~Base();
+                slot.object = nullptr;
+                return;
+            }
+        }
+    }
+
+    size_t in_use() const
+    {
+        size_t count = 0;
+        for (const auto& slot : slots_)
+        {
+            count += slot.object ? 1 : 0;
+        }
+        return count;
+    }
+
+private:
+    struct Slot
+    {
+        alignas(Types...) uint8_t storage[SLOT_SIZE];
+        Base* object{nullptr};
+    };
+
+    std::array<Slot, COUNT> slots_{};
+};
+
+#endif // _HOST_DRIVER_POOL_H_
@@ -5,9 +5,17 @@
 
 #include "USBHost/HostDriver/N64/N64.h"
 
+static constexpr SourceMap<2> BUTTON_MAP = SourceMap<2>()
+    .hat(0, N64::DPAD_MASK, { N64::Buttons::DPAD_UP, N64::Buttons::DPAD_UP_RIGHT, N64::Buttons::DPAD_RIGHT, N64::Buttons::DPAD_RIGHT_DOWN,
+                              N64::Buttons::DPAD_DOWN, N64::Buttons::DPAD_DOWN_LEFT, N64::Buttons::DPAD_LEFT, N64::Buttons::DPAD_LEFT_UP })
+    .button(0, N64::Buttons::A,     Gamepad::BUTTON_A)
+    .button(0, N64::Buttons::B,     Gamepad::BUTTON_B)
+    .button(0, N64::Buttons::L,     Gamepad::BUTTON_LB)
+    .button(0, N64::Buttons::R,     Gamepad::BUTTON_RB)
+    .button(0, N64::Buttons::START, Gamepad::BUTTON_START);
+
 void N64Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
-    tuh_hid_receive_report(address, instance);
 }
 
 void N64Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -15,47 +23,12 @@ void N64Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
     const N64::InReport* in_report = reinterpret_cast<const N64::InReport*>(report);
     if (std::memcmp(in_report, &prev_in_report_, sizeof(N64::InReport)) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
-    switch (in_report->buttons & N64::DPAD_MASK)
-    {
-        case N64::Buttons::DPAD_UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP;
-            break;
-        case N64::Buttons::DPAD_UP_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT;
-            break;
-        case N64::Buttons::DPAD_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;  
-            break;
-        case N64::Buttons::DPAD_RIGHT_DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT;
-            break;
-        case N64::Buttons::DPAD_DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-            break;
-        case N64::Buttons::DPAD_DOWN_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT;
-            break;
-        case N64::Buttons::DPAD_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-            break;
-        case N64::Buttons::DPAD_LEFT_UP:    
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT;
-            break;  
-        default:
-            break;
-    }
-
-    if (in_report->buttons & N64::Buttons::A) gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons & N64::Buttons::B) gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons & N64::Buttons::L) gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons & N64::Buttons::R) gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons & N64::Buttons::START) gp_in.buttons |= gamepad.MAP_BUTTON_START;
+    gamepad.remap(BUTTON_MAP.map(&in_report->buttons), gp_in);
 
     uint8_t joy_ry = N64::JOY_MID;
     uint8_t joy_rx = N64::JOY_MID;
@@ -101,7 +74,6 @@ void N64Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(N64::InReport));
 }
 
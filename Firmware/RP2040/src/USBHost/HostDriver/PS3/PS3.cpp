@@ -5,6 +5,23 @@
 
 #include "USBHost/HostDriver/PS3/PS3.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .dpad(0, PS3::Buttons0::DPAD_UP,    Gamepad::DPAD_UP)
+    .dpad(0, PS3::Buttons0::DPAD_DOWN,  Gamepad::DPAD_DOWN)
+    .dpad(0, PS3::Buttons0::DPAD_LEFT,  Gamepad::DPAD_LEFT)
+    .dpad(0, PS3::Buttons0::DPAD_RIGHT, Gamepad::DPAD_RIGHT)
+    .button(0, PS3::Buttons0::SELECT,   Gamepad::BUTTON_BACK)
+    .button(0, PS3::Buttons0::START,    Gamepad::BUTTON_START)
+    .button(0, PS3::Buttons0::L3,       Gamepad::BUTTON_L3)
+    .button(0, PS3::Buttons0::R3,       Gamepad::BUTTON_R3)
+    .button(1, PS3::Buttons1::L1,       Gamepad::BUTTON_LB)
+    .button(1, PS3::Buttons1::R1,       Gamepad::BUTTON_RB)
+    .button(1, PS3::Buttons1::TRIANGLE, Gamepad::BUTTON_Y)
+    .button(1, PS3::Buttons1::CIRCLE,   Gamepad::BUTTON_B)
+    .button(1, PS3::Buttons1::CROSS,    Gamepad::BUTTON_A)
+    .button(1, PS3::Buttons1::SQUARE,   Gamepad::BUTTON_X)
+    .button(2, PS3::Buttons2::SYS,      Gamepad::BUTTON_SYS);
+
 const tusb_control_request_t PS3Host::RUMBLE_REQUEST = 
 {
     .bmRequestType = 0x21,
@@ -39,8 +56,6 @@ void PS3Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, co
     };
 
     send_control_xfer(address, &init_request, init_state_.init_buffer.data(), get_report_complete_cb, reinterpret_cast<uintptr_t>(&init_state_));
-
-    tuh_hid_receive_report(address, instance);
 }
 
 bool PS3Host::send_control_xfer(uint8_t dev_addr, const tusb_control_request_t* request, uint8_t* buffer, tuh_xfer_cb_t complete_cb, uintptr_t user_data)
@@ -100,28 +115,12 @@ void PS3Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
     const PS3::InReport* in_report = reinterpret_cast<const PS3::InReport*>(report);
     if (std::memcmp(&prev_in_report_, in_report, std::min(static_cast<size_t>(len), static_cast<size_t>(26))) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
-    if (in_report->buttons[0] & PS3::Buttons0::DPAD_UP)    gp_in.dpad |= gamepad.MAP_DPAD_UP;
-    if (in_report->buttons[0] & PS3::Buttons0::DPAD_DOWN)  gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-    if (in_report->buttons[0] & PS3::Buttons0::DPAD_LEFT)  gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-    if (in_report->buttons[0] & PS3::Buttons0::DPAD_RIGHT) gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-
-    if (in_report->buttons[0] & PS3::Buttons0::SELECT)   gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons[0] & PS3::Buttons0::START)    gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons[0] & PS3::Buttons0::L3)       gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons[0] & PS3::Buttons0::R3)       gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report->buttons[1] & PS3::Buttons1::L1)       gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons[1] & PS3::Buttons1::R1)       gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons[1] & PS3::Buttons1::TRIANGLE) gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->buttons[1] & PS3::Buttons1::CIRCLE)   gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons[1] & PS3::Buttons1::CROSS)    gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons[1] & PS3::Buttons1::SQUARE)   gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->buttons[2] & PS3::Buttons2::SYS)      gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
+    gamepad.remap(BUTTON_MAP.map(in_report->buttons), gp_in);
 
     if (gamepad.analog_enabled())
     {
@@ -145,7 +144,6 @@ void PS3Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(PS3::InReport));
 }
 
@@ -6,13 +6,27 @@
 
 #include "USBHost/HostDriver/PS4/PS4.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .hat(0, PS4::DPAD_MASK, { PS4::Buttons0::DPAD_UP, PS4::Buttons0::DPAD_UP_RIGHT, PS4::Buttons0::DPAD_RIGHT, PS4::Buttons0::DPAD_RIGHT_DOWN,
+                              PS4::Buttons0::DPAD_DOWN, PS4::Buttons0::DPAD_DOWN_LEFT, PS4::Buttons0::DPAD_LEFT, PS4::Buttons0::DPAD_LEFT_UP })
+    .button(0, PS4::Buttons0::SQUARE,   Gamepad::BUTTON_X)
+    .button(0, PS4::Buttons0::CROSS,    Gamepad::BUTTON_A)
+    .button(0, PS4::Buttons0::CIRCLE,   Gamepad::BUTTON_B)
+    .button(0, PS4::Buttons0::TRIANGLE, Gamepad::BUTTON_Y)
+    .button(1, PS4::Buttons1::L1,       Gamepad::BUTTON_LB)
+    .button(1, PS4::Buttons1::R1,       Gamepad::BUTTON_RB)
+    .button(1, PS4::Buttons1::L3,       Gamepad::BUTTON_L3)
+    .button(1, PS4::Buttons1::R3,       Gamepad::BUTTON_R3)
+    .button(1, PS4::Buttons1::SHARE,    Gamepad::BUTTON_BACK)
+    .button(1, PS4::Buttons1::OPTIONS,  Gamepad::BUTTON_START)
+    .button(2, PS4::Buttons2::PS,       Gamepad::BUTTON_SYS)
+    .button(2, PS4::Buttons2::TP,       Gamepad::BUTTON_MISC);
+
 void PS4Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) 
 {
     out_report_.report_id = 0x05;
     out_report_.set_led = 1;
     out_report_.lightbar_blue = 0xFF / 2;
-
-    tuh_hid_receive_report(address, instance);
 }
 
 void PS4Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -26,48 +40,7 @@ void PS4Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
 
     Gamepad::PadIn gp_in;   
 
-    switch (in_report_.buttons[0] & PS4::DPAD_MASK)
-    {
-        case PS4::Buttons0::DPAD_UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP;
-            break;
-        case PS4::Buttons0::DPAD_DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN;    
-            break;
-        case PS4::Buttons0::DPAD_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_LEFT; 
-            break;
-        case PS4::Buttons0::DPAD_RIGHT: 
-            gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-            break;
-        case PS4::Buttons0::DPAD_UP_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT;
-            break;
-        case PS4::Buttons0::DPAD_RIGHT_DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT;
-            break;
-        case PS4::Buttons0::DPAD_DOWN_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT;
-            break;
-        case PS4::Buttons0::DPAD_LEFT_UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT;
-            break;
-        default:
-            break;
-    }
-
-    if (in_report_.buttons[0] & PS4::Buttons0::SQUARE)   gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report_.buttons[0] & PS4::Buttons0::CROSS)    gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report_.buttons[0] & PS4::Buttons0::CIRCLE)   gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report_.buttons[0] & PS4::Buttons0::TRIANGLE) gp_in.buttons |= gamepad.MAP_BUTTON_Y; 
-    if (in_report_.buttons[1] & PS4::Buttons1::L1)       gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report_.buttons[1] & PS4::Buttons1::R1)       gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report_.buttons[1] & PS4::Buttons1::L3)       gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report_.buttons[1] & PS4::Buttons1::R3)       gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report_.buttons[1] & PS4::Buttons1::SHARE)    gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report_.buttons[1] & PS4::Buttons1::OPTIONS)  gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report_.buttons[2] & PS4::Buttons2::PS)       gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report_.buttons[2] & PS4::Buttons2::TP)       gp_in.buttons |= gamepad.MAP_BUTTON_MISC;
+    gamepad.remap(BUTTON_MAP.map(in_report_.buttons), gp_in);
 
     gp_in.trigger_l = gamepad.scale_trigger_l(in_report_.trigger_l);
     gp_in.trigger_r = gamepad.scale_trigger_r(in_report_.trigger_r);
@@ -77,7 +50,6 @@ void PS4Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, &in_report_, sizeof(PS4::InReport));
 }
 
@@ -5,26 +5,28 @@
 
 #include "USBHost/HostDriver/PS5/PS5.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .hat(0, PS5::DPAD_MASK, { PS5::Buttons0::DPAD_UP, PS5::Buttons0::DPAD_UP_RIGHT, PS5::Buttons0::DPAD_RIGHT, PS5::Buttons0::DPAD_RIGHT_DOWN,
+                              PS5::Buttons0::DPAD_DOWN, PS5::Buttons0::DPAD_DOWN_LEFT, PS5::Buttons0::DPAD_LEFT, PS5::Buttons0::DPAD_LEFT_UP })
+    .button(0, PS5::Buttons0::SQUARE,   Gamepad::BUTTON_X)
+    .button(0, PS5::Buttons0::CROSS,    Gamepad::BUTTON_A)
+    .button(0, PS5::Buttons0::CIRCLE,   Gamepad::BUTTON_B)
+    .button(0, PS5::Buttons0::TRIANGLE, Gamepad::BUTTON_Y)
+    .button(1, PS5::Buttons1::L1,       Gamepad::BUTTON_LB)
+    .button(1, PS5::Buttons1::R1,       Gamepad::BUTTON_RB)
+    .button(1, PS5::Buttons1::L3,       Gamepad::BUTTON_L3)
+    .button(1, PS5::Buttons1::R3,       Gamepad::BUTTON_R3)
+    .button(1, PS5::Buttons1::SHARE,    Gamepad::BUTTON_BACK)
+    .button(1, PS5::Buttons1::OPTIONS,  Gamepad::BUTTON_START)
+    .button(2, PS5::Buttons2::PS,       Gamepad::BUTTON_SYS)
+    .button(2, PS5::Buttons2::MUTE,     Gamepad::BUTTON_MISC);
+
 void PS5Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) 
 {
-    // --- Configuración inicial: Color ROJO ---
-    out_report_.report_id = PS5::OutReportID::CONTROL;
-    out_report_.control_flag[0] = 2;
-    out_report_.control_flag[1] = 2;
-    out_report_.led_control_flag = 0x01 | 0x02; // Flags para habilitar LED y brillo
-    out_report_.pulse_option = 1;
-    out_report_.led_brightness = 0xFF; // Brillo al máximo
-    out_report_.player_number = idx_ + 1;
-    
-    out_report_.lightbar_red = 0xFF;   // Rojo al máximo
-    out_report_.lightbar_green = 0x00;
-    out_report_.lightbar_blue = 0x00;
-
-    // Enviar reporte inicial de configuración
-    while (!tuh_hid_send_report(address, instance, 0, &out_report_, sizeof(PS5::OutReport)))
-    {
-        tuh_task();
-    }
+    // Enviar reporte inicial de configuración, si el endpoint está ocupado se reintenta
+    // desde process_report/send_feedback en vez de esperar aquí
+    init_state_ = InitState::LIGHTBAR;
+    send_init_report(address, instance);
 
     // Preparamos la estructura para futuros reportes (Vibración/Feedback)
     // Mantenemos los valores del LED para que no se apaguen al vibrar
@@ -35,51 +37,53 @@ void PS5Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, co
     out_report_.led_control_flag = 0x01 | 0x02 | 0x04; // LED + Brillo + Rumble
     out_report_.led_brightness = 0xFF;
     out_report_.lightbar_red = 0xFF;    // Mantener rojo constante
+}
+
+bool PS5Host::send_init_report(uint8_t address, uint8_t instance)
+{
+    // --- Configuración inicial: Color ROJO ---
+    PS5::OutReport init_report{};
+    init_report.report_id = PS5::OutReportID::CONTROL;
+    init_report.control_flag[0] = 2;
+    init_report.control_flag[1] = 2;
+    init_report.led_control_flag = 0x01 | 0x02; // Flags para habilitar LED y brillo
+    init_report.pulse_option = 1;
+    init_report.led_brightness = 0xFF; // Brillo al máximo
+    init_report.player_number = idx_ + 1;
     
-    tuh_hid_receive_report(address, instance);
+    init_report.lightbar_red = 0xFF;   // Rojo al máximo
+    init_report.lightbar_green = 0x00;
+    init_report.lightbar_blue = 0x00;
+
+    if (!tuh_hid_send_report(address, instance, 0, &init_report, sizeof(PS5::OutReport)))
+    {
+        return false;
+    }
+    init_state_ = InitState::DONE;
+    return true;
 }
 
 void PS5Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
 {
+    if (init_state_ != InitState::DONE)
+    {
+        send_init_report(address, instance);
+    }
+
     const PS5::InReport* in_report = reinterpret_cast<const PS5::InReport*>(report);
 
     // Si nada ha cambiado, no procesamos para ahorrar CPU
     if (std::memcmp(&prev_in_report_.joystick_lx, &in_report->joystick_lx, sizeof(uint8_t) * 6) == 0 &&
         std::memcmp(prev_in_report_.buttons, in_report->buttons, sizeof(in_report->buttons)) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
     // Mapeo del DPAD
-    switch (in_report->buttons[0] & PS5::DPAD_MASK)
-    {
-        case PS5::Buttons0::DPAD_UP:         gp_in.dpad |= gamepad.MAP_DPAD_UP; break;
-        case PS5::Buttons0::DPAD_UP_RIGHT:   gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT; break;
-        case PS5::Buttons0::DPAD_RIGHT:      gp_in.dpad |= gamepad.MAP_DPAD_RIGHT; break;
-        case PS5::Buttons0::DPAD_RIGHT_DOWN: gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT; break;
-        case PS5::Buttons0::DPAD_DOWN:       gp_in.dpad |= gamepad.MAP_DPAD_DOWN; break;
-        case PS5::Buttons0::DPAD_DOWN_LEFT:  gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT; break;
-        case PS5::Buttons0::DPAD_LEFT:       gp_in.dpad |= gamepad.MAP_DPAD_LEFT; break;
-        case PS5::Buttons0::DPAD_LEFT_UP:    gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT; break;
-        default: break;
-    }
-
     // Mapeo de botones principales
-    if (in_report->buttons[0] & PS5::Buttons0::SQUARE)   gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->buttons[0] & PS5::Buttons0::CROSS)    gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons[0] & PS5::Buttons0::CIRCLE)   gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons[0] & PS5::Buttons0::TRIANGLE) gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->buttons[1] & PS5::Buttons1::L1)       gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons[1] & PS5::Buttons1::R1)       gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons[1] & PS5::Buttons1::L3)       gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons[1] & PS5::Buttons1::R3)       gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report->buttons[1] & PS5::Buttons1::SHARE)    gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons[1] & PS5::Buttons1::OPTIONS)  gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons[2] & PS5::Buttons2::PS)       gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report->buttons[2] & PS5::Buttons2::MUTE)     gp_in.buttons |= gamepad.MAP_BUTTON_MISC;
+    gamepad.remap(BUTTON_MAP.map(in_report->buttons), gp_in);
 
     // Triggers y Joysticks
     gp_in.trigger_l = gamepad.scale_trigger_l(in_report->trigger_l);
@@ -90,12 +94,16 @@ void PS5Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance
     
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(PS5::InReport));
 }
 
 bool PS5Host::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
+    if (init_state_ != InitState::DONE)
+    {
+        return send_init_report(address, instance);
+    }
+
     Gamepad::PadOut gp_out = gamepad.get_pad_out();
     
     // Actualizamos motores de vibración
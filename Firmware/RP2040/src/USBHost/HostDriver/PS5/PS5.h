@@ -17,8 +17,17 @@ public:
     bool send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance) override;
 
 private:
+    enum class InitState
+    {
+        LIGHTBAR,
+        DONE
+    };
+
+    InitState init_state_{InitState::LIGHTBAR};
     PS5::InReport prev_in_report_{};
     PS5::OutReport out_report_{};
+
+    bool send_init_report(uint8_t address, uint8_t instance);
 };
 
 #endif // _PS5_HOST_H_
\ No newline at end of file
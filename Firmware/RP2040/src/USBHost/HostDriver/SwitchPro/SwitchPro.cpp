@@ -6,6 +6,24 @@
 
 #include "USBHost/HostDriver/SwitchPro/SwitchPro.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .button(0, SwitchPro::Buttons0::Y,       Gamepad::BUTTON_X)
+    .button(0, SwitchPro::Buttons0::B,       Gamepad::BUTTON_A)
+    .button(0, SwitchPro::Buttons0::A,       Gamepad::BUTTON_B)
+    .button(0, SwitchPro::Buttons0::X,       Gamepad::BUTTON_Y)
+    .button(2, SwitchPro::Buttons2::L,       Gamepad::BUTTON_LB)
+    .button(0, SwitchPro::Buttons0::R,       Gamepad::BUTTON_RB)
+    .button(1, SwitchPro::Buttons1::L3,      Gamepad::BUTTON_L3)
+    .button(1, SwitchPro::Buttons1::R3,      Gamepad::BUTTON_R3)
+    .button(1, SwitchPro::Buttons1::MINUS,   Gamepad::BUTTON_BACK)
+    .button(1, SwitchPro::Buttons1::PLUS,    Gamepad::BUTTON_START)
+    .button(1, SwitchPro::Buttons1::HOME,    Gamepad::BUTTON_SYS)
+    .button(1, SwitchPro::Buttons1::CAPTURE, Gamepad::BUTTON_MISC)
+    .dpad(2, SwitchPro::Buttons2::DPAD_UP,    Gamepad::DPAD_UP)
+    .dpad(2, SwitchPro::Buttons2::DPAD_DOWN,  Gamepad::DPAD_DOWN)
+    .dpad(2, SwitchPro::Buttons2::DPAD_LEFT,  Gamepad::DPAD_LEFT)
+    .dpad(2, SwitchPro::Buttons2::DPAD_RIGHT, Gamepad::DPAD_RIGHT);
+
 void SwitchProHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) 
 {
     std::memset(&out_report_, 0, sizeof(out_report_));
@@ -115,14 +133,11 @@ void SwitchProHost::init_switch_host(Gamepad& gamepad, uint8_t address, uint8_t
             if (tuh_hid_send_report(address, instance, 0, &out_report_, report_size))
             {
                 init_state_ = InitState::DONE;
-                tuh_hid_receive_report(address, instance);
             }
             break;
         default:
             break;
     }
-
-    // tuh_hid_receive_report(address, instance);
 }
 
 void SwitchProHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -136,29 +151,12 @@ void SwitchProHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t in
     const SwitchPro::InReport* in_report = reinterpret_cast<const SwitchPro::InReport*>(report);
     if (std::memcmp(&prev_in_report_.buttons, in_report->buttons, 9) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
-    if (in_report->buttons[0] & SwitchPro::Buttons0::Y)  gp_in.buttons |= gamepad.MAP_BUTTON_X;   
-    if (in_report->buttons[0] & SwitchPro::Buttons0::B)  gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons[0] & SwitchPro::Buttons0::A)  gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons[0] & SwitchPro::Buttons0::X)  gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->buttons[2] & SwitchPro::Buttons2::L)  gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons[0] & SwitchPro::Buttons0::R)  gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::L3) gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::R3) gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::MINUS)     gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::PLUS)      gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::HOME)      gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report->buttons[1] & SwitchPro::Buttons1::CAPTURE)   gp_in.buttons |= gamepad.MAP_BUTTON_MISC;
-
-    if (in_report->buttons[2] & SwitchPro::Buttons2::DPAD_UP)    gp_in.dpad |= gamepad.MAP_DPAD_UP;
-    if (in_report->buttons[2] & SwitchPro::Buttons2::DPAD_DOWN)  gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-    if (in_report->buttons[2] & SwitchPro::Buttons2::DPAD_LEFT)  gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-    if (in_report->buttons[2] & SwitchPro::Buttons2::DPAD_RIGHT) gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
+    gamepad.remap(BUTTON_MAP.map(in_report->buttons), gp_in);
 
     gp_in.trigger_l = in_report->buttons[2] & SwitchPro::Buttons2::ZL ? Range::MAX<uint8_t> : Range::MIN<uint8_t>;
     gp_in.trigger_r = in_report->buttons[0] & SwitchPro::Buttons0::ZR ? Range::MAX<uint8_t> : Range::MIN<uint8_t>;
@@ -176,7 +174,6 @@ void SwitchProHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t in
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(SwitchPro::InReport));
 }
 
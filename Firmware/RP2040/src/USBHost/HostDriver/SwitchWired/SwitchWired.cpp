@@ -5,9 +5,24 @@
 
 #include "USBHost/HostDriver/SwitchWired/SwitchWired.h"
 
+static constexpr SourceMap<3> BUTTON_MAP = SourceMap<3>()
+    .hat(2, 0x0F, { SwitchWired::DPad::UP, SwitchWired::DPad::UP_RIGHT, SwitchWired::DPad::RIGHT, SwitchWired::DPad::DOWN_RIGHT,
+                    SwitchWired::DPad::DOWN, SwitchWired::DPad::DOWN_LEFT, SwitchWired::DPad::LEFT, SwitchWired::DPad::UP_LEFT })
+    .button(0, SwitchWired::Buttons::Y,       Gamepad::BUTTON_X)
+    .button(0, SwitchWired::Buttons::B,       Gamepad::BUTTON_A)
+    .button(0, SwitchWired::Buttons::A,       Gamepad::BUTTON_B)
+    .button(0, SwitchWired::Buttons::X,       Gamepad::BUTTON_Y)
+    .button(0, SwitchWired::Buttons::L,       Gamepad::BUTTON_LB)
+    .button(0, SwitchWired::Buttons::R,       Gamepad::BUTTON_RB)
+    .button(0, SwitchWired::Buttons::MINUS,   Gamepad::BUTTON_BACK)
+    .button(0, SwitchWired::Buttons::PLUS,    Gamepad::BUTTON_START)
+    .button(0, SwitchWired::Buttons::HOME,    Gamepad::BUTTON_SYS)
+    .button(0, SwitchWired::Buttons::CAPTURE, Gamepad::BUTTON_MISC)
+    .button(0, SwitchWired::Buttons::L3,      Gamepad::BUTTON_L3)
+    .button(0, SwitchWired::Buttons::R3,      Gamepad::BUTTON_R3);
+
 void SwitchWiredHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len) 
 {
-    tuh_hid_receive_report(address, instance);
 }
 
 void SwitchWiredHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -15,54 +30,12 @@ void SwitchWiredHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t
     const SwitchWired::InReport* in_report = reinterpret_cast<const SwitchWired::InReport*>(report);
     if (std::memcmp(&prev_in_report_, in_report, sizeof(SwitchWired::InReport)) == 0)
     {
-        tuh_hid_receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;   
 
-    switch (in_report->dpad)
-    {
-        case SwitchWired::DPad::UP:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP;
-            break;
-        case SwitchWired::DPad::DOWN:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-            break;
-        case SwitchWired::DPad::LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-            break;
-        case SwitchWired::DPad::RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-            break;
-        case SwitchWired::DPad::UP_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_RIGHT;
-            break;
-        case SwitchWired::DPad::DOWN_RIGHT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_RIGHT;
-            break;
-        case SwitchWired::DPad::DOWN_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_DOWN_LEFT;
-            break;
-        case SwitchWired::DPad::UP_LEFT:
-            gp_in.dpad |= gamepad.MAP_DPAD_UP_LEFT;
-            break;
-        default:
-            break;
-    }
-
-    if (in_report->buttons & SwitchWired::Buttons::Y)       gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->buttons & SwitchWired::Buttons::B)       gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons & SwitchWired::Buttons::A)       gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons & SwitchWired::Buttons::X)       gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->buttons & SwitchWired::Buttons::L)       gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons & SwitchWired::Buttons::R)       gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons & SwitchWired::Buttons::MINUS)   gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons & SwitchWired::Buttons::PLUS)    gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons & SwitchWired::Buttons::HOME)    gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report->buttons & SwitchWired::Buttons::CAPTURE) gp_in.buttons |= gamepad.MAP_BUTTON_MISC;   
-    if (in_report->buttons & SwitchWired::Buttons::L3)      gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons & SwitchWired::Buttons::R3)      gp_in.buttons |= gamepad.MAP_BUTTON_R3;
+    gamepad.remap(BUTTON_MAP.map(in_report), gp_in);
 
     gp_in.trigger_l = (in_report->buttons & SwitchWired::Buttons::ZL) ? Range::MAX<uint8_t> : Range::MIN<uint8_t>;
     gp_in.trigger_r = (in_report->buttons & SwitchWired::Buttons::ZR) ? Range::MAX<uint8_t> : Range::MIN<uint8_t>;
@@ -72,7 +45,6 @@ void SwitchWiredHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_hid_receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(SwitchWired::InReport));
 }
 
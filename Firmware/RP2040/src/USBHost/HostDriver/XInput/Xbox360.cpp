@@ -5,10 +5,26 @@
 #include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput.h"
 #include "USBHost/HostDriver/XInput/Xbox360.h"
 
+static constexpr SourceMap<2> BUTTON_MAP = SourceMap<2>()
+    .dpad(0, XInput::Buttons0::DPAD_UP,    Gamepad::DPAD_UP)
+    .dpad(0, XInput::Buttons0::DPAD_DOWN,  Gamepad::DPAD_DOWN)
+    .dpad(0, XInput::Buttons0::DPAD_LEFT,  Gamepad::DPAD_LEFT)
+    .dpad(0, XInput::Buttons0::DPAD_RIGHT, Gamepad::DPAD_RIGHT)
+    .button(0, XInput::Buttons0::START, Gamepad::BUTTON_START)
+    .button(0, XInput::Buttons0::BACK,  Gamepad::BUTTON_BACK)
+    .button(0, XInput::Buttons0::L3,    Gamepad::BUTTON_L3)
+    .button(0, XInput::Buttons0::R3,    Gamepad::BUTTON_R3)
+    .button(1, XInput::Buttons1::LB,    Gamepad::BUTTON_LB)
+    .button(1, XInput::Buttons1::RB,    Gamepad::BUTTON_RB)
+    .button(1, XInput::Buttons1::HOME,  Gamepad::BUTTON_SYS)
+    .button(1, XInput::Buttons1::A,     Gamepad::BUTTON_A)
+    .button(1, XInput::Buttons1::B,     Gamepad::BUTTON_B)
+    .button(1, XInput::Buttons1::X,     Gamepad::BUTTON_X)
+    .button(1, XInput::Buttons1::Y,     Gamepad::BUTTON_Y);
+
 void Xbox360Host::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
-    tuh_xinput::set_led(address, instance, idx_ + 1, true);
-    tuh_xinput::receive_report(address, instance);
+    tuh_xinput::set_led(address, instance, idx_ + 1);
 }
 
 void Xbox360Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -16,28 +32,12 @@ void Xbox360Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t inst
     const XInput::InReport* in_report_ = reinterpret_cast<const XInput::InReport*>(report);
     if (std::memcmp(&prev_in_report_, in_report_, std::min(static_cast<size_t>(len), sizeof(XInput::InReport))) == 0)
     {
-        tuh_xinput::receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;
 
-    if (in_report_->buttons[0] & XInput::Buttons0::DPAD_UP)    gp_in.dpad |= gamepad.MAP_DPAD_UP;
-    if (in_report_->buttons[0] & XInput::Buttons0::DPAD_DOWN)  gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-    if (in_report_->buttons[0] & XInput::Buttons0::DPAD_LEFT)  gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-    if (in_report_->buttons[0] & XInput::Buttons0::DPAD_RIGHT) gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-
-    if (in_report_->buttons[0] & XInput::Buttons0::START)  gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report_->buttons[0] & XInput::Buttons0::BACK)   gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report_->buttons[0] & XInput::Buttons0::L3)     gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report_->buttons[0] & XInput::Buttons0::R3)     gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report_->buttons[1] & XInput::Buttons1::LB)     gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report_->buttons[1] & XInput::Buttons1::RB)     gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report_->buttons[1] & XInput::Buttons1::HOME)   gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report_->buttons[1] & XInput::Buttons1::A)      gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report_->buttons[1] & XInput::Buttons1::B)      gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report_->buttons[1] & XInput::Buttons1::X)      gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report_->buttons[1] & XInput::Buttons1::Y)      gp_in.buttons |= gamepad.MAP_BUTTON_Y;
+    gamepad.remap(BUTTON_MAP.map(in_report_->buttons), gp_in);
 
     gp_in.trigger_l = gamepad.scale_trigger_l(in_report_->trigger_l);
     gp_in.trigger_r = gamepad.scale_trigger_r(in_report_->trigger_r);
@@ -47,12 +47,11 @@ void Xbox360Host::process_report(Gamepad& gamepad, uint8_t address, uint8_t inst
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_xinput::receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report_, sizeof(XInput::InReport));
 }
 
 bool Xbox360Host::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out();
-    return tuh_xinput::set_rumble(address, 0, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, 0, gp_out.rumble_l, gp_out.rumble_r);
 }
\ No newline at end of file
@@ -10,6 +10,23 @@
 #include "USBHost/HostDriver/XInput/Xbox360W.h"
 #include "Board/ogxm_log.h"
 
+static constexpr SourceMap<2> BUTTON_MAP = SourceMap<2>()
+    .dpad(0, XInput::Buttons0::DPAD_UP,    Gamepad::DPAD_UP)
+    .dpad(0, XInput::Buttons0::DPAD_DOWN,  Gamepad::DPAD_DOWN)
+    .dpad(0, XInput::Buttons0::DPAD_LEFT,  Gamepad::DPAD_LEFT)
+    .dpad(0, XInput::Buttons0::DPAD_RIGHT, Gamepad::DPAD_RIGHT)
+    .button(0, XInput::Buttons0::START, Gamepad::BUTTON_START)
+    .button(0, XInput::Buttons0::BACK,  Gamepad::BUTTON_BACK)
+    .button(0, XInput::Buttons0::L3,    Gamepad::BUTTON_L3)
+    .button(0, XInput::Buttons0::R3,    Gamepad::BUTTON_R3)
+    .button(1, XInput::Buttons1::LB,    Gamepad::BUTTON_LB)
+    .button(1, XInput::Buttons1::RB,    Gamepad::BUTTON_RB)
+    .button(1, XInput::Buttons1::HOME,  Gamepad::BUTTON_SYS)
+    .button(1, XInput::Buttons1::A,     Gamepad::BUTTON_A)
+    .button(1, XInput::Buttons1::B,     Gamepad::BUTTON_B)
+    .button(1, XInput::Buttons1::X,     Gamepad::BUTTON_X)
+    .button(1, XInput::Buttons1::Y,     Gamepad::BUTTON_Y);
+
 Xbox360WHost::~Xbox360WHost()
 {
     TaskQueue::Core1::cancel_delayed_task(tid_chatpad_keepalive_);
@@ -17,7 +34,6 @@ Xbox360WHost::~Xbox360WHost()
 
 void Xbox360WHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
-    tuh_xinput::receive_report(address, instance);
 }
 
 void Xbox360WHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -40,7 +56,6 @@ void Xbox360WHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t ins
             tuh_xinput::xbox360_chatpad_init(address, instance);
         }
 
-        tuh_xinput::receive_report(address, instance);
         return;
     }
 
@@ -48,28 +63,12 @@ void Xbox360WHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t ins
         !(in_report->report_size == 0x13) ||
         std::memcmp(&prev_in_report_, in_report, std::min(static_cast<size_t>(len), sizeof(XInput::InReportWireless))) == 0)
     {
-        tuh_xinput::receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;
 
-    if (in_report->buttons[0] & XInput::Buttons0::DPAD_UP)    gp_in.dpad |= gamepad.MAP_DPAD_UP;
-    if (in_report->buttons[0] & XInput::Buttons0::DPAD_DOWN)  gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-    if (in_report->buttons[0] & XInput::Buttons0::DPAD_LEFT)  gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-    if (in_report->buttons[0] & XInput::Buttons0::DPAD_RIGHT) gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-
-    if (in_report->buttons[0] & XInput::Buttons0::START)  gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons[0] & XInput::Buttons0::BACK)   gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons[0] & XInput::Buttons0::L3)     gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons[0] & XInput::Buttons0::R3)     gp_in.buttons |= gamepad.MAP_BUTTON_R3;
-    if (in_report->buttons[1] & XInput::Buttons1::LB)     gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->buttons[1] & XInput::Buttons1::RB)     gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-    if (in_report->buttons[1] & XInput::Buttons1::HOME)   gp_in.buttons |= gamepad.MAP_BUTTON_SYS;
-    if (in_report->buttons[1] & XInput::Buttons1::A)      gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->buttons[1] & XInput::Buttons1::B)      gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->buttons[1] & XInput::Buttons1::X)      gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->buttons[1] & XInput::Buttons1::Y)      gp_in.buttons |= gamepad.MAP_BUTTON_Y;
+    gamepad.remap(BUTTON_MAP.map(in_report->buttons), gp_in);
 
     gp_in.trigger_l = gamepad.scale_trigger_l(in_report->trigger_l);
     gp_in.trigger_r = gamepad.scale_trigger_r(in_report->trigger_r);
@@ -79,14 +78,13 @@ void Xbox360WHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t ins
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_xinput::receive_report(address, instance);
     prev_in_report_ = *in_report;
 }
 
 bool Xbox360WHost::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out(); 
-    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r);
 }
 
 void Xbox360WHost::connect_cb(Gamepad& gamepad, uint8_t address, uint8_t instance)
@@ -97,7 +95,7 @@ void Xbox360WHost::connect_cb(Gamepad& gamepad, uint8_t address, uint8_t instanc
     TaskQueue::Core1::queue_delayed_task(TaskQueue::Core1::get_new_task_id(), 1000, false, 
     [address, instance, this]
     {
-        tuh_xinput::set_led(address, instance, idx_ + 1, false);
+        tuh_xinput::set_led(address, instance, idx_ + 1);
         tuh_xinput::xbox360_chatpad_init(address, instance);
         
         TaskQueue::Core1::queue_delayed_task(tid_chatpad_keepalive_, tuh_xinput::KEEPALIVE_MS, true, 
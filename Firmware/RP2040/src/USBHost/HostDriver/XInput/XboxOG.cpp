@@ -5,11 +5,20 @@
 #include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput.h"
 #include "USBHost/HostDriver/XInput/XboxOG.h"
 
+static constexpr SourceMap<1> BUTTON_MAP = SourceMap<1>()
+    .dpad(0, XboxOG::GP::Buttons::DPAD_UP,    Gamepad::DPAD_UP)
+    .dpad(0, XboxOG::GP::Buttons::DPAD_DOWN,  Gamepad::DPAD_DOWN)
+    .dpad(0, XboxOG::GP::Buttons::DPAD_LEFT,  Gamepad::DPAD_LEFT)
+    .dpad(0, XboxOG::GP::Buttons::DPAD_RIGHT, Gamepad::DPAD_RIGHT)
+    .button(0, XboxOG::GP::Buttons::START, Gamepad::BUTTON_START)
+    .button(0, XboxOG::GP::Buttons::BACK,  Gamepad::BUTTON_BACK)
+    .button(0, XboxOG::GP::Buttons::L3,    Gamepad::BUTTON_L3)
+    .button(0, XboxOG::GP::Buttons::R3,    Gamepad::BUTTON_R3);
+
 void XboxOGHost::initialize(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report_desc, uint16_t desc_len)
 {
     gamepad.set_analog_host(true);
     std::memset(&prev_in_report_, 0, sizeof(XboxOG::GP::InReport));
-    tuh_xinput::receive_report(address, instance);
 }
 
 void XboxOGHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
@@ -17,28 +26,20 @@ void XboxOGHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t insta
     const XboxOG::GP::InReport* in_report = reinterpret_cast<const XboxOG::GP::InReport*>(report);
     if (std::memcmp(&prev_in_report_, in_report, std::min(static_cast<size_t>(len), sizeof(XboxOG::GP::InReport))) == 0)
     {
-        tuh_xinput::receive_report(address, instance);
         return;
     }
 
     Gamepad::PadIn gp_in;
 
-    if (in_report->buttons & XboxOG::GP::Buttons::DPAD_UP)    gp_in.dpad |= gamepad.MAP_DPAD_UP;
-    if (in_report->buttons & XboxOG::GP::Buttons::DPAD_DOWN)  gp_in.dpad |= gamepad.MAP_DPAD_DOWN;
-    if (in_report->buttons & XboxOG::GP::Buttons::DPAD_LEFT)  gp_in.dpad |= gamepad.MAP_DPAD_LEFT;
-    if (in_report->buttons & XboxOG::GP::Buttons::DPAD_RIGHT) gp_in.dpad |= gamepad.MAP_DPAD_RIGHT;
-
-    if (in_report->a) gp_in.buttons |= gamepad.MAP_BUTTON_A;
-    if (in_report->b) gp_in.buttons |= gamepad.MAP_BUTTON_B;
-    if (in_report->x) gp_in.buttons |= gamepad.MAP_BUTTON_X;
-    if (in_report->y) gp_in.buttons |= gamepad.MAP_BUTTON_Y;
-    if (in_report->black) gp_in.buttons |= gamepad.MAP_BUTTON_LB;
-    if (in_report->white) gp_in.buttons |= gamepad.MAP_BUTTON_RB;
-
-    if (in_report->buttons & XboxOG::GP::Buttons::START)   gp_in.buttons |= gamepad.MAP_BUTTON_START;
-    if (in_report->buttons & XboxOG::GP::Buttons::BACK)    gp_in.buttons |= gamepad.MAP_BUTTON_BACK;
-    if (in_report->buttons & XboxOG::GP::Buttons::L3)      gp_in.buttons |= gamepad.MAP_BUTTON_L3;
-    if (in_report->buttons & XboxOG::GP::Buttons::R3)      gp_in.buttons |= gamepad.MAP_BUTTON_R3;
+    //Face buttons are analog, pressed is anything above 0
+    MappingPlan::Pad pad = BUTTON_MAP.map(&in_report->buttons);
+    if (in_report->a)     pad.buttons |= Gamepad::BUTTON_A;
+    if (in_report->b)     pad.buttons |= Gamepad::BUTTON_B;
+    if (in_report->x)     pad.buttons |= Gamepad::BUTTON_X;
+    if (in_report->y)     pad.buttons |= Gamepad::BUTTON_Y;
+    if (in_report->black) pad.buttons |= Gamepad::BUTTON_LB;
+    if (in_report->white) pad.buttons |= Gamepad::BUTTON_RB;
+    gamepad.remap(pad, gp_in);
 
     if (gamepad.analog_enabled())
     {
@@ -62,12 +63,11 @@ void XboxOGHost::process_report(Gamepad& gamepad, uint8_t address, uint8_t insta
 
     gamepad.set_pad_in(gp_in);
 
-    tuh_xinput::receive_report(address, instance);
     std::memcpy(&prev_in_report_, in_report, sizeof(XboxOG::GP::InReport));
 }
 
 bool XboxOGHost::send_feedback(Gamepad& gamepad, uint8_t address, uint8_t instance)
 {
     Gamepad::PadOut gp_out = gamepad.get_pad_out();
-    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r, false);
+    return tuh_xinput::set_rumble(address, instance, gp_out.rumble_l, gp_out.rumble_r);
 }
\ No newline at end of file
@@ -13,6 +13,8 @@ namespace tuh_xinput {
 static constexpr uint8_t MAX_INTERFACES = CFG_TUH_XINPUT * 2;
 static constexpr uint8_t MAX_DEVICES = CFG_TUH_DEVICE_MAX;
 static constexpr uint8_t INVALID_IDX = 0xFF;
+//Some 3rd party wireless receivers ignore RUMBLE_ENABLE sent right as the controller connects
+static constexpr uint32_t RUMBLE_ENABLE_DELAY_MS = 1000;
 
 struct Device
 {
@@ -95,22 +97,37 @@ TU_ATTR_ALWAYS_INLINE static inline Interface* get_itf_by_instance(uint8_t dev_a
     return &device->interfaces[instance];
 }
 
-static void std_sleep_ms(uint32_t ms)
+static inline uint32_t now_ms()
 {
-    auto start = std::chrono::high_resolution_clock::now();
-    while ( std::chrono::duration_cast<std::chrono::milliseconds>(
-                std::chrono::high_resolution_clock::now() - start).count() < ms) 
-    {
-        tuh_task();
-    }
+    const uint32_t now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count());
+    return (now == 0) ? 1 : now;
 }
 
-static void wait_for_tx_complete(uint8_t dev_addr, uint8_t ep_addr)
+//Starts the oldest queued report if the endpoint is free, it's only dequeued once the transfer is underway
+static bool send_queued(uint8_t dev_addr, Interface* interface)
 {
-    while (usbh_edpt_busy(dev_addr, ep_addr))
+    if (interface->out_queue_count == 0 || !usbh_edpt_claim(dev_addr, interface->ep_out))
+    {
+        return false;
+    }
+
+    const QueuedReport& report = interface->out_queue[interface->out_queue_head];
+    std::memcpy(interface->ep_out_buffer.data(), report.data, report.len);
+    if (report.patch_idx < report.len)
     {
-        tuh_task();
+        interface->ep_out_buffer[report.patch_idx] = report.patch_value;
+    }
+
+    if (!usbh_edpt_xfer(dev_addr, interface->ep_out, interface->ep_out_buffer.data(), report.len))
+    {
+        usbh_edpt_release(dev_addr, interface->ep_out);
+        return false;
     }
+
+    interface->out_queue_head = (interface->out_queue_head + 1) % OUT_QUEUE_SIZE;
+    --interface->out_queue_count;
+    return true;
 }
 
 bool send_ctrl_xfer(uint8_t dev_addr, const tusb_control_request_t* request, uint8_t* buffer, tuh_xfer_cb_t complete_cb, uintptr_t user_data)
@@ -127,29 +144,24 @@ bool send_ctrl_xfer(uint8_t dev_addr, const tusb_control_request_t* request, uin
     return tuh_control_xfer(&transfer);
 }
 
-static void xboxone_init(Interface *interface, uint8_t dev_addr, uint8_t instance)
+static void xboxone_init(uint8_t dev_addr, uint8_t instance)
 {
     uint16_t PID, VID;
     tuh_vid_pid_get(dev_addr, &VID, &PID);
 
-    send_report(dev_addr, instance, XboxOne::POWER_ON, sizeof(XboxOne::POWER_ON));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
-    send_report(dev_addr, instance, XboxOne::S_INIT, sizeof(XboxOne::S_INIT));
-    wait_for_tx_complete(dev_addr, interface->ep_out);
+    queue_report(dev_addr, instance, XboxOne::POWER_ON, sizeof(XboxOne::POWER_ON));
+    queue_report(dev_addr, instance, XboxOne::S_INIT, sizeof(XboxOne::S_INIT));
 
     if (VID == 0x045e && (PID == 0x0b00))
     {
-        send_report(dev_addr, instance, XboxOne::EXTRA_INPUT_PACKET_INIT, sizeof(XboxOne::EXTRA_INPUT_PACKET_INIT));
-        wait_for_tx_complete(dev_addr, interface->ep_out);
+        queue_report(dev_addr, instance, XboxOne::EXTRA_INPUT_PACKET_INIT, sizeof(XboxOne::EXTRA_INPUT_PACKET_INIT));
     }
 
     //Required for PDP aftermarket controllers
     if (VID == 0x0e6f)
     {
-        send_report(dev_addr, instance, XboxOne::PDP_LED_ON, sizeof(XboxOne::PDP_LED_ON));
-        wait_for_tx_complete(dev_addr, interface->ep_out);
-        send_report(dev_addr, instance, XboxOne::PDP_AUTH, sizeof(XboxOne::PDP_AUTH));
-        wait_for_tx_complete(dev_addr, interface->ep_out);
+        queue_report(dev_addr, instance, XboxOne::PDP_LED_ON, sizeof(XboxOne::PDP_LED_ON));
+        queue_report(dev_addr, instance, XboxOne::PDP_AUTH, sizeof(XboxOne::PDP_AUTH));
     }
 }
 
@@ -251,11 +263,10 @@ static bool set_config(uint8_t dev_addr, uint8_t itf_num)
     {
         case DevType::XBOX360W:
             interface->connected = false;
-            send_report(dev_addr, instance, Xbox360W::INQUIRE_PRESENT, sizeof(Xbox360W::INQUIRE_PRESENT));
-            wait_for_tx_complete(dev_addr, interface->ep_out);
+            queue_report(dev_addr, instance, Xbox360W::INQUIRE_PRESENT, sizeof(Xbox360W::INQUIRE_PRESENT));
             break;
         case DevType::XBOXONE:
-            xboxone_init(interface, dev_addr, instance);
+            xboxone_init(dev_addr, instance);
             break;
         default:
             break;
@@ -282,7 +293,8 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
     {
         if (dir == TUSB_DIR_IN)
         {
-            report_received_cb(dev_addr, instance, interface->ep_in_buffer.data(), interface->ep_in_size);
+            report_received_cb(dev_addr, instance, interface->ep_in_buffers[interface->ep_in_idx].data(), 0);
+            return true;
         }
         else if (report_sent_cb)
         {
@@ -293,7 +305,20 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
     if (dir == TUSB_DIR_IN)
     {
         bool new_pad_data = false;
-        uint8_t* in_buffer = interface->ep_in_buffer.data();
+        //The next transfer goes to the other buffer, this one stays put until after report_received_cb
+        uint8_t* in_buffer = interface->ep_in_buffers[interface->ep_in_idx].data();
+        interface->ep_in_idx ^= 1;
+
+        if (interface->rumble_enable_ms != 0 && static_cast<int32_t>(now_ms() - interface->rumble_enable_ms) >= 0)
+        {
+            interface->rumble_enable_ms = 0;
+            queue_report(dev_addr, instance, Xbox360W::RUMBLE_ENABLE, sizeof(Xbox360W::RUMBLE_ENABLE));
+        }
+        //Normally restarted by the OUT completion, this catches a queue whose first xfer couldn't start
+        if (interface->out_queue_count > 0 && !usbh_edpt_busy(dev_addr, interface->ep_out))
+        {
+            send_queued(dev_addr, interface);
+        }
 
         switch (interface->dev_type)
         {
@@ -312,9 +337,8 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
 
                         TU_LOG1("Xbox 360 wireless controller connected\n");
 
-                        //I think some 3rd party adapters need this:
-                        std_sleep_ms(1000);
-                        send_report(dev_addr, instance, Xbox360W::RUMBLE_ENABLE, sizeof(Xbox360W::RUMBLE_ENABLE));
+                        //I think some 3rd party adapters need this, sent by the IN reports that follow once it's due
+                        interface->rumble_enable_ms = now_ms() + RUMBLE_ENABLE_DELAY_MS;
 
                         if (xbox360w_connect_cb)
                         {
@@ -325,6 +349,7 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
                     {
                         interface->connected = false;
                         interface->chatpad_inited = false;
+                        interface->rumble_enable_ms = 0;
 
                         TU_LOG1("Xbox 360 wireless controller disconnected\n");
 
@@ -358,7 +383,7 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
                         }
                         break;
                     case XboxOne::GIP_CMD_ANNOUNCE:
-                        xboxone_init(interface, dev_addr, instance);
+                        xboxone_init(dev_addr, instance);
                         break;
                 }
                 break;
@@ -386,6 +411,7 @@ static bool xfer_cb(uint8_t dev_addr, uint8_t ep_addr, xfer_result_t result, uin
         {
             report_sent_cb(dev_addr, instance, interface->ep_out_buffer.data(), static_cast<uint16_t>(xferred_bytes));
         }
+        send_queued(dev_addr, interface);
     }
     return true;
 }
@@ -412,6 +438,8 @@ void close(uint8_t dev_addr)
             TU_LOG1("XInput unmount\r\n");
             device->interfaces[i].itf_num = 0xFF;
             device->interfaces[i].connected = false;
+            device->interfaces[i].out_queue_count = 0;
+            device->interfaces[i].rumble_enable_ms = 0;
         }
     }
 }
@@ -440,7 +468,8 @@ const usbh_class_driver_t* class_driver()
 bool send_report(uint8_t dev_addr, uint8_t instance, const uint8_t *buffer, uint16_t len)
 {
     Interface* interface = get_itf_by_instance(dev_addr, instance);
-    TU_VERIFY(interface != nullptr);
+    TU_VERIFY(interface != nullptr && len <= ENDPOINT_SIZE);
+    TU_VERIFY(interface->out_queue_count == 0);
     TU_VERIFY(usbh_edpt_claim(dev_addr, interface->ep_out));
 
     std::memcpy(interface->ep_out_buffer.data(), buffer, len);
@@ -453,12 +482,35 @@ bool send_report(uint8_t dev_addr, uint8_t instance, const uint8_t *buffer, uint
     return true;
 }
 
+bool queue_report(uint8_t dev_addr, uint8_t instance, const uint8_t* report, uint16_t len, uint8_t patch_idx, uint8_t patch_value)
+{
+    Interface* interface = get_itf_by_instance(dev_addr, instance);
+    TU_VERIFY(interface != nullptr && len <= ENDPOINT_SIZE);
+    TU_VERIFY(interface->out_queue_count < OUT_QUEUE_SIZE);
+
+    QueuedReport& queued = interface->out_queue[(interface->out_queue_head + interface->out_queue_count) % OUT_QUEUE_SIZE];
+    queued.data = report;
+    queued.len = static_cast<uint8_t>(len);
+    queued.patch_idx = patch_idx;
+    queued.patch_value = patch_value;
+    ++interface->out_queue_count;
+
+    //Otherwise the completion of the transfer in flight sends it
+    if (!usbh_edpt_busy(dev_addr, interface->ep_out))
+    {
+        send_queued(dev_addr, interface);
+    }
+    return true;
+}
+
 bool receive_report(uint8_t dev_addr, uint8_t instance)
 {
     Interface* interface = get_itf_by_instance(dev_addr, instance);
     TU_VERIFY(interface != nullptr);
 
-    if (!usbh_edpt_xfer(dev_addr, interface->ep_in, interface->ep_in_buffer.data(), interface->ep_in_size))
+    TU_VERIFY(usbh_edpt_claim(dev_addr, interface->ep_in));
+
+    if (!usbh_edpt_xfer(dev_addr, interface->ep_in, interface->ep_in_buffers[interface->ep_in_idx].data(), interface->ep_in_size))
     {
         usbh_edpt_release(dev_addr, interface->ep_in);
         return false;
@@ -466,39 +518,25 @@ bool receive_report(uint8_t dev_addr, uint8_t instance)
     return true;
 }
 
-bool set_led(uint8_t dev_addr, uint8_t instance, uint8_t quadrant, bool block)
+bool set_led(uint8_t dev_addr, uint8_t instance, uint8_t quadrant)
 {
     Interface* interface = get_itf_by_instance(dev_addr, instance);
     TU_VERIFY(interface != nullptr);
 
-    uint8_t buffer[32];
-    uint16_t len;
-
     switch (interface->dev_type)
     {
         case DevType::XBOX360W:
-            std::memcpy(buffer, Xbox360W::LED, sizeof(Xbox360W::LED));
-            buffer[3] = (quadrant == 0) ? 0x40 : (0x40 | (quadrant + 5));
-            len = sizeof(Xbox360W::LED);
-            break;
+            return queue_report(dev_addr, instance, Xbox360W::LED, sizeof(Xbox360W::LED), 
+                                3, (quadrant == 0) ? 0x40 : (0x40 | (quadrant + 5)));
         case DevType::XBOX360:
-            std::memcpy(buffer, Xbox360::LED, sizeof(Xbox360::LED));
-            buffer[2] = (quadrant == 0) ? 0 : (quadrant + 5);
-            len = sizeof(Xbox360::LED);
-            break;
+            return queue_report(dev_addr, instance, Xbox360::LED, sizeof(Xbox360::LED), 
+                                2, (quadrant == 0) ? 0 : (quadrant + 5));
         default:
             return true;
     }
-
-    bool ret = send_report(dev_addr, instance, buffer, len);
-    if (block && ret)
-    {
-        wait_for_tx_complete(dev_addr, interface->ep_out);
-    }
-    return ret;
 }
 
-bool set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r, bool block)
+bool set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r)
 {
     Interface* interface = get_itf_by_instance(dev_addr, instance);
     TU_VERIFY(interface != nullptr);
@@ -538,12 +576,7 @@ bool set_rumble(uint8_t dev_addr, uint8_t instance, uint8_t rumble_l, uint8_t ru
             return true;
     }
 
-    bool ret = send_report(dev_addr, instance, buffer, len);
-    if (block && ret)
-    {
-        wait_for_tx_complete(dev_addr, interface->ep_out);
-    }
-    return true;
+    return send_report(dev_addr, instance, buffer, len);
 }
 
 void xbox360_chatpad_init(uint8_t address, uint8_t instance)
@@ -554,19 +587,13 @@ void xbox360_chatpad_init(uint8_t address, uint8_t instance)
     TU_VERIFY(interface != nullptr && interface->connected, );
     TU_VERIFY(interface->dev_type == DevType::XBOX360W, ); //Only supported on Xbox 360 Wireless atm, wired is more complicated
 
-    send_report(address, instance, Xbox360W::CONTROLLER_INFO, sizeof(Xbox360W::CONTROLLER_INFO));
-    wait_for_tx_complete(address, interface->ep_out);
-    send_report(address, instance, Xbox360W::Chatpad::INIT, sizeof(Xbox360W::Chatpad::INIT));
-    wait_for_tx_complete(address, interface->ep_out);
-    send_report(address, instance, Xbox360W::RUMBLE_ENABLE, sizeof(Xbox360W::RUMBLE_ENABLE));
-    wait_for_tx_complete(address, interface->ep_out);
-
-    uint8_t led_ctrl[4];
-    std::memcpy(led_ctrl, Xbox360W::Chatpad::LED_CTRL, sizeof(Xbox360W::Chatpad::LED_CTRL));
-    led_ctrl[2] = Xbox360W::Chatpad::LED_ON[0];
+    TU_VERIFY(interface->out_queue_count + 4 <= OUT_QUEUE_SIZE, );
 
-    send_report(address, instance, led_ctrl, sizeof(led_ctrl));
-    wait_for_tx_complete(address, interface->ep_out);
+    queue_report(address, instance, Xbox360W::CONTROLLER_INFO, sizeof(Xbox360W::CONTROLLER_INFO));
+    queue_report(address, instance, Xbox360W::Chatpad::INIT, sizeof(Xbox360W::Chatpad::INIT));
+    queue_report(address, instance, Xbox360W::RUMBLE_ENABLE, sizeof(Xbox360W::RUMBLE_ENABLE));
+    queue_report(address, instance, Xbox360W::Chatpad::LED_CTRL, sizeof(Xbox360W::Chatpad::LED_CTRL), 
+                 2, Xbox360W::Chatpad::LED_ON[0]);
 
     interface->chatpad_inited = true;
     interface->chatpad_stage = ChatpadStage::KEEPALIVE_1;
@@ -587,7 +614,7 @@ bool xbox360_chatpad_keepalive(uint8_t address, uint8_t instance)
                     send_ctrl_xfer(interface->dev_addr, &Xbox360::Chatpad::KEEPALIVE_1, nullptr, nullptr, 0);
                     break;
                 case DevType::XBOX360W:
-                    send_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_1, sizeof(Xbox360W::Chatpad::KEEPALIVE_1));
+                    queue_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_1, sizeof(Xbox360W::Chatpad::KEEPALIVE_1));
                     break;
                 default:
                     break;
@@ -601,7 +628,7 @@ bool xbox360_chatpad_keepalive(uint8_t address, uint8_t instance)
                     send_ctrl_xfer(interface->dev_addr, &Xbox360::Chatpad::KEEPALIVE_2, nullptr, nullptr, 0);
                     break;
                 case DevType::XBOX360W:
-                    send_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_2, sizeof(Xbox360W::Chatpad::KEEPALIVE_2));
+                    queue_report(interface->dev_addr, instance, Xbox360W::Chatpad::KEEPALIVE_2, sizeof(Xbox360W::Chatpad::KEEPALIVE_2));
                     break;
                 default:
                     break;
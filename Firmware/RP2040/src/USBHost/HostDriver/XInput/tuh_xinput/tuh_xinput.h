@@ -55,6 +55,17 @@ namespace tuh_xinput
 
     static constexpr uint8_t ENDPOINT_SIZE = 64;
     static constexpr uint32_t KEEPALIVE_MS = 1000;
+    static constexpr uint8_t OUT_QUEUE_SIZE = 6;
+
+    //OUT report waiting for the endpoint, points at a constant packet.
+    //If patch_idx is inside the packet that byte of the sent copy is replaced with patch_value
+    struct QueuedReport
+    {
+        const uint8_t* data{nullptr};
+        uint8_t len{0};
+        uint8_t patch_idx{0xFF};
+        uint8_t patch_value{0};
+    };
 
     struct Interface
     {
@@ -75,18 +86,35 @@ namespace tuh_xinput
         uint16_t ep_in_size{0xFF};
         uint16_t ep_out_size{0xFF};
 
-        std::array<uint8_t, ENDPOINT_SIZE> ep_in_buffer{0};
+        //IN transfers alternate between the two, the report being parsed is never the one being received
+        std::array<std::array<uint8_t, ENDPOINT_SIZE>, 2> ep_in_buffers{};
+        uint8_t ep_in_idx{0};
         std::array<uint8_t, ENDPOINT_SIZE> ep_out_buffer{0};
+
+        //Init sequences are queued and sent from xfer_cb as each OUT transfer completes,
+        //nothing waits on the endpoint so other devices keep being serviced
+        std::array<QueuedReport, OUT_QUEUE_SIZE> out_queue{};
+        uint8_t out_queue_head{0};
+        uint8_t out_queue_count{0};
+
+        //Xbox 360 wireless, when RUMBLE_ENABLE is due after a controller connects, 0 if it isn't
+        uint32_t rumble_enable_ms{0};
     };
 
     // API
 
     const usbh_class_driver_t* class_driver();
 
+    //Fails if the endpoint is busy or reports are queued
     bool send_report(uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len);
+    //Sent after anything already queued, report must stay valid until then (constant packets)
+    bool queue_report(uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len, uint8_t patch_idx = 0xFF, uint8_t patch_value = 0);
+    //Arms the IN endpoint with the buffer the last report wasn't received in, fails if it's already busy
     bool receive_report(uint8_t address, uint8_t instance);
-    bool set_rumble(uint8_t address, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r, bool block);
-    bool set_led(uint8_t address, uint8_t instance, uint8_t led_number, bool block);
+    //Latest value wins, fails rather than waits if the endpoint is busy
+    bool set_rumble(uint8_t address, uint8_t instance, uint8_t rumble_l, uint8_t rumble_r);
+    //Queued
+    bool set_led(uint8_t address, uint8_t instance, uint8_t led_number);
 
     //Wireless only atm
     void xbox360_chatpad_init(uint8_t address, uint8_t instance); 
@@ -99,6 +127,7 @@ namespace tuh_xinput
     TU_ATTR_WEAK void report_sent_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len);
     TU_ATTR_WEAK void xbox360w_connect_cb(uint8_t dev_addr, uint8_t instance);
     TU_ATTR_WEAK void xbox360w_disconnect_cb(uint8_t dev_addr, uint8_t instance);
+    //len is 0 for a failed IN transfer. Not re-armed, call receive_report (before parsing the report is fine)
     void report_received_cb(uint8_t dev_addr, uint8_t instance, uint8_t const* report, uint16_t len);
     
 }; // namespace tuh_xinput
@@ -0,0 +1,98 @@
+#ifndef _HOST_IN_PIPE_H_
+#define _HOST_IN_PIPE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <algorithm>
+
+/*  Interrupt IN pipe of one host interface, re-armed before its report is handed to the driver.
+
+    The caller marks the completion, takes a stable copy of the report if the class driver only has
+    the one IN buffer (TinyUSB HID, tuh_xinput alternates two of its own), starts the next transfer
+    and only then runs the driver on the held report. The controller can deliver its next poll while
+    this one is being mapped.
+
+    NAKs never reach a class driver, the HCD retries them every frame. What's counted is what the
+    firmware controls: completions without data, re-arms that failed, and frames the endpoint sat
+    unarmed between a completion and the next transfer starting. At full speed an interrupt
+    endpoint is polled at most once a frame, so an unarmed frame is a poll the controller
+    couldn't answer. */
+
+template <uint16_t BUFFER_SIZE>
+class HostInPipe
+{
+public:
+    static constexpr uint32_t FRAME_US = 1000;
+
+    struct Stats
+    {
+        uint32_t reports{0};
+        uint32_t empty{0};          //Completed without data, transfer errors included
+        uint32_t rearm_failed{0};   //Endpoint couldn't be armed right after a completion
+        uint32_t unarmed_frames{0}; //Polls lost while the endpoint wasn't armed
+        uint32_t max_unarmed_us{0};
+    };
+
+    //New mount, nothing is armed yet
+    inline void reset(uint32_t now_us)
+    {
+        stats_ = Stats();
+        unarmed_ = true;
+        unarmed_since_us_ = now_us;
+    }
+
+    //Call first thing in the report callback
+    inline void completed(uint32_t now_us, uint16_t len)
+    {
+        unarmed_ = true;
+        unarmed_since_us_ = now_us;
+        if (len == 0)
+        {
+            ++stats_.empty;
+        }
+        else
+        {
+            ++stats_.reports;
+        }
+    }
+
+    //Copy of the report that the next transfer can't overwrite, len is clamped to the buffer
+    inline const uint8_t* hold(const uint8_t* report, uint16_t& len)
+    {
+        len = std::min(len, BUFFER_SIZE);
+        std::memcpy(buffer_.data(), report, len);
+        return buffer_.data();
+    }
+
+    //Result of starting the next transfer, retry is true when it's a later attempt after a failure
+    inline void armed(uint32_t now_us, bool success, bool retry = false)
+    {
+        if (!unarmed_)
+        {
+            return;
+        }
+        if (!success)
+        {
+            stats_.rearm_failed += retry ? 0 : 1;
+            return;
+        }
+        //Frame boundaries crossed, 900us can still straddle one
+        const uint32_t unarmed_us = now_us - unarmed_since_us_;
+        stats_.unarmed_frames += ((unarmed_since_us_ % FRAME_US) + unarmed_us) / FRAME_US;
+        stats_.max_unarmed_us = std::max(stats_.max_unarmed_us, unarmed_us);
+        unarmed_ = false;
+    }
+
+    //Outside the report callback this means the re-arm failed and hasn't been retried yet
+    inline bool unarmed() const { return unarmed_; }
+    inline const Stats& stats() const { return stats_; }
+
+private:
+    std::array<uint8_t, BUFFER_SIZE> buffer_{0};
+    Stats stats_;
+    uint32_t unarmed_since_us_{0};
+    bool unarmed_{false};
+};
+
+#endif // _HOST_IN_PIPE_H_
@@ -2,16 +2,25 @@
 #define _HOST_MANAGER_H_
 
 #include <cstdint>
-#include <memory>	
+#include <array>
 #include <hardware/regs/usb.h>
 #include <hardware/irq.h>
 #include <hardware/structs/usb.h>
 #include <hardware/resets.h>
+#include <pico/time.h>
+
+#include "class/hid/hid_host.h"
 
 #include "Board/Config.h"
+#include "Board/ogxm_log.h"
+#include "Board/board_api.h"
+#include "Board/latency_trace.h"
+#include "Gamepad/FeedbackLimiter.h"
 #include "USBHost/HardwareIDs.h"
+#include "USBHost/HostInPipe.h"
 #include "USBHost/HostDriver/XInput/tuh_xinput/tuh_xinput.h"
 #include "USBHost/HostDriver/HostDriver.h"
+#include "USBHost/HostDriver/HostDriverPool.h"
 #include "USBHost/HostDriver/PS5/PS5.h"
 #include "USBHost/HostDriver/PS4/PS4.h"
 #include "USBHost/HostDriver/PS3/PS3.h"
@@ -32,6 +41,7 @@ class HostManager
 {
 public:
 	enum class DriverClass { NONE, HID, XINPUT };
+	using InPipe = HostInPipe<CFG_TUH_HID_EPIN_BUFSIZE>;
 
 	HostManager(HostManager const&) = delete;
 	void operator=(HostManager const&)  = delete;
@@ -47,6 +57,7 @@ public:
 		for (size_t i = 0; i < MAX_GAMEPADS; ++i)
 		{
 			gamepads_[i] = &gamepads[i];
+			gamepads_[i]->set_trace_idx(static_cast<uint8_t>(i));
 		}
 	}
 
@@ -54,7 +65,7 @@ public:
 	inline bool setup_driver(const HostDriverType driver_type, const uint8_t address, const uint8_t instance, uint8_t const* report_desc = nullptr, uint16_t desc_len = 0)
 	{
 		uint8_t gp_idx = find_free_gamepad();
-		if (gp_idx == INVALID_IDX || instance >= MAX_INTERFACES)
+		if (gp_idx == INVALID_IDX || instance >= MAX_INTERFACES || address >= slot_by_address_.size())
 		{
 			return false;
 		}
@@ -73,45 +84,45 @@ public:
 		switch (driver_type)
 		{
 			case HostDriverType::PS5:
-				interface.driver = std::make_unique<PS5Host>(gp_idx);
+				interface.driver = create_driver<PS5Host>(interface, gp_idx);
 				break;
 			case HostDriverType::PS4:
-				interface.driver = std::make_unique<PS4Host>(gp_idx);
+				interface.driver = create_driver<PS4Host>(interface, gp_idx);
 				break;
 			case HostDriverType::PS3:
-				interface.driver = std::make_unique<PS3Host>(gp_idx);
+				interface.driver = create_driver<PS3Host>(interface, gp_idx);
 				break;
 			case HostDriverType::DINPUT:
-				interface.driver = std::make_unique<DInputHost>(gp_idx);
+				interface.driver = create_driver<DInputHost>(interface, gp_idx);
 				break;
 			case HostDriverType::SWITCH:
-				interface.driver = std::make_unique<SwitchWiredHost>(gp_idx);
+				interface.driver = create_driver<SwitchWiredHost>(interface, gp_idx);
 				break;
 			case HostDriverType::SWITCH_PRO:
-				interface.driver = std::make_unique<SwitchProHost>(gp_idx);
+				interface.driver = create_driver<SwitchProHost>(interface, gp_idx);
 				break;
 			case HostDriverType::N64:
-				interface.driver = std::make_unique<N64Host>(gp_idx);
+				interface.driver = create_driver<N64Host>(interface, gp_idx);
 				break;
 			case HostDriverType::PSCLASSIC:
-				interface.driver = std::make_unique<PSClassicHost>(gp_idx);
+				interface.driver = create_driver<PSClassicHost>(interface, gp_idx);
 				break;
 			case HostDriverType::XBOXOG:
-				interface.driver = std::make_unique<XboxOGHost>(gp_idx);
+				interface.driver = create_driver<XboxOGHost>(interface, gp_idx);
 				break;
 			case HostDriverType::XBOXONE:
-				interface.driver = std::make_unique<XboxOneHost>(gp_idx);
+				interface.driver = create_driver<XboxOneHost>(interface, gp_idx);
 				break;
 			case HostDriverType::XBOX360:
-				interface.driver = std::make_unique<Xbox360Host>(gp_idx);
+				interface.driver = create_driver<Xbox360Host>(interface, gp_idx);
 				break;
 			case HostDriverType::XBOX360W: //Composite device, takes up all 4 gamepads when mounted
-				interface.driver = std::make_unique<Xbox360WHost>(gp_idx);
+				interface.driver = create_driver<Xbox360WHost>(interface, gp_idx);
 				break;
 			default:
 				if (is_hid_gamepad(report_desc, desc_len))
 				{
-					interface.driver = std::make_unique<HIDHost>(gp_idx);
+					interface.driver = create_driver<HIDHost>(interface, gp_idx);
 				}
 				else
 				{
@@ -120,56 +131,87 @@ public:
 				break;
 		}
 
+		if (!interface.driver)
+		{
+			return false;
+		}
+
 		device_slot.address = address;
+		slot_by_address_[address] = dev_idx;
 		interface.gamepad_idx = gp_idx;
 		interface.gamepad = gamepads_[gp_idx];
+		interface.feedback.reset(interface.gamepad->pad_out_event());
 		interface.driver->initialize(*interface.gamepad, device_slot.address, instance, report_desc, desc_len);
 
+		const DriverClass driver_class = get_driver_class(driver_type);
+		routes_[dev_idx][instance] = { interface.driver, interface.gamepad, driver_class, gp_idx };
+
+		//First transfer, process_report keeps it going from here
+		InPipe& pipe = pipes_[dev_idx][instance];
+		pipe.reset(time_us_32());
+		pipe.armed(time_us_32(), receive_report(driver_class, address, instance));
 		return true;
 	}
 
+	//Hot path, one lookup in the table setup_driver/deinit_driver keep up to date.
+	//The next IN transfer is started before the driver parses this one, drivers don't re-arm
 	inline void process_report(uint8_t address, uint8_t instance, const uint8_t* report, uint16_t len)
 	{
-		for (auto& device_slot : device_slots_)
+		const Route* route = get_route(address, instance);
+		if (!route)
 		{
-			if (device_slot.address == address && 
-				device_slot.interfaces[instance].driver &&
-				device_slot.interfaces[instance].gamepad)
-			{
-				device_slot.interfaces[instance].driver->process_report(*device_slot.interfaces[instance].gamepad, address, instance, report, len);
-			}
+			return;
+		}
+		latency_trace::host_report(route->gamepad_idx);
+
+		InPipe& pipe = pipes_[slot_by_address_[address]][instance];
+		pipe.completed(time_us_32(), len);
+		//TinyUSB HID has one IN buffer per interface, tuh_xinput alternates two of its own
+		if (route->driver_class == DriverClass::HID)
+		{
+			report = pipe.hold(report, len);
+		}
+		pipe.armed(time_us_32(), receive_report(route->driver_class, address, instance));
+
+		if (len > 0)
+		{
+			route->driver->process_report(*route->gamepad, address, instance, report, len);
 		}
 	}
 
 	inline void connect_cb(uint8_t address, uint8_t instance)
 	{
-		for (auto& device_slot : device_slots_)
+		const Route* route = get_route(address, instance);
+		if (route)
 		{
-			if (device_slot.address == address && 
-				device_slot.interfaces[instance].driver &&
-				device_slot.interfaces[instance].gamepad)
-			{
-				device_slot.interfaces[instance].driver->connect_cb(*device_slot.interfaces[instance].gamepad, address, instance);
-			}
+			route->driver->connect_cb(*route->gamepad, address, instance);
 		}
 	}
 
 	inline void disconnect_cb(uint8_t address, uint8_t instance)
 	{
-		for (auto& device_slot : device_slots_)
+		const Route* route = get_route(address, instance);
+		if (route)
 		{
-			if (device_slot.address == address && 
-				device_slot.interfaces[instance].driver &&
-				device_slot.interfaces[instance].gamepad)
-			{
-				device_slot.interfaces[instance].driver->disconnect_cb(*device_slot.interfaces[instance].gamepad, address, instance);
-			}
+			route->driver->disconnect_cb(*route->gamepad, address, instance);
 		}
 	}
 
-	//Call on a timer
+	//Call on every pass of the core1 loop
+	inline void task()
+	{
+		retry_receive();
+		send_feedback();
+#if defined(CONFIG_OGXM_DEBUG)
+		log_poll_stats();
+#endif
+	}
+
+	//A console write goes out on the next pass unless that controller
+	//was sent something less than FEEDBACK_MIN_INTERVAL_US ago
 	inline void send_feedback()
 	{
+		const uint64_t now_us = time_us_64();
 		for (auto& device_slot : device_slots_)
 		{
 			if (device_slot.address == INVALID_IDX)
@@ -178,10 +220,24 @@ public:
 			}
 			for (uint8_t i = 0; i < MAX_INTERFACES; ++i)
 			{
-				if (device_slot.interfaces[i].driver && device_slot.interfaces[i].gamepad->new_pad_out())
+				Interface& interface = device_slot.interfaces[i];
+				if (!interface.driver)
+				{
+					continue;
+				}
+				//Read before the send, a write landing during it is sent on a later pass
+				const uint32_t event = interface.gamepad->pad_out_event();
+				if (interface.feedback.due(event, interface.gamepad->new_pad_out(), now_us) == Feedback::Due::NONE)
+				{
+					continue;
+				}
+				if (interface.driver->send_feedback(*interface.gamepad, device_slot.address, i))
 				{
-					device_slot.interfaces[i].driver->send_feedback(*device_slot.interfaces[i].gamepad, device_slot.address, i);
-					tuh_task();
+					interface.feedback.sent(event, now_us);
+				}
+				else
+				{
+					interface.feedback.failed(now_us);
 				}
 			}
 		}
@@ -189,13 +245,18 @@ public:
 
     void deinit_driver(DriverClass driver_class, uint8_t address, uint8_t instance)
 	{
-		for (auto& device_slot : device_slots_)
+		for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
 		{
-			if (device_slot.address == address)
+			if (device_slots_[i].address == address)
 			{
-				device_slot.reset();
+				reset_device(device_slots_[i]);
+				routes_[i].fill(Route());
 			}
 		}
+		if (address < slot_by_address_.size())
+		{
+			slot_by_address_[address] = INVALID_IDX;
+		}
 	}
 
 	static inline HostDriverType get_type(const HardwareID& ids)
@@ -232,6 +293,12 @@ public:
 		}
 	}
 
+	//Null if nothing is mounted there, counters start over on every mount
+	inline const InPipe::Stats* get_poll_stats(uint8_t address, uint8_t instance) const
+	{
+		return get_route(address, instance) ? &pipes_[slot_by_address_[address]][instance].stats() : nullptr;
+	}
+
 	inline uint8_t get_gamepad_idx(DriverClass driver_class, uint8_t address, uint8_t instance)
 	{
 		for (auto& device_slot : device_slots_)
@@ -259,34 +326,71 @@ public:
 private:
 	static constexpr uint8_t INVALID_IDX = 0xFF;
 
+	//At most one driver per gamepad is ever mounted, so that many slots covers every mix of devices
+	using DriverPool = HostDriverPool<HostDriver, MAX_GAMEPADS,
+		PS5Host, PS4Host, PS3Host, DInputHost, SwitchWiredHost, SwitchProHost, N64Host,
+		PSClassicHost, XboxOGHost, XboxOneHost, Xbox360Host, Xbox360WHost, HIDHost>;
+
+	using Feedback = FeedbackLimiter<FEEDBACK_MIN_INTERVAL_US, FEEDBACK_REFRESH_MS * 1000>;
+
 	struct Interface
 	{
-		std::unique_ptr<HostDriver> driver{nullptr};
+		HostDriver* driver{nullptr}; //Owned by driver_pool_
 		Gamepad* gamepad{nullptr};
 		uint8_t gamepad_idx{INVALID_IDX};
+		Feedback feedback;
 	};
 	struct Device
 	{
 		uint8_t address{INVALID_IDX};
 		Interface interfaces[MAX_INTERFACES];
+	};
 
-		void reset()
-		{
-			address = INVALID_IDX;
-			for (auto& interface : interfaces)
-			{
-				interface.driver.reset();
-				interface.gamepad_idx = INVALID_IDX;
-				interface.gamepad = nullptr;
-			}
-		}
+	//Both set or both null, a copy of what the device slot owns so reports skip the slot search
+	struct Route
+	{
+		HostDriver* driver{nullptr};
+		Gamepad* gamepad{nullptr};
+		DriverClass driver_class{DriverClass::NONE};
+		uint8_t gamepad_idx{INVALID_IDX};
 	};
 
+	DriverPool driver_pool_;
 	Device device_slots_[MAX_GAMEPADS];
 	Gamepad* gamepads_[MAX_GAMEPADS];
+	//Device slot for each address TinyUSB can hand out (hub included), INVALID_IDX if none.
+	//Behind a hub pads don't sit at address slot + 1
+	std::array<uint8_t, CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1> slot_by_address_ = make_slot_table();
+	//Indexed like device_slots_, then by interface
+	std::array<std::array<Route, MAX_INTERFACES>, MAX_GAMEPADS> routes_{};
+	std::array<std::array<InPipe, MAX_INTERFACES>, MAX_GAMEPADS> pipes_{};
+#if defined(CONFIG_OGXM_DEBUG)
+	uint32_t poll_stats_logged_ms_{0};
+#endif
 
     HostManager() {}
 
+	//Replaces whatever the interface had, nullptr if the pool is somehow full
+	template <typename T>
+	inline HostDriver* create_driver(Interface& interface, uint8_t gp_idx)
+	{
+		driver_pool_.destroy(interface.driver);
+		interface.driver = nullptr;
+		return driver_pool_.create<T>(gp_idx);
+	}
+
+	inline void reset_device(Device& device)
+	{
+		device.address = INVALID_IDX;
+		for (auto& interface : device.interfaces)
+		{
+			driver_pool_.destroy(interface.driver);
+			interface.driver = nullptr;
+			interface.gamepad_idx = INVALID_IDX;
+			interface.gamepad = nullptr;
+		}
+	}
+
 	inline uint8_t find_free_device_slot()
 	{
 		for (uint8_t i = 0; i < MAX_GAMEPADS; ++i)
@@ -316,28 +420,97 @@ private:
 		return (count < MAX_GAMEPADS) ? count : INVALID_IDX;
 	}
 
+	static constexpr std::array<uint8_t, CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1> make_slot_table()
+	{
+		std::array<uint8_t, CFG_TUH_DEVICE_MAX + CFG_TUH_HUB + 1> table{};
+		for (auto& slot : table)
+		{
+			slot = INVALID_IDX;
+		}
+		return table;
+	}
+
+	inline const Route* get_route(uint8_t address, uint8_t instance) const
+	{
+		if (address >= slot_by_address_.size() || instance >= MAX_INTERFACES)
+		{
+			return nullptr;
+		}
+		const uint8_t dev_idx = slot_by_address_[address];
+		if (dev_idx >= MAX_GAMEPADS)
+		{
+			return nullptr;
+		}
+		const Route& route = routes_[dev_idx][instance];
+		return route.driver ? &route : nullptr;
+	}
+
 	inline uint8_t get_device_slot(uint8_t address)
 	{
-		if (address > MAX_GAMEPADS)
+		return (address < slot_by_address_.size()) ? slot_by_address_[address] : INVALID_IDX;
+	}
+
+	static inline DriverClass get_driver_class(HostDriverType driver_type)
+	{
+		switch (driver_type)
 		{
-			return INVALID_IDX;
+			case HostDriverType::XBOXOG:
+			case HostDriverType::XBOXONE:
+			case HostDriverType::XBOX360:
+			case HostDriverType::XBOX360W:
+				return DriverClass::XINPUT;
+			default:
+				return DriverClass::HID;
+		}
+	}
+
+	static inline bool receive_report(DriverClass driver_class, uint8_t address, uint8_t instance)
+	{
+		return (driver_class == DriverClass::XINPUT) ? tuh_xinput::receive_report(address, instance) 
+		                                             : tuh_hid_receive_report(address, instance);
+	}
+
+	inline void retry_receive()
+	{
+		for (uint8_t dev_idx = 0; dev_idx < MAX_GAMEPADS; ++dev_idx)
+		{
+			for (uint8_t instance = 0; instance < MAX_INTERFACES; ++instance)
+			{
+				const Route& route = routes_[dev_idx][instance];
+				InPipe& pipe = pipes_[dev_idx][instance];
+				if (route.driver && pipe.unarmed())
+				{
+					pipe.armed(time_us_32(), receive_report(route.driver_class, device_slots_[dev_idx].address, instance), true);
+				}
+			}
 		}
-		return address - 1;
 	}
 
-	// inline DriverClass determine_driver_class(HostDriver::Type host_type)
-	// {
-	// 	switch (host_type)
-	// 	{
-	// 		case HostDriver::Type::XBOXOG:
-	// 		case HostDriver::Type::XBOXONE:
-	// 		case HostDriver::Type::XBOX360:
-	// 		case HostDriver::Type::XBOX360W:
-	// 			return DriverClass::XINPUT;
-	// 		default:
-	// 			return DriverClass::HID;
-	// 	}
-	// }
+#if defined(CONFIG_OGXM_DEBUG)
+	inline void log_poll_stats()
+	{
+		const uint32_t now_ms = board_api::ms_since_boot();
+		if (now_ms - poll_stats_logged_ms_ < HOST_POLL_STATS_LOG_MS)
+		{
+			return;
+		}
+		poll_stats_logged_ms_ = now_ms;
+
+		for (uint8_t dev_idx = 0; dev_idx < MAX_GAMEPADS; ++dev_idx)
+		{
+			for (uint8_t instance = 0; instance < MAX_INTERFACES; ++instance)
+			{
+				if (!routes_[dev_idx][instance].driver)
+				{
+					continue;
+				}
+				const InPipe::Stats& stats = pipes_[dev_idx][instance].stats();
+				OGXM_LOG("Host %u.%u: %lu reports, %lu empty, %lu re-arm failed, %lu unarmed frames, max unarmed %lu us\n",
+					device_slots_[dev_idx].address, instance, stats.reports, stats.empty, stats.rearm_failed, stats.unarmed_frames, stats.max_unarmed_us);
+			}
+		}
+	}
+#endif
 
 	bool is_hid_gamepad(const uint8_t* report_desc, uint16_t desc_len)
 	{
@@ -364,7 +537,7 @@ private:
 			{
 				if (interface.gamepad_idx == gamepad_idx)
 				{
-					return interface.driver.get();
+					return interface.driver;
 				}
 			}
 		}
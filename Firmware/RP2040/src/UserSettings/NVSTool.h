@@ -2,7 +2,7 @@
 #define _NVS_TOOL_H_
 
 #include <cstdint>
-#include <string>
+#include <cstdio>
 #include <array>
 #include <cstring>
 #include <hardware/flash.h>
@@ -17,13 +17,28 @@ public:
     static constexpr size_t   VALUE_LEN_MAX = FLASH_PAGE_SIZE - KEY_LEN_MAX;
     static constexpr uint32_t MAX_ENTRIES = ((NVS_SECTORS * FLASH_SECTOR_SIZE) / FLASH_PAGE_SIZE) - 1;
 
+    //Fixed size key, building one never touches the heap
+    struct Key
+    {
+        char str[KEY_LEN_MAX]{};
+
+        Key(const char* name)
+        {
+            std::strncpy(str, name, sizeof(str) - 1);
+        }
+        Key(const char* prefix, uint8_t index)
+        {
+            std::snprintf(str, sizeof(str), "%s%u", prefix, static_cast<unsigned>(index));
+        }
+    };
+
     static NVSTool& get_instance()
     {
         static NVSTool instance;
         return instance;
     }
 
-    bool write(const std::string& key, const void* value, size_t len)
+    bool write(const Key& key, const void* value, size_t len)
     {
         if (!valid_args(key, len))
         {
@@ -36,7 +51,7 @@ public:
         {
             Entry* read_entry = get_entry(i);
 
-            if (!is_valid_entry(read_entry) || std::strcmp(read_entry->key, key.c_str()) == 0)
+            if (!is_valid_entry(read_entry) || std::strcmp(read_entry->key, key.str) == 0)
             {
                 update_entry(i, key, value, len);
 
@@ -49,7 +64,7 @@ public:
         return false; // No space for new entry
     }
 
-    bool read(const std::string& key, void* value, size_t len)
+    bool read(const Key& key, void* value, size_t len)
     {
         if (!valid_args(key, len))
         {
@@ -62,7 +77,7 @@ public:
         {
             Entry* read_entry = get_entry(i);
 
-            if (std::strcmp(read_entry->key, key.c_str()) == 0)
+            if (std::strcmp(read_entry->key, key.str) == 0)
             {
                 std::memcpy(value, read_entry->value, len);
 
@@ -147,12 +162,12 @@ private:
         return std::strcmp(entry->key, INVALID_KEY) != 0;
     }
 
-    inline bool valid_args(const std::string& key, size_t len)
+    inline bool valid_args(const Key& key, size_t len)
     {
-        return (key.size() < KEY_LEN_MAX - 1 && len <= sizeof(Entry::value) && std::strcmp(key.c_str(), INVALID_KEY) != 0);
+        return (std::strlen(key.str) < KEY_LEN_MAX - 1 && len <= sizeof(Entry::value) && std::strcmp(key.str, INVALID_KEY) != 0);
     }
 
-    void update_entry(uint32_t index, const std::string& key, const void* buffer, size_t len)
+    void update_entry(uint32_t index, const Key& key, const void* buffer, size_t len)
     {
         uint32_t entry_offset = index * sizeof(Entry);
         uint32_t sector_offset = ((NVS_START_OFFSET + entry_offset) / FLASH_SECTOR_SIZE) * FLASH_SECTOR_SIZE;
@@ -165,8 +180,7 @@ private:
         Entry* entry_to_write = reinterpret_cast<Entry*>(sector_buffer.data() + entry_offset);
 
         *entry_to_write = Entry();
-        std::strncpy(entry_to_write->key, key.c_str(), key.size());
-        entry_to_write->key[key.size()] = '\0';
+        std::memcpy(entry_to_write->key, key.str, sizeof(entry_to_write->key));
         std::memcpy(entry_to_write->value, buffer, len);
 
         for (uint32_t i = 0; i < FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE; ++i) 
@@ -0,0 +1,25 @@
+#ifndef OUTPUT_CURVE_SETTINGS_H
+#define OUTPUT_CURVE_SETTINGS_H
+
+#include <cstdint>
+
+#include "libfixmath/fix16.hpp"
+
+//Radial response a device driver puts on each stick after the joystick settings,
+//out = sensitivity * ((1 - linear_mix) * in^curve + linear_mix * in) past the deadzone
+#pragma pack(push, 1)
+struct OutputCurveRaw
+{
+    uint8_t enabled{false}; //0 keeps the device driver's own curve
+
+    fix16_t deadzone{fix16_from_int(0)};
+    fix16_t curve{fix16_from_int(1)};
+    fix16_t linear_mix{fix16_from_int(0)};
+    fix16_t sensitivity{fix16_from_int(1)};
+
+    uint8_t uncap_radius{true}; //Past 1.0 only the axes are clamped
+};
+static_assert(sizeof(OutputCurveRaw) == 18, "OutputCurveRaw is an unexpected size");
+#pragma pack(pop)
+
+#endif // OUTPUT_CURVE_SETTINGS_H
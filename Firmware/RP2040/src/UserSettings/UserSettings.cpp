@@ -2,6 +2,7 @@
 #include <array>
 #include <memory>
 #include <pico/multicore.h>
+#include <pico/flash.h>
 
 #include "tusb.h"
 
@@ -9,6 +10,9 @@
 #include "Board/board_api.h"
 #include "UserSettings/UserSettings.h"
 
+//Profiles are stored as one NVS value
+static_assert(sizeof(UserProfile) <= NVSTool::VALUE_LEN_MAX, "UserProfile doesn't fit an NVS value");
+
 static constexpr uint32_t BUTTON_COMBO(const uint16_t& buttons, const uint8_t& dpad = 0) {
     return (static_cast<uint32_t>(buttons) << 16) | static_cast<uint32_t>(dpad);
 }
@@ -82,29 +86,29 @@ static constexpr std::array<ComboMap, 10> BUTTON_COMBO_MAP = {{
     { ButtonCombo::PS4,       DeviceDriverType::PS4       }  // NUEVO: PS4
 }};
 
-const std::string UserSettings::INIT_FLAG_KEY()
+NVSTool::Key UserSettings::INIT_FLAG_KEY()
 {
-    return std::string("init_flag");
+    return NVSTool::Key("init_flag");
 }
 
-const std::string UserSettings::PROFILE_KEY(const uint8_t profile_id)
+NVSTool::Key UserSettings::PROFILE_KEY(const uint8_t profile_id)
 {
-    return std::string("profile_") + std::to_string(profile_id);
+    return NVSTool::Key("profile_", profile_id);
 }
 
-const std::string UserSettings::ACTIVE_PROFILE_KEY(const uint8_t index)
+NVSTool::Key UserSettings::ACTIVE_PROFILE_KEY(const uint8_t index)
 {
-    return std::string("active_id_") + std::to_string(index);
+    return NVSTool::Key("active_id_", index);
 }
 
-const std::string UserSettings::DRIVER_TYPE_KEY()
+NVSTool::Key UserSettings::DRIVER_TYPE_KEY()
 {
-    return std::string("driver_type");
+    return NVSTool::Key("driver_type");
 }
 
-const std::string UserSettings::DATETIME_KEY()
+NVSTool::Key UserSettings::DATETIME_KEY()
 {
-    return std::string("datetime");
+    return NVSTool::Key("datetime");
 }
 
 DeviceDriverType UserSettings::DEFAULT_DRIVER()
@@ -236,6 +240,37 @@ void UserSettings::store_driver_type(DeviceDriverType new_driver)
     board_api::reboot();
 }
 
+//Stores the driver type without a reboot, core1 keeps its state and is only paused for the write.
+//Its task has to have called multicore_lockout_victim_init, call from core0
+bool UserSettings::write_driver_type(DeviceDriverType new_driver)
+{
+    if (!is_valid_driver(new_driver))
+    {
+        return false;
+    }
+
+    struct Write
+    {
+        NVSTool& nvs_tool;
+        NVSTool::Key key;
+        DeviceDriverType driver;
+        bool written;
+    } write{ nvs_tool_, DRIVER_TYPE_KEY(), new_driver, false };
+
+    const int result = flash_safe_execute([](void* param)
+    {
+        Write* write = static_cast<Write*>(param);
+        write->written = write->nvs_tool.write(write->key, &write->driver, sizeof(uint8_t));
+    }, &write, FLASH_LOCKOUT_TIMEOUT_MS);
+
+    if (result != PICO_OK || !write.written)
+    {
+        OGXM_LOG("Driver type not stored, flash_safe_execute: " + OGXM_TO_STRING(result) + "\n");
+        return false;
+    }
+    return true;
+}
+
 uint8_t UserSettings::get_active_profile_id(const uint8_t index)
 {
     if (index > MAX_GAMEPADS - 1)
@@ -311,15 +346,15 @@ DeviceDriverType UserSettings::get_current_driver()
 
 void UserSettings::write_datetime()
 {
-    nvs_tool_.write(DATETIME_KEY(), DATETIME_TAG.c_str(), DATETIME_TAG.size() + 1);
+    nvs_tool_.write(DATETIME_KEY(), DATETIME_TAG, sizeof(DATETIME_TAG));
 }
 
 bool UserSettings::verify_datetime()
 {
-    char read_dt_tag[DATETIME_TAG.size() + 1] = {0};
+    char read_dt_tag[sizeof(DATETIME_TAG)] = {0};
 
     if (!nvs_tool_.read(DATETIME_KEY(), read_dt_tag, sizeof(read_dt_tag)) ||
-        (std::strcmp(read_dt_tag, DATETIME_TAG.c_str()) != 0))
+        (std::strcmp(read_dt_tag, DATETIME_TAG) != 0))
     {
         return false;
     }
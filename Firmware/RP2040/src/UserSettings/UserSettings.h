@@ -2,7 +2,6 @@
 #define _USER_SETTINGS_H_
 
 #include <cstdint>
-#include <string>
 
 #include "Board/Config.h"
 #include "USBDevice/DeviceDriver/DeviceDriverTypes.h"
@@ -37,6 +36,7 @@ public:
     uint8_t get_active_profile_id(const uint8_t index);
 
     void store_driver_type(DeviceDriverType new_driver_type);
+    bool write_driver_type(DeviceDriverType new_driver_type);
     bool store_profile(uint8_t index, const UserProfile& profile);
     bool store_profile_and_driver_type(DeviceDriverType new_driver_type, uint8_t index, const UserProfile& profile);
 
@@ -47,18 +47,20 @@ private:
     UserSettings& operator=(const UserSettings&) = delete;
 
     static constexpr uint8_t GP_CHECK_COUNT = 3000 / GP_CHECK_DELAY_MS;
-    static constexpr uint8_t FLASH_INIT_FLAG = 0xF8;
-    const std::string DATETIME_TAG = BUILD_DATETIME; 
+    //One bump for the poll interval, output curve and turbo fields together, profiles are wiped once
+    static constexpr uint8_t FLASH_INIT_FLAG = 0xF9;
+    static constexpr uint32_t FLASH_LOCKOUT_TIMEOUT_MS = 100;
+    static constexpr char DATETIME_TAG[] = BUILD_DATETIME;
     
     NVSTool& nvs_tool_{NVSTool::get_instance()};
     DeviceDriverType current_driver_{DeviceDriverType::NONE};
     
     DeviceDriverType DEFAULT_DRIVER();
-    const std::string INIT_FLAG_KEY();
-    const std::string PROFILE_KEY(const uint8_t profile_id);
-    const std::string ACTIVE_PROFILE_KEY(const uint8_t index);
-    const std::string DRIVER_TYPE_KEY();
-    const std::string DATETIME_KEY();
+    NVSTool::Key INIT_FLAG_KEY();
+    NVSTool::Key PROFILE_KEY(const uint8_t profile_id);
+    NVSTool::Key ACTIVE_PROFILE_KEY(const uint8_t index);
+    NVSTool::Key DRIVER_TYPE_KEY();
+    NVSTool::Key DATETIME_KEY();
 };
 
 #endif // _USER_SETTINGS_H_
\ No newline at end of file